@@ -8,6 +8,11 @@
 #include <cstdint>
 #include <thread>
 #include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <limits>
+#include <functional>
 
 namespace titan {
 
@@ -27,6 +32,62 @@ struct StorageStats {
     size_t auto_compaction_count = 0;
     double write_amplification = 0.0;
     double space_amplification = 0.0;
+    size_t cold_recompressed_count = 0;
+    size_t cold_bytes_saved = 0;
+    size_t memory_bytes = 0;
+    size_t memtable_bytes = 0;
+    size_t tombstone_bytes = 0;
+    size_t sstable_index_bytes = 0;
+    size_t collection_bytes = 0;
+    size_t evicted_keys = 0;
+    size_t evicted_bytes = 0;
+};
+
+// What happens once memory_bytes exceeds setMaxMemoryBytes(). Spill moves the
+// memtable to an SSTable and needs a data directory; the others evict entries
+// in the manner of Redis maxmemory-policy, sampling a few candidates per
+// eviction. VolatileTtl only ever evicts keys that carry a TTL.
+enum class EvictionPolicy : uint8_t {
+    Spill = 0,
+    AllKeysLru = 1,
+    AllKeysLfu = 2,
+    VolatileTtl = 3
+};
+
+// Each eviction step draws `samples` random entries into a small pool of the
+// best candidates seen so far and evicts the top one. LFU counters are 8-bit
+// and logarithmic: lfu_log_factor sets how many hits it takes to saturate,
+// and a counter loses one point per lfu_decay_minutes without access.
+struct EvictionConfig {
+    EvictionPolicy policy = EvictionPolicy::Spill;
+    size_t samples = 5;
+    uint32_t lfu_log_factor = 10;
+    uint32_t lfu_decay_minutes = 1;
+};
+
+enum class CompressionCodec : uint8_t {
+    Zstd = 0,
+    None = 1
+};
+
+// Per-prefix compression override. The longest matching prefix wins; keys that
+// match no policy use the engine-wide compression level.
+struct CompressionPolicy {
+    std::string prefix;
+    CompressionCodec codec = CompressionCodec::Zstd;
+    int level = 3;
+    std::string dictionary;
+};
+
+// Values not read or written for idle_ms are re-encoded at `level`, optionally
+// with a dictionary trained from the cold set. Runs before WAL compaction and
+// on explicit recompressCold() calls; the write path is never involved.
+struct ColdRecompressionPolicy {
+    bool enabled = false;
+    int64_t idle_ms = 10 * 60 * 1000;
+    int level = 19;
+    bool train_dictionary = false;
+    size_t batch_size = 512;
 };
 
 struct CompactionPolicy {
@@ -36,8 +97,201 @@ struct CompactionPolicy {
     size_t min_wal_bytes = 4 * 1024 * 1024;
 };
 
+// A value and the version it was read at. Versions are drawn from one
+// counter per engine and change whenever the key's value may have changed;
+// keys that are absent or only held in SSTables share a version that moves
+// on every spill, so a version mismatch can be spurious but a change is never
+// missed. Native collections are not versioned.
+struct VersionedValue {
+    std::optional<std::string> value;
+    uint64_t version = 0;
+};
+
+// Result of TitanEngine::checkpoint().
+struct CheckpointResult {
+    uint64_t wal_bytes = 0;
+    // Below wal_bytes when an earlier checkpoint in the directory was only
+    // extended with the new tail.
+    uint64_t copied_bytes = 0;
+};
+
+// Bounds of TitanEngine::iterate(). start and end are inclusive and combine
+// with prefix; an empty bound leaves that side open.
+struct IterateOptions {
+    std::string prefix;
+    std::string start;
+    std::string end;
+    bool reverse = false;
+};
+
+// Mixed writes that TitanEngine::write() applies under one storage lock and
+// logs as a single WAL record, so a crash keeps all of them or none.
+class WriteBatch {
+public:
+    enum class OpKind : uint8_t { Put, Del, Incr };
+
+    struct Op {
+        OpKind kind = OpKind::Put;
+        std::string key;
+        std::string value;
+        int64_t ttl_ms = 0;
+        int64_t delta = 0;
+    };
+
+    void put(const std::string& key, std::string value, int64_t ttl_ms = 0) {
+        ops_.push_back({OpKind::Put, key, std::move(value), ttl_ms, 0});
+    }
+    void del(const std::string& key) { ops_.push_back({OpKind::Del, key, {}, 0, 0}); }
+    void incr(const std::string& key, int64_t delta = 1) { ops_.push_back({OpKind::Incr, key, {}, 0, delta}); }
+    // Makes the batch conditional: it is applied only if key is still at
+    // `version` (see TitanEngine::version) when the storage lock is taken.
+    void watch(const std::string& key, uint64_t version) { watches_.emplace_back(key, version); }
+
+    const std::vector<Op>& ops() const { return ops_; }
+    const std::vector<std::pair<std::string, uint64_t>>& watches() const { return watches_; }
+    size_t size() const { return ops_.size(); }
+    bool empty() const { return ops_.empty(); }
+    void clear() {
+        ops_.clear();
+        watches_.clear();
+    }
+
+private:
+    std::vector<Op> ops_;
+    std::vector<std::pair<std::string, uint64_t>> watches_;
+};
+
+// The outcome of one WriteBatch op: 0 for puts, 1/0 for dels that did/did
+// not remove anything, the new value for incrs. `error` is set, and the op
+// was skipped, when an incr hit a non-integer value or would overflow.
+struct WriteResult {
+    int64_t value = 0;
+    std::string error;
+};
+
+// A message taken from a pub/sub subscriber queue. `pattern` is the glob
+// subscription it matched, empty for a channel subscription.
+struct PubSubMessage {
+    std::string channel;
+    std::string message;
+    std::string pattern;
+};
+
 class Storage;
+class SSTableBuilder;
+class Compressor;
 class WAL;
+class ReadSnapshot;
+class PubSub;
+class TitanEngine;
+class TitanSnapshot;
+class TitanExporter;
+struct StorageSnapshot;
+
+// Cursor over the plain values of an engine as of the moment it was opened.
+// Each next() call seeks into the memtable and every SSTable and merges one
+// chunk under a shared lock, so memory is bounded by the chunk size however
+// large the keyspace is. Writes made meanwhile are not seen. The pin that
+// keeps this view is released once the cursor is exhausted or destroyed; an
+// iterator must not outlive its engine or be used from two threads at once.
+class TitanIterator {
+public:
+    using KVPair = std::pair<std::string, std::string>;
+
+    ~TitanIterator();
+
+    TitanIterator(const TitanIterator&) = delete;
+    TitanIterator& operator=(const TitanIterator&) = delete;
+
+    // Up to max_entries pairs in key order, descending when reversed; fewer
+    // than requested means the scan is complete.
+    std::vector<KVPair> next(size_t max_entries);
+    bool done() const { return done_; }
+
+private:
+    friend class TitanEngine;
+    friend class TitanSnapshot;
+
+    TitanIterator(TitanEngine& engine, IterateOptions options, std::shared_ptr<const StorageSnapshot> snapshot);
+
+    TitanEngine& engine_;
+    IterateOptions options_;
+    std::shared_ptr<const StorageSnapshot> snapshot_;
+    std::optional<std::string> last_key_;
+    bool done_ = false;
+};
+
+// Point-in-time view of an engine's plain values. Taking one pins the
+// current write sequence rather than copying anything: later writes keep
+// the states they replace for as long as a pin could still read them, so
+// every read here, and every iterator opened from it, sees the same data.
+// The pin is held until the snapshot and its iterators are destroyed, and
+// clear() invalidates it. Collections are not covered. Like an iterator, a
+// snapshot must not outlive its engine.
+class TitanSnapshot {
+public:
+    using KVPair = std::pair<std::string, std::string>;
+
+    ~TitanSnapshot();
+
+    TitanSnapshot(const TitanSnapshot&) = delete;
+    TitanSnapshot& operator=(const TitanSnapshot&) = delete;
+
+    std::optional<std::string> get(const std::string& key) const;
+    bool has(const std::string& key) const;
+    // Paged like TitanEngine::keys() and scan().
+    std::vector<std::string> keys(const IterateOptions& options, size_t limit,
+                                  const std::optional<std::string>& after = std::nullopt) const;
+    std::vector<KVPair> scan(const IterateOptions& options, size_t limit,
+                             const std::optional<std::string>& after = std::nullopt) const;
+    std::unique_ptr<TitanIterator> iterate(const IterateOptions& options = {}) const;
+    std::unique_ptr<TitanExporter> exportNdjson(const IterateOptions& options = {}, int compression_level = 0) const;
+    // The write sequence the snapshot was taken at.
+    uint64_t sequence() const;
+
+private:
+    friend class TitanEngine;
+
+    TitanSnapshot(TitanEngine& engine, std::shared_ptr<const StorageSnapshot> snapshot);
+
+    TitanEngine& engine_;
+    std::shared_ptr<const StorageSnapshot> snapshot_;
+};
+
+// NDJSON export of the plain values in a pinned view, one
+// {"key":...,"value":...} object per line in key order. Values that are not
+// valid UTF-8 are written base64-encoded with "encoding":"base64" added.
+// With a compression level the output is a single zstd frame. Each next()
+// reads iterator chunks until about `chunk_bytes` of output are ready, so
+// memory stays bounded however large the keyspace is. Lifetime rules are
+// those of TitanIterator.
+class TitanExporter {
+public:
+    ~TitanExporter();
+
+    TitanExporter(const TitanExporter&) = delete;
+    TitanExporter& operator=(const TitanExporter&) = delete;
+
+    // The next piece of output; empty once everything was returned.
+    std::string next(size_t chunk_bytes);
+    bool done() const { return done_; }
+    uint64_t records() const { return records_; }
+
+private:
+    friend class TitanEngine;
+    friend class TitanSnapshot;
+
+    TitanExporter(std::unique_ptr<TitanIterator> iterator, int compression_level);
+
+    std::unique_ptr<TitanIterator> iterator_;
+    // Null for plain NDJSON.
+    std::unique_ptr<Compressor> compressor_;
+    uint64_t records_ = 0;
+    bool done_ = false;
+};
+
+struct LogEntry;
+enum class WalOp : uint8_t;
 
 class TitanEngine {
 public:
@@ -55,39 +309,168 @@ public:
 
     void put(const std::string& key, const std::string& value, int64_t ttl_ms = 0);
     std::optional<std::string> get(const std::string& key);
+    std::optional<std::string> getRange(const std::string& key, size_t offset, size_t length);
+    std::optional<size_t> valueLength(const std::string& key);
+    std::vector<uint8_t> compressChunk(const std::string& key, const std::string& chunk) const;
+    void putCompressed(const std::string& key, std::vector<uint8_t>&& frames, int64_t ttl_ms = 0);
     bool del(const std::string& key);
     bool has(const std::string& key);
+    bool expire(const std::string& key, int64_t ttl_ms);
+    bool persist(const std::string& key);
+    // Remaining TTL in ms, -1 without expiry, -2 when the key does not exist.
+    int64_t ttl(const std::string& key);
+    size_t purgeExpired(size_t max_keys);
     size_t size() const;
     void clear();
 
     int64_t incr(const std::string& key, int64_t delta = 1);
     int64_t decr(const std::string& key, int64_t delta = 1);
 
+    // Compare-and-set on value versions, checked and applied under one
+    // storage lock. The conditional puts return the new version, or nullopt
+    // when the key's version did not match or the key already exists.
+    VersionedValue getWithVersion(const std::string& key);
+    uint64_t version(const std::string& key) const;
+    std::optional<uint64_t> putIfVersion(const std::string& key, const std::string& value, uint64_t expected_version,
+                                         int64_t ttl_ms = 0);
+    std::optional<uint64_t> putIfAbsent(const std::string& key, const std::string& value, int64_t ttl_ms = 0);
+
+    // Native lists, logged to the WAL as per-operation deltas. lpush keeps
+    // the argument order at the head; indexes may be negative.
+    size_t lpush(const std::string& key, const std::vector<std::string>& values);
+    size_t rpush(const std::string& key, const std::vector<std::string>& values);
+    std::optional<std::string> lpop(const std::string& key);
+    std::optional<std::string> rpop(const std::string& key);
+    size_t llen(const std::string& key) const;
+    std::vector<std::string> lrange(const std::string& key, int64_t start, int64_t stop) const;
+    std::optional<std::string> lindex(const std::string& key, int64_t index) const;
+    bool lset(const std::string& key, int64_t index, const std::string& value);
+
+    // Native sorted sets ordered by (score, member), logged like lists.
+    // Ranks are 0-based; `reverse` counts them from the highest score.
+    using ScoredMember = std::pair<std::string, double>;
+    size_t zadd(const std::string& key, const std::vector<ScoredMember>& members);
+    double zincrby(const std::string& key, const std::string& member, double delta);
+    size_t zrem(const std::string& key, const std::vector<std::string>& members);
+    std::optional<double> zscore(const std::string& key, const std::string& member) const;
+    std::optional<size_t> zrank(const std::string& key, const std::string& member, bool reverse = false) const;
+    size_t zcard(const std::string& key) const;
+    std::vector<ScoredMember> zrange(const std::string& key, int64_t start, int64_t stop, bool reverse = false) const;
+    std::vector<ScoredMember> zrangeByScore(const std::string& key, double min, double max, size_t offset = 0,
+                                            size_t count = std::numeric_limits<size_t>::max(),
+                                            bool reverse = false) const;
+    size_t zcount(const std::string& key, double min, double max) const;
+
+    // Native hashes and sets with field-level WAL records. hincrby throws
+    // when the field does not hold an integer.
+    using FieldValue = std::pair<std::string, std::string>;
+    size_t hset(const std::string& key, const std::vector<FieldValue>& fields);
+    std::optional<std::string> hget(const std::string& key, const std::string& field) const;
+    size_t hdel(const std::string& key, const std::vector<std::string>& fields);
+    size_t hlen(const std::string& key) const;
+    std::vector<FieldValue> hgetall(const std::string& key) const;
+    int64_t hincrby(const std::string& key, const std::string& field, int64_t delta);
+    size_t sadd(const std::string& key, const std::vector<std::string>& members);
+    size_t srem(const std::string& key, const std::vector<std::string>& members);
+    bool sismember(const std::string& key, const std::string& member) const;
+    size_t scard(const std::string& key) const;
+    std::vector<std::string> smembers(const std::string& key) const;
+
     std::vector<std::string> keys(size_t limit = 1000) const;
     std::vector<KVPair> scan(const std::string& prefix, size_t limit = 1000) const;
     std::vector<KVPair> range(const std::string& start, const std::string& end, size_t limit = 1000) const;
+    // Pages of plain values within `options`, in key order or descending
+    // when reversed. Passing the last key of a page as `after` resumes right
+    // past it with a seek, so deep pages cost the same as the first.
+    std::vector<std::string> keys(const IterateOptions& options, size_t limit,
+                                  const std::optional<std::string>& after = std::nullopt) const;
+    std::vector<KVPair> scan(const IterateOptions& options, size_t limit,
+                             const std::optional<std::string>& after = std::nullopt) const;
     size_t countPrefix(const std::string& prefix) const;
 
     void putBatch(const std::vector<KVPair>& pairs);
+    // One result per op. A failing incr is reported in its result and the
+    // other ops still apply; returns nullopt without writing anything if a
+    // watched key has moved past its version.
+    std::optional<std::vector<WriteResult>> write(const WriteBatch& batch);
     std::vector<std::optional<std::string>> getBatch(const std::vector<std::string>& keys);
 
+    // Opens a consistent, chunked cursor over the plain values within
+    // `options`; collections are not included.
+    std::unique_ptr<TitanIterator> iterate(const IterateOptions& options = {});
+    // Pins the current state for repeated consistent reads.
+    std::unique_ptr<TitanSnapshot> snapshot();
+    // Exports a snapshot pinned now; a compression level of 0 writes plain
+    // NDJSON.
+    std::unique_ptr<TitanExporter> exportNdjson(const IterateOptions& options = {}, int compression_level = 0);
+
     void flush();
     void compact();
     void close();
     void setCompressionLevel(int level);
+    void setCompressionPolicies(const std::vector<CompressionPolicy>& policies);
+    void setColdRecompressionPolicy(const ColdRecompressionPolicy& policy);
+    size_t recompressCold();
     void setMaxMemoryBytes(size_t limit_bytes);
+    void setEvictionConfig(const EvictionConfig& config);
+    // Period of the background expiry cycle; 0 leaves expiry to reads.
+    void setActiveExpiryInterval(int64_t interval_ms);
     void setSSTableBloomFilterEnabled(bool enabled);
     void setAutoCompactEnabled(bool enabled);
     void setCompactionPolicy(size_t min_ops, double tombstone_ratio, size_t min_wal_bytes);
 
     StorageStats getStats() const;
 
+    // Writes the live plain values as a new read snapshot generation for
+    // TitanReader instances in other processes and returns its number.
+    // Requires a data directory; collections are not included.
+    uint64_t publishSnapshot();
+
+    // Writes a copy of the database to `dir` that opens like any other data
+    // directory. Writers are held up only while the WAL end is fixed; the
+    // copy is taken afterwards. Checkpointing into the same directory again
+    // appends just what was logged since, unless the WAL was compacted or
+    // reopened in between. Requires a data directory.
+    CheckpointResult checkpoint(const std::string& dir);
+
+    // Adds SSTables written by SSTableWriter. Each file is moved (with
+    // `move`) or copied into <data_dir>/ingest and all of them are committed
+    // by one WAL record naming them, so they become visible together and
+    // their values are never logged or decoded. Ingested values replace the
+    // current ones for the same keys, later files winning over earlier ones.
+    // Returns the number of records added. Requires a data directory.
+    size_t ingest(const std::vector<std::string>& files, bool move = false);
+
+    // Pub/sub shared by every handle on the engine. A subscriber's `wake`
+    // runs on the publishing thread when its queue turns non-empty and must
+    // only schedule a drainMessages() call. Subscriptions matching
+    // __keyspace@0__:<key> or __keyevent@0__:<event> receive set, incrby,
+    // del, expire, persist, expired and evicted events for plain values.
+    // publish() returns the number of messages queued for other subscribers
+    // and leaves `origin`'s own matches in `origin_matches`.
+    uint64_t addSubscriber(std::function<void()> wake);
+    void removeSubscriber(uint64_t subscriber);
+    bool subscribe(uint64_t subscriber, const std::string& channel);
+    bool unsubscribe(uint64_t subscriber, const std::string& channel);
+    size_t publish(const std::string& channel, const std::string& message, uint64_t origin = 0,
+                   std::vector<std::string>* origin_matches = nullptr);
+    std::vector<PubSubMessage> drainMessages(uint64_t subscriber);
+
 private:
+    friend class TitanIterator;
+    friend class TitanSnapshot;
+
     std::unique_ptr<Storage> storage_;
     std::unique_ptr<WAL> wal_;
+    std::unique_ptr<PubSub> pubsub_;
     std::filesystem::path db_path_;
     RecoveryMode recovery_mode_ = RecoveryMode::Permissive;
     CompactionPolicy compaction_policy_{};
+    ColdRecompressionPolicy cold_policy_{};
+    uint32_t cold_dict_id_ = 0;
+    std::mutex cold_mutex_;
+    std::atomic<size_t> cold_recompressed_total_{0};
+    std::atomic<size_t> cold_bytes_saved_total_{0};
     std::atomic<size_t> wal_put_ops_{0};
     std::atomic<size_t> wal_del_ops_{0};
     std::atomic<size_t> wal_bytes_since_compact_{0};
@@ -98,12 +481,99 @@ private:
     std::atomic<bool> compact_in_progress_{false};
     std::thread compaction_thread_;
 
+    int64_t expiry_interval_ms_ = 100;
+    bool expiry_stop_ = false;
+    std::mutex expiry_mutex_;
+    std::condition_variable expiry_cv_;
+    std::thread expiry_thread_;
+    std::mutex publish_mutex_;
+    std::mutex ingest_mutex_;
+    uint64_t ingest_seq_ = 0;
+
+    // Throws once the engine is closed.
+    Storage& openStorage() const;
     void recover();
+    void replayCollectionOp(const LogEntry& entry);
+    void trackCollectionWrite(const std::string& key, const std::vector<uint8_t>& payload);
+    std::function<void()> collectionLog(WalOp op, const std::string& key, const std::vector<uint8_t>& payload);
+    void trackCollectionRemoval(const std::string& key, const std::vector<uint8_t>& payload);
+    void logConditionalPut(const std::string& key, const std::vector<uint8_t>& compressed, size_t raw_size,
+                           int64_t expires_at);
+    size_t pushList(const std::string& key, const std::vector<std::string>& values, bool front);
+    std::optional<std::string> popList(const std::string& key, bool front);
+    void loadDictionaries();
+    void persistDictionary(uint32_t dict_id, const std::string& dictionary);
+    std::vector<uint8_t> compressValue(const std::string& key, const char* data, size_t size) const;
     void writeRecoveryManifestSnapshot();
     void maybeAutoCompact();
     void trackWalActivity(size_t put_ops, size_t del_ops, size_t estimated_bytes);
+    void logReclaimedKeys();
+    void notifyKeyspace(const char* event, const std::string& key);
+    void updateReclaimedKeyRecording();
+    bool logExpiryChange(const std::string& key, int64_t ttl_ms);
+    void expiryLoop();
+    void runExpiryCycle(std::chrono::milliseconds budget);
+    void stopExpiryThread();
     void resetCompactionCountersFromWal();
     void compactInternal(bool auto_triggered = false);
 };
 
+// Read-only view of the snapshot a writer last published with
+// TitanEngine::publishSnapshot(). It memory-maps the file and takes no
+// database lock, so any number of processes can open the directory beside
+// the one writer. Reads see the published state, less keys that have since
+// expired, until refresh() maps a newer generation.
+class TitanReader {
+public:
+    using KVPair = std::pair<std::string, std::string>;
+
+    explicit TitanReader(const std::string& data_dir);
+    ~TitanReader();
+
+    TitanReader(const TitanReader&) = delete;
+    TitanReader& operator=(const TitanReader&) = delete;
+
+    std::optional<std::string> get(const std::string& key) const;
+    bool has(const std::string& key) const;
+    std::vector<std::string> keys(size_t limit = 1000) const;
+    std::vector<KVPair> scan(const std::string& prefix, size_t limit = 1000) const;
+    // Entries in the mapped snapshot, counting any that expired since.
+    size_t size() const;
+    // 0 until the writer has published once.
+    uint64_t generation() const;
+    // Maps the newest generation; returns true when it changed.
+    bool refresh();
+
+private:
+    std::filesystem::path dir_;
+    mutable std::mutex mutex_;
+    std::shared_ptr<const ReadSnapshot> snapshot_;
+
+    std::shared_ptr<const ReadSnapshot> current() const;
+};
+
+// Writes an SSTable for TitanEngine::ingest() without an engine, e.g. from
+// a sorted export. Keys must be added in strictly ascending byte order and
+// values are encoded as the engine stores them. Only the keys are held in
+// memory until finish() writes the index; the file is not valid before.
+class SSTableWriter {
+public:
+    explicit SSTableWriter(const std::string& path, int compression_level = 3);
+    ~SSTableWriter();
+
+    SSTableWriter(const SSTableWriter&) = delete;
+    SSTableWriter& operator=(const SSTableWriter&) = delete;
+
+    // ttl_ms counts from this call, as for TitanEngine::put().
+    void add(const std::string& key, const std::string& value, int64_t ttl_ms = 0);
+    // Returns the number of records written.
+    size_t finish();
+    size_t size() const;
+
+private:
+    std::unique_ptr<SSTableBuilder> builder_;
+    std::unique_ptr<Compressor> compressor_;
+    int compression_level_;
+};
+
 } // namespace titan
@@ -1,8 +1,19 @@
 import { EventEmitter } from 'events';
+import { Readable, Writable } from 'stream';
 
 export interface TitanOptions {
     compressionLevel?: number;
+    /** Native collections count toward `memoryBytes` but are not evicted or held to this budget. */
     maxMemoryBytes?: number;
+    /** What to do once `maxMemoryBytes` is exceeded. Defaults to `'spill'`. */
+    evictionPolicy?: EvictionPolicy;
+    /** Keys sampled per eviction step. Defaults to 5. */
+    evictionSamples?: number;
+    /** Higher values make the LFU counter saturate more slowly. Defaults to 10. */
+    lfuLogFactor?: number;
+    /** Idle minutes per LFU counter decrement; 0 disables decay. Defaults to 1. */
+    lfuDecayMinutes?: number;
+    /** Period of the native expiry cycle in ms; 0 leaves expiry to reads. Defaults to 100. */
     cleanupIntervalMs?: number;
     bloomFilter?: boolean;
     recoverMode?: 'permissive' | 'strict';
@@ -10,7 +21,57 @@ export interface TitanOptions {
     compactMinOps?: number;
     compactTombstoneRatio?: number;
     compactMinWalBytes?: number;
+    externalBuffers?: boolean;
+    compressionPolicies?: CompressionPolicy[];
+    coldRecompress?: ColdRecompressOptions;
+    /** Publish a read snapshot for TitanReader processes every intervalMs. */
+    readSnapshot?: { intervalMs: number };
     sync?: 'sync' | 'async' | 'none';
+    /**
+     * Name under which an in-memory engine is shared with other handles in
+     * this process, including worker_threads. Persistent engines are always
+     * shared by path. Options only apply to the handle that creates it.
+     */
+    shared?: string;
+}
+
+export type BinaryValue = Buffer | Uint8Array;
+
+export type EvictionPolicy = 'spill' | 'allkeys-lru' | 'allkeys-lfu' | 'volatile-ttl';
+
+export interface CompressionPolicy {
+    /** Key prefix the policy applies to; the longest matching prefix wins. */
+    prefix: string;
+    codec?: 'zstd' | 'none';
+    level?: number;
+    /** Trained zstd dictionary bytes. */
+    dictionary?: BinaryValue;
+}
+
+export interface ColdRecompressOptions {
+    /** Idle time after which a value counts as cold (default 10 minutes). */
+    afterMs?: number;
+    /** zstd level for cold values (default 19). */
+    level?: number;
+    /** Train a dictionary from the first cold slice (default false). */
+    trainDictionary?: boolean;
+    /** Entries re-encoded per locked swap (default 512). */
+    batchSize?: number;
+    /** Run a background pass every intervalMs (default: only on compaction). */
+    intervalMs?: number;
+}
+
+export interface ReadStreamOptions {
+    /** First byte offset to read (default 0). */
+    start?: number;
+    /** Exclusive end offset (default: end of value). */
+    end?: number;
+    /** Bytes per emitted chunk (default 1MB). */
+    chunkSize?: number;
+}
+
+export interface WriteStreamOptions {
+    ttl?: number;
 }
 
 export interface TitanStats {
@@ -29,6 +90,15 @@ export interface TitanStats {
     autoCompactionCount: number;
     writeAmplification: number;
     spaceAmplification: number;
+    coldRecompressedCount: number;
+    coldBytesSaved: number;
+    memoryBytes: number;
+    memtableBytes: number;
+    tombstoneBytes: number;
+    sstableIndexBytes: number;
+    collectionBytes: number;
+    evictedKeys: number;
+    evictedBytes: number;
 }
 
 export interface ImportOptions {
@@ -45,6 +115,71 @@ export interface ExportOptions {
     limit?: number;
 }
 
+export interface ExportStreamOptions {
+    prefix?: string;
+    /** Inclusive bounds. */
+    start?: string;
+    end?: string;
+    reverse?: boolean;
+    /** zstd-compress the output; `true` uses level 3. */
+    compress?: boolean | number;
+    /** Target size of each chunk (default 64 KiB). */
+    chunkBytes?: number;
+}
+
+/**
+ * One line per value: `{"key":...,"value":...}`. Values that are not valid
+ * UTF-8 carry `"encoding":"base64"`.
+ */
+export interface ExportStream extends Readable {
+    /** Set once the stream has ended. */
+    readonly records: number;
+    /** Output bytes pushed so far. */
+    readonly bytes: number;
+}
+
+export interface ExportResult {
+    records: number;
+    bytes: number;
+}
+
+export interface CheckpointResult {
+    /** WAL bytes the checkpoint holds. */
+    walBytes: number;
+    /** Bytes written this time; less than walBytes when an earlier checkpoint was extended. */
+    copiedBytes: number;
+}
+
+export interface PageOptions {
+    /** Default 1000. */
+    limit?: number;
+    /** Last key of the previous page; the page starts right past it. */
+    after?: string;
+    /** Descending key order. */
+    reverse?: boolean;
+}
+
+export interface IterateOptions {
+    prefix?: string;
+    /** Inclusive bounds. */
+    start?: string;
+    end?: string;
+    reverse?: boolean;
+    /** Entries read per native call (default 256). */
+    batchSize?: number;
+    asBuffer?: boolean;
+}
+
+/**
+ * Pages through a consistent snapshot in fixed-size chunks; writes made after
+ * it was created are not seen. Iterating to the end, breaking out of the loop
+ * or calling return() releases the snapshot.
+ */
+export interface Cursor<V> extends AsyncIterableIterator<[string, V]> {
+    return(): Promise<IteratorResult<[string, V]>>;
+    [Symbol.iterator](): Iterator<[string, V]>;
+}
+
 export interface ScanResult {
     cursor: number;
     entries: [string, string][];
@@ -64,8 +199,13 @@ export interface ZRangeByScoreOptions extends ZRangeOptions {
     limit?: { offset: number; count: number };
 }
 
+export interface VersionedValue {
+    value: string | null;
+    version: number;
+}
+
 export class Transaction {
-    put(key: string, value: string, ttl?: number): this;
+    put(key: string, value: string | BinaryValue, ttl?: number): this;
     get(key: string): this;
     del(key: string): this;
     incr(key: string, delta?: number): this;
@@ -75,7 +215,13 @@ export class Transaction {
     rpush(key: string, ...values: string[]): this;
     sadd(key: string, ...members: string[]): this;
     zadd(key: string, ...args: (number | string)[]): this;
-    exec(): unknown[];
+    /**
+     * Null when a watched key changed since `watch()`; nothing is run then.
+     * A failing command gets an `Error` in its result slot and the others
+     * still run. Queues of only put/del/incr/decr are applied atomically,
+     * with the watched versions checked under the same lock.
+     */
+    exec(): unknown[] | null;
     discard(): string;
     readonly length: number;
 }
@@ -84,11 +230,26 @@ export class TitanKV extends EventEmitter {
     constructor(dataDir?: string, options?: TitanOptions);
 
     // Core
-    put(key: string, value: string, ttlMs?: number): void;
-    putAsync(key: string, value: string, ttlMs?: number): Promise<void>;
+    put(key: string, value: string | BinaryValue, ttlMs?: number): void;
+    putAsync(key: string, value: string | BinaryValue, ttlMs?: number): Promise<void>;
     get(key: string): string | null;
     getAsync(key: string): Promise<string | null>;
+    getBuffer(key: string): Buffer | null;
+    getBufferAsync(key: string): Promise<Buffer | null>;
     del(key: string): boolean;
+
+    // Large Values
+    getRange(key: string, offset: number, length: number): string | null;
+    getRangeBuffer(key: string, offset: number, length: number): Buffer | null;
+    getRangeAsync(key: string, offset: number, length: number): Promise<string | null>;
+    strlen(key: string): number;
+    createReadStream(key: string, opts?: ReadStreamOptions): Readable;
+    /**
+     * Compresses incoming data one frame at a time and commits the value in one
+     * write on finish; the compressed frames are held in memory until then.
+     */
+    createWriteStream(key: string, opts?: WriteStreamOptions): Writable;
+
     exists(key: string): boolean;
     dbsize(): number;
     rename(oldKey: string, newKey: string): string;
@@ -102,22 +263,34 @@ export class TitanKV extends EventEmitter {
     incr(key: string, delta?: number): number;
     decr(key: string, delta?: number): number;
 
+    // Versions (compare-and-set)
+    getWithVersion(key: string): VersionedValue;
+    /** Writes only if the key is still at `version`; returns the new version or null. */
+    putIfVersion(key: string, value: string | BinaryValue, version: number, ttlMs?: number): number | null;
+    /** Writes only if the key does not exist; returns the new version or null. */
+    putIfAbsent(key: string, value: string | BinaryValue, ttlMs?: number): number | null;
+    watch(...keys: string[]): string;
+    unwatch(): string;
+
     // Query
-    keys(limit?: number): string[];
-    keysAsync(limit?: number): Promise<string[]>;
-    scan(prefix: string, limit?: number): [string, string][];
-    scanAsync(prefix: string, limit?: number): Promise<[string, string][]>;
-    range(start: string, end: string, limit?: number): [string, string][];
-    rangeAsync(start: string, end: string, limit?: number): Promise<[string, string][]>;
+    keys(limit?: number | PageOptions): string[];
+    keysAsync(limit?: number | PageOptions): Promise<string[]>;
+    scan(prefix: string, limit?: number | PageOptions): [string, string][];
+    scanAsync(prefix: string, limit?: number | PageOptions): Promise<[string, string][]>;
+    /** `start` and `end` are inclusive. */
+    range(start: string, end: string, limit?: number | PageOptions): [string, string][];
+    rangeAsync(start: string, end: string, limit?: number | PageOptions): Promise<[string, string][]>;
     countPrefix(prefix: string): number;
     countPrefixAsync(prefix: string): Promise<number>;
     keysMatch(pattern: string, limit?: number): string[];
 
     // Batch
-    putBatch(pairs: [string, string][]): void;
-    putBatchAsync(pairs: [string, string][]): Promise<void>;
+    putBatch(pairs: [string, string | BinaryValue][]): void;
+    putBatchAsync(pairs: [string, string | BinaryValue][]): Promise<void>;
     getBatch(keys: string[]): (string | null)[];
     getBatchAsync(keys: string[]): Promise<(string | null)[]>;
+    getBatchBuffer(keys: string[]): (Buffer | null)[];
+    getBatchBufferAsync(keys: string[]): Promise<(Buffer | null)[]>;
 
     // TTL
     expire(key: string, ttlMs: number): boolean;
@@ -126,19 +299,33 @@ export class TitanKV extends EventEmitter {
 
     // Cursor-based scan
     sscan(prefix: string, cursor: number, count?: number): ScanResult;
-    iterate(prefix?: string, batchSize?: number): IterableIterator<[string, string]>;
+    /** Cursor over a snapshot of the plain values taken now. */
+    iterate(options?: IterateOptions): Cursor<string>;
+    iterate(options: IterateOptions & { asBuffer: true }): Cursor<Buffer>;
+    iterate(prefix?: string, batchSize?: number): Cursor<string>;
+    /** Pins the current state for consistent reads until released. */
+    snapshot(): Snapshot;
 
     // JSON
     importJSON(filePath: string, opts?: ImportOptions): number;
     importJSONStream(filePath: string, opts?: StreamImportOptions): Promise<number>;
     exportJSON(filePath?: string | null, opts?: ExportOptions): Record<string, unknown>;
+    /** Streams a snapshot as NDJSON lines of `{ key, value }`, encoded natively off the event loop. */
+    exportStream(opts?: ExportStreamOptions): ExportStream;
+    exportNDJSON(target: string | number | Writable, opts?: ExportStreamOptions): Promise<ExportResult>;
 
     // Transactions
     multi(): Transaction;
 
     // Pub/Sub
+    /**
+     * Channels containing `*` are glob patterns (`*`, `?`). Keyspace
+     * notifications arrive on `__keyspace@0__:<key>` (message: event) and
+     * `__keyevent@0__:<event>` (message: key).
+     */
     subscribe(channel: string, listener: (message: string, channel: string) => void): this;
     unsubscribe(channel: string, listener?: (message: string, channel: string) => void): this;
+    /** Listeners reached on this handle plus messages queued for other handles. */
     publish(channel: string, message: string): number;
 
     // List (Redis-like)
@@ -179,9 +366,12 @@ export class TitanKV extends EventEmitter {
     zscore(key: string, member: string): number | null;
     zcard(key: string): number;
     zrank(key: string, member: string): number | null;
+    zrevrank(key: string, member: string): number | null;
     zrange(key: string, start: number, stop: number, opts?: ZRangeOptions): string[] | ZMember[];
     zrevrange(key: string, start: number, stop: number, opts?: ZRangeOptions): string[] | ZMember[];
     zrangebyscore(key: string, min: number | '-inf', max: number | '+inf', opts?: ZRangeByScoreOptions): string[] | ZMember[];
+    /** Highest scores first; `max` comes before `min` as in Redis. */
+    zrevrangebyscore(key: string, max: number | '+inf', min: number | '-inf', opts?: ZRangeByScoreOptions): string[] | ZMember[];
     zincrby(key: string, increment: number, member: string): number;
     zcount(key: string, min: number | '-inf', max: number | '+inf'): number;
 
@@ -190,6 +380,23 @@ export class TitanKV extends EventEmitter {
     flushAsync(): Promise<void>;
     compact(): void;
     compactAsync(): Promise<void>;
+    recompressCold(): number;
+    recompressColdAsync(): Promise<number>;
+
+    // Read snapshots
+    /** Writes the live plain values for TitanReader; returns the generation. */
+    publishSnapshot(): number;
+    publishSnapshotAsync(): Promise<number>;
+
+    // Backups
+    /** Consistent copy in `dir` that opens as a database; requires a path. */
+    checkpoint(dir: string): CheckpointResult;
+    checkpointAsync(dir: string): Promise<CheckpointResult>;
+
+    // Bulk load
+    /** Adds SSTables built with SSTableWriter atomically; returns the records added. */
+    ingest(files: string[], options?: IngestOptions): number;
+    ingestAsync(files: string[], options?: IngestOptions): Promise<number>;
 
     // Stats
     stats(): TitanStats;
@@ -197,3 +404,68 @@ export class TitanKV extends EventEmitter {
     // Lifecycle
     close(): void;
 }
+
+/**
+ * Point-in-time view of the plain values: reads and cursors see the data as
+ * of `db.snapshot()` without it being copied. The engine keeps versions
+ * overwritten meanwhile until `release()`; `clear()` invalidates it.
+ */
+export interface Snapshot {
+    readonly sequence: number;
+    get(key: string): string | null;
+    getBuffer(key: string): Buffer | null;
+    has(key: string): boolean;
+    keys(limit?: number | PageOptions): string[];
+    scan(prefix: string, limit?: number | PageOptions): [string, string][];
+    range(start: string, end: string, limit?: number | PageOptions): [string, string][];
+    iterate(options?: IterateOptions): Cursor<string>;
+    iterate(options: IterateOptions & { asBuffer: true }): Cursor<Buffer>;
+    exportStream(opts?: ExportStreamOptions): ExportStream;
+    exportNDJSON(target: string | number | Writable, opts?: ExportStreamOptions): Promise<ExportResult>;
+    release(): void;
+}
+
+export interface IngestOptions {
+    /** Move the files into the database instead of copying them. */
+    move?: boolean;
+}
+
+export interface SSTableWriterOptions {
+    /** zstd level for the values (default 3). */
+    compressionLevel?: number;
+}
+
+export class SSTableWriter {
+    constructor(path: string, options?: SSTableWriterOptions);
+
+    /** Keys must be added in strictly ascending byte order. */
+    add(key: string, value: string | Buffer, ttl?: number): void;
+    size(): number;
+    /** Writes the index; returns the record count. The file is usable afterwards. */
+    finish(): number;
+}
+
+export interface TitanReaderOptions {
+    /** How often to look for a newer generation; 0 disables (default 1000). */
+    refreshIntervalMs?: number;
+}
+
+/**
+ * Read-only view of the snapshot published by the process that owns `path`.
+ * Takes no database lock, so any number of processes can open it.
+ */
+export class TitanReader {
+    constructor(path: string, options?: TitanReaderOptions);
+
+    get(key: string): string | null;
+    getBuffer(key: string): Buffer | null;
+    has(key: string): boolean;
+    keys(limit?: number): string[];
+    scan(prefix: string, limit?: number): [string, string][];
+    size(): number;
+    /** 0 until the writer has published once. */
+    generation(): number;
+    /** Maps the newest generation; true when it changed. */
+    refresh(): boolean;
+    close(): void;
+}
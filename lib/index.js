@@ -4,6 +4,7 @@ const gyp = require('node-gyp-build');
 const fs = require('fs');
 const { EventEmitter } = require('events');
 const { createReadStream } = require('fs');
+const { Readable, Writable, pipeline } = require('stream');
 const native = gyp(require('path').join(__dirname, '..'));
 
 const LIST_PREFIX = '\x00L:';
@@ -11,58 +12,58 @@ const SET_PREFIX = '\x00S:';
 const HASH_PREFIX = '\x00H:';
 const ZSET_PREFIX = '\x00Z:';
 
+// Matches Compressor::kFrameBytes so every streamed chunk becomes one
+// independently decodable zstd frame.
+const STREAM_FRAME_BYTES = 1024 * 1024;
+
 class TitanKV extends EventEmitter {
     constructor(path, opts) {
         super();
-        if (path) {
-            this._db = new native.TitanKV(path, opts || {});
-        } else {
-            this._db = new native.TitanKV();
-        }
+        this._db = new native.TitanKV(path || null, opts || {});
         this._ops = 0;
         this._hits = 0;
         this._misses = 0;
         this._subs = new Map();
-        this._ttls = new Map();
-        this._versions = new Map();
         this._watched = new Map();
-        this._cleanupTimer = null;
-
-        const cleanupMs = (opts && opts.cleanupIntervalMs) || 0
-        if (cleanupMs > 0) {
+        // Woken by the engine whenever other handles, worker threads or
+        // keyspace events queued messages for this handle.
+        this._onMessages = () => this._deliverQueued()
+
+        // Cold recompression runs on the libuv pool; the next pass is only
+        // scheduled once the previous one has settled.
+        this._coldTimer = null
+        this._coldIntervalMs = (opts && opts.coldRecompress && opts.coldRecompress.intervalMs) || 0
+        if (this._coldIntervalMs > 0) {
             const self = this
-            ;(function cleanup() {
-                self._purgeExpiredKeys()
-                self._cleanupTimer = setTimeout(cleanup, cleanupMs)
-            }())
+            const schedule = () => {
+                if (self._coldIntervalMs > 0) self._coldTimer = setTimeout(recompress, self._coldIntervalMs)
+            }
+            function recompress() {
+                self._db.recompressColdAsync().then(schedule, schedule)
+            }
+            schedule()
         }
-    }
 
-    _purgeExpiredKeys() {
-        if (!this._ttls || !this._ttls.size) return 0
-        const now = Date.now()
-        let purged = 0
-        const MAX_SCAN = 10000
-        let count = 0
-        for (const [key, deadline] of this._ttls) {
-            if (count++ >= MAX_SCAN) break
-            if (deadline <= now) {
-                this._db.del(key)
-                this._ttls.delete(key)
-                purged++
+        // Read snapshots for TitanReader processes are published the same
+        // way, off the event loop.
+        this._publishTimer = null
+        this._publishIntervalMs = (opts && opts.readSnapshot && opts.readSnapshot.intervalMs) || 0
+        if (this._publishIntervalMs > 0) {
+            const self = this
+            const schedule = () => {
+                if (self._publishIntervalMs > 0) self._publishTimer = setTimeout(publish, self._publishIntervalMs)
+            }
+            function publish() {
+                self._db.publishSnapshotAsync().then(schedule, schedule)
             }
+            publish()
         }
-        return purged
     }
 
     // -- Core --
 
     put(key, value, ttl) {
         this._ops++;
-        if (ttl && ttl > 0) {
-            this._ttls.set(key, Date.now() + ttl);
-        }
-        this._bumpVersion(key)
         return this._db.put(key, value, ttl || 0);
     }
 
@@ -73,17 +74,12 @@ class TitanKV extends EventEmitter {
             this._hits++;
         } else {
             this._misses++;
-            this._ttls.delete(key);
         }
         return val;
     }
 
     async putAsync(key, value, ttl) {
         this._ops++;
-        if (ttl && ttl > 0) {
-            this._ttls.set(key, Date.now() + ttl);
-        }
-        this._bumpVersion(key);
         return this._db.putAsync(key, value, ttl || 0);
     }
 
@@ -94,17 +90,126 @@ class TitanKV extends EventEmitter {
             this._hits++;
         } else {
             this._misses++;
-            this._ttls.delete(key);
         }
         return val;
     }
 
+    getBuffer(key) {
+        this._ops++;
+        const val = this._db.get(key, true);
+        if (val !== null && val !== undefined) {
+            this._hits++;
+        } else {
+            this._misses++;
+        }
+        return val;
+    }
+
+    async getBufferAsync(key) {
+        this._ops++;
+        const val = await this._db.getAsync(key, true);
+        if (val !== null && val !== undefined) {
+            this._hits++;
+        } else {
+            this._misses++;
+        }
+        return val;
+    }
+
+    // -- Large Values --
+
+    getRange(key, offset, length) {
+        this._ops++
+        return this._db.getRange(key, offset, length)
+    }
+
+    getRangeBuffer(key, offset, length) {
+        this._ops++
+        return this._db.getRange(key, offset, length, true)
+    }
+
+    async getRangeAsync(key, offset, length) {
+        this._ops++
+        return this._db.getRangeAsync(key, offset, length)
+    }
+
+    strlen(key) {
+        const len = this._db.valueLength(key)
+        return len === null ? 0 : len
+    }
+
+    createReadStream(key, opts) {
+        const db = this._db
+        const chunkSize = (opts && opts.chunkSize) || STREAM_FRAME_BYTES
+        const end = opts && opts.end !== undefined ? opts.end : Infinity
+        let offset = (opts && opts.start) || 0
+        this._ops++
+
+        return new Readable({
+            read() {
+                const length = Math.min(chunkSize, end - offset)
+                if (length <= 0) {
+                    this.push(null)
+                    return
+                }
+                db.getRangeAsync(key, offset, length, true).then(chunk => {
+                    if (chunk === null) {
+                        this.destroy(new Error('ERR no such key'))
+                        return
+                    }
+                    offset += chunk.length
+                    if (chunk.length > 0) this.push(chunk)
+                    if (chunk.length < length) this.push(null)
+                }, err => this.destroy(err))
+            }
+        })
+    }
+
+    createWriteStream(key, opts) {
+        const self = this
+        const ttl = (opts && opts.ttl) || 0
+        const frames = []
+        let pending = []
+        let pendingBytes = 0
+
+        // Not a streaming write into the engine: the value becomes visible
+        // atomically on finish, so the compressed frames are collected here
+        // and committed together. Raw bytes are held back only until a full
+        // frame is available, so memory is one raw frame plus the compressed
+        // size of the value, which the memtable holds afterwards anyway.
+        const compressPending = () => {
+            const raw = Buffer.concat(pending, pendingBytes)
+            pending = []
+            pendingBytes = 0
+            return self._db.compressChunkAsync(key, raw).then(frame => { frames.push(frame) })
+        }
+
+        return new Writable({
+            write(chunk, encoding, callback) {
+                const buf = Buffer.isBuffer(chunk) ? chunk : Buffer.from(chunk, encoding)
+                pending.push(buf)
+                pendingBytes += buf.length
+                if (pendingBytes < STREAM_FRAME_BYTES) {
+                    callback()
+                    return
+                }
+                compressPending().then(() => callback(), callback)
+            },
+            final(callback) {
+                const tail = pendingBytes > 0 ? compressPending() : Promise.resolve()
+                tail.then(() => {
+                    self._ops++
+                    return self._db.putCompressedAsync(key, frames, ttl)
+                }).then(() => callback(), callback)
+            }
+        })
+    }
+
     del(key) {
         this._ops++;
-        this._ttls.delete(key);
-        this._bumpVersion(key)
 
-        // Clean complex types stored in C++ layer via prefixed internal deletes
+        // Native collections are dropped by the engine's del; the prefixed
+        // keys hold collections written by older versions
         this._db.del(LIST_PREFIX + key)
         this._db.del(SET_PREFIX + key)
         this._db.del(HASH_PREFIX + key)
@@ -116,18 +221,11 @@ class TitanKV extends EventEmitter {
     rename(oldKey, newKey) {
         const val = this.get(oldKey)
         if (val === null || val === undefined) throw new Error('ERR no such key')
-        const ttlDeadline = this._ttls.get(oldKey)
+        const remaining = this._db.ttl(oldKey)
         this._db.del(oldKey)
-        if (ttlDeadline !== undefined) {
-            const remaining = ttlDeadline - Date.now()
-            if (remaining > 0) {
-                this._db.put(newKey, val, remaining)
-                this._ttls.delete(oldKey)
-                this._ttls.set(newKey, ttlDeadline)
-            } else {
-                this._ttls.delete(oldKey)
-            }
-        } else {
+        if (remaining > 0) {
+            this._db.put(newKey, val, remaining)
+        } else if (remaining === -1) {
             this._db.put(newKey, val)
         }
         return 'OK'
@@ -140,10 +238,10 @@ class TitanKV extends EventEmitter {
     type(key) {
         if (!key) throw new Error('type: key required')
         this._ops++
-        if (this._db.has(LIST_PREFIX + key)) return 'list'
-        if (this._db.has(SET_PREFIX + key)) return 'set'
-        if (this._db.has(HASH_PREFIX + key)) return 'hash'
-        if (this._db.has(ZSET_PREFIX + key)) return 'zset'
+        if (this._db.llen(key) > 0 || this._db.has(LIST_PREFIX + key)) return 'list'
+        if (this._db.scard(key) > 0 || this._db.has(SET_PREFIX + key)) return 'set'
+        if (this._db.hlen(key) > 0 || this._db.has(HASH_PREFIX + key)) return 'hash'
+        if (this._db.zcard(key) > 0 || this._db.has(ZSET_PREFIX + key)) return 'zset'
         if (this._db.has(key)) return 'string'
         return 'none'
     }
@@ -171,20 +269,36 @@ class TitanKV extends EventEmitter {
 
     clear() {
         this._ops++;
-        this._ttls.clear();
-        this._versions.clear();
         return this._db.clear();
     }
 
-    _bumpVersion(key) {
-        const cur = this._versions.get(key) || 0
-        this._versions.set(key, cur + 1)
+    // Versions come from the engine, so writes made through any path
+    // (async, batches, streams, other handles) are seen by watch().
+    getWithVersion(key) {
+        this._ops++
+        const result = this._db.getWithVersion(key)
+        if (result.value !== null) {
+            this._hits++
+        } else {
+            this._misses++
+        }
+        return result
+    }
+
+    putIfVersion(key, value, version, ttl) {
+        this._ops++
+        return this._db.putIfVersion(key, value, version, ttl || 0)
+    }
+
+    putIfAbsent(key, value, ttl) {
+        this._ops++
+        return this._db.putIfAbsent(key, value, ttl || 0)
     }
 
     watch(...keys) {
         if (!keys.length) throw new Error('watch: at least one key required')
         for (const k of keys) {
-            this._watched.set(k, this._versions.get(k) || 0)
+            this._watched.set(k, this._db.version(k))
         }
         return 'OK'
     }
@@ -196,44 +310,50 @@ class TitanKV extends EventEmitter {
 
     incr(key, delta) {
         this._ops++;
-        this._bumpVersion(key)
         return this._db.incr(key, delta || 1);
     }
 
     decr(key, delta) {
         this._ops++;
-        this._bumpVersion(key)
         return this._db.decr(key, delta || 1);
     }
 
+    // keys/scan/range take a limit or { limit, after, reverse }; pass the
+    // last key of a page as `after` to fetch the next one.
     keys(limit) {
         this._ops++;
-        return this._db.keys(limit || 1000);
+        const page = _pageOptions(limit)
+        return this._db.keys(page.limit, page);
     }
 
     async keysAsync(limit) {
         this._ops++;
-        return this._db.keysAsync(limit || 1000);
+        const page = _pageOptions(limit)
+        return this._db.keysAsync(page.limit, page);
     }
 
     scan(prefix, limit) {
         this._ops++;
-        return this._db.scan(prefix, limit || 1000);
+        const page = _pageOptions(limit)
+        return this._db.scan(prefix, page.limit, page);
     }
 
     async scanAsync(prefix, limit) {
         this._ops++;
-        return this._db.scanAsync(prefix, limit || 1000);
+        const page = _pageOptions(limit)
+        return this._db.scanAsync(prefix, page.limit, page);
     }
 
     range(start, end, limit) {
         this._ops++;
-        return this._db.range(start, end, limit || 1000);
+        const page = _pageOptions(limit)
+        return this._db.range(start, end, page.limit, page);
     }
 
     async rangeAsync(start, end, limit) {
         this._ops++;
-        return this._db.rangeAsync(start, end, limit || 1000);
+        const page = _pageOptions(limit)
+        return this._db.rangeAsync(start, end, page.limit, page);
     }
 
     countPrefix(prefix) {
@@ -246,6 +366,21 @@ class TitanKV extends EventEmitter {
         return this._db.countPrefixAsync(prefix);
     }
 
+    // Cursor over a snapshot taken now; see Cursor. The older
+    // iterate(prefix, batchSize) form is still accepted.
+    iterate(opts, batchSize) {
+        this._ops++
+        if (opts === undefined || typeof opts === 'string') {
+            opts = { prefix: opts || '', batchSize: batchSize || 100 }
+        }
+        return new Cursor(this._db, opts)
+    }
+
+    // Point-in-time view for consistent reads; see Snapshot.
+    snapshot() {
+        return new Snapshot(this._db)
+    }
+
     putBatch(pairs) {
         this._ops++;
         return this._db.putBatch(pairs);
@@ -253,11 +388,6 @@ class TitanKV extends EventEmitter {
 
     async putBatchAsync(pairs) {
         this._ops++;
-        for (const pair of pairs) {
-            if (Array.isArray(pair) && pair.length >= 1 && typeof pair[0] === 'string') {
-                this._bumpVersion(pair[0]);
-            }
-        }
         return this._db.putBatchAsync(pairs);
     }
 
@@ -271,6 +401,16 @@ class TitanKV extends EventEmitter {
         return this._db.getBatchAsync(keys);
     }
 
+    getBatchBuffer(keys) {
+        this._ops++;
+        return this._db.getBatch(keys, true);
+    }
+
+    async getBatchBufferAsync(keys) {
+        this._ops++;
+        return this._db.getBatchAsync(keys, true);
+    }
+
     flush() {
         return this._db.flush();
     }
@@ -287,40 +427,65 @@ class TitanKV extends EventEmitter {
         return this._db.compactAsync();
     }
 
+    recompressCold() {
+        return this._db.recompressCold()
+    }
+
+    async recompressColdAsync() {
+        return this._db.recompressColdAsync()
+    }
+
+    // -- Read snapshots (multi-process reads) --
+
+    publishSnapshot() {
+        return this._db.publishSnapshot()
+    }
+
+    async publishSnapshotAsync() {
+        return this._db.publishSnapshotAsync()
+    }
+
+    // Consistent copy of the database that opens like any data directory;
+    // repeating it into the same directory only appends new WAL records.
+    checkpoint(dir) {
+        return this._db.checkpoint(dir)
+    }
+
+    async checkpointAsync(dir) {
+        return this._db.checkpointAsync(dir)
+    }
+
+    // -- Bulk load --
+
+    // Adds SSTables built with SSTableWriter in one step; their values are
+    // not rewritten through the WAL. Returns the number of records added.
+    ingest(files, opts) {
+        const count = this._db.ingest(files, !!(opts && opts.move))
+        this._ops += count
+        return count
+    }
+
+    async ingestAsync(files, opts) {
+        const count = await this._db.ingestAsync(files, !!(opts && opts.move))
+        this._ops += count
+        return count
+    }
+
     // -- EXPIRE / TTL on existing keys --
 
     expire(key, ttlMs) {
         this._ops++;
-        if (!this._db.has(key)) return false;
-        const val = this._db.get(key);
-        if (val === null || val === undefined) return false;
-        this._ttls.set(key, Date.now() + ttlMs);
-        this._db.put(key, val, ttlMs);
-        return true;
+        return this._db.expire(key, ttlMs);
     }
 
     ttl(key) {
         this._ops++;
-        const deadline = this._ttls.get(key);
-        if (deadline === undefined) {
-            return this._db.has(key) ? -1 : -2;
-        }
-        const remaining = deadline - Date.now();
-        if (remaining <= 0) {
-            this._ttls.delete(key);
-            return -2;
-        }
-        return remaining;
+        return this._db.ttl(key);
     }
 
     persist(key) {
         this._ops++;
-        if (!this._db.has(key)) return false;
-        const val = this._db.get(key);
-        if (val === null || val === undefined) return false;
-        this._ttls.delete(key);
-        this._db.put(key, val, 0);
-        return true;
+        return this._db.persist(key);
     }
 
     // -- KEYS glob pattern matching --
@@ -347,23 +512,6 @@ class TitanKV extends EventEmitter {
         };
     }
 
-    *iterate(prefix, batchSize) {
-        const step = batchSize || 100
-        const MAX_ITER = 1000000
-        let cursor = 0
-        let rounds = 0
-        while (rounds < MAX_ITER) {
-            rounds++
-            const result = this.sscan(prefix || '', cursor, step)
-            for (const entry of result.entries) {
-                yield entry
-            }
-            if (result.done) break
-            cursor = result.cursor
-        }
-        if (rounds >= MAX_ITER) throw new Error('iterate: safety limit exceeded')
-    }
-
     // -- JSON import/export --
 
     importJSON(filePath, opts) {
@@ -460,6 +608,18 @@ class TitanKV extends EventEmitter {
         return result;
     }
 
+    // NDJSON export that never holds the dataset in memory: a snapshot is
+    // encoded natively on the threadpool, one chunk per read.
+    exportStream(opts) {
+        this._ops++
+        return new ExportStream(this._db, opts)
+    }
+
+    // target: a file path, a file descriptor or a writable stream.
+    async exportNDJSON(target, opts) {
+        return pipeExport(this.exportStream(opts), target)
+    }
+
     // -- MULTI/EXEC transactions --
 
     multi() {
@@ -468,8 +628,13 @@ class TitanKV extends EventEmitter {
 
     // -- Pub/Sub --
 
+    // Subscriptions live in the engine's pub/sub hub, which matches
+    // patterns against a trie and also carries keyspace notifications.
+    // Listeners on this handle are called synchronously by publish();
+    // messages from elsewhere arrive in batches on the event loop.
     subscribe(channel, listener) {
         if (!this._subs.has(channel)) {
+            this._db.subscribe(channel, this._onMessages)
             this._subs.set(channel, new Set());
         }
         this._subs.get(channel).add(listener);
@@ -485,159 +650,150 @@ class TitanKV extends EventEmitter {
         } else {
             subs.clear();
         }
-        if (subs.size === 0) this._subs.delete(channel);
+        if (subs.size === 0) {
+            this._subs.delete(channel);
+            this._db.unsubscribe(channel)
+        }
         this.emit('unsubscribe', channel);
         return this;
     }
 
+    // Returns the number of listeners reached on this handle plus the
+    // messages queued for other handles. Messages leaving this handle are
+    // sent as strings.
     publish(channel, message) {
         this._ops++;
-        const subs = this._subs.get(channel);
-        let count = 0;
-        if (subs) {
-            for (const fn of subs) {
+        const payload = typeof message === 'string' || Buffer.isBuffer(message) ? message : String(message)
+        const { queued, matches } = this._db.publish(channel, payload)
+        let count = queued
+        for (const match of matches) {
+            const listeners = this._subs.get(match)
+            if (!listeners) continue
+            for (const fn of listeners) {
                 fn(message, channel);
                 count++;
             }
         }
-        // pattern-based subscribers
-        for (const [pat, listeners] of this._subs) {
-            if (pat !== channel && pat.includes('*')) {
-                if (_globMatch(pat, channel)) {
-                    for (const fn of listeners) {
-                        fn(message, channel);
-                        count++;
-                    }
-                }
-            }
-        }
         return count;
     }
 
-    // -- List operations (Redis-like) --
-
-    _getList(key) {
-        const raw = this._db.get(LIST_PREFIX + key);
-        if (raw === null || raw === undefined) return [];
-        try { return JSON.parse(raw); } catch { /* tolerate corrupt list data */ return []; }
+    _deliverQueued() {
+        const queued = this._db.drainMessages()
+        for (let i = 0; i < queued.length; i += 3) {
+            const listeners = this._subs.get(queued[i + 2] || queued[i])
+            if (!listeners) continue
+            for (const fn of listeners) fn(queued[i + 1], queued[i])
+        }
     }
 
-    _setList(key, arr) {
-        this._db.put(LIST_PREFIX + key, JSON.stringify(arr));
+    // -- List operations (Redis-like) --
+
+    // Lists live in the native quicklist store. Lists written by older
+    // versions as JSON under LIST_PREFIX are moved over on first touch.
+    _migrateList(key) {
+        if (this._db.llen(key) > 0) return
+        const raw = this._db.get(LIST_PREFIX + key)
+        if (raw === null || raw === undefined) return
+        let items = []
+        try { items = JSON.parse(raw) } catch { /* tolerate corrupt list data */ }
+        if (Array.isArray(items) && items.length > 0) {
+            this._db.rpush(key, items.map(String))
+        }
+        this._db.del(LIST_PREFIX + key)
     }
 
     lpush(key, ...values) {
-        this._ops++;
-        const list = this._getList(key);
-        for (let i = values.length - 1; i >= 0; i--) {
-            list.unshift(values[i]);
-        }
-        this._setList(key, list);
-        return list.length;
+        this._ops++
+        this._migrateList(key)
+        return this._db.lpush(key, values.map(String))
     }
 
     rpush(key, ...values) {
-        this._ops++;
-        const list = this._getList(key);
-        for (const v of values) list.push(v);
-        this._setList(key, list);
-        return list.length;
+        this._ops++
+        this._migrateList(key)
+        return this._db.rpush(key, values.map(String))
     }
 
     lpop(key) {
-        this._ops++;
-        const list = this._getList(key);
-        if (list.length === 0) return null;
-        const val = list.shift();
-        this._setList(key, list);
-        return val;
+        this._ops++
+        this._migrateList(key)
+        return this._db.lpop(key)
     }
 
     rpop(key) {
-        this._ops++;
-        const list = this._getList(key);
-        if (list.length === 0) return null;
-        const val = list.pop();
-        this._setList(key, list);
-        return val;
+        this._ops++
+        this._migrateList(key)
+        return this._db.rpop(key)
     }
 
     llen(key) {
-        this._ops++;
-        return this._getList(key).length;
+        this._ops++
+        this._migrateList(key)
+        return this._db.llen(key)
     }
 
     lrange(key, start, stop) {
-        this._ops++;
-        const list = this._getList(key);
-        if (stop < 0) stop = list.length + stop;
-        return list.slice(start, stop + 1);
+        this._ops++
+        this._migrateList(key)
+        return this._db.lrange(key, start, stop)
     }
 
     lindex(key, index) {
-        this._ops++;
-        const list = this._getList(key);
-        if (index < 0) index = list.length + index;
-        return index >= 0 && index < list.length ? list[index] : null;
+        this._ops++
+        this._migrateList(key)
+        return this._db.lindex(key, index)
     }
 
     lset(key, index, value) {
-        this._ops++;
-        const list = this._getList(key);
-        if (index < 0) index = list.length + index;
-        if (index < 0 || index >= list.length) return false;
-        list[index] = value;
-        this._setList(key, list);
-        return true;
+        this._ops++
+        this._migrateList(key)
+        return this._db.lset(key, index, String(value))
     }
 
     // -- Set operations (Redis-like) --
 
-    _getSet(key) {
-        const raw = this._db.get(SET_PREFIX + key);
-        if (raw === null || raw === undefined) return new Set();
-        try { return new Set(JSON.parse(raw)); } catch { /* tolerate corrupt set data */ return new Set(); }
-    }
-
-    _setSet(key, s) {
-        this._db.put(SET_PREFIX + key, JSON.stringify([...s]));
+    // Sets and hashes live in the native field containers; JSON values
+    // written by older versions are moved over on first touch.
+    _migrateSet(key) {
+        if (this._db.scard(key) > 0) return
+        const raw = this._db.get(SET_PREFIX + key)
+        if (raw === null || raw === undefined) return
+        let members = []
+        try { members = JSON.parse(raw) } catch { /* tolerate corrupt set data */ }
+        if (Array.isArray(members) && members.length > 0) {
+            this._db.sadd(key, members.map(String))
+        }
+        this._db.del(SET_PREFIX + key)
     }
 
     sadd(key, ...members) {
-        this._ops++;
-        const s = this._getSet(key);
-        let added = 0;
-        for (const m of members) {
-            if (!s.has(m)) { s.add(m); added++; }
-        }
-        if (added > 0) this._setSet(key, s);
-        return added;
+        this._ops++
+        this._migrateSet(key)
+        return this._db.sadd(key, members.map(String))
     }
 
     srem(key, ...members) {
-        this._ops++;
-        const s = this._getSet(key);
-        let removed = 0;
-        for (const m of members) {
-            if (s.delete(m)) removed++;
-        }
-        if (removed > 0) this._setSet(key, s);
-        return removed;
+        this._ops++
+        this._migrateSet(key)
+        return this._db.srem(key, members.map(String))
     }
 
     sismember(key, member) {
-        this._ops++;
-        return this._getSet(key).has(member);
+        this._ops++
+        this._migrateSet(key)
+        return this._db.sismember(key, String(member))
     }
 
     smembers(key) {
-        this._ops++;
-        return [...this._getSet(key)];
+        this._ops++
+        this._migrateSet(key)
+        return this._db.smembers(key)
     }
 
     scard(key) {
-        this._ops++;
-        return this._getSet(key).size;
+        this._ops++
+        this._migrateSet(key)
+        return this._db.scard(key)
     }
 
     sunion(...keys) {
@@ -645,7 +801,8 @@ class TitanKV extends EventEmitter {
         this._ops++
         const result = new Set()
         for (const k of keys) {
-            for (const m of this._getSet(k)) result.add(m)
+            this._migrateSet(k)
+            for (const m of this._db.smembers(k)) result.add(m)
         }
         return [...result]
     }
@@ -653,235 +810,192 @@ class TitanKV extends EventEmitter {
     sinter(...keys) {
         if (!keys.length) throw new Error('sinter: at least one key required')
         this._ops++
-        const sets = keys.map(k => this._getSet(k))
-        const smallest = sets.reduce((a, b) => a.size <= b.size ? a : b)
-        const result = []
-        for (const m of smallest) {
-            if (sets.every(s => s.has(m))) result.push(m)
-        }
-        return result
+        for (const k of keys) this._migrateSet(k)
+        const smallest = keys.reduce((a, b) => this._db.scard(a) <= this._db.scard(b) ? a : b)
+        return this._db.smembers(smallest).filter(m => keys.every(k => k === smallest || this._db.sismember(k, m)))
     }
 
     sdiff(key, ...otherKeys) {
         if (!key) throw new Error('sdiff: key required')
         this._ops++
-        const base = this._getSet(key)
-        const others = otherKeys.map(k => this._getSet(k))
-        const result = []
-        for (const m of base) {
-            if (!others.some(s => s.has(m))) result.push(m)
-        }
-        return result
+        this._migrateSet(key)
+        for (const k of otherKeys) this._migrateSet(k)
+        return this._db.smembers(key).filter(m => !otherKeys.some(k => this._db.sismember(k, m)))
     }
 
     // -- Hash operations (Redis-like) --
 
-    _getHash(key) {
-        const raw = this._db.get(HASH_PREFIX + key);
-        if (raw === null || raw === undefined) return {};
-        try { return JSON.parse(raw); } catch { /* tolerate corrupt hash data */ return {}; }
-    }
-
-    _setHash(key, h) {
-        this._db.put(HASH_PREFIX + key, JSON.stringify(h));
+    _migrateHash(key) {
+        if (this._db.hlen(key) > 0) return
+        const raw = this._db.get(HASH_PREFIX + key)
+        if (raw === null || raw === undefined) return
+        let h = {}
+        try { h = JSON.parse(raw) } catch { /* tolerate corrupt hash data */ }
+        if (h && typeof h === 'object') {
+            const fields = Object.keys(h)
+            if (fields.length > 0) this._db.hset(key, fields, fields.map(f => String(h[f])))
+        }
+        this._db.del(HASH_PREFIX + key)
     }
 
     hset(key, field, value) {
-        this._ops++;
-        const h = this._getHash(key);
-        const isNew = !(field in h);
-        h[field] = value;
-        this._setHash(key, h);
-        return isNew ? 1 : 0;
+        this._ops++
+        this._migrateHash(key)
+        return this._db.hset(key, [String(field)], [String(value)])
     }
 
     hmset(key, obj) {
-        this._ops++;
-        const h = this._getHash(key);
-        Object.assign(h, obj);
-        this._setHash(key, h);
+        this._ops++
+        this._migrateHash(key)
+        const fields = Object.keys(obj)
+        this._db.hset(key, fields, fields.map(f => String(obj[f])))
     }
 
     hget(key, field) {
-        this._ops++;
-        const h = this._getHash(key);
-        return field in h ? h[field] : null;
+        this._ops++
+        this._migrateHash(key)
+        return this._db.hget(key, String(field))
     }
 
     hgetall(key) {
-        this._ops++;
-        return this._getHash(key);
+        this._ops++
+        this._migrateHash(key)
+        return this._db.hgetall(key)
     }
 
     hdel(key, ...fields) {
-        this._ops++;
-        const h = this._getHash(key);
-        let count = 0;
-        for (const f of fields) {
-            if (f in h) { delete h[f]; count++; }
-        }
-        if (count > 0) this._setHash(key, h);
-        return count;
+        this._ops++
+        this._migrateHash(key)
+        return this._db.hdel(key, fields.map(String))
     }
 
     hexists(key, field) {
-        this._ops++;
-        return field in this._getHash(key);
+        this._ops++
+        this._migrateHash(key)
+        return this._db.hget(key, String(field)) !== null
     }
 
     hkeys(key) {
-        this._ops++;
-        return Object.keys(this._getHash(key));
+        this._ops++
+        this._migrateHash(key)
+        return Object.keys(this._db.hgetall(key))
     }
 
     hvals(key) {
-        this._ops++;
-        return Object.values(this._getHash(key));
+        this._ops++
+        this._migrateHash(key)
+        return Object.values(this._db.hgetall(key))
     }
 
     hlen(key) {
-        this._ops++;
-        return Object.keys(this._getHash(key)).length;
+        this._ops++
+        this._migrateHash(key)
+        return this._db.hlen(key)
     }
 
     hincrby(key, field, increment) {
-        this._ops++;
-        const h = this._getHash(key);
-        const current = Number(h[field]) || 0;
-        h[field] = String(current + (increment || 1));
-        this._setHash(key, h);
-        return Number(h[field]);
+        this._ops++
+        this._migrateHash(key)
+        return this._db.hincrby(key, String(field), increment || 1)
     }
 
     // -- Sorted Set operations (Redis-like) --
 
-    _getZset(key) {
-        const raw = this._db.get(ZSET_PREFIX + key);
-        if (raw === null || raw === undefined) return [];
-        try { return JSON.parse(raw); } catch { /* tolerate corrupt zset data */ return []; }
-    }
-
-    _setZset(key, arr) {
-        this._db.put(ZSET_PREFIX + key, JSON.stringify(arr));
+    // Sorted sets live in the native skiplist store; JSON zsets written by
+    // older versions are moved over on first touch.
+    _migrateZset(key) {
+        if (this._db.zcard(key) > 0) return
+        const raw = this._db.get(ZSET_PREFIX + key)
+        if (raw === null || raw === undefined) return
+        let entries = []
+        try { entries = JSON.parse(raw) } catch { /* tolerate corrupt zset data */ }
+        if (Array.isArray(entries) && entries.length > 0) {
+            this._db.zadd(key, entries.map(e => String(e[1])), entries.map(e => Number(e[0])))
+        }
+        this._db.del(ZSET_PREFIX + key)
     }
 
     zadd(key, ...args) {
-        this._ops++;
-        const zset = this._getZset(key);
-        let added = 0;
-
+        this._ops++
+        this._migrateZset(key)
+        const members = []
+        const scores = []
         for (let i = 0; i < args.length; i += 2) {
-            const score = Number(args[i]);
-            const member = args[i + 1];
-            const idx = zset.findIndex(e => e[1] === member);
-            if (idx >= 0) {
-                zset[idx][0] = score;
-            } else {
-                zset.push([score, member]);
-                added++;
-            }
+            scores.push(Number(args[i]))
+            members.push(String(args[i + 1]))
         }
-        zset.sort((a, b) => a[0] - b[0] || (a[1] < b[1] ? -1 : a[1] > b[1] ? 1 : 0));
-        this._setZset(key, zset);
-        return added;
+        return this._db.zadd(key, members, scores)
     }
 
     zrem(key, ...members) {
-        this._ops++;
-        const zset = this._getZset(key);
-        const before = zset.length;
-        const filtered = zset.filter(e => !members.includes(e[1]));
-        if (filtered.length < before) {
-            this._setZset(key, filtered);
-        }
-        return before - filtered.length;
+        this._ops++
+        this._migrateZset(key)
+        return this._db.zrem(key, members.map(String))
     }
 
     zscore(key, member) {
-        this._ops++;
-        const zset = this._getZset(key);
-        const entry = zset.find(e => e[1] === member);
-        return entry ? entry[0] : null;
+        this._ops++
+        this._migrateZset(key)
+        return this._db.zscore(key, String(member))
     }
 
     zcard(key) {
-        this._ops++;
-        return this._getZset(key).length;
+        this._ops++
+        this._migrateZset(key)
+        return this._db.zcard(key)
     }
 
     zrank(key, member) {
-        this._ops++;
-        const zset = this._getZset(key);
-        const idx = zset.findIndex(e => e[1] === member);
-        return idx >= 0 ? idx : null;
+        this._ops++
+        this._migrateZset(key)
+        return this._db.zrank(key, String(member), false)
+    }
+
+    zrevrank(key, member) {
+        this._ops++
+        this._migrateZset(key)
+        return this._db.zrank(key, String(member), true)
     }
 
     zrange(key, start, stop, opts) {
-        this._ops++;
-        const zset = this._getZset(key);
-        if (start < 0) start = Math.max(0, zset.length + start);
-        if (stop < 0) stop = zset.length + stop;
-        const slice = zset.slice(start, stop + 1);
-        if (opts && opts.withScores) {
-            return slice.map(e => ({ member: e[1], score: e[0] }));
-        }
-        return slice.map(e => e[1]);
+        this._ops++
+        this._migrateZset(key)
+        return this._db.zrange(key, start, stop, false, !!(opts && opts.withScores))
     }
 
     zrevrange(key, start, stop, opts) {
-        this._ops++;
-        const zset = this._getZset(key);
-        const reversed = [...zset].reverse();
-        if (start < 0) start = Math.max(0, reversed.length + start);
-        if (stop < 0) stop = reversed.length + stop;
-        const slice = reversed.slice(start, stop + 1);
-        if (opts && opts.withScores) {
-            return slice.map(e => ({ member: e[1], score: e[0] }));
-        }
-        return slice.map(e => e[1]);
+        this._ops++
+        this._migrateZset(key)
+        return this._db.zrange(key, start, stop, true, !!(opts && opts.withScores))
     }
 
     zrangebyscore(key, min, max, opts) {
-        this._ops++;
-        const zset = this._getZset(key);
-        const minVal = min === '-inf' ? -Infinity : Number(min);
-        const maxVal = max === '+inf' ? Infinity : Number(max);
-        let filtered = zset.filter(e => e[0] >= minVal && e[0] <= maxVal);
-
-        if (opts && opts.limit) {
-            const offset = opts.limit.offset || 0;
-            const count = opts.limit.count || filtered.length;
-            filtered = filtered.slice(offset, offset + count);
-        }
-        if (opts && opts.withScores) {
-            return filtered.map(e => ({ member: e[1], score: e[0] }));
-        }
-        return filtered.map(e => e[1]);
+        this._ops++
+        this._migrateZset(key)
+        const limit = opts && opts.limit
+        return this._db.zrangeByScore(key, _scoreBound(min), _scoreBound(max),
+            limit ? limit.offset || 0 : 0, limit ? limit.count || 0 : 0, !!(opts && opts.withScores))
+    }
+
+    // Redis argument order: the upper bound comes first.
+    zrevrangebyscore(key, max, min, opts) {
+        this._ops++
+        this._migrateZset(key)
+        const limit = opts && opts.limit
+        return this._db.zrangeByScore(key, _scoreBound(min), _scoreBound(max),
+            limit ? limit.offset || 0 : 0, limit ? limit.count || 0 : 0, !!(opts && opts.withScores), true)
     }
 
     zincrby(key, increment, member) {
-        this._ops++;
-        const zset = this._getZset(key);
-        const idx = zset.findIndex(e => e[1] === member);
-        let newScore;
-        if (idx >= 0) {
-            zset[idx][0] += Number(increment);
-            newScore = zset[idx][0];
-        } else {
-            newScore = Number(increment);
-            zset.push([newScore, member]);
-        }
-        zset.sort((a, b) => a[0] - b[0] || (a[1] < b[1] ? -1 : a[1] > b[1] ? 1 : 0));
-        this._setZset(key, zset);
-        return newScore;
+        this._ops++
+        this._migrateZset(key)
+        return this._db.zincrby(key, String(member), Number(increment))
     }
 
     zcount(key, min, max) {
-        this._ops++;
-        const zset = this._getZset(key);
-        const minVal = min === '-inf' ? -Infinity : Number(min);
-        const maxVal = max === '+inf' ? Infinity : Number(max);
-        return zset.filter(e => e[0] >= minVal && e[0] <= maxVal).length;
+        this._ops++
+        this._migrateZset(key)
+        return this._db.zcount(key, _scoreBound(min), _scoreBound(max))
     }
 
     // -- Stats --
@@ -906,15 +1020,28 @@ class TitanKV extends EventEmitter {
             autoCompactionCount: nativeStats.autoCompactionCount,
             writeAmplification: nativeStats.writeAmplification,
             spaceAmplification: nativeStats.spaceAmplification,
+            coldRecompressedCount: nativeStats.coldRecompressedCount,
+            coldBytesSaved: nativeStats.coldBytesSaved,
+            memoryBytes: nativeStats.memoryBytes,
+            memtableBytes: nativeStats.memtableBytes,
+            tombstoneBytes: nativeStats.tombstoneBytes,
+            sstableIndexBytes: nativeStats.sstableIndexBytes,
+            evictedKeys: nativeStats.evictedKeys,
+            evictedBytes: nativeStats.evictedBytes,
         }
     }
 
     close() {
-        if (this._cleanupTimer) {
-            clearTimeout(this._cleanupTimer)
-            this._cleanupTimer = null
+        this._coldIntervalMs = 0
+        if (this._coldTimer) {
+            clearTimeout(this._coldTimer)
+            this._coldTimer = null
+        }
+        this._publishIntervalMs = 0
+        if (this._publishTimer) {
+            clearTimeout(this._publishTimer)
+            this._publishTimer = null
         }
-        this._ttls.clear()
         this._subs.clear()
         if (this._db && typeof this._db.close === 'function') {
             this._db.close()
@@ -922,6 +1049,272 @@ class TitanKV extends EventEmitter {
     }
 }
 
+// -- Cursor (snapshot iteration) --
+
+// Iterator over the [key, value] pairs visible when it was created. With
+// for-await, chunks of `batchSize` entries are read on the libuv pool only
+// once the previous one is consumed, so memory stays bounded however many
+// keys match; for-of reads the same chunks synchronously.
+class Cursor {
+    constructor(db, opts, snapshot) {
+        this._it = new native.TitanIterator(db, opts, snapshot)
+        this._batchSize = opts.batchSize || 256
+        this._asBuffer = !!opts.asBuffer
+        this._buffer = []
+        this._pos = 0
+        this._pending = null
+        // Set once the native side has nothing more to read.
+        this._exhausted = false
+    }
+
+    async next() {
+        while (this._pos === this._buffer.length) {
+            if (this._exhausted) return { done: true, value: undefined }
+            // Calls made while a chunk is in flight wait for the same one.
+            if (!this._pending) this._pending = this._fill()
+            await this._pending
+        }
+        return { done: false, value: this._buffer[this._pos++] }
+    }
+
+    async _fill() {
+        try {
+            const chunk = await this._it.nextAsync(this._batchSize, this._asBuffer)
+            if (this._exhausted) return
+            this._buffer = chunk
+            this._pos = 0
+            if (chunk.length < this._batchSize) this._release()
+        } catch (err) {
+            this._release()
+            throw err
+        } finally {
+            this._pending = null
+        }
+    }
+
+    _release() {
+        if (!this._exhausted) {
+            this._exhausted = true
+            this._it.close()
+        }
+    }
+
+    // Releases the snapshot; called by for-await on break and on errors.
+    async return() {
+        this._release()
+        this._buffer = []
+        this._pos = 0
+        return { done: true, value: undefined }
+    }
+
+    [Symbol.asyncIterator]() {
+        return this
+    }
+
+    *[Symbol.iterator]() {
+        try {
+            while (true) {
+                while (this._pos < this._buffer.length) yield this._buffer[this._pos++]
+                if (this._exhausted) return
+                this._buffer = this._it.next(this._batchSize, this._asBuffer)
+                this._pos = 0
+                if (this._buffer.length < this._batchSize) this._release()
+            }
+        } finally {
+            this.return()
+        }
+    }
+}
+
+// -- Snapshot (point-in-time reads) --
+
+// Pins the engine's current state without copying it: every read and cursor
+// from the snapshot sees the data as of snapshot(), whatever is written
+// meanwhile. Release it when done, since the engine keeps the versions it
+// could still read until then.
+class Snapshot {
+    constructor(db) {
+        this._db = db
+        this._snap = new native.TitanSnapshot(db)
+    }
+
+    get(key) {
+        return this._snap.get(key)
+    }
+
+    getBuffer(key) {
+        return this._snap.get(key, true)
+    }
+
+    has(key) {
+        return this._snap.has(key)
+    }
+
+    keys(limit) {
+        const page = _pageOptions(limit)
+        return this._snap.keys(page.limit, page)
+    }
+
+    scan(prefix, limit) {
+        const page = _pageOptions(limit)
+        return this._snap.scan(prefix, page.limit, page)
+    }
+
+    range(start, end, limit) {
+        const page = _pageOptions(limit)
+        return this._snap.range(start, end, page.limit, page)
+    }
+
+    iterate(opts) {
+        return new Cursor(this._db, opts || {}, this._snap)
+    }
+
+    exportStream(opts) {
+        return new ExportStream(this._db, opts, this._snap)
+    }
+
+    async exportNDJSON(target, opts) {
+        return pipeExport(this.exportStream(opts), target)
+    }
+
+    // The engine write sequence the snapshot pins.
+    get sequence() {
+        return this._snap.sequence()
+    }
+
+    release() {
+        this._snap.release()
+    }
+}
+
+// -- TitanReader (read snapshots) --
+
+// Lock-free, read-only view of the snapshot the process owning `path`
+// publishes, for cluster workers and other processes beside the writer.
+class TitanReader {
+    constructor(path, opts) {
+        this._reader = new native.TitanReader(path)
+        this._refreshTimer = null
+
+        const refreshMs = opts && opts.refreshIntervalMs !== undefined ? opts.refreshIntervalMs : 1000
+        if (refreshMs > 0) {
+            this._refreshTimer = setInterval(() => {
+                try { this._reader.refresh() } catch { /* keep serving the mapped generation */ }
+            }, refreshMs)
+            this._refreshTimer.unref()
+        }
+    }
+
+    get(key) {
+        return this._reader.get(key)
+    }
+
+    getBuffer(key) {
+        return this._reader.get(key, true)
+    }
+
+    has(key) {
+        return this._reader.has(key)
+    }
+
+    keys(limit) {
+        return this._reader.keys(limit || 1000)
+    }
+
+    scan(prefix, limit) {
+        return this._reader.scan(prefix, limit || 1000)
+    }
+
+    size() {
+        return this._reader.size()
+    }
+
+    generation() {
+        return this._reader.generation()
+    }
+
+    refresh() {
+        return this._reader.refresh()
+    }
+
+    close() {
+        if (this._refreshTimer) {
+            clearInterval(this._refreshTimer)
+            this._refreshTimer = null
+        }
+        this._reader.close()
+    }
+}
+
+// -- NDJSON export --
+
+// Readable over a native exporter. Node asks for the next chunk only once
+// the previous one was pushed, so at most one chunk is encoded at a time
+// and a slow consumer holds the export back. `compress` (true or a zstd
+// level) turns the output into a single zstd frame.
+class ExportStream extends Readable {
+    constructor(db, opts, snapshot) {
+        const options = opts || {}
+        super({ highWaterMark: options.chunkBytes || 64 * 1024 })
+        const compressionLevel = options.compress === true ? 3 : (options.compress || 0)
+        this._exporter = new native.TitanExporter(db, { ...options, compressionLevel }, snapshot)
+        this._chunkBytes = options.chunkBytes || 64 * 1024
+        this.records = 0
+        this.bytes = 0
+    }
+
+    _read() {
+        this._exporter.nextAsync(this._chunkBytes).then(chunk => {
+            if (chunk.length === 0) {
+                this.records = this._exporter.records()
+                this._exporter.close()
+                this.push(null)
+                return
+            }
+            this.bytes += chunk.length
+            this.push(chunk)
+        }, err => this.destroy(err))
+    }
+
+    _destroy(err, callback) {
+        this._exporter.close()
+        callback(err)
+    }
+}
+
+function pipeExport(source, target) {
+    let sink = target
+    if (typeof target === 'string') sink = fs.createWriteStream(target)
+    else if (typeof target === 'number') sink = fs.createWriteStream(null, { fd: target, autoClose: false })
+    return new Promise((resolve, reject) => {
+        pipeline(source, sink, err => {
+            if (err) reject(err)
+            else resolve({ records: source.records, bytes: source.bytes })
+        })
+    })
+}
+
+// -- Offline SSTable builder --
+
+class SSTableWriter {
+    constructor(path, opts) {
+        this._writer = new native.SSTableWriter(path, (opts && opts.compressionLevel) || 3)
+    }
+
+    // Keys must arrive in strictly ascending byte order.
+    add(key, value, ttl) {
+        this._writer.add(key, value, ttl || 0)
+    }
+
+    size() {
+        return this._writer.size()
+    }
+
+    finish() {
+        return this._writer.finish()
+    }
+}
+
 // -- Transaction (MULTI/EXEC) --
 
 class Transaction {
@@ -980,7 +1373,42 @@ class Transaction {
         return this;
     }
 
+    // Returns null without running anything when a key passed to watch()
+    // was written since; either way the watched keys are released. A failing
+    // command is returned as an Error in its result slot and the others
+    // still run, whether or not the queue goes out as one write batch.
     exec() {
+        const watches = [...this._db._watched]
+        this._db._watched.clear()
+
+        // Plain puts, deletes and counters go to the engine as one WriteBatch:
+        // one lock acquisition, one WAL record, all-or-nothing on a crash.
+        // The watched versions are checked under that same lock.
+        if (this._queue.length > 0 && this._queue.every(cmd => BATCH_OPS.has(cmd.op))) {
+            const queue = this._queue.splice(0)
+            this._db._ops++
+            const results = this._db._db.writeBatch(queue.map(_batchOp), watches)
+            if (results === null) return null
+
+            // Collections written by older versions live under prefixed keys
+            // outside the batch; dropping them is idempotent
+            for (const cmd of queue) {
+                if (cmd.op !== 'del') continue
+                const key = cmd.args[0]
+                this._db._db.del(LIST_PREFIX + key)
+                this._db._db.del(SET_PREFIX + key)
+                this._db._db.del(HASH_PREFIX + key)
+                this._db._db.del(ZSET_PREFIX + key)
+            }
+            return results
+        }
+
+        // Other commands run one by one after the versions are checked, so
+        // a write landing while they run is not detected.
+        if (watches.length > 0 && this._db._db.writeBatch([], watches) === null) {
+            this._queue.length = 0
+            return null
+        }
         const results = [];
         for (const cmd of this._queue) {
             try {
@@ -996,6 +1424,7 @@ class Transaction {
 
     discard() {
         this._queue.length = 0;
+        this._db._watched.clear()
         return 'OK';
     }
 
@@ -1035,4 +1464,29 @@ function _globMatch(pattern, str) {
     return pIndex === pattern.length;
 }
 
-module.exports = { TitanKV, Transaction };
+// Transaction commands that map onto native WriteBatch operations.
+const BATCH_OPS = new Set(['put', 'del', 'incr', 'decr'])
+
+function _batchOp(cmd) {
+    const [key, arg, ttl] = cmd.args
+    if (cmd.op === 'put') return ['put', key, arg, ttl || 0]
+    if (cmd.op === 'del') return ['del', key]
+    return ['incr', key, cmd.op === 'decr' ? -(arg || 1) : (arg || 1)]
+}
+
+// Accepts Redis-style '-inf'/'+inf' score bounds.
+function _scoreBound(value) {
+    if (value === '-inf') return -Infinity
+    if (value === '+inf') return Infinity
+    return Number(value)
+}
+
+// Normalizes the limit-or-options argument of keys/scan/range.
+function _pageOptions(arg) {
+    if (arg && typeof arg === 'object') {
+        return { limit: arg.limit || 1000, after: arg.after, reverse: !!arg.reverse }
+    }
+    return { limit: arg || 1000 }
+}
+
+module.exports = { TitanKV, TitanReader, SSTableWriter, Transaction };
@@ -1,19 +1,34 @@
 const debug = require('debug')('titankv:nextjs-cache')
 
+const DEFAULT_MAX_MEMORY_BYTES = 64 * 1024 * 1024
+
 class NextJSTitanKVCache {
   /**
    * Next.js Custom Cache Handler implemented via TitanKV.
    * Enables caching Data Fetching and ISR payload in TitanKV naturally.
    *
+   * Next.js constructs the handler itself, so without `client` it opens its
+   * own bounded instance: LFU eviction under `maxMemoryBytes`, persisted to
+   * `dir` when set.
+   *
    * @param {Object} options
-   * @param {Object} options.client TitanKV instance
+   * @param {Object} options.client TitanKV instance (optional)
    * @param {string} options.prefix Prefix to separate Next.js cache from other keys (defaults to 'nextcache:')
+   * @param {string} options.dir Data directory for the owned instance (defaults to TITAN_CACHE_DIR)
+   * @param {number} options.maxMemoryBytes Memory budget for the owned instance (defaults to TITAN_CACHE_MAX_BYTES or 64MB)
    */
   constructor(options) {
     const opts = options || {}
-    if (!opts.client) throw new Error('TitanKV client instance is required in options')
 
-    this.client = opts.client
+    if (opts.client) {
+      this.client = opts.client
+    } else {
+      const { TitanKV } = require('./index')
+      const dir = opts.dir || process.env.TITAN_CACHE_DIR || null
+      const maxMemoryBytes = opts.maxMemoryBytes ||
+        Number(process.env.TITAN_CACHE_MAX_BYTES) || DEFAULT_MAX_MEMORY_BYTES
+      this.client = new TitanKV(dir, { maxMemoryBytes, evictionPolicy: 'allkeys-lfu' })
+    }
     this.prefix = opts.prefix == null ? 'nextcache:' : opts.prefix
 
     debug('NextJSTitanKVCache initialized with prefix %s', this.prefix)
@@ -1,26 +1,250 @@
 #include <napi.h>
 #include "titankv.hpp"
+#include <algorithm>
+#include <atomic>
+#include <filesystem>
+#include <functional>
+#include <limits>
 #include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <unordered_map>
 #include <vector>
 
+namespace {
+
+// Values may arrive as strings (UTF-8) or as Buffer/Uint8Array views; binary
+// payloads are copied byte-for-byte without any transcoding.
+std::string readValueBytes(const Napi::Value& value) {
+    if (value.IsTypedArray()) {
+        Napi::TypedArray view = value.As<Napi::TypedArray>();
+        Napi::ArrayBuffer backing = view.ArrayBuffer();
+        const char* data = static_cast<const char*>(backing.Data()) + view.ByteOffset();
+        return std::string(data, view.ByteLength());
+    }
+    return value.As<Napi::String>().Utf8Value();
+}
+
+// With external buffers the engine-owned bytes are handed to V8 as-is and freed
+// by the finalizer, so large values never get copied into the JS heap.
+Napi::Value makeValue(Napi::Env env, std::string&& bytes, bool as_buffer, bool external) {
+    if (!as_buffer) {
+        return Napi::String::New(env, bytes);
+    }
+    if (!external || bytes.empty()) {
+        return Napi::Buffer<char>::Copy(env, bytes.data(), bytes.size());
+    }
+
+    auto* owned = new std::string(std::move(bytes));
+    return Napi::Buffer<char>::New(
+        env,
+        owned->data(),
+        owned->size(),
+        [](Napi::Env, char*, std::string* hint) { delete hint; },
+        owned);
+}
+
+bool readFlag(const Napi::CallbackInfo& info, size_t index) {
+    return info.Length() > index && info[index].IsBoolean() && info[index].As<Napi::Boolean>().Value();
+}
+
+bool readAsBuffer(const Napi::CallbackInfo& info, size_t index) {
+    return readFlag(info, index);
+}
+
+std::vector<std::string> readValueArray(const Napi::Value& value) {
+    std::vector<std::string> values;
+    if (!value.IsArray()) return values;
+    Napi::Array arr = value.As<Napi::Array>();
+    values.reserve(arr.Length());
+    for (uint32_t i = 0; i < arr.Length(); i++) {
+        values.push_back(readValueBytes(arr.Get(i)));
+    }
+    return values;
+}
+
+// Optional { after, reverse } argument of keys/scan/range: `after` resumes
+// past the last key of the previous page.
+void readPageOptions(const Napi::CallbackInfo& info, size_t index, titan::IterateOptions& options,
+                     std::optional<std::string>& after) {
+    if (info.Length() <= index || !info[index].IsObject()) return;
+    Napi::Object opts = info[index].As<Napi::Object>();
+    if (opts.Has("after") && opts.Get("after").IsString()) after = opts.Get("after").As<Napi::String>().Utf8Value();
+    if (opts.Has("reverse") && opts.Get("reverse").IsBoolean()) {
+        options.reverse = opts.Get("reverse").As<Napi::Boolean>().Value();
+    }
+}
+
+Napi::Value makeOptionalString(Napi::Env env, const std::optional<std::string>& value) {
+    return value.has_value() ? Napi::String::New(env, *value) : env.Null();
+}
+
+// Plain members, or { member, score } objects when withScores is set.
+Napi::Array makeScoredMembers(Napi::Env env, const std::vector<titan::TitanEngine::ScoredMember>& members,
+                              bool with_scores) {
+    Napi::Array arr = Napi::Array::New(env, members.size());
+    for (size_t i = 0; i < members.size(); i++) {
+        if (with_scores) {
+            Napi::Object entry = Napi::Object::New(env);
+            entry.Set("member", Napi::String::New(env, members[i].first));
+            entry.Set("score", Napi::Number::New(env, members[i].second));
+            arr.Set(i, entry);
+        } else {
+            arr.Set(i, Napi::String::New(env, members[i].first));
+        }
+    }
+    return arr;
+}
+
+// Engines that worker_threads isolates share: every persistent engine, keyed
+// by its canonical path, and in-memory engines opened with a `shared` name.
+// Entries are weak, so an engine closes when its last handle is closed or
+// collected. The registry is never destroyed because handles can still be
+// finalized during process teardown.
+struct EngineRegistry {
+    std::mutex mutex;
+    std::unordered_map<std::string, std::weak_ptr<titan::TitanEngine>> engines;
+};
+
+EngineRegistry& engineRegistry() {
+    static auto* registry = new EngineRegistry();
+    return *registry;
+}
+
+std::string registryKey(const std::string& path, const std::string& shared_name) {
+    if (!path.empty()) {
+        std::error_code ec;
+        auto resolved = std::filesystem::weakly_canonical(std::filesystem::absolute(path), ec);
+        return "path:" + (ec ? path : resolved.string());
+    }
+    return shared_name.empty() ? std::string() : "name:" + shared_name;
+}
+
+// Returns the live engine registered under `key`, or registers the one that
+// `open` creates; `created` tells the caller whether to configure it.
+std::shared_ptr<titan::TitanEngine> acquireEngine(
+    const std::string& key, const std::function<std::unique_ptr<titan::TitanEngine>()>& open, bool& created) {
+    auto& registry = engineRegistry();
+    while (true) {
+        std::unique_lock lock(registry.mutex);
+        auto it = registry.engines.find(key);
+        if (it != registry.engines.end()) {
+            if (auto engine = it->second.lock()) {
+                created = false;
+                return engine;
+            }
+            // The last handle was collected and its deleter is still closing
+            // the engine; a new one could not take the WAL lock yet.
+            lock.unlock();
+            std::this_thread::yield();
+            continue;
+        }
+
+        std::shared_ptr<titan::TitanEngine> engine(open().release(), [key](titan::TitanEngine* dying) {
+            auto& owner = engineRegistry();
+            std::lock_guard guard(owner.mutex);
+            delete dying;
+            auto entry = owner.engines.find(key);
+            if (entry != owner.engines.end() && entry->second.expired()) owner.engines.erase(entry);
+        });
+        registry.engines.emplace(key, engine);
+        created = true;
+        return engine;
+    }
+}
+
+// Drops one handle; the last one closes the engine so close() errors still
+// reach the caller.
+void releaseEngine(std::shared_ptr<titan::TitanEngine>& engine, const std::string& key) {
+    if (!engine) return;
+    std::shared_ptr<titan::TitanEngine> handle = std::move(engine);
+
+    // The handle is destroyed after the lock is released, since the
+    // registry's deleter takes it too.
+    auto& registry = engineRegistry();
+    std::unique_lock lock(registry.mutex, std::defer_lock);
+    if (!key.empty()) lock.lock();
+    if (handle.use_count() == 1) {
+        if (!key.empty()) registry.engines.erase(key);
+        handle->close();
+    }
+}
+
+} // namespace
+
 class TitanKV : public Napi::ObjectWrap<TitanKV> {
 public:
     static Napi::Object Init(Napi::Env env, Napi::Object exports);
     TitanKV(const Napi::CallbackInfo& info);
+    ~TitanKV();
+
+    // Null once the handle is closed.
+    const std::shared_ptr<titan::TitanEngine>& engine() const { return engine_; }
 
 private:
-    std::unique_ptr<titan::TitanEngine> engine_;
+    std::shared_ptr<titan::TitanEngine> engine_;
+    // Empty for engines private to this handle.
+    std::string registry_key_;
+    bool external_buffers_ = false;
+    // Pub/sub subscriber of this handle, 0 before the first subscribe. The
+    // engine wakes `messages_` from whichever thread published, and the JS
+    // callback drains everything queued since in one drainMessages() call.
+    uint64_t subscriber_ = 0;
+    Napi::ThreadSafeFunction messages_;
+
+    void dropSubscriber();
 
     Napi::Value Put(const Napi::CallbackInfo& info);
     Napi::Value PutAsync(const Napi::CallbackInfo& info);
     Napi::Value Get(const Napi::CallbackInfo& info);
     Napi::Value GetAsync(const Napi::CallbackInfo& info);
+    Napi::Value GetRange(const Napi::CallbackInfo& info);
+    Napi::Value GetRangeAsync(const Napi::CallbackInfo& info);
+    Napi::Value ValueLength(const Napi::CallbackInfo& info);
+    Napi::Value CompressChunkAsync(const Napi::CallbackInfo& info);
+    Napi::Value PutCompressedAsync(const Napi::CallbackInfo& info);
     Napi::Value Del(const Napi::CallbackInfo& info);
     Napi::Value Has(const Napi::CallbackInfo& info);
+    Napi::Value Expire(const Napi::CallbackInfo& info);
+    Napi::Value Persist(const Napi::CallbackInfo& info);
+    Napi::Value Ttl(const Napi::CallbackInfo& info);
     Napi::Value Size(const Napi::CallbackInfo& info);
     Napi::Value Clear(const Napi::CallbackInfo& info);
     Napi::Value Incr(const Napi::CallbackInfo& info);
     Napi::Value Decr(const Napi::CallbackInfo& info);
+    Napi::Value GetWithVersion(const Napi::CallbackInfo& info);
+    Napi::Value Version(const Napi::CallbackInfo& info);
+    Napi::Value PutIfVersion(const Napi::CallbackInfo& info);
+    Napi::Value PutIfAbsent(const Napi::CallbackInfo& info);
+    Napi::Value LPush(const Napi::CallbackInfo& info);
+    Napi::Value RPush(const Napi::CallbackInfo& info);
+    Napi::Value LPop(const Napi::CallbackInfo& info);
+    Napi::Value RPop(const Napi::CallbackInfo& info);
+    Napi::Value LLen(const Napi::CallbackInfo& info);
+    Napi::Value LRange(const Napi::CallbackInfo& info);
+    Napi::Value LIndex(const Napi::CallbackInfo& info);
+    Napi::Value LSet(const Napi::CallbackInfo& info);
+    Napi::Value ZAdd(const Napi::CallbackInfo& info);
+    Napi::Value ZIncrBy(const Napi::CallbackInfo& info);
+    Napi::Value ZRem(const Napi::CallbackInfo& info);
+    Napi::Value ZScore(const Napi::CallbackInfo& info);
+    Napi::Value ZRank(const Napi::CallbackInfo& info);
+    Napi::Value ZCard(const Napi::CallbackInfo& info);
+    Napi::Value ZRange(const Napi::CallbackInfo& info);
+    Napi::Value ZRangeByScore(const Napi::CallbackInfo& info);
+    Napi::Value ZCount(const Napi::CallbackInfo& info);
+    Napi::Value HSet(const Napi::CallbackInfo& info);
+    Napi::Value HGet(const Napi::CallbackInfo& info);
+    Napi::Value HDel(const Napi::CallbackInfo& info);
+    Napi::Value HLen(const Napi::CallbackInfo& info);
+    Napi::Value HGetAll(const Napi::CallbackInfo& info);
+    Napi::Value HIncrBy(const Napi::CallbackInfo& info);
+    Napi::Value SAdd(const Napi::CallbackInfo& info);
+    Napi::Value SRem(const Napi::CallbackInfo& info);
+    Napi::Value SIsMember(const Napi::CallbackInfo& info);
+    Napi::Value SCard(const Napi::CallbackInfo& info);
+    Napi::Value SMembers(const Napi::CallbackInfo& info);
     Napi::Value Keys(const Napi::CallbackInfo& info);
     Napi::Value KeysAsync(const Napi::CallbackInfo& info);
     Napi::Value Scan(const Napi::CallbackInfo& info);
@@ -30,6 +254,7 @@ private:
     Napi::Value CountPrefix(const Napi::CallbackInfo& info);
     Napi::Value CountPrefixAsync(const Napi::CallbackInfo& info);
     Napi::Value PutBatch(const Napi::CallbackInfo& info);
+    Napi::Value WriteBatch(const Napi::CallbackInfo& info);
     Napi::Value GetBatch(const Napi::CallbackInfo& info);
     Napi::Value PutBatchAsync(const Napi::CallbackInfo& info);
     Napi::Value GetBatchAsync(const Napi::CallbackInfo& info);
@@ -37,6 +262,18 @@ private:
     Napi::Value FlushAsync(const Napi::CallbackInfo& info);
     Napi::Value Compact(const Napi::CallbackInfo& info);
     Napi::Value CompactAsync(const Napi::CallbackInfo& info);
+    Napi::Value RecompressCold(const Napi::CallbackInfo& info);
+    Napi::Value RecompressColdAsync(const Napi::CallbackInfo& info);
+    Napi::Value PublishSnapshot(const Napi::CallbackInfo& info);
+    Napi::Value PublishSnapshotAsync(const Napi::CallbackInfo& info);
+    Napi::Value Checkpoint(const Napi::CallbackInfo& info);
+    Napi::Value CheckpointAsync(const Napi::CallbackInfo& info);
+    Napi::Value Ingest(const Napi::CallbackInfo& info);
+    Napi::Value IngestAsync(const Napi::CallbackInfo& info);
+    Napi::Value Subscribe(const Napi::CallbackInfo& info);
+    Napi::Value Unsubscribe(const Napi::CallbackInfo& info);
+    Napi::Value Publish(const Napi::CallbackInfo& info);
+    Napi::Value DrainMessages(const Napi::CallbackInfo& info);
     Napi::Value Close(const Napi::CallbackInfo& info);
     Napi::Value GetStats(const Napi::CallbackInfo& info);
 };
@@ -47,12 +284,52 @@ Napi::Object TitanKV::Init(Napi::Env env, Napi::Object exports) {
         InstanceMethod("putAsync", &TitanKV::PutAsync),
         InstanceMethod("get", &TitanKV::Get),
         InstanceMethod("getAsync", &TitanKV::GetAsync),
+        InstanceMethod("getRange", &TitanKV::GetRange),
+        InstanceMethod("getRangeAsync", &TitanKV::GetRangeAsync),
+        InstanceMethod("valueLength", &TitanKV::ValueLength),
+        InstanceMethod("compressChunkAsync", &TitanKV::CompressChunkAsync),
+        InstanceMethod("putCompressedAsync", &TitanKV::PutCompressedAsync),
         InstanceMethod("del", &TitanKV::Del),
         InstanceMethod("has", &TitanKV::Has),
+        InstanceMethod("expire", &TitanKV::Expire),
+        InstanceMethod("persist", &TitanKV::Persist),
+        InstanceMethod("ttl", &TitanKV::Ttl),
         InstanceMethod("size", &TitanKV::Size),
         InstanceMethod("clear", &TitanKV::Clear),
         InstanceMethod("incr", &TitanKV::Incr),
         InstanceMethod("decr", &TitanKV::Decr),
+        InstanceMethod("getWithVersion", &TitanKV::GetWithVersion),
+        InstanceMethod("version", &TitanKV::Version),
+        InstanceMethod("putIfVersion", &TitanKV::PutIfVersion),
+        InstanceMethod("putIfAbsent", &TitanKV::PutIfAbsent),
+        InstanceMethod("lpush", &TitanKV::LPush),
+        InstanceMethod("rpush", &TitanKV::RPush),
+        InstanceMethod("lpop", &TitanKV::LPop),
+        InstanceMethod("rpop", &TitanKV::RPop),
+        InstanceMethod("llen", &TitanKV::LLen),
+        InstanceMethod("lrange", &TitanKV::LRange),
+        InstanceMethod("lindex", &TitanKV::LIndex),
+        InstanceMethod("lset", &TitanKV::LSet),
+        InstanceMethod("zadd", &TitanKV::ZAdd),
+        InstanceMethod("zincrby", &TitanKV::ZIncrBy),
+        InstanceMethod("zrem", &TitanKV::ZRem),
+        InstanceMethod("zscore", &TitanKV::ZScore),
+        InstanceMethod("zrank", &TitanKV::ZRank),
+        InstanceMethod("zcard", &TitanKV::ZCard),
+        InstanceMethod("zrange", &TitanKV::ZRange),
+        InstanceMethod("zrangeByScore", &TitanKV::ZRangeByScore),
+        InstanceMethod("zcount", &TitanKV::ZCount),
+        InstanceMethod("hset", &TitanKV::HSet),
+        InstanceMethod("hget", &TitanKV::HGet),
+        InstanceMethod("hdel", &TitanKV::HDel),
+        InstanceMethod("hlen", &TitanKV::HLen),
+        InstanceMethod("hgetall", &TitanKV::HGetAll),
+        InstanceMethod("hincrby", &TitanKV::HIncrBy),
+        InstanceMethod("sadd", &TitanKV::SAdd),
+        InstanceMethod("srem", &TitanKV::SRem),
+        InstanceMethod("sismember", &TitanKV::SIsMember),
+        InstanceMethod("scard", &TitanKV::SCard),
+        InstanceMethod("smembers", &TitanKV::SMembers),
         InstanceMethod("keys", &TitanKV::Keys),
         InstanceMethod("keysAsync", &TitanKV::KeysAsync),
         InstanceMethod("scan", &TitanKV::Scan),
@@ -62,6 +339,7 @@ Napi::Object TitanKV::Init(Napi::Env env, Napi::Object exports) {
         InstanceMethod("countPrefix", &TitanKV::CountPrefix),
         InstanceMethod("countPrefixAsync", &TitanKV::CountPrefixAsync),
         InstanceMethod("putBatch", &TitanKV::PutBatch),
+        InstanceMethod("writeBatch", &TitanKV::WriteBatch),
         InstanceMethod("getBatch", &TitanKV::GetBatch),
         InstanceMethod("putBatchAsync", &TitanKV::PutBatchAsync),
         InstanceMethod("getBatchAsync", &TitanKV::GetBatchAsync),
@@ -69,6 +347,18 @@ Napi::Object TitanKV::Init(Napi::Env env, Napi::Object exports) {
         InstanceMethod("flushAsync", &TitanKV::FlushAsync),
         InstanceMethod("compact", &TitanKV::Compact),
         InstanceMethod("compactAsync", &TitanKV::CompactAsync),
+        InstanceMethod("recompressCold", &TitanKV::RecompressCold),
+        InstanceMethod("recompressColdAsync", &TitanKV::RecompressColdAsync),
+        InstanceMethod("publishSnapshot", &TitanKV::PublishSnapshot),
+        InstanceMethod("publishSnapshotAsync", &TitanKV::PublishSnapshotAsync),
+        InstanceMethod("checkpoint", &TitanKV::Checkpoint),
+        InstanceMethod("checkpointAsync", &TitanKV::CheckpointAsync),
+        InstanceMethod("ingest", &TitanKV::Ingest),
+        InstanceMethod("ingestAsync", &TitanKV::IngestAsync),
+        InstanceMethod("subscribe", &TitanKV::Subscribe),
+        InstanceMethod("unsubscribe", &TitanKV::Unsubscribe),
+        InstanceMethod("publish", &TitanKV::Publish),
+        InstanceMethod("drainMessages", &TitanKV::DrainMessages),
         InstanceMethod("close", &TitanKV::Close),
         InstanceMethod("stats", &TitanKV::GetStats),
     });
@@ -84,14 +374,19 @@ Napi::Object TitanKV::Init(Napi::Env env, Napi::Object exports) {
 TitanKV::TitanKV(const Napi::CallbackInfo& info) : Napi::ObjectWrap<TitanKV>(info) {
     Napi::Env env = info.Env();
     std::string path = "";
+    std::string shared_name;
     int compression_level = 3;
     size_t max_memory_bytes = 0;
+    titan::EvictionConfig eviction_config;
+    int64_t cleanup_interval_ms = -1;
     titan::RecoveryMode recovery_mode = titan::RecoveryMode::Permissive;
     bool bloom_filter_enabled = true;
     bool auto_compact_enabled = false;
     size_t compact_min_ops = 2000;
     double compact_tombstone_ratio = 0.35;
     size_t compact_min_wal_bytes = 4 * 1024 * 1024;
+    std::vector<titan::CompressionPolicy> compression_policies;
+    titan::ColdRecompressionPolicy cold_policy;
 
     if (info.Length() > 0 && info[0].IsString()) {
         path = info[0].As<Napi::String>().Utf8Value();
@@ -99,12 +394,40 @@ TitanKV::TitanKV(const Napi::CallbackInfo& info) : Napi::ObjectWrap<TitanKV>(inf
 
     if (info.Length() > 1 && info[1].IsObject()) {
         Napi::Object opts = info[1].As<Napi::Object>();
+        if (opts.Has("shared") && opts.Get("shared").IsString()) {
+            shared_name = opts.Get("shared").As<Napi::String>().Utf8Value();
+        }
         if (opts.Has("compressionLevel")) {
             compression_level = opts.Get("compressionLevel").As<Napi::Number>().Int32Value();
         }
         if (opts.Has("maxMemoryBytes")) {
             max_memory_bytes = static_cast<size_t>(opts.Get("maxMemoryBytes").As<Napi::Number>().Int64Value());
         }
+        if (opts.Has("evictionPolicy") && opts.Get("evictionPolicy").IsString()) {
+            const std::string policy = opts.Get("evictionPolicy").As<Napi::String>().Utf8Value();
+            if (policy == "allkeys-lru") {
+                eviction_config.policy = titan::EvictionPolicy::AllKeysLru;
+            } else if (policy == "allkeys-lfu") {
+                eviction_config.policy = titan::EvictionPolicy::AllKeysLfu;
+            } else if (policy == "volatile-ttl") {
+                eviction_config.policy = titan::EvictionPolicy::VolatileTtl;
+            } else if (policy != "spill") {
+                Napi::TypeError::New(env, "Unknown eviction policy: " + policy).ThrowAsJavaScriptException();
+                return;
+            }
+        }
+        if (opts.Has("cleanupIntervalMs") && opts.Get("cleanupIntervalMs").IsNumber()) {
+            cleanup_interval_ms = opts.Get("cleanupIntervalMs").As<Napi::Number>().Int64Value();
+        }
+        if (opts.Has("evictionSamples") && opts.Get("evictionSamples").IsNumber()) {
+            eviction_config.samples = static_cast<size_t>(opts.Get("evictionSamples").As<Napi::Number>().Int64Value());
+        }
+        if (opts.Has("lfuLogFactor") && opts.Get("lfuLogFactor").IsNumber()) {
+            eviction_config.lfu_log_factor = opts.Get("lfuLogFactor").As<Napi::Number>().Uint32Value();
+        }
+        if (opts.Has("lfuDecayMinutes") && opts.Get("lfuDecayMinutes").IsNumber()) {
+            eviction_config.lfu_decay_minutes = opts.Get("lfuDecayMinutes").As<Napi::Number>().Uint32Value();
+        }
         if (opts.Has("recoverMode") && opts.Get("recoverMode").IsString()) {
             const std::string mode = opts.Get("recoverMode").As<Napi::String>().Utf8Value();
             if (mode == "strict") {
@@ -126,13 +449,82 @@ TitanKV::TitanKV(const Napi::CallbackInfo& info) : Napi::ObjectWrap<TitanKV>(inf
         if (opts.Has("compactMinWalBytes") && opts.Get("compactMinWalBytes").IsNumber()) {
             compact_min_wal_bytes = static_cast<size_t>(opts.Get("compactMinWalBytes").As<Napi::Number>().Int64Value());
         }
+        if (opts.Has("externalBuffers") && opts.Get("externalBuffers").IsBoolean()) {
+            external_buffers_ = opts.Get("externalBuffers").As<Napi::Boolean>().Value();
+        }
+        if (opts.Has("compressionPolicies") && opts.Get("compressionPolicies").IsArray()) {
+            Napi::Array policies = opts.Get("compressionPolicies").As<Napi::Array>();
+            for (uint32_t i = 0; i < policies.Length(); i++) {
+                Napi::Value item = policies.Get(i);
+                if (!item.IsObject()) continue;
+                Napi::Object entry = item.As<Napi::Object>();
+
+                titan::CompressionPolicy policy;
+                policy.level = compression_level;
+                if (entry.Has("prefix") && entry.Get("prefix").IsString()) {
+                    policy.prefix = entry.Get("prefix").As<Napi::String>().Utf8Value();
+                }
+                if (entry.Has("codec") && entry.Get("codec").IsString()) {
+                    const std::string codec = entry.Get("codec").As<Napi::String>().Utf8Value();
+                    if (codec == "none") {
+                        policy.codec = titan::CompressionCodec::None;
+                    } else if (codec != "zstd") {
+                        Napi::TypeError::New(env, "Unknown compression codec: " + codec).ThrowAsJavaScriptException();
+                        return;
+                    }
+                }
+                if (entry.Has("level") && entry.Get("level").IsNumber()) {
+                    policy.level = entry.Get("level").As<Napi::Number>().Int32Value();
+                }
+                if (entry.Has("dictionary") && entry.Get("dictionary").IsTypedArray()) {
+                    policy.dictionary = readValueBytes(entry.Get("dictionary"));
+                }
+                compression_policies.push_back(std::move(policy));
+            }
+        }
+        if (opts.Has("coldRecompress") && opts.Get("coldRecompress").IsObject()) {
+            Napi::Object cold = opts.Get("coldRecompress").As<Napi::Object>();
+            cold_policy.enabled = true;
+            if (cold.Has("afterMs") && cold.Get("afterMs").IsNumber()) {
+                cold_policy.idle_ms = cold.Get("afterMs").As<Napi::Number>().Int64Value();
+            }
+            if (cold.Has("level") && cold.Get("level").IsNumber()) {
+                cold_policy.level = cold.Get("level").As<Napi::Number>().Int32Value();
+            }
+            if (cold.Has("trainDictionary") && cold.Get("trainDictionary").IsBoolean()) {
+                cold_policy.train_dictionary = cold.Get("trainDictionary").As<Napi::Boolean>().Value();
+            }
+            if (cold.Has("batchSize") && cold.Get("batchSize").IsNumber()) {
+                cold_policy.batch_size = static_cast<size_t>(cold.Get("batchSize").As<Napi::Number>().Int64Value());
+            }
+        }
     }
 
     try {
-        engine_ = std::make_unique<titan::TitanEngine>(path, recovery_mode, bloom_filter_enabled);
+        const auto open = [&] {
+            return std::make_unique<titan::TitanEngine>(path, recovery_mode, bloom_filter_enabled);
+        };
+        registry_key_ = registryKey(path, shared_name);
+        if (registry_key_.empty()) {
+            engine_ = open();
+        } else {
+            // A shared engine keeps the options it was first opened with.
+            bool created = false;
+            engine_ = acquireEngine(registry_key_, open, created);
+            if (!created) return;
+        }
+
         engine_->setCompressionLevel(compression_level);
+        if (!compression_policies.empty()) {
+            engine_->setCompressionPolicies(compression_policies);
+        }
+        engine_->setColdRecompressionPolicy(cold_policy);
         engine_->setCompactionPolicy(compact_min_ops, compact_tombstone_ratio, compact_min_wal_bytes);
         engine_->setAutoCompactEnabled(auto_compact_enabled);
+        engine_->setEvictionConfig(eviction_config);
+        if (cleanup_interval_ms >= 0) {
+            engine_->setActiveExpiryInterval(cleanup_interval_ms);
+        }
         if (max_memory_bytes > 0) {
             engine_->setMaxMemoryBytes(max_memory_bytes);
         }
@@ -148,7 +540,7 @@ Napi::Value TitanKV::Put(const Napi::CallbackInfo& info) {
         return env.Null();
     }
     std::string key = info[0].As<Napi::String>().Utf8Value();
-    std::string value = info[1].As<Napi::String>().Utf8Value();
+    std::string value = readValueBytes(info[1]);
     int64_t ttl = 0;
     if (info.Length() > 2 && info[2].IsNumber()) {
         ttl = info[2].As<Napi::Number>().Int64Value();
@@ -203,7 +595,7 @@ Napi::Value TitanKV::PutAsync(const Napi::CallbackInfo& info) {
         return env.Null();
     }
     std::string key = info[0].As<Napi::String>().Utf8Value();
-    std::string value = info[1].As<Napi::String>().Utf8Value();
+    std::string value = readValueBytes(info[1]);
     int64_t ttl = 0;
     if (info.Length() > 2 && info[2].IsNumber()) {
         ttl = info[2].As<Napi::Number>().Int64Value();
@@ -219,7 +611,7 @@ Napi::Value TitanKV::Get(const Napi::CallbackInfo& info) {
     if (info.Length() < 1) return env.Null();
     try {
         auto result = engine_->get(info[0].As<Napi::String>().Utf8Value());
-        return result ? Napi::String::New(env, *result) : env.Null();
+        return result ? makeValue(env, std::move(*result), readAsBuffer(info, 1), external_buffers_) : env.Null();
     } catch (const std::exception& e) {
         Napi::Error::New(env, e.what()).ThrowAsJavaScriptException();
         return env.Null();
@@ -228,8 +620,13 @@ Napi::Value TitanKV::Get(const Napi::CallbackInfo& info) {
 
 class GetAsyncWorker : public Napi::AsyncWorker {
 public:
-    GetAsyncWorker(Napi::Env& env, titan::TitanEngine* engine, std::string key)
-        : Napi::AsyncWorker(env), deferred(Napi::Promise::Deferred::New(env)), engine_(engine), key_(std::move(key)) {}
+    GetAsyncWorker(Napi::Env& env, titan::TitanEngine* engine, std::string key, bool as_buffer, bool external)
+        : Napi::AsyncWorker(env),
+          deferred(Napi::Promise::Deferred::New(env)),
+          engine_(engine),
+          key_(std::move(key)),
+          as_buffer_(as_buffer),
+          external_(external) {}
 
     ~GetAsyncWorker() {}
 
@@ -244,7 +641,7 @@ public:
     void OnOK() override {
         Napi::Env env = Env();
         if (result_) {
-            deferred.Resolve(Napi::String::New(env, *result_));
+            deferred.Resolve(makeValue(env, std::move(*result_), as_buffer_, external_));
         } else {
             deferred.Resolve(env.Null());
         }
@@ -262,6 +659,8 @@ private:
     Napi::Promise::Deferred deferred;
     titan::TitanEngine* engine_;
     std::string key_;
+    bool as_buffer_;
+    bool external_;
     std::optional<std::string> result_;
 };
 
@@ -273,103 +672,46 @@ Napi::Value TitanKV::GetAsync(const Napi::CallbackInfo& info) {
     }
     std::string key = info[0].As<Napi::String>().Utf8Value();
 
-    GetAsyncWorker* worker = new GetAsyncWorker(env, engine_.get(), key);
+    GetAsyncWorker* worker = new GetAsyncWorker(env, engine_.get(), key, readAsBuffer(info, 1), external_buffers_);
     worker->Queue();
     return worker->GetPromise();
 }
 
-Napi::Value TitanKV::Del(const Napi::CallbackInfo& info) {
-    Napi::Env env = info.Env();
-    if (info.Length() < 1) return Napi::Boolean::New(env, false);
-    try {
-        return Napi::Boolean::New(env, engine_->del(info[0].As<Napi::String>().Utf8Value()));
-    } catch (const std::exception& e) {
-        Napi::Error::New(env, e.what()).ThrowAsJavaScriptException();
-        return Napi::Boolean::New(env, false);
-    }
-}
-
-Napi::Value TitanKV::Has(const Napi::CallbackInfo& info) {
-    Napi::Env env = info.Env();
-    if (info.Length() < 1) return Napi::Boolean::New(env, false);
-    try {
-        return Napi::Boolean::New(env, engine_->has(info[0].As<Napi::String>().Utf8Value()));
-    } catch (const std::exception& e) {
-        Napi::Error::New(env, e.what()).ThrowAsJavaScriptException();
-        return Napi::Boolean::New(env, false);
-    }
-}
-
-Napi::Value TitanKV::Size(const Napi::CallbackInfo& info) {
-    try {
-        return Napi::Number::New(info.Env(), static_cast<double>(engine_->size()));
-    } catch (const std::exception& e) {
-        Napi::Error::New(info.Env(), e.what()).ThrowAsJavaScriptException();
-        return info.Env().Null();
-    }
-}
-
-Napi::Value TitanKV::Clear(const Napi::CallbackInfo& info) {
-    try {
-        engine_->clear();
-    } catch (const std::exception& e) {
-        Napi::Error::New(info.Env(), e.what()).ThrowAsJavaScriptException();
-    }
-    return info.Env().Undefined();
-}
-
-Napi::Value TitanKV::Incr(const Napi::CallbackInfo& info) {
-    Napi::Env env = info.Env();
-    int64_t delta = 1;
-    if (info.Length() > 1 && info[1].IsNumber()) delta = info[1].As<Napi::Number>().Int64Value();
-    try {
-        return Napi::Number::New(env, static_cast<double>(engine_->incr(info[0].As<Napi::String>().Utf8Value(), delta)));
-    } catch (const std::exception& e) {
-        Napi::Error::New(env, e.what()).ThrowAsJavaScriptException();
-        return env.Null();
-    }
-}
-
-Napi::Value TitanKV::Decr(const Napi::CallbackInfo& info) {
+Napi::Value TitanKV::GetRange(const Napi::CallbackInfo& info) {
     Napi::Env env = info.Env();
-    int64_t delta = 1;
-    if (info.Length() > 1 && info[1].IsNumber()) delta = info[1].As<Napi::Number>().Int64Value();
-    try {
-        return Napi::Number::New(env, static_cast<double>(engine_->decr(info[0].As<Napi::String>().Utf8Value(), delta)));
-    } catch (const std::exception& e) {
-        Napi::Error::New(env, e.what()).ThrowAsJavaScriptException();
+    if (info.Length() < 3) {
+        Napi::TypeError::New(env, "Expected key, offset and length").ThrowAsJavaScriptException();
         return env.Null();
     }
-}
-
-Napi::Value TitanKV::Keys(const Napi::CallbackInfo& info) {
-    Napi::Env env = info.Env();
-    size_t limit = 1000;
-    if (info.Length() > 0 && info[0].IsNumber()) limit = info[0].As<Napi::Number>().Int64Value();
-
     try {
-        auto keys = engine_->keys(limit);
-        Napi::Array arr = Napi::Array::New(env, keys.size());
-        for (size_t i = 0; i < keys.size(); i++) {
-            arr.Set(i, Napi::String::New(env, keys[i]));
-        }
-        return arr;
+        auto result = engine_->getRange(
+            info[0].As<Napi::String>().Utf8Value(),
+            static_cast<size_t>(info[1].As<Napi::Number>().Int64Value()),
+            static_cast<size_t>(info[2].As<Napi::Number>().Int64Value()));
+        return result ? makeValue(env, std::move(*result), readAsBuffer(info, 3), external_buffers_) : env.Null();
     } catch (const std::exception& e) {
         Napi::Error::New(env, e.what()).ThrowAsJavaScriptException();
         return env.Null();
     }
 }
 
-class KeysAsyncWorker : public Napi::AsyncWorker {
+class GetRangeAsyncWorker : public Napi::AsyncWorker {
 public:
-    KeysAsyncWorker(Napi::Env& env, titan::TitanEngine* engine, size_t limit)
-        : Napi::AsyncWorker(env), deferred(Napi::Promise::Deferred::New(env)), engine_(engine), limit_(limit) {}
+    GetRangeAsyncWorker(Napi::Env& env, titan::TitanEngine* engine, std::string key, size_t offset, size_t length, bool as_buffer, bool external)
+        : Napi::AsyncWorker(env),
+          deferred(Napi::Promise::Deferred::New(env)),
+          engine_(engine),
+          key_(std::move(key)),
+          offset_(offset),
+          length_(length),
+          as_buffer_(as_buffer),
+          external_(external) {}
 
-    ~KeysAsyncWorker() {}
+    ~GetRangeAsyncWorker() {}
 
     void Execute() override {
         try {
-            keys_ = engine_->keys(limit_);
+            result_ = engine_->getRange(key_, offset_, length_);
         } catch (const std::exception& e) {
             SetError(e.what());
         }
@@ -377,11 +719,11 @@ public:
 
     void OnOK() override {
         Napi::Env env = Env();
-        Napi::Array arr = Napi::Array::New(env, keys_.size());
-        for (size_t i = 0; i < keys_.size(); i++) {
-            arr.Set(i, Napi::String::New(env, keys_[i]));
+        if (result_) {
+            deferred.Resolve(makeValue(env, std::move(*result_), as_buffer_, external_));
+        } else {
+            deferred.Resolve(env.Null());
         }
-        deferred.Resolve(arr);
     }
 
     void OnError(const Napi::Error& e) override {
@@ -395,74 +737,61 @@ public:
 private:
     Napi::Promise::Deferred deferred;
     titan::TitanEngine* engine_;
-    size_t limit_;
-    std::vector<std::string> keys_;
+    std::string key_;
+    size_t offset_;
+    size_t length_;
+    bool as_buffer_;
+    bool external_;
+    std::optional<std::string> result_;
 };
 
-Napi::Value TitanKV::KeysAsync(const Napi::CallbackInfo& info) {
+Napi::Value TitanKV::GetRangeAsync(const Napi::CallbackInfo& info) {
     Napi::Env env = info.Env();
-    size_t limit = 1000;
-    if (info.Length() > 0 && info[0].IsNumber()) {
-        limit = info[0].As<Napi::Number>().Int64Value();
+    if (info.Length() < 3) {
+        Napi::TypeError::New(env, "Expected key, offset and length").ThrowAsJavaScriptException();
+        return env.Null();
     }
+    std::string key = info[0].As<Napi::String>().Utf8Value();
+    size_t offset = static_cast<size_t>(info[1].As<Napi::Number>().Int64Value());
+    size_t length = static_cast<size_t>(info[2].As<Napi::Number>().Int64Value());
 
-    KeysAsyncWorker* worker = new KeysAsyncWorker(env, engine_.get(), limit);
+    GetRangeAsyncWorker* worker = new GetRangeAsyncWorker(env, engine_.get(), key, offset, length, readAsBuffer(info, 3), external_buffers_);
     worker->Queue();
     return worker->GetPromise();
 }
 
-Napi::Value TitanKV::Scan(const Napi::CallbackInfo& info) {
+Napi::Value TitanKV::ValueLength(const Napi::CallbackInfo& info) {
     Napi::Env env = info.Env();
-    if (info.Length() < 1) return Napi::Array::New(env, 0);
-    std::string prefix = info[0].As<Napi::String>().Utf8Value();
-    size_t limit = 1000;
-    if (info.Length() > 1 && info[1].IsNumber()) limit = info[1].As<Napi::Number>().Int64Value();
-
+    if (info.Length() < 1) return env.Null();
     try {
-        auto pairs = engine_->scan(prefix, limit);
-        Napi::Array arr = Napi::Array::New(env, pairs.size());
-        for (size_t i = 0; i < pairs.size(); i++) {
-            Napi::Array pair = Napi::Array::New(env, 2);
-            pair.Set((uint32_t)0, Napi::String::New(env, pairs[i].first));
-            pair.Set((uint32_t)1, Napi::String::New(env, pairs[i].second));
-            arr.Set(i, pair);
-        }
-        return arr;
+        auto length = engine_->valueLength(info[0].As<Napi::String>().Utf8Value());
+        return length ? Napi::Number::New(env, static_cast<double>(*length)) : env.Null();
     } catch (const std::exception& e) {
         Napi::Error::New(env, e.what()).ThrowAsJavaScriptException();
         return env.Null();
     }
 }
 
-class ScanAsyncWorker : public Napi::AsyncWorker {
+// Compresses one raw chunk of a streamed value off the main thread using the
+// key's compression policy. The frames are returned to JS and concatenated by
+// putCompressedAsync once the stream ends.
+class CompressChunkAsyncWorker : public Napi::AsyncWorker {
 public:
-    ScanAsyncWorker(Napi::Env& env, titan::TitanEngine* engine, std::string prefix, size_t limit)
-        : Napi::AsyncWorker(env),
-          deferred(Napi::Promise::Deferred::New(env)),
-          engine_(engine),
-          prefix_(std::move(prefix)),
-          limit_(limit) {}
+    CompressChunkAsyncWorker(Napi::Env& env, titan::TitanEngine* engine, std::string key, std::string chunk)
+        : Napi::AsyncWorker(env), deferred(Napi::Promise::Deferred::New(env)), engine_(engine), key_(std::move(key)), chunk_(std::move(chunk)) {}
 
-    ~ScanAsyncWorker() {}
+    ~CompressChunkAsyncWorker() {}
 
     void Execute() override {
         try {
-            pairs_ = engine_->scan(prefix_, limit_);
+            frames_ = engine_->compressChunk(key_, chunk_);
         } catch (const std::exception& e) {
             SetError(e.what());
         }
     }
 
     void OnOK() override {
-        Napi::Env env = Env();
-        Napi::Array arr = Napi::Array::New(env, pairs_.size());
-        for (size_t i = 0; i < pairs_.size(); i++) {
-            Napi::Array pair = Napi::Array::New(env, 2);
-            pair.Set((uint32_t)0, Napi::String::New(env, pairs_[i].first));
-            pair.Set((uint32_t)1, Napi::String::New(env, pairs_[i].second));
-            arr.Set(i, pair);
-        }
-        deferred.Resolve(arr);
+        deferred.Resolve(Napi::Buffer<uint8_t>::Copy(Env(), frames_.data(), frames_.size()));
     }
 
     void OnError(const Napi::Error& e) override {
@@ -476,84 +805,41 @@ public:
 private:
     Napi::Promise::Deferred deferred;
     titan::TitanEngine* engine_;
-    std::string prefix_;
-    size_t limit_;
-    std::vector<std::pair<std::string, std::string>> pairs_;
+    std::string key_;
+    std::string chunk_;
+    std::vector<uint8_t> frames_;
 };
 
-Napi::Value TitanKV::ScanAsync(const Napi::CallbackInfo& info) {
+Napi::Value TitanKV::CompressChunkAsync(const Napi::CallbackInfo& info) {
     Napi::Env env = info.Env();
-    if (info.Length() < 1) {
-        Napi::Promise::Deferred deferred = Napi::Promise::Deferred::New(env);
-        deferred.Resolve(Napi::Array::New(env, 0));
-        return deferred.Promise();
-    }
-
-    std::string prefix = info[0].As<Napi::String>().Utf8Value();
-    size_t limit = 1000;
-    if (info.Length() > 1 && info[1].IsNumber()) {
-        limit = info[1].As<Napi::Number>().Int64Value();
+    if (info.Length() < 2) {
+        Napi::TypeError::New(env, "Expected key and chunk").ThrowAsJavaScriptException();
+        return env.Null();
     }
+    std::string key = info[0].As<Napi::String>().Utf8Value();
 
-    ScanAsyncWorker* worker = new ScanAsyncWorker(env, engine_.get(), std::move(prefix), limit);
+    CompressChunkAsyncWorker* worker = new CompressChunkAsyncWorker(env, engine_.get(), key, readValueBytes(info[1]));
     worker->Queue();
     return worker->GetPromise();
 }
 
-Napi::Value TitanKV::Range(const Napi::CallbackInfo& info) {
-    Napi::Env env = info.Env();
-    if (info.Length() < 2) return Napi::Array::New(env, 0);
-    std::string start = info[0].As<Napi::String>().Utf8Value();
-    std::string end = info[1].As<Napi::String>().Utf8Value();
-    size_t limit = 1000;
-    if (info.Length() > 2 && info[2].IsNumber()) limit = info[2].As<Napi::Number>().Int64Value();
-
-    try {
-        auto pairs = engine_->range(start, end, limit);
-        Napi::Array arr = Napi::Array::New(env, pairs.size());
-        for (size_t i = 0; i < pairs.size(); i++) {
-            Napi::Array pair = Napi::Array::New(env, 2);
-            pair.Set((uint32_t)0, Napi::String::New(env, pairs[i].first));
-            pair.Set((uint32_t)1, Napi::String::New(env, pairs[i].second));
-            arr.Set(i, pair);
-        }
-        return arr;
-    } catch (const std::exception& e) {
-        Napi::Error::New(env, e.what()).ThrowAsJavaScriptException();
-        return env.Null();
-    }
-}
-
-class RangeAsyncWorker : public Napi::AsyncWorker {
+class PutCompressedAsyncWorker : public Napi::AsyncWorker {
 public:
-    RangeAsyncWorker(Napi::Env& env, titan::TitanEngine* engine, std::string start, std::string end, size_t limit)
-        : Napi::AsyncWorker(env),
-          deferred(Napi::Promise::Deferred::New(env)),
-          engine_(engine),
-          start_(std::move(start)),
-          end_(std::move(end)),
-          limit_(limit) {}
+    PutCompressedAsyncWorker(Napi::Env& env, titan::TitanEngine* engine, std::string key, std::vector<uint8_t> frames, int64_t ttl)
+        : Napi::AsyncWorker(env), deferred(Napi::Promise::Deferred::New(env)), engine_(engine), key_(std::move(key)), frames_(std::move(frames)), ttl_(ttl) {}
 
-    ~RangeAsyncWorker() {}
+    ~PutCompressedAsyncWorker() {}
 
     void Execute() override {
         try {
-            pairs_ = engine_->range(start_, end_, limit_);
+            engine_->putCompressed(key_, std::move(frames_), ttl_);
         } catch (const std::exception& e) {
             SetError(e.what());
         }
     }
 
     void OnOK() override {
-        Napi::Env env = Env();
-        Napi::Array arr = Napi::Array::New(env, pairs_.size());
-        for (size_t i = 0; i < pairs_.size(); i++) {
-            Napi::Array pair = Napi::Array::New(env, 2);
-            pair.Set((uint32_t)0, Napi::String::New(env, pairs_[i].first));
-            pair.Set((uint32_t)1, Napi::String::New(env, pairs_[i].second));
-            arr.Set(i, pair);
-        }
-        deferred.Resolve(arr);
+        deferred.Resolve(Env().Undefined());
     }
 
     void OnError(const Napi::Error& e) override {
@@ -567,239 +853,2247 @@ public:
 private:
     Napi::Promise::Deferred deferred;
     titan::TitanEngine* engine_;
-    std::string start_;
-    std::string end_;
-    size_t limit_;
-    std::vector<std::pair<std::string, std::string>> pairs_;
+    std::string key_;
+    std::vector<uint8_t> frames_;
+    int64_t ttl_;
 };
 
-Napi::Value TitanKV::RangeAsync(const Napi::CallbackInfo& info) {
+Napi::Value TitanKV::PutCompressedAsync(const Napi::CallbackInfo& info) {
     Napi::Env env = info.Env();
-    if (info.Length() < 2) {
-        Napi::Promise::Deferred deferred = Napi::Promise::Deferred::New(env);
-        deferred.Resolve(Napi::Array::New(env, 0));
-        return deferred.Promise();
+    if (info.Length() < 2 || !info[1].IsArray()) {
+        Napi::TypeError::New(env, "Expected key and array of compressed chunks").ThrowAsJavaScriptException();
+        return env.Null();
     }
-
-    std::string start = info[0].As<Napi::String>().Utf8Value();
-    std::string end = info[1].As<Napi::String>().Utf8Value();
-    size_t limit = 1000;
+    std::string key = info[0].As<Napi::String>().Utf8Value();
+    Napi::Array chunks = info[1].As<Napi::Array>();
+    int64_t ttl = 0;
     if (info.Length() > 2 && info[2].IsNumber()) {
-        limit = info[2].As<Napi::Number>().Int64Value();
+        ttl = info[2].As<Napi::Number>().Int64Value();
     }
 
-    RangeAsyncWorker* worker = new RangeAsyncWorker(env, engine_.get(), std::move(start), std::move(end), limit);
+    std::vector<uint8_t> frames;
+    for (uint32_t i = 0; i < chunks.Length(); i++) {
+        Napi::Value chunk = chunks.Get(i);
+        if (!chunk.IsTypedArray()) {
+            Napi::TypeError::New(env, "Compressed chunks must be Buffers").ThrowAsJavaScriptException();
+            return env.Null();
+        }
+        Napi::TypedArray view = chunk.As<Napi::TypedArray>();
+        const uint8_t* data = static_cast<const uint8_t*>(view.ArrayBuffer().Data()) + view.ByteOffset();
+        frames.insert(frames.end(), data, data + view.ByteLength());
+    }
+
+    PutCompressedAsyncWorker* worker = new PutCompressedAsyncWorker(env, engine_.get(), key, std::move(frames), ttl);
     worker->Queue();
     return worker->GetPromise();
 }
 
-Napi::Value TitanKV::CountPrefix(const Napi::CallbackInfo& info) {
-    if (info.Length() < 1) return Napi::Number::New(info.Env(), 0);
+Napi::Value TitanKV::Del(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    if (info.Length() < 1) return Napi::Boolean::New(env, false);
     try {
-        return Napi::Number::New(info.Env(), static_cast<double>(engine_->countPrefix(info[0].As<Napi::String>().Utf8Value())));
+        return Napi::Boolean::New(env, engine_->del(info[0].As<Napi::String>().Utf8Value()));
+    } catch (const std::exception& e) {
+        Napi::Error::New(env, e.what()).ThrowAsJavaScriptException();
+        return Napi::Boolean::New(env, false);
+    }
+}
+
+Napi::Value TitanKV::Has(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    if (info.Length() < 1) return Napi::Boolean::New(env, false);
+    try {
+        return Napi::Boolean::New(env, engine_->has(info[0].As<Napi::String>().Utf8Value()));
+    } catch (const std::exception& e) {
+        Napi::Error::New(env, e.what()).ThrowAsJavaScriptException();
+        return Napi::Boolean::New(env, false);
+    }
+}
+
+Napi::Value TitanKV::Expire(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    if (info.Length() < 2) {
+        Napi::TypeError::New(env, "Expected key and ttl").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    try {
+        std::string key = info[0].As<Napi::String>().Utf8Value();
+        int64_t ttl = info[1].As<Napi::Number>().Int64Value();
+        return Napi::Boolean::New(env, engine_->expire(key, ttl));
+    } catch (const std::exception& e) {
+        Napi::Error::New(env, e.what()).ThrowAsJavaScriptException();
+        return env.Null();
+    }
+}
+
+Napi::Value TitanKV::Persist(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    if (info.Length() < 1) return Napi::Boolean::New(env, false);
+    try {
+        return Napi::Boolean::New(env, engine_->persist(info[0].As<Napi::String>().Utf8Value()));
+    } catch (const std::exception& e) {
+        Napi::Error::New(env, e.what()).ThrowAsJavaScriptException();
+        return Napi::Boolean::New(env, false);
+    }
+}
+
+Napi::Value TitanKV::Ttl(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    if (info.Length() < 1) return Napi::Number::New(env, -2);
+    try {
+        return Napi::Number::New(env, static_cast<double>(engine_->ttl(info[0].As<Napi::String>().Utf8Value())));
+    } catch (const std::exception& e) {
+        Napi::Error::New(env, e.what()).ThrowAsJavaScriptException();
+        return env.Null();
+    }
+}
+
+Napi::Value TitanKV::Size(const Napi::CallbackInfo& info) {
+    try {
+        return Napi::Number::New(info.Env(), static_cast<double>(engine_->size()));
     } catch (const std::exception& e) {
         Napi::Error::New(info.Env(), e.what()).ThrowAsJavaScriptException();
         return info.Env().Null();
     }
 }
 
-class CountPrefixAsyncWorker : public Napi::AsyncWorker {
-public:
-    CountPrefixAsyncWorker(Napi::Env& env, titan::TitanEngine* engine, std::string prefix)
-        : Napi::AsyncWorker(env),
-          deferred(Napi::Promise::Deferred::New(env)),
-          engine_(engine),
-          prefix_(std::move(prefix)) {}
+Napi::Value TitanKV::Clear(const Napi::CallbackInfo& info) {
+    try {
+        engine_->clear();
+    } catch (const std::exception& e) {
+        Napi::Error::New(info.Env(), e.what()).ThrowAsJavaScriptException();
+    }
+    return info.Env().Undefined();
+}
 
-    ~CountPrefixAsyncWorker() {}
+Napi::Value TitanKV::Incr(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    int64_t delta = 1;
+    if (info.Length() > 1 && info[1].IsNumber()) delta = info[1].As<Napi::Number>().Int64Value();
+    try {
+        return Napi::Number::New(env, static_cast<double>(engine_->incr(info[0].As<Napi::String>().Utf8Value(), delta)));
+    } catch (const std::exception& e) {
+        Napi::Error::New(env, e.what()).ThrowAsJavaScriptException();
+        return env.Null();
+    }
+}
 
-    void Execute() override {
-        try {
-            count_ = engine_->countPrefix(prefix_);
-        } catch (const std::exception& e) {
-            SetError(e.what());
-        }
+Napi::Value TitanKV::Decr(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    int64_t delta = 1;
+    if (info.Length() > 1 && info[1].IsNumber()) delta = info[1].As<Napi::Number>().Int64Value();
+    try {
+        return Napi::Number::New(env, static_cast<double>(engine_->decr(info[0].As<Napi::String>().Utf8Value(), delta)));
+    } catch (const std::exception& e) {
+        Napi::Error::New(env, e.what()).ThrowAsJavaScriptException();
+        return env.Null();
     }
+}
 
-    void OnOK() override {
-        deferred.Resolve(Napi::Number::New(Env(), static_cast<double>(count_)));
+Napi::Value TitanKV::GetWithVersion(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    if (info.Length() < 1) {
+        Napi::TypeError::New(env, "Expected key").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    try {
+        auto result = engine_->getWithVersion(info[0].As<Napi::String>().Utf8Value());
+        Napi::Object out = Napi::Object::New(env);
+        out.Set("value", result.value ? makeValue(env, std::move(*result.value), readAsBuffer(info, 1), external_buffers_)
+                                      : env.Null());
+        out.Set("version", Napi::Number::New(env, static_cast<double>(result.version)));
+        return out;
+    } catch (const std::exception& e) {
+        Napi::Error::New(env, e.what()).ThrowAsJavaScriptException();
+        return env.Null();
     }
+}
 
-    void OnError(const Napi::Error& e) override {
-        deferred.Reject(e.Value());
+Napi::Value TitanKV::Version(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    if (info.Length() < 1) {
+        Napi::TypeError::New(env, "Expected key").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    try {
+        return Napi::Number::New(env, static_cast<double>(engine_->version(info[0].As<Napi::String>().Utf8Value())));
+    } catch (const std::exception& e) {
+        Napi::Error::New(env, e.what()).ThrowAsJavaScriptException();
+        return env.Null();
     }
+}
 
-    Napi::Promise GetPromise() {
-        return deferred.Promise();
+Napi::Value TitanKV::PutIfVersion(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    if (info.Length() < 3 || !info[2].IsNumber()) {
+        Napi::TypeError::New(env, "Expected key, value and version").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    std::string key = info[0].As<Napi::String>().Utf8Value();
+    std::string value = readValueBytes(info[1]);
+    const auto expected = static_cast<uint64_t>(info[2].As<Napi::Number>().Int64Value());
+    int64_t ttl = 0;
+    if (info.Length() > 3 && info[3].IsNumber()) ttl = info[3].As<Napi::Number>().Int64Value();
+    try {
+        auto version = engine_->putIfVersion(key, value, expected, ttl);
+        return version ? Napi::Number::New(env, static_cast<double>(*version)) : env.Null();
+    } catch (const std::exception& e) {
+        Napi::Error::New(env, e.what()).ThrowAsJavaScriptException();
+        return env.Null();
     }
+}
 
-private:
-    Napi::Promise::Deferred deferred;
-    titan::TitanEngine* engine_;
-    std::string prefix_;
-    size_t count_ = 0;
-};
+Napi::Value TitanKV::PutIfAbsent(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    if (info.Length() < 2) {
+        Napi::TypeError::New(env, "Expected key and value").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    std::string key = info[0].As<Napi::String>().Utf8Value();
+    std::string value = readValueBytes(info[1]);
+    int64_t ttl = 0;
+    if (info.Length() > 2 && info[2].IsNumber()) ttl = info[2].As<Napi::Number>().Int64Value();
+    try {
+        auto version = engine_->putIfAbsent(key, value, ttl);
+        return version ? Napi::Number::New(env, static_cast<double>(*version)) : env.Null();
+    } catch (const std::exception& e) {
+        Napi::Error::New(env, e.what()).ThrowAsJavaScriptException();
+        return env.Null();
+    }
+}
 
-Napi::Value TitanKV::CountPrefixAsync(const Napi::CallbackInfo& info) {
+Napi::Value TitanKV::LPush(const Napi::CallbackInfo& info) {
     Napi::Env env = info.Env();
-    if (info.Length() < 1) {
-        Napi::Promise::Deferred deferred = Napi::Promise::Deferred::New(env);
-        deferred.Resolve(Napi::Number::New(env, 0));
-        return deferred.Promise();
+    if (info.Length() < 2) {
+        Napi::TypeError::New(env, "Expected key and values").ThrowAsJavaScriptException();
+        return env.Null();
     }
+    try {
+        return Napi::Number::New(env, static_cast<double>(
+            engine_->lpush(info[0].As<Napi::String>().Utf8Value(), readValueArray(info[1]))));
+    } catch (const std::exception& e) {
+        Napi::Error::New(env, e.what()).ThrowAsJavaScriptException();
+        return env.Null();
+    }
+}
 
-    std::string prefix = info[0].As<Napi::String>().Utf8Value();
-    CountPrefixAsyncWorker* worker = new CountPrefixAsyncWorker(env, engine_.get(), std::move(prefix));
-    worker->Queue();
-    return worker->GetPromise();
+Napi::Value TitanKV::RPush(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    if (info.Length() < 2) {
+        Napi::TypeError::New(env, "Expected key and values").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    try {
+        return Napi::Number::New(env, static_cast<double>(
+            engine_->rpush(info[0].As<Napi::String>().Utf8Value(), readValueArray(info[1]))));
+    } catch (const std::exception& e) {
+        Napi::Error::New(env, e.what()).ThrowAsJavaScriptException();
+        return env.Null();
+    }
 }
 
-Napi::Value TitanKV::PutBatch(const Napi::CallbackInfo& info) {
-    if (info.Length() < 1 || !info[0].IsArray()) return info.Env().Undefined();
-    Napi::Array arr = info[0].As<Napi::Array>();
-    std::vector<std::pair<std::string, std::string>> pairs;
-    pairs.reserve(arr.Length());
+Napi::Value TitanKV::LPop(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    if (info.Length() < 1) return env.Null();
+    try {
+        return makeOptionalString(env, engine_->lpop(info[0].As<Napi::String>().Utf8Value()));
+    } catch (const std::exception& e) {
+        Napi::Error::New(env, e.what()).ThrowAsJavaScriptException();
+        return env.Null();
+    }
+}
 
-    for (uint32_t i = 0; i < arr.Length(); i++) {
-        Napi::Value item = arr.Get(i);
-        if (item.IsArray()) {
-            Napi::Array pair = item.As<Napi::Array>();
-            if (pair.Length() >= 2) {
-                pairs.emplace_back(
-                    pair.Get((uint32_t)0).As<Napi::String>().Utf8Value(),
-                    pair.Get((uint32_t)1).As<Napi::String>().Utf8Value()
-                );
-            }
+Napi::Value TitanKV::RPop(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    if (info.Length() < 1) return env.Null();
+    try {
+        return makeOptionalString(env, engine_->rpop(info[0].As<Napi::String>().Utf8Value()));
+    } catch (const std::exception& e) {
+        Napi::Error::New(env, e.what()).ThrowAsJavaScriptException();
+        return env.Null();
+    }
+}
+
+Napi::Value TitanKV::LLen(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    if (info.Length() < 1) return Napi::Number::New(env, 0);
+    try {
+        return Napi::Number::New(env, static_cast<double>(engine_->llen(info[0].As<Napi::String>().Utf8Value())));
+    } catch (const std::exception& e) {
+        Napi::Error::New(env, e.what()).ThrowAsJavaScriptException();
+        return env.Null();
+    }
+}
+
+Napi::Value TitanKV::LRange(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    if (info.Length() < 1) return Napi::Array::New(env, 0);
+    int64_t start = 0;
+    int64_t stop = -1;
+    if (info.Length() > 1 && info[1].IsNumber()) start = info[1].As<Napi::Number>().Int64Value();
+    if (info.Length() > 2 && info[2].IsNumber()) stop = info[2].As<Napi::Number>().Int64Value();
+
+    try {
+        auto values = engine_->lrange(info[0].As<Napi::String>().Utf8Value(), start, stop);
+        Napi::Array arr = Napi::Array::New(env, values.size());
+        for (size_t i = 0; i < values.size(); i++) {
+            arr.Set(i, Napi::String::New(env, values[i]));
         }
+        return arr;
+    } catch (const std::exception& e) {
+        Napi::Error::New(env, e.what()).ThrowAsJavaScriptException();
+        return env.Null();
     }
+}
+
+Napi::Value TitanKV::LIndex(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    if (info.Length() < 2) return env.Null();
     try {
-        engine_->putBatch(pairs);
+        return makeOptionalString(env, engine_->lindex(
+            info[0].As<Napi::String>().Utf8Value(), info[1].As<Napi::Number>().Int64Value()));
+    } catch (const std::exception& e) {
+        Napi::Error::New(env, e.what()).ThrowAsJavaScriptException();
+        return env.Null();
+    }
+}
+
+Napi::Value TitanKV::LSet(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    if (info.Length() < 3) {
+        Napi::TypeError::New(env, "Expected key, index and value").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    try {
+        return Napi::Boolean::New(env, engine_->lset(info[0].As<Napi::String>().Utf8Value(),
+            info[1].As<Napi::Number>().Int64Value(), readValueBytes(info[2])));
+    } catch (const std::exception& e) {
+        Napi::Error::New(env, e.what()).ThrowAsJavaScriptException();
+        return env.Null();
+    }
+}
+
+Napi::Value TitanKV::ZAdd(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    if (info.Length() < 3 || !info[1].IsArray() || !info[2].IsArray()) {
+        Napi::TypeError::New(env, "Expected key, members and scores").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    Napi::Array members = info[1].As<Napi::Array>();
+    Napi::Array scores = info[2].As<Napi::Array>();
+    if (members.Length() != scores.Length()) {
+        Napi::TypeError::New(env, "members and scores must have the same length").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    std::vector<titan::TitanEngine::ScoredMember> entries;
+    entries.reserve(members.Length());
+    for (uint32_t i = 0; i < members.Length(); i++) {
+        entries.emplace_back(readValueBytes(members.Get(i)), scores.Get(i).ToNumber().DoubleValue());
+    }
+
+    try {
+        return Napi::Number::New(env, static_cast<double>(engine_->zadd(info[0].As<Napi::String>().Utf8Value(), entries)));
+    } catch (const std::exception& e) {
+        Napi::Error::New(env, e.what()).ThrowAsJavaScriptException();
+        return env.Null();
+    }
+}
+
+Napi::Value TitanKV::ZIncrBy(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    if (info.Length() < 3) {
+        Napi::TypeError::New(env, "Expected key, member and increment").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    try {
+        return Napi::Number::New(env, engine_->zincrby(info[0].As<Napi::String>().Utf8Value(),
+            readValueBytes(info[1]), info[2].ToNumber().DoubleValue()));
+    } catch (const std::exception& e) {
+        Napi::Error::New(env, e.what()).ThrowAsJavaScriptException();
+        return env.Null();
+    }
+}
+
+Napi::Value TitanKV::ZRem(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    if (info.Length() < 2) return Napi::Number::New(env, 0);
+    try {
+        return Napi::Number::New(env, static_cast<double>(
+            engine_->zrem(info[0].As<Napi::String>().Utf8Value(), readValueArray(info[1]))));
+    } catch (const std::exception& e) {
+        Napi::Error::New(env, e.what()).ThrowAsJavaScriptException();
+        return env.Null();
+    }
+}
+
+Napi::Value TitanKV::ZScore(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    if (info.Length() < 2) return env.Null();
+    try {
+        auto score = engine_->zscore(info[0].As<Napi::String>().Utf8Value(), readValueBytes(info[1]));
+        return score.has_value() ? Napi::Number::New(env, *score) : env.Null();
+    } catch (const std::exception& e) {
+        Napi::Error::New(env, e.what()).ThrowAsJavaScriptException();
+        return env.Null();
+    }
+}
+
+Napi::Value TitanKV::ZRank(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    if (info.Length() < 2) return env.Null();
+    try {
+        auto rank = engine_->zrank(info[0].As<Napi::String>().Utf8Value(), readValueBytes(info[1]), readFlag(info, 2));
+        return rank.has_value() ? Napi::Number::New(env, static_cast<double>(*rank)) : env.Null();
+    } catch (const std::exception& e) {
+        Napi::Error::New(env, e.what()).ThrowAsJavaScriptException();
+        return env.Null();
+    }
+}
+
+Napi::Value TitanKV::ZCard(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    if (info.Length() < 1) return Napi::Number::New(env, 0);
+    try {
+        return Napi::Number::New(env, static_cast<double>(engine_->zcard(info[0].As<Napi::String>().Utf8Value())));
+    } catch (const std::exception& e) {
+        Napi::Error::New(env, e.what()).ThrowAsJavaScriptException();
+        return env.Null();
+    }
+}
+
+Napi::Value TitanKV::ZRange(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    if (info.Length() < 1) return Napi::Array::New(env, 0);
+    int64_t start = 0;
+    int64_t stop = -1;
+    if (info.Length() > 1 && info[1].IsNumber()) start = info[1].As<Napi::Number>().Int64Value();
+    if (info.Length() > 2 && info[2].IsNumber()) stop = info[2].As<Napi::Number>().Int64Value();
+
+    try {
+        auto members = engine_->zrange(info[0].As<Napi::String>().Utf8Value(), start, stop, readFlag(info, 3));
+        return makeScoredMembers(env, members, readFlag(info, 4));
+    } catch (const std::exception& e) {
+        Napi::Error::New(env, e.what()).ThrowAsJavaScriptException();
+        return env.Null();
+    }
+}
+
+Napi::Value TitanKV::ZRangeByScore(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    if (info.Length() < 3) return Napi::Array::New(env, 0);
+    size_t offset = 0;
+    size_t count = std::numeric_limits<size_t>::max();
+    if (info.Length() > 3 && info[3].IsNumber()) {
+        offset = static_cast<size_t>(std::max<int64_t>(0, info[3].As<Napi::Number>().Int64Value()));
+    }
+    if (info.Length() > 4 && info[4].IsNumber() && info[4].As<Napi::Number>().Int64Value() > 0) {
+        count = static_cast<size_t>(info[4].As<Napi::Number>().Int64Value());
+    }
+
+    try {
+        auto members = engine_->zrangeByScore(info[0].As<Napi::String>().Utf8Value(),
+            info[1].ToNumber().DoubleValue(), info[2].ToNumber().DoubleValue(), offset, count, readFlag(info, 6));
+        return makeScoredMembers(env, members, readFlag(info, 5));
+    } catch (const std::exception& e) {
+        Napi::Error::New(env, e.what()).ThrowAsJavaScriptException();
+        return env.Null();
+    }
+}
+
+Napi::Value TitanKV::ZCount(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    if (info.Length() < 3) return Napi::Number::New(env, 0);
+    try {
+        return Napi::Number::New(env, static_cast<double>(engine_->zcount(info[0].As<Napi::String>().Utf8Value(),
+            info[1].ToNumber().DoubleValue(), info[2].ToNumber().DoubleValue())));
+    } catch (const std::exception& e) {
+        Napi::Error::New(env, e.what()).ThrowAsJavaScriptException();
+        return env.Null();
+    }
+}
+
+Napi::Value TitanKV::HSet(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    if (info.Length() < 3 || !info[1].IsArray() || !info[2].IsArray()) {
+        Napi::TypeError::New(env, "Expected key, fields and values").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    auto fields = readValueArray(info[1]);
+    auto values = readValueArray(info[2]);
+    if (fields.size() != values.size()) {
+        Napi::TypeError::New(env, "fields and values must have the same length").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    std::vector<titan::TitanEngine::FieldValue> entries;
+    entries.reserve(fields.size());
+    for (size_t i = 0; i < fields.size(); i++) {
+        entries.emplace_back(std::move(fields[i]), std::move(values[i]));
+    }
+
+    try {
+        return Napi::Number::New(env, static_cast<double>(engine_->hset(info[0].As<Napi::String>().Utf8Value(), entries)));
+    } catch (const std::exception& e) {
+        Napi::Error::New(env, e.what()).ThrowAsJavaScriptException();
+        return env.Null();
+    }
+}
+
+Napi::Value TitanKV::HGet(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    if (info.Length() < 2) return env.Null();
+    try {
+        return makeOptionalString(env, engine_->hget(info[0].As<Napi::String>().Utf8Value(), readValueBytes(info[1])));
+    } catch (const std::exception& e) {
+        Napi::Error::New(env, e.what()).ThrowAsJavaScriptException();
+        return env.Null();
+    }
+}
+
+Napi::Value TitanKV::HDel(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    if (info.Length() < 2) return Napi::Number::New(env, 0);
+    try {
+        return Napi::Number::New(env, static_cast<double>(
+            engine_->hdel(info[0].As<Napi::String>().Utf8Value(), readValueArray(info[1]))));
+    } catch (const std::exception& e) {
+        Napi::Error::New(env, e.what()).ThrowAsJavaScriptException();
+        return env.Null();
+    }
+}
+
+Napi::Value TitanKV::HLen(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    if (info.Length() < 1) return Napi::Number::New(env, 0);
+    try {
+        return Napi::Number::New(env, static_cast<double>(engine_->hlen(info[0].As<Napi::String>().Utf8Value())));
+    } catch (const std::exception& e) {
+        Napi::Error::New(env, e.what()).ThrowAsJavaScriptException();
+        return env.Null();
+    }
+}
+
+Napi::Value TitanKV::HGetAll(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    Napi::Object obj = Napi::Object::New(env);
+    if (info.Length() < 1) return obj;
+    try {
+        for (const auto& [field, value] : engine_->hgetall(info[0].As<Napi::String>().Utf8Value())) {
+            obj.Set(field, Napi::String::New(env, value));
+        }
+        return obj;
+    } catch (const std::exception& e) {
+        Napi::Error::New(env, e.what()).ThrowAsJavaScriptException();
+        return env.Null();
+    }
+}
+
+Napi::Value TitanKV::HIncrBy(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    if (info.Length() < 3) {
+        Napi::TypeError::New(env, "Expected key, field and increment").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    try {
+        return Napi::Number::New(env, static_cast<double>(engine_->hincrby(info[0].As<Napi::String>().Utf8Value(),
+            readValueBytes(info[1]), info[2].ToNumber().Int64Value())));
+    } catch (const std::exception& e) {
+        Napi::Error::New(env, e.what()).ThrowAsJavaScriptException();
+        return env.Null();
+    }
+}
+
+Napi::Value TitanKV::SAdd(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    if (info.Length() < 2) {
+        Napi::TypeError::New(env, "Expected key and members").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    try {
+        return Napi::Number::New(env, static_cast<double>(
+            engine_->sadd(info[0].As<Napi::String>().Utf8Value(), readValueArray(info[1]))));
+    } catch (const std::exception& e) {
+        Napi::Error::New(env, e.what()).ThrowAsJavaScriptException();
+        return env.Null();
+    }
+}
+
+Napi::Value TitanKV::SRem(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    if (info.Length() < 2) return Napi::Number::New(env, 0);
+    try {
+        return Napi::Number::New(env, static_cast<double>(
+            engine_->srem(info[0].As<Napi::String>().Utf8Value(), readValueArray(info[1]))));
+    } catch (const std::exception& e) {
+        Napi::Error::New(env, e.what()).ThrowAsJavaScriptException();
+        return env.Null();
+    }
+}
+
+Napi::Value TitanKV::SIsMember(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    if (info.Length() < 2) return Napi::Boolean::New(env, false);
+    try {
+        return Napi::Boolean::New(env, engine_->sismember(info[0].As<Napi::String>().Utf8Value(), readValueBytes(info[1])));
+    } catch (const std::exception& e) {
+        Napi::Error::New(env, e.what()).ThrowAsJavaScriptException();
+        return env.Null();
+    }
+}
+
+Napi::Value TitanKV::SCard(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    if (info.Length() < 1) return Napi::Number::New(env, 0);
+    try {
+        return Napi::Number::New(env, static_cast<double>(engine_->scard(info[0].As<Napi::String>().Utf8Value())));
+    } catch (const std::exception& e) {
+        Napi::Error::New(env, e.what()).ThrowAsJavaScriptException();
+        return env.Null();
+    }
+}
+
+Napi::Value TitanKV::SMembers(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    if (info.Length() < 1) return Napi::Array::New(env, 0);
+    try {
+        auto members = engine_->smembers(info[0].As<Napi::String>().Utf8Value());
+        Napi::Array arr = Napi::Array::New(env, members.size());
+        for (size_t i = 0; i < members.size(); i++) {
+            arr.Set(i, Napi::String::New(env, members[i]));
+        }
+        return arr;
+    } catch (const std::exception& e) {
+        Napi::Error::New(env, e.what()).ThrowAsJavaScriptException();
+        return env.Null();
+    }
+}
+
+Napi::Value TitanKV::Keys(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    size_t limit = 1000;
+    if (info.Length() > 0 && info[0].IsNumber()) limit = info[0].As<Napi::Number>().Int64Value();
+    titan::IterateOptions options;
+    std::optional<std::string> after;
+    readPageOptions(info, 1, options, after);
+
+    try {
+        auto keys = engine_->keys(options, limit, after);
+        Napi::Array arr = Napi::Array::New(env, keys.size());
+        for (size_t i = 0; i < keys.size(); i++) {
+            arr.Set(i, Napi::String::New(env, keys[i]));
+        }
+        return arr;
+    } catch (const std::exception& e) {
+        Napi::Error::New(env, e.what()).ThrowAsJavaScriptException();
+        return env.Null();
+    }
+}
+
+class KeysAsyncWorker : public Napi::AsyncWorker {
+public:
+    KeysAsyncWorker(Napi::Env& env, titan::TitanEngine* engine, titan::IterateOptions options,
+                    std::optional<std::string> after, size_t limit)
+        : Napi::AsyncWorker(env),
+          deferred(Napi::Promise::Deferred::New(env)),
+          engine_(engine),
+          options_(std::move(options)),
+          after_(std::move(after)),
+          limit_(limit) {}
+
+    ~KeysAsyncWorker() {}
+
+    void Execute() override {
+        try {
+            keys_ = engine_->keys(options_, limit_, after_);
+        } catch (const std::exception& e) {
+            SetError(e.what());
+        }
+    }
+
+    void OnOK() override {
+        Napi::Env env = Env();
+        Napi::Array arr = Napi::Array::New(env, keys_.size());
+        for (size_t i = 0; i < keys_.size(); i++) {
+            arr.Set(i, Napi::String::New(env, keys_[i]));
+        }
+        deferred.Resolve(arr);
+    }
+
+    void OnError(const Napi::Error& e) override {
+        deferred.Reject(e.Value());
+    }
+
+    Napi::Promise GetPromise() {
+        return deferred.Promise();
+    }
+
+private:
+    Napi::Promise::Deferred deferred;
+    titan::TitanEngine* engine_;
+    titan::IterateOptions options_;
+    std::optional<std::string> after_;
+    size_t limit_;
+    std::vector<std::string> keys_;
+};
+
+Napi::Value TitanKV::KeysAsync(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    size_t limit = 1000;
+    if (info.Length() > 0 && info[0].IsNumber()) {
+        limit = info[0].As<Napi::Number>().Int64Value();
+    }
+    titan::IterateOptions options;
+    std::optional<std::string> after;
+    readPageOptions(info, 1, options, after);
+
+    KeysAsyncWorker* worker = new KeysAsyncWorker(env, engine_.get(), std::move(options), std::move(after), limit);
+    worker->Queue();
+    return worker->GetPromise();
+}
+
+Napi::Value TitanKV::Scan(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    if (info.Length() < 1) return Napi::Array::New(env, 0);
+    titan::IterateOptions options;
+    options.prefix = info[0].As<Napi::String>().Utf8Value();
+    size_t limit = 1000;
+    if (info.Length() > 1 && info[1].IsNumber()) limit = info[1].As<Napi::Number>().Int64Value();
+    std::optional<std::string> after;
+    readPageOptions(info, 2, options, after);
+
+    try {
+        auto pairs = engine_->scan(options, limit, after);
+        Napi::Array arr = Napi::Array::New(env, pairs.size());
+        for (size_t i = 0; i < pairs.size(); i++) {
+            Napi::Array pair = Napi::Array::New(env, 2);
+            pair.Set((uint32_t)0, Napi::String::New(env, pairs[i].first));
+            pair.Set((uint32_t)1, Napi::String::New(env, pairs[i].second));
+            arr.Set(i, pair);
+        }
+        return arr;
+    } catch (const std::exception& e) {
+        Napi::Error::New(env, e.what()).ThrowAsJavaScriptException();
+        return env.Null();
+    }
+}
+
+class ScanAsyncWorker : public Napi::AsyncWorker {
+public:
+    ScanAsyncWorker(Napi::Env& env, titan::TitanEngine* engine, titan::IterateOptions options,
+                    std::optional<std::string> after, size_t limit)
+        : Napi::AsyncWorker(env),
+          deferred(Napi::Promise::Deferred::New(env)),
+          engine_(engine),
+          options_(std::move(options)),
+          after_(std::move(after)),
+          limit_(limit) {}
+
+    ~ScanAsyncWorker() {}
+
+    void Execute() override {
+        try {
+            pairs_ = engine_->scan(options_, limit_, after_);
+        } catch (const std::exception& e) {
+            SetError(e.what());
+        }
+    }
+
+    void OnOK() override {
+        Napi::Env env = Env();
+        Napi::Array arr = Napi::Array::New(env, pairs_.size());
+        for (size_t i = 0; i < pairs_.size(); i++) {
+            Napi::Array pair = Napi::Array::New(env, 2);
+            pair.Set((uint32_t)0, Napi::String::New(env, pairs_[i].first));
+            pair.Set((uint32_t)1, Napi::String::New(env, pairs_[i].second));
+            arr.Set(i, pair);
+        }
+        deferred.Resolve(arr);
+    }
+
+    void OnError(const Napi::Error& e) override {
+        deferred.Reject(e.Value());
+    }
+
+    Napi::Promise GetPromise() {
+        return deferred.Promise();
+    }
+
+private:
+    Napi::Promise::Deferred deferred;
+    titan::TitanEngine* engine_;
+    titan::IterateOptions options_;
+    std::optional<std::string> after_;
+    size_t limit_;
+    std::vector<std::pair<std::string, std::string>> pairs_;
+};
+
+Napi::Value TitanKV::ScanAsync(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    if (info.Length() < 1) {
+        Napi::Promise::Deferred deferred = Napi::Promise::Deferred::New(env);
+        deferred.Resolve(Napi::Array::New(env, 0));
+        return deferred.Promise();
+    }
+
+    titan::IterateOptions options;
+    options.prefix = info[0].As<Napi::String>().Utf8Value();
+    size_t limit = 1000;
+    if (info.Length() > 1 && info[1].IsNumber()) {
+        limit = info[1].As<Napi::Number>().Int64Value();
+    }
+    std::optional<std::string> after;
+    readPageOptions(info, 2, options, after);
+
+    ScanAsyncWorker* worker = new ScanAsyncWorker(env, engine_.get(), std::move(options), std::move(after), limit);
+    worker->Queue();
+    return worker->GetPromise();
+}
+
+Napi::Value TitanKV::Range(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    if (info.Length() < 2) return Napi::Array::New(env, 0);
+    titan::IterateOptions options;
+    options.start = info[0].As<Napi::String>().Utf8Value();
+    options.end = info[1].As<Napi::String>().Utf8Value();
+    size_t limit = 1000;
+    if (info.Length() > 2 && info[2].IsNumber()) limit = info[2].As<Napi::Number>().Int64Value();
+    std::optional<std::string> after;
+    readPageOptions(info, 3, options, after);
+
+    try {
+        auto pairs = engine_->scan(options, limit, after);
+        Napi::Array arr = Napi::Array::New(env, pairs.size());
+        for (size_t i = 0; i < pairs.size(); i++) {
+            Napi::Array pair = Napi::Array::New(env, 2);
+            pair.Set((uint32_t)0, Napi::String::New(env, pairs[i].first));
+            pair.Set((uint32_t)1, Napi::String::New(env, pairs[i].second));
+            arr.Set(i, pair);
+        }
+        return arr;
+    } catch (const std::exception& e) {
+        Napi::Error::New(env, e.what()).ThrowAsJavaScriptException();
+        return env.Null();
+    }
+}
+
+Napi::Value TitanKV::RangeAsync(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    if (info.Length() < 2) {
+        Napi::Promise::Deferred deferred = Napi::Promise::Deferred::New(env);
+        deferred.Resolve(Napi::Array::New(env, 0));
+        return deferred.Promise();
+    }
+
+    titan::IterateOptions options;
+    options.start = info[0].As<Napi::String>().Utf8Value();
+    options.end = info[1].As<Napi::String>().Utf8Value();
+    size_t limit = 1000;
+    if (info.Length() > 2 && info[2].IsNumber()) {
+        limit = info[2].As<Napi::Number>().Int64Value();
+    }
+    std::optional<std::string> after;
+    readPageOptions(info, 3, options, after);
+
+    ScanAsyncWorker* worker = new ScanAsyncWorker(env, engine_.get(), std::move(options), std::move(after), limit);
+    worker->Queue();
+    return worker->GetPromise();
+}
+
+Napi::Value TitanKV::CountPrefix(const Napi::CallbackInfo& info) {
+    if (info.Length() < 1) return Napi::Number::New(info.Env(), 0);
+    try {
+        return Napi::Number::New(info.Env(), static_cast<double>(engine_->countPrefix(info[0].As<Napi::String>().Utf8Value())));
+    } catch (const std::exception& e) {
+        Napi::Error::New(info.Env(), e.what()).ThrowAsJavaScriptException();
+        return info.Env().Null();
+    }
+}
+
+class CountPrefixAsyncWorker : public Napi::AsyncWorker {
+public:
+    CountPrefixAsyncWorker(Napi::Env& env, titan::TitanEngine* engine, std::string prefix)
+        : Napi::AsyncWorker(env),
+          deferred(Napi::Promise::Deferred::New(env)),
+          engine_(engine),
+          prefix_(std::move(prefix)) {}
+
+    ~CountPrefixAsyncWorker() {}
+
+    void Execute() override {
+        try {
+            count_ = engine_->countPrefix(prefix_);
+        } catch (const std::exception& e) {
+            SetError(e.what());
+        }
+    }
+
+    void OnOK() override {
+        deferred.Resolve(Napi::Number::New(Env(), static_cast<double>(count_)));
+    }
+
+    void OnError(const Napi::Error& e) override {
+        deferred.Reject(e.Value());
+    }
+
+    Napi::Promise GetPromise() {
+        return deferred.Promise();
+    }
+
+private:
+    Napi::Promise::Deferred deferred;
+    titan::TitanEngine* engine_;
+    std::string prefix_;
+    size_t count_ = 0;
+};
+
+Napi::Value TitanKV::CountPrefixAsync(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    if (info.Length() < 1) {
+        Napi::Promise::Deferred deferred = Napi::Promise::Deferred::New(env);
+        deferred.Resolve(Napi::Number::New(env, 0));
+        return deferred.Promise();
+    }
+
+    std::string prefix = info[0].As<Napi::String>().Utf8Value();
+    CountPrefixAsyncWorker* worker = new CountPrefixAsyncWorker(env, engine_.get(), std::move(prefix));
+    worker->Queue();
+    return worker->GetPromise();
+}
+
+Napi::Value TitanKV::PutBatch(const Napi::CallbackInfo& info) {
+    if (info.Length() < 1 || !info[0].IsArray()) return info.Env().Undefined();
+    Napi::Array arr = info[0].As<Napi::Array>();
+    std::vector<std::pair<std::string, std::string>> pairs;
+    pairs.reserve(arr.Length());
+
+    for (uint32_t i = 0; i < arr.Length(); i++) {
+        Napi::Value item = arr.Get(i);
+        if (item.IsArray()) {
+            Napi::Array pair = item.As<Napi::Array>();
+            if (pair.Length() >= 2) {
+                pairs.emplace_back(
+                    pair.Get((uint32_t)0).As<Napi::String>().Utf8Value(),
+                    readValueBytes(pair.Get((uint32_t)1))
+                );
+            }
+        }
+    }
+    try {
+        engine_->putBatch(pairs);
+    } catch (const std::exception& e) {
+        Napi::Error::New(info.Env(), e.what()).ThrowAsJavaScriptException();
+    }
+    return info.Env().Undefined();
+}
+
+// ops: ['put', key, value, ttl?] | ['del', key] | ['incr', key, delta?]
+Napi::Value TitanKV::WriteBatch(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    if (info.Length() < 1 || !info[0].IsArray()) {
+        Napi::TypeError::New(env, "Expected an array of operations").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    Napi::Array arr = info[0].As<Napi::Array>();
+    titan::WriteBatch batch;
+
+    for (uint32_t i = 0; i < arr.Length(); i++) {
+        Napi::Value item = arr.Get(i);
+        if (!item.IsArray() || item.As<Napi::Array>().Length() < 2) {
+            Napi::TypeError::New(env, "Expected [op, key, ...] entries").ThrowAsJavaScriptException();
+            return env.Null();
+        }
+        Napi::Array op = item.As<Napi::Array>();
+        const std::string kind = op.Get((uint32_t)0).ToString().Utf8Value();
+        std::string key = op.Get((uint32_t)1).As<Napi::String>().Utf8Value();
+        Napi::Value arg = op.Length() > 2 ? op.Get((uint32_t)2) : env.Undefined();
+        if (kind == "put") {
+            Napi::Value ttl = op.Length() > 3 ? op.Get((uint32_t)3) : env.Undefined();
+            batch.put(key, readValueBytes(arg), ttl.IsNumber() ? ttl.As<Napi::Number>().Int64Value() : 0);
+        } else if (kind == "del") {
+            batch.del(key);
+        } else if (kind == "incr") {
+            batch.incr(key, arg.IsNumber() ? arg.As<Napi::Number>().Int64Value() : 1);
+        } else {
+            Napi::TypeError::New(env, "Unknown batch operation: " + kind).ThrowAsJavaScriptException();
+            return env.Null();
+        }
+    }
+
+    // Optional [key, version] pairs the batch is conditional on.
+    if (info.Length() > 1 && info[1].IsArray()) {
+        Napi::Array watches = info[1].As<Napi::Array>();
+        for (uint32_t i = 0; i < watches.Length(); i++) {
+            Napi::Value item = watches.Get(i);
+            if (!item.IsArray() || item.As<Napi::Array>().Length() < 2) {
+                Napi::TypeError::New(env, "Expected [key, version] watches").ThrowAsJavaScriptException();
+                return env.Null();
+            }
+            Napi::Array watch = item.As<Napi::Array>();
+            batch.watch(watch.Get((uint32_t)0).As<Napi::String>().Utf8Value(),
+                        static_cast<uint64_t>(watch.Get((uint32_t)1).As<Napi::Number>().Int64Value()));
+        }
+    }
+
+    try {
+        const auto applied = engine_->write(batch);
+        if (!applied) return env.Null();
+        const auto& results = *applied;
+        Napi::Array out = Napi::Array::New(env, results.size());
+        for (size_t i = 0; i < results.size(); i++) {
+            // A failing op is returned, not thrown, in its own slot.
+            if (!results[i].error.empty()) {
+                out.Set(static_cast<uint32_t>(i), Napi::Error::New(env, results[i].error).Value());
+                continue;
+            }
+            switch (batch.ops()[i].kind) {
+                case titan::WriteBatch::OpKind::Put:
+                    out.Set(static_cast<uint32_t>(i), env.Undefined());
+                    break;
+                case titan::WriteBatch::OpKind::Del:
+                    out.Set(static_cast<uint32_t>(i), Napi::Boolean::New(env, results[i].value != 0));
+                    break;
+                case titan::WriteBatch::OpKind::Incr:
+                    out.Set(static_cast<uint32_t>(i), Napi::Number::New(env, static_cast<double>(results[i].value)));
+                    break;
+            }
+        }
+        return out;
+    } catch (const std::exception& e) {
+        Napi::Error::New(env, e.what()).ThrowAsJavaScriptException();
+        return env.Null();
+    }
+}
+
+Napi::Value TitanKV::GetBatch(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    if (info.Length() < 1 || !info[0].IsArray()) return Napi::Array::New(env, 0);
+    Napi::Array arr = info[0].As<Napi::Array>();
+    std::vector<std::string> keys;
+    keys.reserve(arr.Length());
+
+    for (uint32_t i = 0; i < arr.Length(); i++) {
+        keys.push_back(arr.Get(i).As<Napi::String>().Utf8Value());
+    }
+
+    try {
+        auto results = engine_->getBatch(keys);
+        const bool as_buffer = readAsBuffer(info, 1);
+        Napi::Array out = Napi::Array::New(env, results.size());
+        for (size_t i = 0; i < results.size(); i++) {
+            out.Set(i, results[i] ? makeValue(env, std::move(*results[i]), as_buffer, external_buffers_) : env.Null());
+        }
+        return out;
+    } catch (const std::exception& e) {
+        Napi::Error::New(env, e.what()).ThrowAsJavaScriptException();
+        return env.Null();
+    }
+}
+
+class PutBatchAsyncWorker : public Napi::AsyncWorker {
+public:
+    PutBatchAsyncWorker(
+        Napi::Env& env,
+        titan::TitanEngine* engine,
+        std::vector<std::pair<std::string, std::string>> pairs)
+        : Napi::AsyncWorker(env),
+          deferred(Napi::Promise::Deferred::New(env)),
+          engine_(engine),
+          pairs_(std::move(pairs)) {}
+
+    ~PutBatchAsyncWorker() {}
+
+    void Execute() override {
+        try {
+            engine_->putBatch(pairs_);
+        } catch (const std::exception& e) {
+            SetError(e.what());
+        }
+    }
+
+    void OnOK() override {
+        deferred.Resolve(Env().Undefined());
+    }
+
+    void OnError(const Napi::Error& e) override {
+        deferred.Reject(e.Value());
+    }
+
+    Napi::Promise GetPromise() {
+        return deferred.Promise();
+    }
+
+private:
+    Napi::Promise::Deferred deferred;
+    titan::TitanEngine* engine_;
+    std::vector<std::pair<std::string, std::string>> pairs_;
+};
+
+Napi::Value TitanKV::PutBatchAsync(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    if (info.Length() < 1 || !info[0].IsArray()) {
+        Napi::TypeError::New(env, "Expected array of key-value pairs").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    Napi::Array arr = info[0].As<Napi::Array>();
+    std::vector<std::pair<std::string, std::string>> pairs;
+    pairs.reserve(arr.Length());
+
+    for (uint32_t i = 0; i < arr.Length(); i++) {
+        Napi::Value item = arr.Get(i);
+        if (item.IsArray()) {
+            Napi::Array pair = item.As<Napi::Array>();
+            if (pair.Length() >= 2) {
+                pairs.emplace_back(
+                    pair.Get((uint32_t)0).As<Napi::String>().Utf8Value(),
+                    readValueBytes(pair.Get((uint32_t)1))
+                );
+            }
+        }
+    }
+
+    PutBatchAsyncWorker* worker = new PutBatchAsyncWorker(env, engine_.get(), std::move(pairs));
+    worker->Queue();
+    return worker->GetPromise();
+}
+
+class GetBatchAsyncWorker : public Napi::AsyncWorker {
+public:
+    GetBatchAsyncWorker(
+        Napi::Env& env,
+        titan::TitanEngine* engine,
+        std::vector<std::string> keys,
+        bool as_buffer,
+        bool external)
+        : Napi::AsyncWorker(env),
+          deferred(Napi::Promise::Deferred::New(env)),
+          engine_(engine),
+          keys_(std::move(keys)),
+          as_buffer_(as_buffer),
+          external_(external) {}
+
+    ~GetBatchAsyncWorker() {}
+
+    void Execute() override {
+        try {
+            results_ = engine_->getBatch(keys_);
+        } catch (const std::exception& e) {
+            SetError(e.what());
+        }
+    }
+
+    void OnOK() override {
+        Napi::Env env = Env();
+        Napi::Array out = Napi::Array::New(env, results_.size());
+        for (size_t i = 0; i < results_.size(); i++) {
+            out.Set(i, results_[i] ? makeValue(env, std::move(*results_[i]), as_buffer_, external_) : env.Null());
+        }
+        deferred.Resolve(out);
+    }
+
+    void OnError(const Napi::Error& e) override {
+        deferred.Reject(e.Value());
+    }
+
+    Napi::Promise GetPromise() {
+        return deferred.Promise();
+    }
+
+private:
+    Napi::Promise::Deferred deferred;
+    titan::TitanEngine* engine_;
+    std::vector<std::string> keys_;
+    bool as_buffer_;
+    bool external_;
+    std::vector<std::optional<std::string>> results_;
+};
+
+Napi::Value TitanKV::GetBatchAsync(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    if (info.Length() < 1 || !info[0].IsArray()) {
+        Napi::TypeError::New(env, "Expected array of keys").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    Napi::Array arr = info[0].As<Napi::Array>();
+    std::vector<std::string> keys;
+    keys.reserve(arr.Length());
+
+    for (uint32_t i = 0; i < arr.Length(); i++) {
+        keys.push_back(arr.Get(i).As<Napi::String>().Utf8Value());
+    }
+
+    GetBatchAsyncWorker* worker = new GetBatchAsyncWorker(
+        env, engine_.get(), std::move(keys), readAsBuffer(info, 1), external_buffers_);
+    worker->Queue();
+    return worker->GetPromise();
+}
+
+class FlushAsyncWorker : public Napi::AsyncWorker {
+public:
+    FlushAsyncWorker(Napi::Env& env, titan::TitanEngine* engine)
+        : Napi::AsyncWorker(env), deferred(Napi::Promise::Deferred::New(env)), engine_(engine) {}
+
+    ~FlushAsyncWorker() {}
+
+    void Execute() override {
+        try {
+            engine_->flush();
+        } catch (const std::exception& e) {
+            SetError(e.what());
+        }
+    }
+
+    void OnOK() override {
+        deferred.Resolve(Env().Undefined());
+    }
+
+    void OnError(const Napi::Error& e) override {
+        deferred.Reject(e.Value());
+    }
+
+    Napi::Promise GetPromise() {
+        return deferred.Promise();
+    }
+
+private:
+    Napi::Promise::Deferred deferred;
+    titan::TitanEngine* engine_;
+};
+
+class CompactAsyncWorker : public Napi::AsyncWorker {
+public:
+    CompactAsyncWorker(Napi::Env& env, titan::TitanEngine* engine)
+        : Napi::AsyncWorker(env), deferred(Napi::Promise::Deferred::New(env)), engine_(engine) {}
+
+    ~CompactAsyncWorker() {}
+
+    void Execute() override {
+        try {
+            engine_->compact();
+        } catch (const std::exception& e) {
+            SetError(e.what());
+        }
+    }
+
+    void OnOK() override {
+        deferred.Resolve(Env().Undefined());
+    }
+
+    void OnError(const Napi::Error& e) override {
+        deferred.Reject(e.Value());
+    }
+
+    Napi::Promise GetPromise() {
+        return deferred.Promise();
+    }
+
+private:
+    Napi::Promise::Deferred deferred;
+    titan::TitanEngine* engine_;
+};
+
+Napi::Value TitanKV::Flush(const Napi::CallbackInfo& info) {
+    try {
+        engine_->flush();
+    } catch (const std::exception& e) {
+        Napi::Error::New(info.Env(), e.what()).ThrowAsJavaScriptException();
+    }
+    return info.Env().Undefined();
+}
+
+Napi::Value TitanKV::FlushAsync(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    FlushAsyncWorker* worker = new FlushAsyncWorker(env, engine_.get());
+    worker->Queue();
+    return worker->GetPromise();
+}
+
+Napi::Value TitanKV::Compact(const Napi::CallbackInfo& info) {
+    try {
+        engine_->compact();
+    } catch (const std::exception& e) {
+        Napi::Error::New(info.Env(), e.what()).ThrowAsJavaScriptException();
+    }
+    return info.Env().Undefined();
+}
+
+Napi::Value TitanKV::CompactAsync(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    CompactAsyncWorker* worker = new CompactAsyncWorker(env, engine_.get());
+    worker->Queue();
+    return worker->GetPromise();
+}
+
+Napi::Value TitanKV::RecompressCold(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    try {
+        return Napi::Number::New(env, (double)engine_->recompressCold());
+    } catch (const std::exception& e) {
+        Napi::Error::New(env, e.what()).ThrowAsJavaScriptException();
+        return env.Null();
+    }
+}
+
+class RecompressColdAsyncWorker : public Napi::AsyncWorker {
+public:
+    RecompressColdAsyncWorker(Napi::Env& env, titan::TitanEngine* engine)
+        : Napi::AsyncWorker(env), deferred(Napi::Promise::Deferred::New(env)), engine_(engine) {}
+
+    ~RecompressColdAsyncWorker() {}
+
+    void Execute() override {
+        try {
+            saved_ = engine_->recompressCold();
+        } catch (const std::exception& e) {
+            SetError(e.what());
+        }
+    }
+
+    void OnOK() override {
+        deferred.Resolve(Napi::Number::New(Env(), (double)saved_));
+    }
+
+    void OnError(const Napi::Error& e) override {
+        deferred.Reject(e.Value());
+    }
+
+    Napi::Promise GetPromise() {
+        return deferred.Promise();
+    }
+
+private:
+    Napi::Promise::Deferred deferred;
+    titan::TitanEngine* engine_;
+    size_t saved_ = 0;
+};
+
+Napi::Value TitanKV::RecompressColdAsync(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    RecompressColdAsyncWorker* worker = new RecompressColdAsyncWorker(env, engine_.get());
+    worker->Queue();
+    return worker->GetPromise();
+}
+
+Napi::Value TitanKV::PublishSnapshot(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    try {
+        return Napi::Number::New(env, static_cast<double>(engine_->publishSnapshot()));
+    } catch (const std::exception& e) {
+        Napi::Error::New(env, e.what()).ThrowAsJavaScriptException();
+        return env.Null();
+    }
+}
+
+class PublishSnapshotAsyncWorker : public Napi::AsyncWorker {
+public:
+    PublishSnapshotAsyncWorker(Napi::Env& env, titan::TitanEngine* engine)
+        : Napi::AsyncWorker(env), deferred(Napi::Promise::Deferred::New(env)), engine_(engine) {}
+
+    ~PublishSnapshotAsyncWorker() {}
+
+    void Execute() override {
+        try {
+            generation_ = engine_->publishSnapshot();
+        } catch (const std::exception& e) {
+            SetError(e.what());
+        }
+    }
+
+    void OnOK() override {
+        deferred.Resolve(Napi::Number::New(Env(), static_cast<double>(generation_)));
+    }
+
+    void OnError(const Napi::Error& e) override {
+        deferred.Reject(e.Value());
+    }
+
+    Napi::Promise GetPromise() {
+        return deferred.Promise();
+    }
+
+private:
+    Napi::Promise::Deferred deferred;
+    titan::TitanEngine* engine_;
+    uint64_t generation_ = 0;
+};
+
+Napi::Value TitanKV::PublishSnapshotAsync(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    PublishSnapshotAsyncWorker* worker = new PublishSnapshotAsyncWorker(env, engine_.get());
+    worker->Queue();
+    return worker->GetPromise();
+}
+
+namespace {
+
+Napi::Object makeCheckpointResult(Napi::Env env, const titan::CheckpointResult& result) {
+    Napi::Object obj = Napi::Object::New(env);
+    obj.Set("walBytes", Napi::Number::New(env, static_cast<double>(result.wal_bytes)));
+    obj.Set("copiedBytes", Napi::Number::New(env, static_cast<double>(result.copied_bytes)));
+    return obj;
+}
+
+} // namespace
+
+Napi::Value TitanKV::Checkpoint(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    if (info.Length() < 1 || !info[0].IsString()) {
+        Napi::TypeError::New(env, "checkpoint requires a directory").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    try {
+        return makeCheckpointResult(env, engine_->checkpoint(info[0].As<Napi::String>().Utf8Value()));
+    } catch (const std::exception& e) {
+        Napi::Error::New(env, e.what()).ThrowAsJavaScriptException();
+        return env.Null();
+    }
+}
+
+class CheckpointAsyncWorker : public Napi::AsyncWorker {
+public:
+    CheckpointAsyncWorker(Napi::Env& env, titan::TitanEngine* engine, std::string dir)
+        : Napi::AsyncWorker(env), deferred(Napi::Promise::Deferred::New(env)), engine_(engine), dir_(std::move(dir)) {}
+
+    ~CheckpointAsyncWorker() {}
+
+    void Execute() override {
+        try {
+            result_ = engine_->checkpoint(dir_);
+        } catch (const std::exception& e) {
+            SetError(e.what());
+        }
+    }
+
+    void OnOK() override {
+        deferred.Resolve(makeCheckpointResult(Env(), result_));
+    }
+
+    void OnError(const Napi::Error& e) override {
+        deferred.Reject(e.Value());
+    }
+
+    Napi::Promise GetPromise() {
+        return deferred.Promise();
+    }
+
+private:
+    Napi::Promise::Deferred deferred;
+    titan::TitanEngine* engine_;
+    std::string dir_;
+    titan::CheckpointResult result_;
+};
+
+Napi::Value TitanKV::CheckpointAsync(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    if (info.Length() < 1 || !info[0].IsString()) {
+        Napi::TypeError::New(env, "checkpoint requires a directory").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    CheckpointAsyncWorker* worker = new CheckpointAsyncWorker(env, engine_.get(), info[0].As<Napi::String>().Utf8Value());
+    worker->Queue();
+    return worker->GetPromise();
+}
+
+namespace {
+
+// ingest(files, move): throws a TypeError and returns false unless `files`
+// is an array of paths.
+bool readIngestFiles(const Napi::CallbackInfo& info, std::vector<std::string>& files, bool& move) {
+    if (info.Length() < 1 || !info[0].IsArray()) {
+        Napi::TypeError::New(info.Env(), "ingest requires an array of SSTable paths").ThrowAsJavaScriptException();
+        return false;
+    }
+    Napi::Array arr = info[0].As<Napi::Array>();
+    for (uint32_t i = 0; i < arr.Length(); i++) {
+        Napi::Value item = arr.Get(i);
+        if (!item.IsString()) {
+            Napi::TypeError::New(info.Env(), "ingest requires an array of SSTable paths").ThrowAsJavaScriptException();
+            return false;
+        }
+        files.push_back(item.As<Napi::String>().Utf8Value());
+    }
+    move = info.Length() > 1 && info[1].ToBoolean().Value();
+    return true;
+}
+
+} // namespace
+
+Napi::Value TitanKV::Ingest(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    std::vector<std::string> files;
+    bool move = false;
+    if (!readIngestFiles(info, files, move)) return env.Null();
+    try {
+        return Napi::Number::New(env, static_cast<double>(engine_->ingest(files, move)));
+    } catch (const std::exception& e) {
+        Napi::Error::New(env, e.what()).ThrowAsJavaScriptException();
+        return env.Null();
+    }
+}
+
+class IngestAsyncWorker : public Napi::AsyncWorker {
+public:
+    IngestAsyncWorker(Napi::Env& env, titan::TitanEngine* engine, std::vector<std::string> files, bool move)
+        : Napi::AsyncWorker(env), deferred(Napi::Promise::Deferred::New(env)), engine_(engine),
+          files_(std::move(files)), move_(move) {}
+
+    ~IngestAsyncWorker() {}
+
+    void Execute() override {
+        try {
+            records_ = engine_->ingest(files_, move_);
+        } catch (const std::exception& e) {
+            SetError(e.what());
+        }
+    }
+
+    void OnOK() override {
+        deferred.Resolve(Napi::Number::New(Env(), static_cast<double>(records_)));
+    }
+
+    void OnError(const Napi::Error& e) override {
+        deferred.Reject(e.Value());
+    }
+
+    Napi::Promise GetPromise() {
+        return deferred.Promise();
+    }
+
+private:
+    Napi::Promise::Deferred deferred;
+    titan::TitanEngine* engine_;
+    std::vector<std::string> files_;
+    bool move_;
+    size_t records_ = 0;
+};
+
+Napi::Value TitanKV::IngestAsync(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    std::vector<std::string> files;
+    bool move = false;
+    if (!readIngestFiles(info, files, move)) return env.Null();
+    IngestAsyncWorker* worker = new IngestAsyncWorker(env, engine_.get(), std::move(files), move);
+    worker->Queue();
+    return worker->GetPromise();
+}
+
+// subscribe(channel, onMessages): the callback is bound to the first call
+// and invoked without arguments whenever messages are waiting.
+Napi::Value TitanKV::Subscribe(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    if (info.Length() < 2 || !info[0].IsString() || !info[1].IsFunction()) {
+        Napi::TypeError::New(env, "Expected channel and callback").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    try {
+        if (subscriber_ == 0) {
+            messages_ = Napi::ThreadSafeFunction::New(env, info[1].As<Napi::Function>(), "titankv-pubsub", 0, 1);
+            // Subscriptions do not keep the process alive, as before.
+            messages_.Unref(env);
+            subscriber_ = engine_->addSubscriber([messages = messages_] { messages.NonBlockingCall(); });
+        }
+        return Napi::Boolean::New(env, engine_->subscribe(subscriber_, info[0].As<Napi::String>().Utf8Value()));
+    } catch (const std::exception& e) {
+        Napi::Error::New(env, e.what()).ThrowAsJavaScriptException();
+        return env.Null();
+    }
+}
+
+Napi::Value TitanKV::Unsubscribe(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    if (info.Length() < 1 || !info[0].IsString()) {
+        Napi::TypeError::New(env, "Expected channel").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    if (subscriber_ == 0) return Napi::Boolean::New(env, false);
+    try {
+        return Napi::Boolean::New(env, engine_->unsubscribe(subscriber_, info[0].As<Napi::String>().Utf8Value()));
+    } catch (const std::exception& e) {
+        Napi::Error::New(env, e.what()).ThrowAsJavaScriptException();
+        return env.Null();
+    }
+}
+
+// Returns { queued, matches }: how many messages went to other handles'
+// queues, and this handle's matching subscriptions for the caller to
+// deliver synchronously.
+Napi::Value TitanKV::Publish(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    if (info.Length() < 2 || !info[0].IsString()) {
+        Napi::TypeError::New(env, "Expected channel and message").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    try {
+        std::vector<std::string> matches;
+        const size_t queued = engine_->publish(info[0].As<Napi::String>().Utf8Value(), readValueBytes(info[1]),
+                                               subscriber_, &matches);
+        Napi::Object result = Napi::Object::New(env);
+        result.Set("queued", Napi::Number::New(env, static_cast<double>(queued)));
+        Napi::Array arr = Napi::Array::New(env, matches.size());
+        for (size_t i = 0; i < matches.size(); i++) {
+            arr.Set(i, Napi::String::New(env, matches[i]));
+        }
+        result.Set("matches", arr);
+        return result;
+    } catch (const std::exception& e) {
+        Napi::Error::New(env, e.what()).ThrowAsJavaScriptException();
+        return env.Null();
+    }
+}
+
+// Flat [channel, message, pattern, ...] triples; pattern is '' for channel
+// subscriptions. Empty once the handle is closed.
+Napi::Value TitanKV::DrainMessages(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    if (subscriber_ == 0 || !engine_) return Napi::Array::New(env, 0);
+
+    const auto messages = engine_->drainMessages(subscriber_);
+    Napi::Array arr = Napi::Array::New(env, messages.size() * 3);
+    uint32_t index = 0;
+    for (const auto& message : messages) {
+        arr.Set(index++, Napi::String::New(env, message.channel));
+        arr.Set(index++, Napi::String::New(env, message.message));
+        arr.Set(index++, Napi::String::New(env, message.pattern));
+    }
+    return arr;
+}
+
+// The subscriber goes first so no publisher can wake a released function.
+void TitanKV::dropSubscriber() {
+    if (subscriber_ == 0) return;
+    if (engine_) engine_->removeSubscriber(subscriber_);
+    subscriber_ = 0;
+    messages_.Release();
+}
+
+TitanKV::~TitanKV() {
+    dropSubscriber();
+}
+
+Napi::Value TitanKV::Close(const Napi::CallbackInfo& info) {
+    try {
+        dropSubscriber();
+        releaseEngine(engine_, registry_key_);
+    } catch (const std::exception& e) {
+        Napi::Error::New(info.Env(), e.what()).ThrowAsJavaScriptException();
+    }
+    return info.Env().Undefined();
+}
+
+Napi::Value TitanKV::GetStats(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    try {
+        auto stats = engine_->getStats();
+        Napi::Object obj = Napi::Object::New(env);
+        obj.Set("keyCount", Napi::Number::New(env, (double)stats.key_count));
+        obj.Set("rawBytes", Napi::Number::New(env, (double)stats.raw_bytes));
+        obj.Set("compressedBytes", Napi::Number::New(env, (double)stats.compressed_bytes));
+        obj.Set("walBytes", Napi::Number::New(env, (double)stats.wal_size_bytes));
+        obj.Set("logicalWriteBytes", Napi::Number::New(env, (double)stats.logical_write_bytes));
+        obj.Set("physicalWriteBytes", Napi::Number::New(env, (double)stats.physical_write_bytes));
+        obj.Set("compactionCount", Napi::Number::New(env, (double)stats.compaction_count));
+        obj.Set("autoCompactionCount", Napi::Number::New(env, (double)stats.auto_compaction_count));
+        obj.Set("writeAmplification", Napi::Number::New(env, stats.write_amplification));
+        obj.Set("spaceAmplification", Napi::Number::New(env, stats.space_amplification));
+        obj.Set("coldRecompressedCount", Napi::Number::New(env, (double)stats.cold_recompressed_count));
+        obj.Set("coldBytesSaved", Napi::Number::New(env, (double)stats.cold_bytes_saved));
+        obj.Set("memoryBytes", Napi::Number::New(env, (double)stats.memory_bytes));
+        obj.Set("memtableBytes", Napi::Number::New(env, (double)stats.memtable_bytes));
+        obj.Set("tombstoneBytes", Napi::Number::New(env, (double)stats.tombstone_bytes));
+        obj.Set("sstableIndexBytes", Napi::Number::New(env, (double)stats.sstable_index_bytes));
+        obj.Set("collectionBytes", Napi::Number::New(env, (double)stats.collection_bytes));
+        obj.Set("evictedKeys", Napi::Number::New(env, (double)stats.evicted_keys));
+        obj.Set("evictedBytes", Napi::Number::New(env, (double)stats.evicted_bytes));
+
+        double ratio = stats.raw_bytes > 0 ? (double)stats.compressed_bytes / stats.raw_bytes : 0.0;
+        obj.Set("compressionRatio", Napi::Number::New(env, ratio));
+
+        return obj;
+    } catch (const std::exception& e) {
+        Napi::Error::New(env, e.what()).ThrowAsJavaScriptException();
+        return env.Null();
+    }
+}
+
+// Read-only access to a directory's published snapshot; see titan::TitanReader.
+class TitanReader : public Napi::ObjectWrap<TitanReader> {
+public:
+    static Napi::Object Init(Napi::Env env, Napi::Object exports);
+    TitanReader(const Napi::CallbackInfo& info);
+
+private:
+    std::unique_ptr<titan::TitanReader> reader_;
+
+    // Throws a JS error and returns null once the reader is closed.
+    titan::TitanReader* open(Napi::Env env);
+
+    Napi::Value Get(const Napi::CallbackInfo& info);
+    Napi::Value Has(const Napi::CallbackInfo& info);
+    Napi::Value Keys(const Napi::CallbackInfo& info);
+    Napi::Value Scan(const Napi::CallbackInfo& info);
+    Napi::Value Size(const Napi::CallbackInfo& info);
+    Napi::Value Generation(const Napi::CallbackInfo& info);
+    Napi::Value Refresh(const Napi::CallbackInfo& info);
+    Napi::Value Close(const Napi::CallbackInfo& info);
+};
+
+Napi::Object TitanReader::Init(Napi::Env env, Napi::Object exports) {
+    Napi::Function func = DefineClass(env, "TitanReader", {
+        InstanceMethod("get", &TitanReader::Get),
+        InstanceMethod("has", &TitanReader::Has),
+        InstanceMethod("keys", &TitanReader::Keys),
+        InstanceMethod("scan", &TitanReader::Scan),
+        InstanceMethod("size", &TitanReader::Size),
+        InstanceMethod("generation", &TitanReader::Generation),
+        InstanceMethod("refresh", &TitanReader::Refresh),
+        InstanceMethod("close", &TitanReader::Close),
+    });
+
+    exports.Set("TitanReader", func);
+    return exports;
+}
+
+TitanReader::TitanReader(const Napi::CallbackInfo& info) : Napi::ObjectWrap<TitanReader>(info) {
+    Napi::Env env = info.Env();
+    if (info.Length() < 1 || !info[0].IsString()) {
+        Napi::TypeError::New(env, "TitanReader requires a data directory").ThrowAsJavaScriptException();
+        return;
+    }
+
+    try {
+        reader_ = std::make_unique<titan::TitanReader>(info[0].As<Napi::String>().Utf8Value());
+    } catch (const std::exception& e) {
+        Napi::Error::New(env, e.what()).ThrowAsJavaScriptException();
+    }
+}
+
+titan::TitanReader* TitanReader::open(Napi::Env env) {
+    if (!reader_) Napi::Error::New(env, "reader is closed").ThrowAsJavaScriptException();
+    return reader_.get();
+}
+
+Napi::Value TitanReader::Get(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    auto* reader = open(env);
+    if (!reader || info.Length() < 1) return env.Null();
+    try {
+        auto result = reader->get(info[0].As<Napi::String>().Utf8Value());
+        return result ? makeValue(env, std::move(*result), readAsBuffer(info, 1), false) : env.Null();
+    } catch (const std::exception& e) {
+        Napi::Error::New(env, e.what()).ThrowAsJavaScriptException();
+        return env.Null();
+    }
+}
+
+Napi::Value TitanReader::Has(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    auto* reader = open(env);
+    if (!reader || info.Length() < 1) return Napi::Boolean::New(env, false);
+    try {
+        return Napi::Boolean::New(env, reader->has(info[0].As<Napi::String>().Utf8Value()));
+    } catch (const std::exception& e) {
+        Napi::Error::New(env, e.what()).ThrowAsJavaScriptException();
+        return env.Null();
+    }
+}
+
+Napi::Value TitanReader::Keys(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    auto* reader = open(env);
+    if (!reader) return env.Null();
+    size_t limit = 1000;
+    if (info.Length() > 0 && info[0].IsNumber()) limit = info[0].As<Napi::Number>().Int64Value();
+
+    try {
+        auto keys = reader->keys(limit);
+        Napi::Array arr = Napi::Array::New(env, keys.size());
+        for (size_t i = 0; i < keys.size(); i++) {
+            arr.Set(i, Napi::String::New(env, keys[i]));
+        }
+        return arr;
+    } catch (const std::exception& e) {
+        Napi::Error::New(env, e.what()).ThrowAsJavaScriptException();
+        return env.Null();
+    }
+}
+
+Napi::Value TitanReader::Scan(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    auto* reader = open(env);
+    if (!reader) return env.Null();
+    if (info.Length() < 1) return Napi::Array::New(env, 0);
+    std::string prefix = info[0].As<Napi::String>().Utf8Value();
+    size_t limit = 1000;
+    if (info.Length() > 1 && info[1].IsNumber()) limit = info[1].As<Napi::Number>().Int64Value();
+
+    try {
+        auto pairs = reader->scan(prefix, limit);
+        Napi::Array arr = Napi::Array::New(env, pairs.size());
+        for (size_t i = 0; i < pairs.size(); i++) {
+            Napi::Array pair = Napi::Array::New(env, 2);
+            pair.Set((uint32_t)0, Napi::String::New(env, pairs[i].first));
+            pair.Set((uint32_t)1, Napi::String::New(env, pairs[i].second));
+            arr.Set(i, pair);
+        }
+        return arr;
+    } catch (const std::exception& e) {
+        Napi::Error::New(env, e.what()).ThrowAsJavaScriptException();
+        return env.Null();
+    }
+}
+
+Napi::Value TitanReader::Size(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    auto* reader = open(env);
+    return reader ? Napi::Number::New(env, static_cast<double>(reader->size())) : env.Null();
+}
+
+Napi::Value TitanReader::Generation(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    auto* reader = open(env);
+    return reader ? Napi::Number::New(env, static_cast<double>(reader->generation())) : env.Null();
+}
+
+Napi::Value TitanReader::Refresh(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    auto* reader = open(env);
+    if (!reader) return env.Null();
+    try {
+        return Napi::Boolean::New(env, reader->refresh());
+    } catch (const std::exception& e) {
+        Napi::Error::New(env, e.what()).ThrowAsJavaScriptException();
+        return env.Null();
+    }
+}
+
+Napi::Value TitanReader::Close(const Napi::CallbackInfo& info) {
+    reader_.reset();
+    return info.Env().Undefined();
+}
+
+// Offline SSTable builder for TitanKV.ingest(); see titan::SSTableWriter.
+class SSTableWriter : public Napi::ObjectWrap<SSTableWriter> {
+public:
+    static Napi::Object Init(Napi::Env env, Napi::Object exports);
+    SSTableWriter(const Napi::CallbackInfo& info);
+
+private:
+    std::unique_ptr<titan::SSTableWriter> writer_;
+
+    // Throws a JS error and returns null once finished.
+    titan::SSTableWriter* open(Napi::Env env);
+
+    Napi::Value Add(const Napi::CallbackInfo& info);
+    Napi::Value Finish(const Napi::CallbackInfo& info);
+    Napi::Value Size(const Napi::CallbackInfo& info);
+};
+
+Napi::Object SSTableWriter::Init(Napi::Env env, Napi::Object exports) {
+    Napi::Function func = DefineClass(env, "SSTableWriter", {
+        InstanceMethod("add", &SSTableWriter::Add),
+        InstanceMethod("finish", &SSTableWriter::Finish),
+        InstanceMethod("size", &SSTableWriter::Size),
+    });
+
+    exports.Set("SSTableWriter", func);
+    return exports;
+}
+
+SSTableWriter::SSTableWriter(const Napi::CallbackInfo& info) : Napi::ObjectWrap<SSTableWriter>(info) {
+    Napi::Env env = info.Env();
+    if (info.Length() < 1 || !info[0].IsString()) {
+        Napi::TypeError::New(env, "SSTableWriter requires a file path").ThrowAsJavaScriptException();
+        return;
+    }
+    int level = 3;
+    if (info.Length() > 1 && info[1].IsNumber()) level = info[1].As<Napi::Number>().Int32Value();
+
+    try {
+        writer_ = std::make_unique<titan::SSTableWriter>(info[0].As<Napi::String>().Utf8Value(), level);
+    } catch (const std::exception& e) {
+        Napi::Error::New(env, e.what()).ThrowAsJavaScriptException();
+    }
+}
+
+titan::SSTableWriter* SSTableWriter::open(Napi::Env env) {
+    if (!writer_) Napi::Error::New(env, "SSTable writer is finished").ThrowAsJavaScriptException();
+    return writer_.get();
+}
+
+Napi::Value SSTableWriter::Add(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    auto* writer = open(env);
+    if (!writer) return env.Null();
+    if (info.Length() < 2 || !info[0].IsString()) {
+        Napi::TypeError::New(env, "Expected key and value").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    int64_t ttl = 0;
+    if (info.Length() > 2 && info[2].IsNumber()) ttl = info[2].As<Napi::Number>().Int64Value();
+    try {
+        writer->add(info[0].As<Napi::String>().Utf8Value(), readValueBytes(info[1]), ttl);
+    } catch (const std::exception& e) {
+        Napi::Error::New(env, e.what()).ThrowAsJavaScriptException();
+    }
+    return env.Undefined();
+}
+
+Napi::Value SSTableWriter::Finish(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    auto* writer = open(env);
+    if (!writer) return env.Null();
+    try {
+        const size_t records = writer->finish();
+        writer_.reset();
+        return Napi::Number::New(env, static_cast<double>(records));
+    } catch (const std::exception& e) {
+        writer_.reset();
+        Napi::Error::New(env, e.what()).ThrowAsJavaScriptException();
+        return env.Null();
+    }
+}
+
+Napi::Value SSTableWriter::Size(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    auto* writer = open(env);
+    if (!writer) return env.Null();
+    return Napi::Number::New(env, static_cast<double>(writer->size()));
+}
+
+namespace {
+
+Napi::Array makeEntries(Napi::Env env, std::vector<titan::TitanEngine::KVPair>& pairs, bool as_buffer) {
+    Napi::Array arr = Napi::Array::New(env, pairs.size());
+    for (size_t i = 0; i < pairs.size(); i++) {
+        Napi::Array pair = Napi::Array::New(env, 2);
+        pair.Set((uint32_t)0, Napi::String::New(env, pairs[i].first));
+        pair.Set((uint32_t)1, makeValue(env, std::move(pairs[i].second), as_buffer, false));
+        arr.Set(i, pair);
+    }
+    return arr;
+}
+
+size_t readChunkSize(const Napi::CallbackInfo& info, int64_t fallback = 256) {
+    int64_t count = fallback;
+    if (info.Length() > 0 && info[0].IsNumber()) count = info[0].As<Napi::Number>().Int64Value();
+    return static_cast<size_t>(std::max<int64_t>(count, 1));
+}
+
+// { prefix, start, end, reverse } of a cursor or export.
+titan::IterateOptions readIterateOptions(const Napi::Value& value) {
+    titan::IterateOptions options;
+    if (!value.IsObject()) return options;
+    Napi::Object opts = value.As<Napi::Object>();
+    const auto readString = [&](const char* name, std::string& out) {
+        if (opts.Has(name) && opts.Get(name).IsString()) out = opts.Get(name).As<Napi::String>().Utf8Value();
+    };
+    readString("prefix", options.prefix);
+    readString("start", options.start);
+    readString("end", options.end);
+    if (opts.Has("reverse") && opts.Get("reverse").IsBoolean()) {
+        options.reverse = opts.Get("reverse").As<Napi::Boolean>().Value();
+    }
+    return options;
+}
+
+} // namespace
+
+// Pinned point-in-time view; see titan::TitanSnapshot. Like TitanIterator
+// it shares the engine, so it stays readable after other handles close.
+class TitanSnapshot : public Napi::ObjectWrap<TitanSnapshot> {
+public:
+    static Napi::Object Init(Napi::Env env, Napi::Object exports);
+    TitanSnapshot(const Napi::CallbackInfo& info);
+
+    const std::shared_ptr<titan::TitanEngine>& engine() const { return engine_; }
+    // Null once released.
+    const std::unique_ptr<titan::TitanSnapshot>& snapshot() const { return snapshot_; }
+
+private:
+    std::shared_ptr<titan::TitanEngine> engine_;
+    std::unique_ptr<titan::TitanSnapshot> snapshot_;
+
+    // Throws a JS error and returns null once released.
+    titan::TitanSnapshot* open(Napi::Env env);
+
+    Napi::Value Get(const Napi::CallbackInfo& info);
+    Napi::Value Has(const Napi::CallbackInfo& info);
+    Napi::Value Keys(const Napi::CallbackInfo& info);
+    Napi::Value Scan(const Napi::CallbackInfo& info);
+    Napi::Value Range(const Napi::CallbackInfo& info);
+    Napi::Value Sequence(const Napi::CallbackInfo& info);
+    Napi::Value Release(const Napi::CallbackInfo& info);
+};
+
+Napi::Object TitanSnapshot::Init(Napi::Env env, Napi::Object exports) {
+    Napi::Function func = DefineClass(env, "TitanSnapshot", {
+        InstanceMethod("get", &TitanSnapshot::Get),
+        InstanceMethod("has", &TitanSnapshot::Has),
+        InstanceMethod("keys", &TitanSnapshot::Keys),
+        InstanceMethod("scan", &TitanSnapshot::Scan),
+        InstanceMethod("range", &TitanSnapshot::Range),
+        InstanceMethod("sequence", &TitanSnapshot::Sequence),
+        InstanceMethod("release", &TitanSnapshot::Release),
+    });
+
+    exports.Set("TitanSnapshot", func);
+    return exports;
+}
+
+TitanSnapshot::TitanSnapshot(const Napi::CallbackInfo& info) : Napi::ObjectWrap<TitanSnapshot>(info) {
+    Napi::Env env = info.Env();
+    if (info.Length() < 1 || !info[0].IsObject()) {
+        Napi::TypeError::New(env, "TitanSnapshot requires a TitanKV handle").ThrowAsJavaScriptException();
+        return;
+    }
+
+    engine_ = TitanKV::Unwrap(info[0].As<Napi::Object>())->engine();
+    if (!engine_) {
+        Napi::Error::New(env, "database is closed").ThrowAsJavaScriptException();
+        return;
+    }
+
+    try {
+        snapshot_ = engine_->snapshot();
+    } catch (const std::exception& e) {
+        Napi::Error::New(env, e.what()).ThrowAsJavaScriptException();
+    }
+}
+
+titan::TitanSnapshot* TitanSnapshot::open(Napi::Env env) {
+    if (!snapshot_) Napi::Error::New(env, "snapshot is released").ThrowAsJavaScriptException();
+    return snapshot_.get();
+}
+
+Napi::Value TitanSnapshot::Get(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    auto* snapshot = open(env);
+    if (!snapshot || info.Length() < 1) return env.Null();
+    try {
+        auto result = snapshot->get(info[0].As<Napi::String>().Utf8Value());
+        return result ? makeValue(env, std::move(*result), readAsBuffer(info, 1), false) : env.Null();
+    } catch (const std::exception& e) {
+        Napi::Error::New(env, e.what()).ThrowAsJavaScriptException();
+        return env.Null();
+    }
+}
+
+Napi::Value TitanSnapshot::Has(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    auto* snapshot = open(env);
+    if (!snapshot || info.Length() < 1) return Napi::Boolean::New(env, false);
+    try {
+        return Napi::Boolean::New(env, snapshot->has(info[0].As<Napi::String>().Utf8Value()));
+    } catch (const std::exception& e) {
+        Napi::Error::New(env, e.what()).ThrowAsJavaScriptException();
+        return env.Null();
+    }
+}
+
+Napi::Value TitanSnapshot::Keys(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    auto* snapshot = open(env);
+    if (!snapshot) return env.Null();
+    size_t limit = 1000;
+    if (info.Length() > 0 && info[0].IsNumber()) limit = info[0].As<Napi::Number>().Int64Value();
+    titan::IterateOptions options;
+    std::optional<std::string> after;
+    readPageOptions(info, 1, options, after);
+
+    try {
+        auto keys = snapshot->keys(options, limit, after);
+        Napi::Array arr = Napi::Array::New(env, keys.size());
+        for (size_t i = 0; i < keys.size(); i++) {
+            arr.Set(i, Napi::String::New(env, keys[i]));
+        }
+        return arr;
     } catch (const std::exception& e) {
-        Napi::Error::New(info.Env(), e.what()).ThrowAsJavaScriptException();
+        Napi::Error::New(env, e.what()).ThrowAsJavaScriptException();
+        return env.Null();
     }
-    return info.Env().Undefined();
 }
 
-Napi::Value TitanKV::GetBatch(const Napi::CallbackInfo& info) {
+Napi::Value TitanSnapshot::Scan(const Napi::CallbackInfo& info) {
     Napi::Env env = info.Env();
-    if (info.Length() < 1 || !info[0].IsArray()) return Napi::Array::New(env, 0);
-    Napi::Array arr = info[0].As<Napi::Array>();
-    std::vector<std::string> keys;
-    keys.reserve(arr.Length());
-
-    for (uint32_t i = 0; i < arr.Length(); i++) {
-        keys.push_back(arr.Get(i).As<Napi::String>().Utf8Value());
-    }
+    auto* snapshot = open(env);
+    if (!snapshot) return env.Null();
+    if (info.Length() < 1) return Napi::Array::New(env, 0);
+    titan::IterateOptions options;
+    options.prefix = info[0].As<Napi::String>().Utf8Value();
+    size_t limit = 1000;
+    if (info.Length() > 1 && info[1].IsNumber()) limit = info[1].As<Napi::Number>().Int64Value();
+    std::optional<std::string> after;
+    readPageOptions(info, 2, options, after);
 
     try {
-        auto results = engine_->getBatch(keys);
-        Napi::Array out = Napi::Array::New(env, results.size());
-        for (size_t i = 0; i < results.size(); i++) {
-            out.Set(i, results[i] ? Napi::String::New(env, *results[i]) : env.Null());
-        }
-        return out;
+        auto pairs = snapshot->scan(options, limit, after);
+        return makeEntries(env, pairs, false);
     } catch (const std::exception& e) {
         Napi::Error::New(env, e.what()).ThrowAsJavaScriptException();
         return env.Null();
     }
 }
 
-class PutBatchAsyncWorker : public Napi::AsyncWorker {
-public:
-    PutBatchAsyncWorker(
-        Napi::Env& env,
-        titan::TitanEngine* engine,
-        std::vector<std::pair<std::string, std::string>> pairs)
-        : Napi::AsyncWorker(env),
-          deferred(Napi::Promise::Deferred::New(env)),
-          engine_(engine),
-          pairs_(std::move(pairs)) {}
-
-    ~PutBatchAsyncWorker() {}
+Napi::Value TitanSnapshot::Range(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    auto* snapshot = open(env);
+    if (!snapshot) return env.Null();
+    if (info.Length() < 2) return Napi::Array::New(env, 0);
+    titan::IterateOptions options;
+    options.start = info[0].As<Napi::String>().Utf8Value();
+    options.end = info[1].As<Napi::String>().Utf8Value();
+    size_t limit = 1000;
+    if (info.Length() > 2 && info[2].IsNumber()) limit = info[2].As<Napi::Number>().Int64Value();
+    std::optional<std::string> after;
+    readPageOptions(info, 3, options, after);
 
-    void Execute() override {
-        try {
-            engine_->putBatch(pairs_);
-        } catch (const std::exception& e) {
-            SetError(e.what());
-        }
+    try {
+        auto pairs = snapshot->scan(options, limit, after);
+        return makeEntries(env, pairs, false);
+    } catch (const std::exception& e) {
+        Napi::Error::New(env, e.what()).ThrowAsJavaScriptException();
+        return env.Null();
     }
+}
 
-    void OnOK() override {
-        deferred.Resolve(Env().Undefined());
-    }
+Napi::Value TitanSnapshot::Sequence(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    auto* snapshot = open(env);
+    return snapshot ? Napi::Number::New(env, static_cast<double>(snapshot->sequence())) : env.Null();
+}
 
-    void OnError(const Napi::Error& e) override {
-        deferred.Reject(e.Value());
-    }
+// Iterators opened from the snapshot keep their own pin.
+Napi::Value TitanSnapshot::Release(const Napi::CallbackInfo& info) {
+    snapshot_.reset();
+    engine_.reset();
+    return info.Env().Undefined();
+}
 
-    Napi::Promise GetPromise() {
-        return deferred.Promise();
-    }
+// Cursor over one pinned snapshot; see titan::TitanIterator. It shares the
+// engine so chunks can still be pulled after other handles close theirs.
+class TitanIterator : public Napi::ObjectWrap<TitanIterator> {
+public:
+    static Napi::Object Init(Napi::Env env, Napi::Object exports);
+    TitanIterator(const Napi::CallbackInfo& info);
 
 private:
-    Napi::Promise::Deferred deferred;
-    titan::TitanEngine* engine_;
-    std::vector<std::pair<std::string, std::string>> pairs_;
+    std::shared_ptr<titan::TitanEngine> engine_;
+    std::shared_ptr<titan::TitanIterator> iterator_;
+    // Set while a nextAsync() chunk is being read on the threadpool.
+    std::shared_ptr<std::atomic<bool>> busy_ = std::make_shared<std::atomic<bool>>(false);
+
+    // Throws a JS error and returns false when closed or already reading.
+    bool acquire(Napi::Env env);
+
+    Napi::Value Next(const Napi::CallbackInfo& info);
+    Napi::Value NextAsync(const Napi::CallbackInfo& info);
+    Napi::Value Done(const Napi::CallbackInfo& info);
+    Napi::Value Close(const Napi::CallbackInfo& info);
 };
 
-Napi::Value TitanKV::PutBatchAsync(const Napi::CallbackInfo& info) {
+Napi::Object TitanIterator::Init(Napi::Env env, Napi::Object exports) {
+    Napi::Function func = DefineClass(env, "TitanIterator", {
+        InstanceMethod("next", &TitanIterator::Next),
+        InstanceMethod("nextAsync", &TitanIterator::NextAsync),
+        InstanceMethod("done", &TitanIterator::Done),
+        InstanceMethod("close", &TitanIterator::Close),
+    });
+
+    exports.Set("TitanIterator", func);
+    return exports;
+}
+
+TitanIterator::TitanIterator(const Napi::CallbackInfo& info) : Napi::ObjectWrap<TitanIterator>(info) {
     Napi::Env env = info.Env();
-    if (info.Length() < 1 || !info[0].IsArray()) {
-        Napi::TypeError::New(env, "Expected array of key-value pairs").ThrowAsJavaScriptException();
-        return env.Null();
+    if (info.Length() < 1 || !info[0].IsObject()) {
+        Napi::TypeError::New(env, "TitanIterator requires a TitanKV handle").ThrowAsJavaScriptException();
+        return;
     }
 
-    Napi::Array arr = info[0].As<Napi::Array>();
-    std::vector<std::pair<std::string, std::string>> pairs;
-    pairs.reserve(arr.Length());
+    const titan::IterateOptions options = info.Length() > 1 ? readIterateOptions(info[1]) : titan::IterateOptions{};
 
-    for (uint32_t i = 0; i < arr.Length(); i++) {
-        Napi::Value item = arr.Get(i);
-        if (item.IsArray()) {
-            Napi::Array pair = item.As<Napi::Array>();
-            if (pair.Length() >= 2) {
-                pairs.emplace_back(
-                    pair.Get((uint32_t)0).As<Napi::String>().Utf8Value(),
-                    pair.Get((uint32_t)1).As<Napi::String>().Utf8Value()
-                );
-            }
+    // A third argument opens the cursor on that TitanSnapshot instead of
+    // pinning a new one.
+    const titan::TitanSnapshot* snapshot = nullptr;
+    if (info.Length() > 2 && info[2].IsObject()) {
+        auto* pinned = TitanSnapshot::Unwrap(info[2].As<Napi::Object>());
+        if (!pinned->snapshot()) {
+            Napi::Error::New(env, "snapshot is released").ThrowAsJavaScriptException();
+            return;
         }
+        engine_ = pinned->engine();
+        snapshot = pinned->snapshot().get();
+    } else {
+        engine_ = TitanKV::Unwrap(info[0].As<Napi::Object>())->engine();
+    }
+    if (!engine_) {
+        Napi::Error::New(env, "database is closed").ThrowAsJavaScriptException();
+        return;
     }
 
-    PutBatchAsyncWorker* worker = new PutBatchAsyncWorker(env, engine_.get(), std::move(pairs));
-    worker->Queue();
-    return worker->GetPromise();
+    try {
+        iterator_ = snapshot ? snapshot->iterate(options) : engine_->iterate(options);
+    } catch (const std::exception& e) {
+        Napi::Error::New(env, e.what()).ThrowAsJavaScriptException();
+    }
 }
 
-class GetBatchAsyncWorker : public Napi::AsyncWorker {
+bool TitanIterator::acquire(Napi::Env env) {
+    if (!iterator_) {
+        Napi::Error::New(env, "iterator is closed").ThrowAsJavaScriptException();
+        return false;
+    }
+    if (busy_->exchange(true)) {
+        Napi::Error::New(env, "iterator is already reading a chunk").ThrowAsJavaScriptException();
+        return false;
+    }
+    return true;
+}
+
+Napi::Value TitanIterator::Next(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    if (!acquire(env)) return env.Null();
+    try {
+        auto pairs = iterator_->next(readChunkSize(info));
+        busy_->store(false);
+        return makeEntries(env, pairs, readAsBuffer(info, 1));
+    } catch (const std::exception& e) {
+        busy_->store(false);
+        Napi::Error::New(env, e.what()).ThrowAsJavaScriptException();
+        return env.Null();
+    }
+}
+
+class IteratorNextAsyncWorker : public Napi::AsyncWorker {
 public:
-    GetBatchAsyncWorker(
-        Napi::Env& env,
-        titan::TitanEngine* engine,
-        std::vector<std::string> keys)
+    IteratorNextAsyncWorker(Napi::Env& env, std::shared_ptr<titan::TitanEngine> engine,
+                            std::shared_ptr<titan::TitanIterator> iterator, std::shared_ptr<std::atomic<bool>> busy,
+                            size_t count, bool as_buffer)
         : Napi::AsyncWorker(env),
           deferred(Napi::Promise::Deferred::New(env)),
-          engine_(engine),
-          keys_(std::move(keys)) {}
+          engine_(std::move(engine)),
+          iterator_(std::move(iterator)),
+          busy_(std::move(busy)),
+          count_(count),
+          as_buffer_(as_buffer) {}
 
-    ~GetBatchAsyncWorker() {}
+    ~IteratorNextAsyncWorker() {}
 
     void Execute() override {
         try {
-            results_ = engine_->getBatch(keys_);
+            pairs_ = iterator_->next(count_);
         } catch (const std::exception& e) {
             SetError(e.what());
         }
+        busy_->store(false);
     }
 
     void OnOK() override {
-        Napi::Env env = Env();
-        Napi::Array out = Napi::Array::New(env, results_.size());
-        for (size_t i = 0; i < results_.size(); i++) {
-            out.Set(i, results_[i] ? Napi::String::New(env, *results_[i]) : env.Null());
-        }
-        deferred.Resolve(out);
+        deferred.Resolve(makeEntries(Env(), pairs_, as_buffer_));
     }
 
     void OnError(const Napi::Error& e) override {
@@ -812,80 +3106,133 @@ public:
 
 private:
     Napi::Promise::Deferred deferred;
-    titan::TitanEngine* engine_;
-    std::vector<std::string> keys_;
-    std::vector<std::optional<std::string>> results_;
+    // Both stay alive until the chunk is read, even if the iterator is
+    // closed meanwhile.
+    std::shared_ptr<titan::TitanEngine> engine_;
+    std::shared_ptr<titan::TitanIterator> iterator_;
+    std::shared_ptr<std::atomic<bool>> busy_;
+    size_t count_;
+    bool as_buffer_;
+    std::vector<titan::TitanEngine::KVPair> pairs_;
 };
 
-Napi::Value TitanKV::GetBatchAsync(const Napi::CallbackInfo& info) {
+Napi::Value TitanIterator::NextAsync(const Napi::CallbackInfo& info) {
     Napi::Env env = info.Env();
-    if (info.Length() < 1 || !info[0].IsArray()) {
-        Napi::TypeError::New(env, "Expected array of keys").ThrowAsJavaScriptException();
-        return env.Null();
-    }
-
-    Napi::Array arr = info[0].As<Napi::Array>();
-    std::vector<std::string> keys;
-    keys.reserve(arr.Length());
+    if (!acquire(env)) return env.Null();
 
-    for (uint32_t i = 0; i < arr.Length(); i++) {
-        keys.push_back(arr.Get(i).As<Napi::String>().Utf8Value());
-    }
-
-    GetBatchAsyncWorker* worker = new GetBatchAsyncWorker(env, engine_.get(), std::move(keys));
+    auto* worker = new IteratorNextAsyncWorker(env, engine_, iterator_, busy_, readChunkSize(info),
+                                               readAsBuffer(info, 1));
     worker->Queue();
     return worker->GetPromise();
 }
 
-class FlushAsyncWorker : public Napi::AsyncWorker {
+Napi::Value TitanIterator::Done(const Napi::CallbackInfo& info) {
+    return Napi::Boolean::New(info.Env(), !iterator_ || (!busy_->load() && iterator_->done()));
+}
+
+// Releases the snapshot pin; a chunk still being read finishes first.
+Napi::Value TitanIterator::Close(const Napi::CallbackInfo& info) {
+    iterator_.reset();
+    engine_.reset();
+    return info.Env().Undefined();
+}
+
+// NDJSON export over a snapshot; see titan::TitanExporter. Chunks are
+// produced on the threadpool like TitanIterator's, one at a time.
+class TitanExporter : public Napi::ObjectWrap<TitanExporter> {
 public:
-    FlushAsyncWorker(Napi::Env& env, titan::TitanEngine* engine)
-        : Napi::AsyncWorker(env), deferred(Napi::Promise::Deferred::New(env)), engine_(engine) {}
+    static Napi::Object Init(Napi::Env env, Napi::Object exports);
+    TitanExporter(const Napi::CallbackInfo& info);
 
-    ~FlushAsyncWorker() {}
+private:
+    std::shared_ptr<titan::TitanEngine> engine_;
+    std::shared_ptr<titan::TitanExporter> exporter_;
+    // Set while nextAsync() is encoding a chunk.
+    std::shared_ptr<std::atomic<bool>> busy_ = std::make_shared<std::atomic<bool>>(false);
 
-    void Execute() override {
-        try {
-            engine_->flush();
-        } catch (const std::exception& e) {
-            SetError(e.what());
-        }
-    }
+    Napi::Value NextAsync(const Napi::CallbackInfo& info);
+    Napi::Value Records(const Napi::CallbackInfo& info);
+    Napi::Value Close(const Napi::CallbackInfo& info);
+};
 
-    void OnOK() override {
-        deferred.Resolve(Env().Undefined());
+Napi::Object TitanExporter::Init(Napi::Env env, Napi::Object exports) {
+    Napi::Function func = DefineClass(env, "TitanExporter", {
+        InstanceMethod("nextAsync", &TitanExporter::NextAsync),
+        InstanceMethod("records", &TitanExporter::Records),
+        InstanceMethod("close", &TitanExporter::Close),
+    });
+
+    exports.Set("TitanExporter", func);
+    return exports;
+}
+
+// (dbHandle, { prefix, start, end, reverse, compressionLevel }, snapshot?)
+TitanExporter::TitanExporter(const Napi::CallbackInfo& info) : Napi::ObjectWrap<TitanExporter>(info) {
+    Napi::Env env = info.Env();
+    if (info.Length() < 1 || !info[0].IsObject()) {
+        Napi::TypeError::New(env, "TitanExporter requires a TitanKV handle").ThrowAsJavaScriptException();
+        return;
     }
 
-    void OnError(const Napi::Error& e) override {
-        deferred.Reject(e.Value());
+    const titan::IterateOptions options = info.Length() > 1 ? readIterateOptions(info[1]) : titan::IterateOptions{};
+    int compression_level = 0;
+    if (info.Length() > 1 && info[1].IsObject()) {
+        Napi::Object opts = info[1].As<Napi::Object>();
+        if (opts.Has("compressionLevel") && opts.Get("compressionLevel").IsNumber()) {
+            compression_level = opts.Get("compressionLevel").As<Napi::Number>().Int32Value();
+        }
     }
 
-    Napi::Promise GetPromise() {
-        return deferred.Promise();
+    const titan::TitanSnapshot* snapshot = nullptr;
+    if (info.Length() > 2 && info[2].IsObject()) {
+        auto* pinned = TitanSnapshot::Unwrap(info[2].As<Napi::Object>());
+        if (!pinned->snapshot()) {
+            Napi::Error::New(env, "snapshot is released").ThrowAsJavaScriptException();
+            return;
+        }
+        engine_ = pinned->engine();
+        snapshot = pinned->snapshot().get();
+    } else {
+        engine_ = TitanKV::Unwrap(info[0].As<Napi::Object>())->engine();
+    }
+    if (!engine_) {
+        Napi::Error::New(env, "database is closed").ThrowAsJavaScriptException();
+        return;
     }
 
-private:
-    Napi::Promise::Deferred deferred;
-    titan::TitanEngine* engine_;
-};
+    try {
+        exporter_ = snapshot ? snapshot->exportNdjson(options, compression_level)
+                             : engine_->exportNdjson(options, compression_level);
+    } catch (const std::exception& e) {
+        Napi::Error::New(env, e.what()).ThrowAsJavaScriptException();
+    }
+}
 
-class CompactAsyncWorker : public Napi::AsyncWorker {
+class ExportNextAsyncWorker : public Napi::AsyncWorker {
 public:
-    CompactAsyncWorker(Napi::Env& env, titan::TitanEngine* engine)
-        : Napi::AsyncWorker(env), deferred(Napi::Promise::Deferred::New(env)), engine_(engine) {}
+    ExportNextAsyncWorker(Napi::Env& env, std::shared_ptr<titan::TitanEngine> engine,
+                          std::shared_ptr<titan::TitanExporter> exporter, std::shared_ptr<std::atomic<bool>> busy,
+                          size_t chunk_bytes)
+        : Napi::AsyncWorker(env),
+          deferred(Napi::Promise::Deferred::New(env)),
+          engine_(std::move(engine)),
+          exporter_(std::move(exporter)),
+          busy_(std::move(busy)),
+          chunk_bytes_(chunk_bytes) {}
 
-    ~CompactAsyncWorker() {}
+    ~ExportNextAsyncWorker() {}
 
     void Execute() override {
         try {
-            engine_->compact();
+            chunk_ = exporter_->next(chunk_bytes_);
         } catch (const std::exception& e) {
             SetError(e.what());
         }
+        busy_->store(false);
     }
 
     void OnOK() override {
-        deferred.Resolve(Env().Undefined());
+        deferred.Resolve(Napi::Buffer<char>::Copy(Env(), chunk_.data(), chunk_.size()));
     }
 
     void OnError(const Napi::Error& e) override {
@@ -898,78 +3245,55 @@ public:
 
 private:
     Napi::Promise::Deferred deferred;
-    titan::TitanEngine* engine_;
+    std::shared_ptr<titan::TitanEngine> engine_;
+    std::shared_ptr<titan::TitanExporter> exporter_;
+    std::shared_ptr<std::atomic<bool>> busy_;
+    size_t chunk_bytes_;
+    std::string chunk_;
 };
 
-Napi::Value TitanKV::Flush(const Napi::CallbackInfo& info) {
-    try {
-        engine_->flush();
-    } catch (const std::exception& e) {
-        Napi::Error::New(info.Env(), e.what()).ThrowAsJavaScriptException();
-    }
-    return info.Env().Undefined();
-}
-
-Napi::Value TitanKV::FlushAsync(const Napi::CallbackInfo& info) {
+// nextAsync(chunkBytes): resolves to a Buffer, empty once the export is
+// complete.
+Napi::Value TitanExporter::NextAsync(const Napi::CallbackInfo& info) {
     Napi::Env env = info.Env();
-    FlushAsyncWorker* worker = new FlushAsyncWorker(env, engine_.get());
-    worker->Queue();
-    return worker->GetPromise();
-}
-
-Napi::Value TitanKV::Compact(const Napi::CallbackInfo& info) {
-    try {
-        engine_->compact();
-    } catch (const std::exception& e) {
-        Napi::Error::New(info.Env(), e.what()).ThrowAsJavaScriptException();
+    if (!exporter_) {
+        Napi::Error::New(env, "exporter is closed").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    if (busy_->exchange(true)) {
+        Napi::Error::New(env, "exporter is already encoding a chunk").ThrowAsJavaScriptException();
+        return env.Null();
     }
-    return info.Env().Undefined();
-}
 
-Napi::Value TitanKV::CompactAsync(const Napi::CallbackInfo& info) {
-    Napi::Env env = info.Env();
-    CompactAsyncWorker* worker = new CompactAsyncWorker(env, engine_.get());
+    auto* worker = new ExportNextAsyncWorker(env, engine_, exporter_, busy_, readChunkSize(info, 64 * 1024));
     worker->Queue();
     return worker->GetPromise();
 }
 
-Napi::Value TitanKV::Close(const Napi::CallbackInfo& info) {
-    try {
-        if (engine_) engine_->close();
-    } catch (const std::exception& e) {
-        Napi::Error::New(info.Env(), e.what()).ThrowAsJavaScriptException();
-    }
-    return info.Env().Undefined();
-}
-
-Napi::Value TitanKV::GetStats(const Napi::CallbackInfo& info) {
+Napi::Value TitanExporter::Records(const Napi::CallbackInfo& info) {
     Napi::Env env = info.Env();
-    try {
-        auto stats = engine_->getStats();
-        Napi::Object obj = Napi::Object::New(env);
-        obj.Set("keyCount", Napi::Number::New(env, (double)stats.key_count));
-        obj.Set("rawBytes", Napi::Number::New(env, (double)stats.raw_bytes));
-        obj.Set("compressedBytes", Napi::Number::New(env, (double)stats.compressed_bytes));
-        obj.Set("walBytes", Napi::Number::New(env, (double)stats.wal_size_bytes));
-        obj.Set("logicalWriteBytes", Napi::Number::New(env, (double)stats.logical_write_bytes));
-        obj.Set("physicalWriteBytes", Napi::Number::New(env, (double)stats.physical_write_bytes));
-        obj.Set("compactionCount", Napi::Number::New(env, (double)stats.compaction_count));
-        obj.Set("autoCompactionCount", Napi::Number::New(env, (double)stats.auto_compaction_count));
-        obj.Set("writeAmplification", Napi::Number::New(env, stats.write_amplification));
-        obj.Set("spaceAmplification", Napi::Number::New(env, stats.space_amplification));
-
-        double ratio = stats.raw_bytes > 0 ? (double)stats.compressed_bytes / stats.raw_bytes : 0.0;
-        obj.Set("compressionRatio", Napi::Number::New(env, ratio));
-
-        return obj;
-    } catch (const std::exception& e) {
-        Napi::Error::New(env, e.what()).ThrowAsJavaScriptException();
+    if (!exporter_) return Napi::Number::New(env, 0);
+    if (busy_->load()) {
+        Napi::Error::New(env, "exporter is already encoding a chunk").ThrowAsJavaScriptException();
         return env.Null();
     }
+    return Napi::Number::New(env, static_cast<double>(exporter_->records()));
+}
+
+// Releases the snapshot pin; a chunk still being encoded finishes first.
+Napi::Value TitanExporter::Close(const Napi::CallbackInfo& info) {
+    exporter_.reset();
+    engine_.reset();
+    return info.Env().Undefined();
 }
 
 Napi::Object Init(Napi::Env env, Napi::Object exports) {
-    return TitanKV::Init(env, exports);
+    TitanKV::Init(env, exports);
+    TitanReader::Init(env, exports);
+    SSTableWriter::Init(env, exports);
+    TitanSnapshot::Init(env, exports);
+    TitanExporter::Init(env, exports);
+    return TitanIterator::Init(env, exports);
 }
 
 NODE_API_MODULE(titankv, Init)
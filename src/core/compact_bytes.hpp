@@ -0,0 +1,122 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory_resource>
+#include <span>
+
+namespace titan {
+
+// Byte buffer for memtable values. Payloads up to kInlineBytes are stored in
+// the object itself (small zstd frames such as counters and flags fit); larger
+// ones are carved from the owning memory resource, normally the memtable arena.
+// Follows pmr container rules: copies use the default resource unless an
+// allocator is supplied, moves keep the source resource.
+class CompactBytes {
+public:
+    using allocator_type = std::pmr::polymorphic_allocator<std::byte>;
+    static constexpr size_t kInlineBytes = 16;
+
+    CompactBytes() noexcept {}
+    explicit CompactBytes(const allocator_type& alloc) noexcept : alloc_(alloc) {}
+
+    CompactBytes(std::span<const uint8_t> bytes, const allocator_type& alloc = {}) : alloc_(alloc) {
+        assign(bytes);
+    }
+
+    CompactBytes(const CompactBytes& other) : CompactBytes(other.view()) {}
+    CompactBytes(const CompactBytes& other, const allocator_type& alloc) : alloc_(alloc) {
+        assign(other.view());
+    }
+
+    CompactBytes(CompactBytes&& other) noexcept : alloc_(other.alloc_) {
+        steal(other);
+    }
+
+    CompactBytes(CompactBytes&& other, const allocator_type& alloc) : alloc_(alloc) {
+        if (alloc_ == other.alloc_) {
+            steal(other);
+        } else {
+            assign(other.view());
+        }
+    }
+
+    CompactBytes& operator=(const CompactBytes& other) {
+        if (this != &other) assign(other.view());
+        return *this;
+    }
+
+    CompactBytes& operator=(CompactBytes&& other) {
+        if (this == &other) return *this;
+        if (alloc_ == other.alloc_) {
+            release();
+            steal(other);
+        } else {
+            assign(other.view());
+        }
+        return *this;
+    }
+
+    ~CompactBytes() { release(); }
+
+    void assign(std::span<const uint8_t> bytes) {
+        const size_t n = bytes.size();
+        if (n <= kInlineBytes) {
+            uint8_t tmp[kInlineBytes];
+            if (n > 0) std::memcpy(tmp, bytes.data(), n);
+            release();
+            if (n > 0) std::memcpy(inline_, tmp, n);
+            size_ = static_cast<uint32_t>(n);
+            return;
+        }
+
+        auto* block = static_cast<uint8_t*>(alloc_.resource()->allocate(n, alignof(uint8_t)));
+        std::memcpy(block, bytes.data(), n);
+        release();
+        heap_ = block;
+        size_ = static_cast<uint32_t>(n);
+    }
+
+    void clear() noexcept { release(); }
+
+    const uint8_t* data() const noexcept { return isInline() ? inline_ : heap_; }
+    size_t size() const noexcept { return size_; }
+    bool empty() const noexcept { return size_ == 0; }
+    const uint8_t* begin() const noexcept { return data(); }
+    const uint8_t* end() const noexcept { return data() + size_; }
+
+    std::span<const uint8_t> view() const noexcept { return {data(), size_}; }
+    operator std::span<const uint8_t>() const noexcept { return view(); }
+
+    allocator_type get_allocator() const noexcept { return alloc_; }
+
+private:
+    allocator_type alloc_;
+    uint32_t size_ = 0;
+    union {
+        uint8_t inline_[kInlineBytes];
+        uint8_t* heap_;
+    };
+
+    bool isInline() const noexcept { return size_ <= kInlineBytes; }
+
+    void release() noexcept {
+        if (!isInline()) {
+            alloc_.resource()->deallocate(heap_, size_, alignof(uint8_t));
+        }
+        size_ = 0;
+    }
+
+    void steal(CompactBytes& other) noexcept {
+        size_ = other.size_;
+        if (other.isInline()) {
+            std::memcpy(inline_, other.inline_, size_);
+        } else {
+            heap_ = other.heap_;
+        }
+        other.size_ = 0;
+    }
+};
+
+} // namespace titan
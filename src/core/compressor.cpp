@@ -1,10 +1,143 @@
 #include "compressor.hpp"
 #include "utils.hpp"
 #include <zstd.h>
+#include <zdict.h>
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+#include <map>
+#include <mutex>
+#include <shared_mutex>
 #include <stdexcept>
+#include <unordered_map>
 
 namespace titan {
 
+namespace {
+
+// Values written with CompressionCodec::None are kept in a zstd skippable
+// frame: magic + little-endian length + raw bytes. Using the skippable range
+// keeps them walkable alongside regular frames.
+constexpr uint32_t kStoredFrameMagic = 0x184D2A5E;
+constexpr size_t kStoredFrameHeader = 8;
+// Integer frames use a neighbouring skippable magic with an 8-byte payload.
+constexpr uint32_t kIntegerFrameMagic = 0x184D2A5D;
+constexpr size_t kIntegerFrameBytes = Compressor::kIntegerFrameBytes;
+static_assert(kIntegerFrameBytes == kStoredFrameHeader + sizeof(int64_t));
+
+struct FrameInfo {
+    size_t compressed_size = 0;
+    size_t content_size = 0;
+    bool stored = false;
+    bool integer = false;
+};
+
+uint32_t readLE32(const uint8_t* p) {
+    return static_cast<uint32_t>(p[0]) |
+           (static_cast<uint32_t>(p[1]) << 8) |
+           (static_cast<uint32_t>(p[2]) << 16) |
+           (static_cast<uint32_t>(p[3]) << 24);
+}
+
+void writeLE32(uint8_t* p, uint32_t v) {
+    p[0] = static_cast<uint8_t>(v);
+    p[1] = static_cast<uint8_t>(v >> 8);
+    p[2] = static_cast<uint8_t>(v >> 16);
+    p[3] = static_cast<uint8_t>(v >> 24);
+}
+
+int64_t readIntegerPayload(const uint8_t* frame) {
+    uint64_t bits = 0;
+    for (int i = 7; i >= 0; i--) bits = (bits << 8) | frame[kStoredFrameHeader + i];
+    return static_cast<int64_t>(bits);
+}
+
+size_t decimalLength(int64_t value) {
+    size_t length = value < 0 ? 2 : 1;
+    uint64_t magnitude = value < 0 ? 0 - static_cast<uint64_t>(value) : static_cast<uint64_t>(value);
+    while (magnitude >= 10) {
+        magnitude /= 10;
+        length++;
+    }
+    return length;
+}
+
+FrameInfo readFrameInfo(const uint8_t* src, size_t remaining) {
+    FrameInfo info;
+    if (remaining >= kStoredFrameHeader && readLE32(src) == kIntegerFrameMagic) {
+        TITAN_ASSERT(remaining >= kIntegerFrameBytes && readLE32(src + 4) == sizeof(int64_t), "truncated integer frame");
+        info.integer = true;
+        info.compressed_size = kIntegerFrameBytes;
+        info.content_size = decimalLength(readIntegerPayload(src));
+        return info;
+    }
+    if (remaining >= kStoredFrameHeader && readLE32(src) == kStoredFrameMagic) {
+        info.stored = true;
+        info.content_size = readLE32(src + 4);
+        info.compressed_size = kStoredFrameHeader + info.content_size;
+        TITAN_ASSERT(info.compressed_size <= remaining, "truncated stored frame");
+        return info;
+    }
+
+    info.compressed_size = ZSTD_findFrameCompressedSize(src, remaining);
+    TITAN_ASSERT(!ZSTD_isError(info.compressed_size), "invalid compressed frame");
+
+    const unsigned long long frame_content = ZSTD_getFrameContentSize(src, info.compressed_size);
+    TITAN_ASSERT(frame_content != ZSTD_CONTENTSIZE_UNKNOWN, "unknown content size");
+    TITAN_ASSERT(frame_content != ZSTD_CONTENTSIZE_ERROR, "invalid compressed data");
+    info.content_size = static_cast<size_t>(frame_content);
+    return info;
+}
+
+struct DictionaryRegistry {
+    std::shared_mutex mutex;
+    std::unordered_map<uint32_t, ZSTD_DDict*> ddicts;
+    std::unordered_map<uint32_t, std::string> raw;
+    std::map<std::pair<uint32_t, int>, ZSTD_CDict*> cdicts;
+
+    ~DictionaryRegistry() {
+        for (auto& [_, d] : ddicts) ZSTD_freeDDict(d);
+        for (auto& [_, c] : cdicts) ZSTD_freeCDict(c);
+    }
+};
+
+DictionaryRegistry& dictionaries() {
+    static DictionaryRegistry registry;
+    return registry;
+}
+
+ZSTD_DDict* findDDict(uint32_t dict_id) {
+    auto& registry = dictionaries();
+    std::shared_lock lock(registry.mutex);
+    auto it = registry.ddicts.find(dict_id);
+    return it == registry.ddicts.end() ? nullptr : it->second;
+}
+
+// CDicts are digested per compression level, so they are built lazily the
+// first time a (dictionary, level) pair is used and then reused.
+ZSTD_CDict* findCDict(uint32_t dict_id, int level) {
+    auto& registry = dictionaries();
+    {
+        std::shared_lock lock(registry.mutex);
+        auto it = registry.cdicts.find({dict_id, level});
+        if (it != registry.cdicts.end()) return it->second;
+    }
+
+    std::unique_lock lock(registry.mutex);
+    auto it = registry.cdicts.find({dict_id, level});
+    if (it != registry.cdicts.end()) return it->second;
+
+    auto raw = registry.raw.find(dict_id);
+    TITAN_ASSERT(raw != registry.raw.end(), "unknown compression dictionary");
+
+    ZSTD_CDict* cdict = ZSTD_createCDict(raw->second.data(), raw->second.size(), level);
+    TITAN_ASSERT(cdict != nullptr, "failed to create ZSTD compression dictionary");
+    registry.cdicts[{dict_id, level}] = cdict;
+    return cdict;
+}
+
+} // namespace
+
 Compressor::Compressor() {
     cctx_ = ZSTD_createCCtx();
     dctx_ = ZSTD_createDCtx();
@@ -17,51 +150,247 @@ Compressor::~Compressor() {
     if (dctx_) ZSTD_freeDCtx(dctx_);
 }
 
+void Compressor::beginStream(int level) {
+    ZSTD_CCtx_reset(cctx_, ZSTD_reset_session_and_parameters);
+    const size_t result = ZSTD_CCtx_setParameter(cctx_, ZSTD_c_compressionLevel, level);
+    if (ZSTD_isError(result)) {
+        throw std::runtime_error(std::string("compression failed: ") + ZSTD_getErrorName(result));
+    }
+}
+
+void Compressor::compressStream(std::string_view data, bool end, std::string& out) {
+    ZSTD_inBuffer input{data.data(), data.size(), 0};
+    const ZSTD_EndDirective mode = end ? ZSTD_e_end : ZSTD_e_continue;
+    size_t remaining = 0;
+    do {
+        const size_t base = out.size();
+        const size_t capacity = ZSTD_CStreamOutSize();
+        out.resize(base + capacity);
+        ZSTD_outBuffer output{out.data() + base, capacity, 0};
+        remaining = ZSTD_compressStream2(cctx_, &output, &input, mode);
+        out.resize(base + output.pos);
+        if (ZSTD_isError(remaining)) {
+            throw std::runtime_error(std::string("compression failed: ") + ZSTD_getErrorName(remaining));
+        }
+    } while (end ? remaining != 0 : input.pos < input.size);
+}
+
 std::vector<uint8_t> Compressor::compress(const std::string& data, int level) {
-    if (data.empty()) return {};
+    CompressionSpec spec;
+    spec.level = level;
+    return compress(data, spec);
+}
 
-    size_t bound = ZSTD_compressBound(data.size());
-    std::vector<uint8_t> buffer(bound);
+std::optional<int64_t> Compressor::parseCanonicalInteger(std::string_view text) {
+    if (text.empty() || text.size() > 20) return std::nullopt;
 
-    size_t result = ZSTD_compressCCtx(cctx_, buffer.data(), bound, data.data(), data.size(), level);
-    TITAN_ASSERT(!ZSTD_isError(result),
-        std::string("compression failed: ") + ZSTD_getErrorName(result));
+    int64_t value = 0;
+    const char* end = text.data() + text.size();
+    auto [ptr, ec] = std::from_chars(text.data(), end, value);
+    if (ec != std::errc() || ptr != end) return std::nullopt;
+    // Leading zeros and "-0" would not survive the round trip.
+    if (text.size() > 1 && (text[0] == '0' || (text[0] == '-' && text[1] == '0'))) return std::nullopt;
+    return value;
+}
+
+std::array<uint8_t, Compressor::kIntegerFrameBytes> Compressor::encodeInteger(int64_t value) {
+    std::array<uint8_t, kIntegerFrameBytes> frame{};
+    writeLE32(frame.data(), kIntegerFrameMagic);
+    writeLE32(frame.data() + 4, sizeof(int64_t));
+    const auto bits = static_cast<uint64_t>(value);
+    for (size_t i = 0; i < sizeof(bits); i++) {
+        frame[kStoredFrameHeader + i] = static_cast<uint8_t>(bits >> (8 * i));
+    }
+    return frame;
+}
+
+std::optional<int64_t> Compressor::decodeInteger(std::span<const uint8_t> compressed) {
+    if (compressed.size() != kIntegerFrameBytes || readLE32(compressed.data()) != kIntegerFrameMagic) {
+        return std::nullopt;
+    }
+    return readIntegerPayload(compressed.data());
+}
 
-    buffer.resize(result);
+std::vector<uint8_t> Compressor::compress(const std::string& data, const CompressionSpec& spec) {
+    if (data.empty()) return {};
+
+    std::vector<uint8_t> buffer;
+    compressAppend(data.data(), data.size(), spec, buffer);
     return buffer;
 }
 
-std::string Compressor::decompress(const std::vector<uint8_t>& compressed) {
-    if (compressed.empty()) return "";
+void Compressor::compressAppend(const char* data, size_t size, const CompressionSpec& spec, std::vector<uint8_t>& out) {
+    ZSTD_CDict* cdict = nullptr;
+    if (spec.codec == CompressionCodec::Zstd && spec.dict_id != 0) {
+        cdict = findCDict(spec.dict_id, spec.level);
+    }
+
+    for (size_t pos = 0; pos < size; pos += kFrameBytes) {
+        const size_t frame_size = std::min(kFrameBytes, size - pos);
+        const size_t base = out.size();
+
+        if (spec.codec == CompressionCodec::None) {
+            out.resize(base + kStoredFrameHeader + frame_size);
+            writeLE32(out.data() + base, kStoredFrameMagic);
+            writeLE32(out.data() + base + 4, static_cast<uint32_t>(frame_size));
+            std::memcpy(out.data() + base + kStoredFrameHeader, data + pos, frame_size);
+            continue;
+        }
 
-    unsigned long long content_size = ZSTD_getFrameContentSize(compressed.data(), compressed.size());
-    TITAN_ASSERT(content_size != ZSTD_CONTENTSIZE_UNKNOWN, "unknown content size");
-    TITAN_ASSERT(content_size != ZSTD_CONTENTSIZE_ERROR, "invalid compressed data");
+        const size_t bound = ZSTD_compressBound(frame_size);
+        out.resize(base + bound);
 
-    constexpr unsigned long long MAX_DECOMPRESS = 100ULL * 1024 * 1024;
-    if (content_size >= MAX_DECOMPRESS) {
-        throw std::runtime_error("decompressed size exceeds 100MB limit");
+        size_t result = cdict
+            ? ZSTD_compress_usingCDict(cctx_, out.data() + base, bound, data + pos, frame_size, cdict)
+            : ZSTD_compressCCtx(cctx_, out.data() + base, bound, data + pos, frame_size, spec.level);
+        TITAN_ASSERT(!ZSTD_isError(result),
+            std::string("compression failed: ") + ZSTD_getErrorName(result));
+
+        out.resize(base + result);
     }
+}
 
-    std::string output;
-    output.resize(content_size);
+size_t Compressor::decompressFrame(const uint8_t* src, size_t src_size, char* dst, size_t dst_capacity) {
+    const unsigned dict_id = ZSTD_getDictID_fromFrame(src, src_size);
 
-    size_t result = ZSTD_decompressDCtx(dctx_, output.data(), content_size,
-                                         compressed.data(), compressed.size());
+    size_t result;
+    if (dict_id != 0) {
+        ZSTD_DDict* ddict = findDDict(dict_id);
+        if (!ddict) {
+            throw std::runtime_error("missing compression dictionary " + std::to_string(dict_id));
+        }
+        result = ZSTD_decompress_usingDDict(dctx_, dst, dst_capacity, src, src_size, ddict);
+    } else {
+        result = ZSTD_decompressDCtx(dctx_, dst, dst_capacity, src, src_size);
+    }
     TITAN_ASSERT(!ZSTD_isError(result),
         std::string("decompression failed: ") + ZSTD_getErrorName(result));
+    return result;
+}
+
+std::string Compressor::decompress(std::span<const uint8_t> compressed) {
+    if (compressed.empty()) return "";
+
+    const size_t content_size = getDecompressedSize(compressed);
+
+    std::string output;
+    output.resize(content_size);
+
+    const uint8_t* src = compressed.data();
+    size_t remaining = compressed.size();
+    size_t written = 0;
+
+    while (remaining > 0) {
+        const FrameInfo info = readFrameInfo(src, remaining);
+        if (info.integer) {
+            const std::string text = std::to_string(readIntegerPayload(src));
+            std::memcpy(output.data() + written, text.data(), text.size());
+        } else if (info.stored) {
+            std::memcpy(output.data() + written, src + kStoredFrameHeader, info.content_size);
+        } else {
+            decompressFrame(src, info.compressed_size, output.data() + written, info.content_size);
+        }
+
+        written += info.content_size;
+        src += info.compressed_size;
+        remaining -= info.compressed_size;
+    }
 
     return output;
 }
 
-size_t Compressor::getDecompressedSize(const std::vector<uint8_t>& compressed) {
+std::string Compressor::decompressRange(std::span<const uint8_t> compressed, size_t offset, size_t length) {
+    std::string output;
+    if (compressed.empty() || length == 0) return output;
+
+    const uint8_t* src = compressed.data();
+    size_t remaining = compressed.size();
+    size_t frame_start = 0;
+    std::string frame;
+
+    while (remaining > 0 && output.size() < length) {
+        const FrameInfo info = readFrameInfo(src, remaining);
+
+        const size_t frame_end = frame_start + info.content_size;
+        const size_t want = offset + output.size();
+        if (want < frame_end) {
+            const size_t from = want - frame_start;
+            const size_t take = std::min(info.content_size - from, length - output.size());
+            if (info.integer) {
+                output.append(std::to_string(readIntegerPayload(src)), from, take);
+            } else if (info.stored) {
+                output.append(reinterpret_cast<const char*>(src + kStoredFrameHeader) + from, take);
+            } else {
+                frame.resize(info.content_size);
+                decompressFrame(src, info.compressed_size, frame.data(), frame.size());
+                output.append(frame, from, take);
+            }
+        }
+
+        frame_start = frame_end;
+        src += info.compressed_size;
+        remaining -= info.compressed_size;
+    }
+
+    return output;
+}
+
+size_t Compressor::getDecompressedSize(std::span<const uint8_t> compressed) {
     if (compressed.empty()) return 0;
 
-    unsigned long long content_size = ZSTD_getFrameContentSize(compressed.data(), compressed.size());
-    TITAN_ASSERT(content_size != ZSTD_CONTENTSIZE_UNKNOWN, "unknown content size");
-    TITAN_ASSERT(content_size != ZSTD_CONTENTSIZE_ERROR, "invalid compressed data");
+    const uint8_t* src = compressed.data();
+    size_t remaining = compressed.size();
+    unsigned long long content_size = 0;
+
+    while (remaining > 0) {
+        const FrameInfo info = readFrameInfo(src, remaining);
+        content_size += info.content_size;
+        src += info.compressed_size;
+        remaining -= info.compressed_size;
+    }
+
+    if (content_size > kMaxValueBytes) {
+        throw std::runtime_error("decompressed size exceeds 1GB limit");
+    }
 
     return static_cast<size_t>(content_size);
 }
 
+uint32_t Compressor::registerDictionary(const std::string& dictionary) {
+    const uint32_t dict_id = ZSTD_getDictID_fromDict(dictionary.data(), dictionary.size());
+    TITAN_ASSERT(dict_id != 0, "compression dictionary must be a trained zstd dictionary");
+
+    auto& registry = dictionaries();
+    std::unique_lock lock(registry.mutex);
+    if (registry.ddicts.count(dict_id)) return dict_id;
+
+    ZSTD_DDict* ddict = ZSTD_createDDict(dictionary.data(), dictionary.size());
+    TITAN_ASSERT(ddict != nullptr, "failed to create ZSTD decompression dictionary");
+    registry.ddicts[dict_id] = ddict;
+    registry.raw[dict_id] = dictionary;
+    return dict_id;
+}
+
+bool Compressor::hasDictionary(uint32_t dict_id) {
+    return findDDict(dict_id) != nullptr;
+}
+
+std::string Compressor::trainDictionary(const std::vector<std::string>& samples, size_t capacity) {
+    std::string buffer;
+    std::vector<size_t> sizes;
+    sizes.reserve(samples.size());
+    for (const auto& sample : samples) {
+        buffer += sample;
+        sizes.push_back(sample.size());
+    }
+
+    std::string dictionary(capacity, '\0');
+    const size_t result = ZDICT_trainFromBuffer(
+        dictionary.data(), dictionary.size(), buffer.data(), sizes.data(), static_cast<unsigned>(sizes.size()));
+    if (ZDICT_isError(result)) return "";
+
+    dictionary.resize(result);
+    return dictionary;
+}
+
 } // namespace titan
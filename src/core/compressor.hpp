@@ -1,17 +1,35 @@
 #pragma once
 
+#include "titankv.hpp"
+#include <array>
 #include <vector>
 #include <string>
 #include <memory>
 #include <cstdint>
+#include <optional>
+#include <span>
+#include <string_view>
 
 typedef struct ZSTD_CCtx_s ZSTD_CCtx;
 typedef struct ZSTD_DCtx_s ZSTD_DCtx;
 
 namespace titan {
 
+// Resolved form of a CompressionPolicy: the dictionary is referenced by the
+// zstd dictID it was registered under, which is also recorded in each frame.
+struct CompressionSpec {
+    CompressionCodec codec = CompressionCodec::Zstd;
+    int level = 3;
+    uint32_t dict_id = 0;
+};
+
 class Compressor {
 public:
+    // Values larger than one frame are stored as a run of independent zstd
+    // frames, so range reads only decompress the frames they overlap.
+    static constexpr size_t kFrameBytes = 1024 * 1024;
+    static constexpr size_t kMaxValueBytes = 1024ULL * 1024 * 1024;
+
     Compressor();
     ~Compressor();
 
@@ -19,12 +37,41 @@ public:
     Compressor& operator=(const Compressor&) = delete;
 
     std::vector<uint8_t> compress(const std::string& data, int level = 15);
-    std::string decompress(const std::vector<uint8_t>& compressed);
-    static size_t getDecompressedSize(const std::vector<uint8_t>& compressed);
+    std::vector<uint8_t> compress(const std::string& data, const CompressionSpec& spec);
+    void compressAppend(const char* data, size_t size, const CompressionSpec& spec, std::vector<uint8_t>& out);
+    // One zstd frame produced across calls, for output that arrives in
+    // pieces: beginStream() starts it and the piece passed with `end` closes
+    // it. The one-shot methods must not be used on the instance meanwhile.
+    void beginStream(int level);
+    void compressStream(std::string_view data, bool end, std::string& out);
+    std::string decompress(std::span<const uint8_t> compressed);
+    std::string decompressRange(std::span<const uint8_t> compressed, size_t offset, size_t length);
+    static size_t getDecompressedSize(std::span<const uint8_t> compressed);
+
+    // Counter updates store their result as an integer frame: a skippable
+    // frame holding the little-endian value, read back as its canonical
+    // decimal text ("-42", not "+42" or "042"). At 16 bytes it stays inline
+    // in the memtable entry, and counters update it without running zstd.
+    // compress() never emits one, so values written through put stay
+    // readable by builds that predate the frame.
+    static constexpr size_t kIntegerFrameBytes = 16;
+    static std::optional<int64_t> parseCanonicalInteger(std::string_view text);
+    static std::array<uint8_t, kIntegerFrameBytes> encodeInteger(int64_t value);
+    // The value of a buffer that is exactly one integer frame.
+    static std::optional<int64_t> decodeInteger(std::span<const uint8_t> compressed);
+
+    // Dictionaries are process-wide and keyed by dictID, so any Compressor can
+    // decode a frame that was written with one.
+    static uint32_t registerDictionary(const std::string& dictionary);
+    static bool hasDictionary(uint32_t dict_id);
+    // Returns an empty string when the samples are too few or too uniform.
+    static std::string trainDictionary(const std::vector<std::string>& samples, size_t capacity);
 
 private:
     ZSTD_CCtx* cctx_;
     ZSTD_DCtx* dctx_;
+
+    size_t decompressFrame(const uint8_t* src, size_t src_size, char* dst, size_t dst_capacity);
 };
 
 } // namespace titan
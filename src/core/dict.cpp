@@ -0,0 +1,217 @@
+#include "dict.hpp"
+#include "utils.hpp"
+
+namespace titan {
+
+namespace {
+
+void appendVarint(std::string& out, size_t value) {
+    while (value >= 0x80) {
+        out.push_back(static_cast<char>(value | 0x80));
+        value >>= 7;
+    }
+    out.push_back(static_cast<char>(value));
+}
+
+size_t readVarint(const std::string& in, size_t& pos) {
+    size_t value = 0;
+    for (int shift = 0; pos < in.size(); shift += 7) {
+        const auto byte = static_cast<uint8_t>(in[pos++]);
+        value |= static_cast<size_t>(byte & 0x7F) << shift;
+        if ((byte & 0x80) == 0) break;
+    }
+    return value;
+}
+
+// Reads one varint-prefixed item starting at `pos` and moves past it.
+std::string_view readItem(const std::string& in, size_t& pos) {
+    const size_t length = readVarint(in, pos);
+    std::string_view item(in.data() + pos, length);
+    pos += length;
+    return item;
+}
+
+template <bool kHasValues>
+void appendEntry(std::string& out, std::string_view field, std::string_view value) {
+    appendVarint(out, field.size());
+    out.append(field);
+    if constexpr (kHasValues) {
+        appendVarint(out, value.size());
+        out.append(value);
+    }
+}
+
+} // namespace
+
+template <bool kHasValues>
+size_t Dict<kHasValues>::tableEntryBytes(const std::string& field, const std::string& value) {
+    return 2 * sizeof(void*) + sizeof(typename Table::value_type) + stringHeapBytes(field) + stringHeapBytes(value);
+}
+
+template <bool kHasValues>
+size_t Dict<kHasValues>::findPacked(std::string_view field) const {
+    size_t pos = 0;
+    while (pos < packed_.size()) {
+        const size_t entry = pos;
+        if (readItem(packed_, pos) == field) return entry;
+        if constexpr (kHasValues) readItem(packed_, pos);
+    }
+    return std::string::npos;
+}
+
+template <bool kHasValues>
+void Dict<kHasValues>::convertToTable() {
+    auto table = std::make_unique<Table>();
+    table->reserve(size_ + 1);
+    table_bytes_ = 0;
+
+    size_t pos = 0;
+    while (pos < packed_.size()) {
+        const std::string_view field = readItem(packed_, pos);
+        if constexpr (kHasValues) {
+            const std::string_view value = readItem(packed_, pos);
+            auto [it, inserted] = table->emplace(std::string(field), std::string(value));
+            table_bytes_ += tableEntryBytes(it->first, it->second);
+        } else {
+            auto [it, inserted] = table->emplace(field);
+            table_bytes_ += tableEntryBytes(*it, {});
+        }
+    }
+
+    table_ = std::move(table);
+    std::string().swap(packed_);
+}
+
+template <bool kHasValues>
+bool Dict<kHasValues>::set(std::string_view field, std::string_view value) {
+    if (packed() && (field.size() > kMaxPackedItemBytes || (kHasValues && value.size() > kMaxPackedItemBytes))) {
+        convertToTable();
+    }
+
+    if (packed()) {
+        const size_t entry = findPacked(field);
+        if (entry != std::string::npos) {
+            if constexpr (kHasValues) {
+                size_t end = entry;
+                readItem(packed_, end);
+                readItem(packed_, end);
+                std::string encoded;
+                appendEntry<kHasValues>(encoded, field, value);
+                packed_.replace(entry, end - entry, encoded);
+            }
+            return false;
+        }
+        if (size_ < kMaxPackedEntries) {
+            appendEntry<kHasValues>(packed_, field, value);
+            size_++;
+            return true;
+        }
+        convertToTable();
+    }
+
+    if constexpr (kHasValues) {
+        auto it = table_->find(field);
+        if (it != table_->end()) {
+            table_bytes_ -= stringHeapBytes(it->second);
+            it->second.assign(value);
+            table_bytes_ += stringHeapBytes(it->second);
+            return false;
+        }
+        auto [inserted, unused] = table_->emplace(std::string(field), std::string(value));
+        table_bytes_ += tableEntryBytes(inserted->first, inserted->second);
+    } else {
+        if (table_->find(field) != table_->end()) return false;
+        auto [inserted, unused] = table_->emplace(field);
+        table_bytes_ += tableEntryBytes(*inserted, {});
+    }
+    size_++;
+    return true;
+}
+
+template <bool kHasValues>
+bool Dict<kHasValues>::erase(std::string_view field) {
+    if (packed()) {
+        const size_t entry = findPacked(field);
+        if (entry == std::string::npos) return false;
+
+        size_t end = entry;
+        readItem(packed_, end);
+        if constexpr (kHasValues) readItem(packed_, end);
+        packed_.erase(entry, end - entry);
+        size_--;
+        return true;
+    }
+
+    auto it = table_->find(field);
+    if (it == table_->end()) return false;
+    if constexpr (kHasValues) {
+        table_bytes_ -= tableEntryBytes(it->first, it->second);
+    } else {
+        table_bytes_ -= tableEntryBytes(*it, {});
+    }
+    table_->erase(it);
+    size_--;
+    return true;
+}
+
+template <bool kHasValues>
+std::optional<std::string> Dict<kHasValues>::get(std::string_view field) const {
+    if (packed()) {
+        size_t pos = findPacked(field);
+        if (pos == std::string::npos) return std::nullopt;
+        readItem(packed_, pos);
+        if constexpr (kHasValues) return std::string(readItem(packed_, pos));
+        return std::string();
+    }
+
+    auto it = table_->find(field);
+    if (it == table_->end()) return std::nullopt;
+    if constexpr (kHasValues) return it->second;
+    return std::string();
+}
+
+template <bool kHasValues>
+bool Dict<kHasValues>::contains(std::string_view field) const {
+    if (packed()) return findPacked(field) != std::string::npos;
+    return table_->find(field) != table_->end();
+}
+
+template <bool kHasValues>
+std::vector<std::pair<std::string, std::string>> Dict<kHasValues>::entries() const {
+    std::vector<std::pair<std::string, std::string>> result;
+    result.reserve(size_);
+
+    if (packed()) {
+        size_t pos = 0;
+        while (pos < packed_.size()) {
+            std::string field(readItem(packed_, pos));
+            std::string value;
+            if constexpr (kHasValues) value = readItem(packed_, pos);
+            result.emplace_back(std::move(field), std::move(value));
+        }
+        return result;
+    }
+
+    for (const auto& entry : *table_) {
+        if constexpr (kHasValues) {
+            result.emplace_back(entry.first, entry.second);
+        } else {
+            result.emplace_back(entry, std::string());
+        }
+    }
+    return result;
+}
+
+template <bool kHasValues>
+size_t Dict<kHasValues>::memoryUsage() const {
+    size_t bytes = sizeof(Dict) + stringHeapBytes(packed_);
+    if (table_) {
+        bytes += sizeof(Table) + table_->bucket_count() * sizeof(void*) + table_bytes_;
+    }
+    return bytes;
+}
+
+template class Dict<true>;
+template class Dict<false>;
+
+} // namespace titan
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+namespace titan {
+
+struct StringViewHash {
+    using is_transparent = void;
+    size_t operator()(std::string_view s) const { return std::hash<std::string_view>{}(s); }
+};
+
+// Field container behind native hashes (field -> value) and sets (fields
+// only), after Redis' listpack encoding: while small it is one contiguous
+// buffer of varint-prefixed fields (and values) scanned linearly, and it
+// converts once to a hash table when it outgrows kMaxPackedEntries or is
+// given an item larger than kMaxPackedItemBytes.
+template <bool kHasValues>
+class Dict {
+public:
+    static constexpr size_t kMaxPackedEntries = 128;
+    static constexpr size_t kMaxPackedItemBytes = 64;
+
+    using Table = std::conditional_t<kHasValues,
+        std::unordered_map<std::string, std::string, StringViewHash, std::equal_to<>>,
+        std::unordered_set<std::string, StringViewHash, std::equal_to<>>>;
+
+    // Inserts or overwrites a field; returns true when it was new. Sets
+    // ignore `value`.
+    bool set(std::string_view field, std::string_view value = {});
+    bool erase(std::string_view field);
+    std::optional<std::string> get(std::string_view field) const;
+    bool contains(std::string_view field) const;
+
+    size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+    bool packed() const { return table_ == nullptr; }
+    size_t memoryUsage() const;
+
+    // Fields with their values (empty for sets); packed dicts keep insertion
+    // order, tables have none.
+    std::vector<std::pair<std::string, std::string>> entries() const;
+
+private:
+    std::string packed_;
+    std::unique_ptr<Table> table_;
+    size_t size_ = 0;
+    // Per-entry table cost, kept so memoryUsage() stays O(1).
+    size_t table_bytes_ = 0;
+
+    // Offset of the field's entry in packed_, or npos.
+    size_t findPacked(std::string_view field) const;
+    void convertToTable();
+    static size_t tableEntryBytes(const std::string& field, const std::string& value);
+};
+
+using HashDict = Dict<true>;
+using SetDict = Dict<false>;
+
+} // namespace titan
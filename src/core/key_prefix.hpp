@@ -0,0 +1,76 @@
+#pragma once
+
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+namespace titan {
+
+// Packs the first 8 bytes of a key big-endian (zero padded) so that unsigned
+// integer order agrees with byte-wise string order. Equal prefixes decide
+// nothing; callers must fall back to a full comparison.
+inline uint64_t keyPrefix(std::string_view key) {
+    unsigned char buf[8] = {0};
+    std::memcpy(buf, key.data(), key.size() < sizeof(buf) ? key.size() : sizeof(buf));
+
+    uint64_t value = 0;
+    for (unsigned char byte : buf) {
+        value = (value << 8) | byte;
+    }
+    return value;
+}
+
+inline size_t commonPrefixLength(std::string_view a, std::string_view b) {
+    const size_t limit = a.size() < b.size() ? a.size() : b.size();
+    size_t i = 0;
+    while (i < limit && a[i] == b[i]) ++i;
+    return i;
+}
+
+inline bool hasPrefix(std::string_view key, std::string_view prefix) {
+    return key.size() >= prefix.size() &&
+           std::memcmp(key.data(), prefix.data(), prefix.size()) == 0;
+}
+
+// Counts entries strictly below `target` in a sorted prefix array, i.e. the
+// lower-bound position. A branch-free linear count beats binary search over
+// the short fence-bounded windows it is used on.
+inline size_t countPrefixesBelow(const uint64_t* prefixes, size_t count, uint64_t target) {
+    size_t i = 0;
+    size_t below = 0;
+
+#if defined(__AVX2__)
+    // AVX2 only has signed 64-bit compares; flipping the sign bit maps
+    // unsigned order onto signed order.
+    const __m256i bias = _mm256_set1_epi64x(static_cast<int64_t>(0x8000000000000000ULL));
+    const __m256i needle = _mm256_xor_si256(_mm256_set1_epi64x(static_cast<int64_t>(target)), bias);
+    for (; i + 4 <= count; i += 4) {
+        const __m256i lanes = _mm256_xor_si256(
+            _mm256_loadu_si256(reinterpret_cast<const __m256i*>(prefixes + i)), bias);
+        const __m256i lt = _mm256_cmpgt_epi64(needle, lanes);
+        below += static_cast<size_t>(std::popcount(
+            static_cast<unsigned>(_mm256_movemask_pd(_mm256_castsi256_pd(lt)))));
+    }
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+    const uint64x2_t needle = vdupq_n_u64(target);
+    for (; i + 2 <= count; i += 2) {
+        const uint64x2_t lt = vcltq_u64(vld1q_u64(prefixes + i), needle);
+        below += static_cast<size_t>((vgetq_lane_u64(lt, 0) & 1) + (vgetq_lane_u64(lt, 1) & 1));
+    }
+#endif
+
+    for (; i < count; ++i) {
+        below += prefixes[i] < target ? 1 : 0;
+    }
+    return below;
+}
+
+} // namespace titan
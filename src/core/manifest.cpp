@@ -63,6 +63,10 @@ bool ManifestStore::load(RecoveryManifest& out_manifest) const {
             out_manifest.wal_size_bytes = static_cast<uint64_t>(std::stoull(fields[1]));
             continue;
         }
+        if (fields[0] == "wal_lineage" && fields.size() >= 2) {
+            out_manifest.wal_lineage = static_cast<uint64_t>(std::stoull(fields[1]));
+            continue;
+        }
         if (fields[0] == "sst" && fields.size() >= 4) {
             SegmentManifestEntry entry;
             entry.relative_path = fields[1];
@@ -92,6 +96,9 @@ void ManifestStore::save(const RecoveryManifest& manifest) const {
     out << "wal_file\t" << manifest.wal_file << '\n';
     out << "wal_format\t" << manifest.wal_format << '\n';
     out << "wal_size_bytes\t" << manifest.wal_size_bytes << '\n';
+    if (manifest.wal_lineage != 0) {
+        out << "wal_lineage\t" << manifest.wal_lineage << '\n';
+    }
 
     std::vector<SegmentManifestEntry> sorted = manifest.sstables;
     std::sort(sorted.begin(), sorted.end(), [](const auto& a, const auto& b) {
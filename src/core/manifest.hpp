@@ -19,6 +19,9 @@ struct RecoveryManifest {
     std::string wal_file;
     std::string wal_format;
     uint64_t wal_size_bytes = 0;
+    // Set by checkpoints: the WAL lineage the copy was taken from, so the
+    // next checkpoint into the same directory can append only the new tail.
+    uint64_t wal_lineage = 0;
     std::vector<SegmentManifestEntry> sstables;
 };
 
@@ -0,0 +1,262 @@
+#include "pubsub.hpp"
+#include <algorithm>
+#include <utility>
+
+namespace titan {
+
+struct PubSub::Node {
+    std::unordered_map<char, std::unique_ptr<Node>> literals;
+    std::unique_ptr<Node> any_char;
+    std::unique_ptr<Node> any_run;
+    // Reached through '*', so it also consumes any character itself.
+    bool absorbs = false;
+    // Set when a pattern ends here.
+    std::string pattern;
+    std::vector<SubscriberId> subscribers;
+    // match_epoch_ of the step that last added the node to an active set.
+    uint64_t seen = 0;
+
+    bool empty() const {
+        return literals.empty() && !any_char && !any_run && subscribers.empty();
+    }
+};
+
+namespace {
+
+// Adds the node and everything reachable from it through '*' edges, which
+// match the empty string.
+template <typename Node>
+void activate(const Node* node, uint64_t epoch, std::vector<const Node*>& active) {
+    while (node && node->seen != epoch) {
+        const_cast<Node*>(node)->seen = epoch;
+        active.push_back(node);
+        node = node->any_run.get();
+    }
+}
+
+template <typename Node>
+std::unique_ptr<Node>& edgeFor(Node& node, char c) {
+    if (c == '*') return node.any_run;
+    if (c == '?') return node.any_char;
+    return node.literals[c];
+}
+
+// Removes `id` below `node` along `rest`; returns true when the node
+// became empty and can be pruned by its parent.
+template <typename Node>
+bool removePattern(Node& node, std::string_view rest, uint64_t id) {
+    if (rest.empty()) {
+        auto it = std::find(node.subscribers.begin(), node.subscribers.end(), id);
+        if (it != node.subscribers.end()) node.subscribers.erase(it);
+        if (node.subscribers.empty()) node.pattern.clear();
+        return node.empty();
+    }
+
+    const char c = rest.front();
+    std::unique_ptr<Node>* edge = nullptr;
+    if (c == '*') {
+        edge = &node.any_run;
+    } else if (c == '?') {
+        edge = &node.any_char;
+    } else {
+        auto it = node.literals.find(c);
+        if (it == node.literals.end()) return node.empty();
+        edge = &it->second;
+    }
+    if (*edge && removePattern(**edge, rest.substr(1), id)) {
+        if (c == '*' || c == '?') {
+            edge->reset();
+        } else {
+            node.literals.erase(c);
+        }
+    }
+    return node.empty();
+}
+
+} // namespace
+
+PubSub::PubSub() : patterns_(std::make_unique<Node>()) {}
+
+PubSub::~PubSub() = default;
+
+bool PubSub::isPattern(std::string_view channel) {
+    return channel.find('*') != std::string_view::npos;
+}
+
+// Whether a subscription could ever receive a keyspace notification: a
+// channel must carry one of the prefixes, a pattern's literal head must be
+// compatible with one.
+bool PubSub::matchesKeyspace(std::string_view channel) {
+    if (!isPattern(channel)) {
+        return channel.starts_with(kKeyspacePrefix) || channel.starts_with(kKeyeventPrefix);
+    }
+    const auto head = channel.substr(0, channel.find_first_of("*?"));
+    for (const auto prefix : {kKeyspacePrefix, kKeyeventPrefix}) {
+        if (prefix.starts_with(head) || head.starts_with(prefix)) return true;
+    }
+    return false;
+}
+
+PubSub::SubscriberId PubSub::addSubscriber(std::function<void()> wake) {
+    std::lock_guard lock(mutex_);
+    const SubscriberId id = next_id_++;
+    subscribers_[id].wake = std::move(wake);
+    return id;
+}
+
+void PubSub::removeSubscriber(SubscriberId id) {
+    std::lock_guard lock(mutex_);
+    auto it = subscribers_.find(id);
+    if (it == subscribers_.end()) return;
+
+    const auto subscriptions = std::move(it->second.subscriptions);
+    for (const auto& channel : subscriptions) unsubscribeUnlocked(id, channel);
+    subscribers_.erase(id);
+}
+
+bool PubSub::subscribe(SubscriberId id, const std::string& channel) {
+    std::lock_guard lock(mutex_);
+    return subscribeUnlocked(id, channel);
+}
+
+bool PubSub::unsubscribe(SubscriberId id, const std::string& channel) {
+    std::lock_guard lock(mutex_);
+    auto it = subscribers_.find(id);
+    if (it == subscribers_.end()) return false;
+
+    auto& subscriptions = it->second.subscriptions;
+    auto pos = std::find(subscriptions.begin(), subscriptions.end(), channel);
+    if (pos == subscriptions.end()) return false;
+    subscriptions.erase(pos);
+    return unsubscribeUnlocked(id, channel);
+}
+
+bool PubSub::subscribeUnlocked(SubscriberId id, const std::string& channel) {
+    auto it = subscribers_.find(id);
+    if (it == subscribers_.end()) return false;
+    auto& subscriptions = it->second.subscriptions;
+    if (std::find(subscriptions.begin(), subscriptions.end(), channel) != subscriptions.end()) return false;
+    subscriptions.push_back(channel);
+
+    if (isPattern(channel)) {
+        Node* node = patterns_.get();
+        for (char c : channel) {
+            auto& edge = edgeFor(*node, c);
+            if (!edge) {
+                edge = std::make_unique<Node>();
+                edge->absorbs = c == '*';
+            }
+            node = edge.get();
+        }
+        node->pattern = channel;
+        node->subscribers.push_back(id);
+    } else {
+        channels_[channel].push_back(id);
+    }
+
+    if (matchesKeyspace(channel)) keyspace_subscriptions_.fetch_add(1, std::memory_order_relaxed);
+    return true;
+}
+
+// The caller has already dropped the channel from the subscriber's list.
+bool PubSub::unsubscribeUnlocked(SubscriberId id, const std::string& channel) {
+    if (isPattern(channel)) {
+        removePattern(*patterns_, channel, id);
+    } else {
+        auto it = channels_.find(channel);
+        if (it != channels_.end()) {
+            auto& ids = it->second;
+            ids.erase(std::remove(ids.begin(), ids.end(), id), ids.end());
+            if (ids.empty()) channels_.erase(it);
+        }
+    }
+
+    if (matchesKeyspace(channel)) keyspace_subscriptions_.fetch_sub(1, std::memory_order_relaxed);
+    return true;
+}
+
+// Simulates the trie as an NFA over the channel; the set of active nodes
+// stays small because only matching prefixes survive each step.
+void PubSub::matchPatternsUnlocked(std::string_view channel, std::vector<const Node*>& matches) {
+    std::vector<const Node*> active;
+    std::vector<const Node*> next;
+    activate<Node>(patterns_.get(), ++match_epoch_, active);
+
+    for (char c : channel) {
+        if (active.empty()) return;
+        const uint64_t epoch = ++match_epoch_;
+        next.clear();
+        for (const Node* node : active) {
+            if (node->absorbs) activate(node, epoch, next);
+            auto it = node->literals.find(c);
+            if (it != node->literals.end()) activate<Node>(it->second.get(), epoch, next);
+            activate<Node>(node->any_char.get(), epoch, next);
+        }
+        active.swap(next);
+    }
+
+    for (const Node* node : active) {
+        if (!node->subscribers.empty()) matches.push_back(node);
+    }
+}
+
+void PubSub::enqueueUnlocked(Subscriber& subscriber, std::string_view channel, std::string_view message,
+                             std::string_view pattern) {
+    if (subscriber.queue.size() >= kMaxPendingMessages) return;
+
+    const bool was_empty = subscriber.queue.empty();
+    subscriber.queue.push_back({std::string(channel), std::string(message), std::string(pattern)});
+    if (was_empty && subscriber.wake) subscriber.wake();
+}
+
+size_t PubSub::publish(std::string_view channel, std::string_view message, SubscriberId origin,
+                       std::vector<std::string>* origin_matches) {
+    std::lock_guard lock(mutex_);
+    size_t queued = 0;
+
+    const auto deliver = [&](SubscriberId id, std::string_view pattern) {
+        if (id == origin) {
+            if (origin_matches) origin_matches->emplace_back(pattern.empty() ? channel : pattern);
+            return;
+        }
+        auto it = subscribers_.find(id);
+        if (it == subscribers_.end()) return;
+        enqueueUnlocked(it->second, channel, message, pattern);
+        queued++;
+    };
+
+    auto exact = channels_.find(std::string(channel));
+    if (exact != channels_.end()) {
+        for (SubscriberId id : exact->second) deliver(id, {});
+    }
+
+    std::vector<const Node*> matches;
+    matchPatternsUnlocked(channel, matches);
+    for (const Node* node : matches) {
+        // A pattern published to verbatim was already served as a channel.
+        if (node->pattern == channel) continue;
+        for (SubscriberId id : node->subscribers) deliver(id, node->pattern);
+    }
+    return queued;
+}
+
+std::vector<PubSubMessage> PubSub::drain(SubscriberId id) {
+    std::lock_guard lock(mutex_);
+    auto it = subscribers_.find(id);
+    if (it == subscribers_.end()) return {};
+    return std::exchange(it->second.queue, {});
+}
+
+void PubSub::publishKeyEvent(std::string_view event, std::string_view key) {
+    if (!keyspaceActive()) return;
+
+    std::string keyspace_channel(kKeyspacePrefix);
+    keyspace_channel.append(key);
+    publish(keyspace_channel, event);
+
+    std::string keyevent_channel(kKeyeventPrefix);
+    keyevent_channel.append(event);
+    publish(keyevent_channel, key);
+}
+
+} // namespace titan
@@ -0,0 +1,94 @@
+#pragma once
+
+#include "titankv.hpp"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace titan {
+
+// Redis-style keyspace notification channels (database 0): events go to
+// kKeyspacePrefix + key with the event name as the message, and to
+// kKeyeventPrefix + event with the key as the message.
+inline constexpr std::string_view kKeyspacePrefix = "__keyspace@0__:";
+inline constexpr std::string_view kKeyeventPrefix = "__keyevent@0__:";
+
+// Channel and pattern subscriptions for every handle on one engine. A
+// subscription containing '*' is a glob pattern in which '*' and '?' are
+// wildcards; anything else names one channel. Channels sit in a hash map and
+// patterns in a trie walked once per publish, so fan-out follows the channel
+// length and the number of matches rather than the number of patterns.
+//
+// Each subscriber owns a queue. publish() appends to it and calls the
+// subscriber's wake callback only when the queue was empty, so a consumer
+// that drains on wake receives messages in batches.
+class PubSub {
+public:
+    using SubscriberId = uint64_t;
+
+    // Per-subscriber backlog; a consumer that falls further behind loses the
+    // newest messages, like a Redis client over its pubsub output limit.
+    static constexpr size_t kMaxPendingMessages = 65536;
+
+    PubSub();
+    ~PubSub();
+
+    PubSub(const PubSub&) = delete;
+    PubSub& operator=(const PubSub&) = delete;
+
+    // `wake` runs on the publishing thread with the hub locked, so it must
+    // only signal the consumer and not call back into the hub.
+    SubscriberId addSubscriber(std::function<void()> wake);
+    void removeSubscriber(SubscriberId id);
+    // Return false when the subscription already exists / did not exist.
+    bool subscribe(SubscriberId id, const std::string& channel);
+    bool unsubscribe(SubscriberId id, const std::string& channel);
+
+    // Queues the message for every matching subscription and returns how
+    // many were queued. Subscriptions held by `origin` are not queued but
+    // appended to `origin_matches` (channel first, then patterns) for the
+    // caller to deliver synchronously.
+    size_t publish(std::string_view channel, std::string_view message, SubscriberId origin = 0,
+                   std::vector<std::string>* origin_matches = nullptr);
+    std::vector<PubSubMessage> drain(SubscriberId id);
+
+    // True while some subscription could match a keyspace channel; writers
+    // check it before building notifications.
+    bool keyspaceActive() const { return keyspace_subscriptions_.load(std::memory_order_relaxed) > 0; }
+    void publishKeyEvent(std::string_view event, std::string_view key);
+
+    static bool isPattern(std::string_view channel);
+
+private:
+    struct Node;
+
+    struct Subscriber {
+        std::function<void()> wake;
+        std::vector<PubSubMessage> queue;
+        std::vector<std::string> subscriptions;
+    };
+
+    mutable std::mutex mutex_;
+    std::unordered_map<SubscriberId, Subscriber> subscribers_;
+    std::unordered_map<std::string, std::vector<SubscriberId>> channels_;
+    std::unique_ptr<Node> patterns_;
+    SubscriberId next_id_ = 1;
+    uint64_t match_epoch_ = 0;
+    std::atomic<size_t> keyspace_subscriptions_{0};
+
+    bool subscribeUnlocked(SubscriberId id, const std::string& channel);
+    bool unsubscribeUnlocked(SubscriberId id, const std::string& channel);
+    void matchPatternsUnlocked(std::string_view channel, std::vector<const Node*>& matches);
+    void enqueueUnlocked(Subscriber& subscriber, std::string_view channel, std::string_view message,
+                         std::string_view pattern);
+    static bool matchesKeyspace(std::string_view channel);
+};
+
+} // namespace titan
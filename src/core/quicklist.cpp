@@ -0,0 +1,287 @@
+#include "quicklist.hpp"
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+namespace titan {
+
+namespace {
+
+size_t varintSize(size_t value) {
+    size_t n = 1;
+    while (value >= 0x80) {
+        value >>= 7;
+        n++;
+    }
+    return n;
+}
+
+void writeVarint(uint8_t* dst, size_t value) {
+    while (value >= 0x80) {
+        *dst++ = static_cast<uint8_t>(value | 0x80);
+        value >>= 7;
+    }
+    *dst = static_cast<uint8_t>(value);
+}
+
+// Returns the number of bytes consumed, or 0 if the varint is truncated.
+size_t readVarint(const uint8_t* src, size_t available, size_t& value) {
+    value = 0;
+    for (size_t i = 0; i < available && i < 10; i++) {
+        value |= static_cast<size_t>(src[i] & 0x7F) << (7 * i);
+        if ((src[i] & 0x80) == 0) return i + 1;
+    }
+    return 0;
+}
+
+// Reads the trailing, byte-reversed copy of an entry's length that ends at `end`.
+size_t readBackVarint(const uint8_t* end, size_t& value) {
+    value = 0;
+    size_t i = 0;
+    while (true) {
+        const uint8_t byte = *(end - 1 - i);
+        value |= static_cast<size_t>(byte & 0x7F) << (7 * i);
+        i++;
+        if ((byte & 0x80) == 0) return i;
+    }
+}
+
+std::string encodeEntry(std::string_view value) {
+    const size_t header = varintSize(value.size());
+    std::string entry(2 * header + value.size(), '\0');
+    auto* out = reinterpret_cast<uint8_t*>(entry.data());
+
+    writeVarint(out, value.size());
+    if (!value.empty()) std::memcpy(out + header, value.data(), value.size());
+    writeVarint(out + header + value.size(), value.size());
+    std::reverse(out + header + value.size(), out + entry.size());
+    return entry;
+}
+
+struct DecodedEntry {
+    size_t payload_offset = 0;
+    size_t length = 0;
+    size_t total = 0;
+};
+
+DecodedEntry decodeEntryAt(const std::string& bytes, size_t offset) {
+    DecodedEntry entry;
+    const auto* src = reinterpret_cast<const uint8_t*>(bytes.data()) + offset;
+    const size_t header = readVarint(src, bytes.size() - offset, entry.length);
+    entry.payload_offset = offset + header;
+    entry.total = 2 * header + entry.length;
+    return entry;
+}
+
+} // namespace
+
+void appendPackedValue(std::vector<uint8_t>& out, std::string_view value) {
+    const size_t base = out.size();
+    out.resize(base + varintSize(value.size()) + value.size());
+    writeVarint(out.data() + base, value.size());
+    if (!value.empty()) {
+        std::memcpy(out.data() + out.size() - value.size(), value.data(), value.size());
+    }
+}
+
+std::vector<std::string> unpackValues(std::span<const uint8_t> packed) {
+    std::vector<std::string> values;
+    size_t pos = 0;
+    while (pos < packed.size()) {
+        size_t length = 0;
+        const size_t header = readVarint(packed.data() + pos, packed.size() - pos, length);
+        if (header == 0 || length > packed.size() - pos - header) {
+            throw std::runtime_error("corrupt list payload");
+        }
+        pos += header;
+        values.emplace_back(reinterpret_cast<const char*>(packed.data() + pos), length);
+        pos += length;
+    }
+    return values;
+}
+
+void QuickList::seal(Chunk& chunk) {
+    chunk_bytes_ -= chunkBytes(chunk);
+    chunk.bytes.shrink_to_fit();
+    chunk_bytes_ += chunkBytes(chunk);
+}
+
+void QuickList::pushBack(std::string_view value) {
+    const std::string entry = encodeEntry(value);
+    if (chunks_.empty() || (chunks_.back().count > 0 && chunks_.back().liveBytes() + entry.size() > kChunkBytes)) {
+        if (!chunks_.empty()) seal(chunks_.back());
+        chunks_.emplace_back();
+        chunk_bytes_ += chunkBytes(chunks_.back());
+    }
+
+    Chunk& chunk = chunks_.back();
+    chunk_bytes_ -= chunkBytes(chunk);
+    chunk.bytes.append(entry);
+    chunk_bytes_ += chunkBytes(chunk);
+    chunk.count++;
+    size_++;
+}
+
+void QuickList::pushFront(std::string_view value) {
+    const std::string entry = encodeEntry(value);
+    if (chunks_.empty() || (chunks_.front().count > 0 && chunks_.front().liveBytes() + entry.size() > kChunkBytes)) {
+        if (!chunks_.empty()) seal(chunks_.front());
+        chunks_.emplace_front();
+        chunk_bytes_ += chunkBytes(chunks_.front());
+    }
+
+    Chunk& chunk = chunks_.front();
+    if (chunk.head < entry.size()) {
+        // Re-open a gap in front proportional to the chunk so a run of
+        // pushFront calls moves each byte O(1) times.
+        const size_t slack = std::min(kChunkBytes / 2, chunk.liveBytes());
+        std::string grown(slack + entry.size(), '\0');
+        grown.append(chunk.bytes, chunk.head, std::string::npos);
+        chunk_bytes_ -= chunkBytes(chunk);
+        chunk.bytes = std::move(grown);
+        chunk_bytes_ += chunkBytes(chunk);
+        chunk.head = slack + entry.size();
+    }
+
+    chunk.head -= entry.size();
+    std::memcpy(chunk.bytes.data() + chunk.head, entry.data(), entry.size());
+    chunk.count++;
+    size_++;
+}
+
+std::optional<std::string> QuickList::popFront() {
+    if (chunks_.empty()) return std::nullopt;
+
+    Chunk& chunk = chunks_.front();
+    const DecodedEntry entry = decodeEntryAt(chunk.bytes, chunk.head);
+    std::string value(chunk.bytes, entry.payload_offset, entry.length);
+    chunk.head += entry.total;
+    chunk.count--;
+    size_--;
+
+    if (chunk.count == 0) {
+        chunk_bytes_ -= chunkBytes(chunk);
+        chunks_.pop_front();
+    } else if (chunk.head > kChunkBytes && chunk.head > chunk.liveBytes()) {
+        // A lone chunk used as a queue would otherwise grow without bound.
+        chunk_bytes_ -= chunkBytes(chunk);
+        chunk.bytes.erase(0, chunk.head);
+        chunk_bytes_ += chunkBytes(chunk);
+        chunk.head = 0;
+    }
+    return value;
+}
+
+std::optional<std::string> QuickList::popBack() {
+    if (chunks_.empty()) return std::nullopt;
+
+    Chunk& chunk = chunks_.back();
+    const auto* end = reinterpret_cast<const uint8_t*>(chunk.bytes.data()) + chunk.bytes.size();
+    size_t length = 0;
+    const size_t header = readBackVarint(end, length);
+    const size_t start = chunk.bytes.size() - (2 * header + length);
+
+    std::string value(chunk.bytes, start + header, length);
+    chunk.bytes.resize(start);
+    chunk.count--;
+    size_--;
+
+    if (chunk.count == 0) {
+        chunk_bytes_ -= chunkBytes(chunk);
+        chunks_.pop_back();
+    }
+    return value;
+}
+
+std::pair<size_t, size_t> QuickList::locate(size_t index) const {
+    size_t chunk_index = 0;
+    size_t position = index;
+
+    if (index < size_ / 2) {
+        while (position >= chunks_[chunk_index].count) {
+            position -= chunks_[chunk_index].count;
+            chunk_index++;
+        }
+    } else {
+        size_t from_back = size_ - 1 - index;
+        chunk_index = chunks_.size() - 1;
+        while (from_back >= chunks_[chunk_index].count) {
+            from_back -= chunks_[chunk_index].count;
+            chunk_index--;
+        }
+        position = chunks_[chunk_index].count - 1 - from_back;
+    }
+
+    const Chunk& chunk = chunks_[chunk_index];
+    size_t offset = chunk.head;
+    for (size_t i = 0; i < position; i++) {
+        offset += decodeEntryAt(chunk.bytes, offset).total;
+    }
+    return {chunk_index, offset};
+}
+
+std::optional<std::string> QuickList::at(size_t index) const {
+    if (index >= size_) return std::nullopt;
+
+    const auto [chunk_index, offset] = locate(index);
+    const std::string& bytes = chunks_[chunk_index].bytes;
+    const DecodedEntry entry = decodeEntryAt(bytes, offset);
+    return std::string(bytes, entry.payload_offset, entry.length);
+}
+
+bool QuickList::set(size_t index, std::string_view value) {
+    if (index >= size_) return false;
+
+    const auto [chunk_index, offset] = locate(index);
+    Chunk& chunk = chunks_[chunk_index];
+    const DecodedEntry entry = decodeEntryAt(chunk.bytes, offset);
+    chunk_bytes_ -= chunkBytes(chunk);
+    chunk.bytes.replace(offset, entry.total, encodeEntry(value));
+    chunk_bytes_ += chunkBytes(chunk);
+    return true;
+}
+
+std::vector<std::string> QuickList::range(size_t start, size_t stop) const {
+    std::vector<std::string> values;
+    if (start > stop || start >= size_) return values;
+    stop = std::min(stop, size_ - 1);
+
+    size_t remaining = stop - start + 1;
+    values.reserve(remaining);
+
+    auto [chunk_index, offset] = locate(start);
+    while (remaining > 0) {
+        const std::string& bytes = chunks_[chunk_index].bytes;
+        while (offset < bytes.size() && remaining > 0) {
+            const DecodedEntry entry = decodeEntryAt(bytes, offset);
+            values.emplace_back(bytes, entry.payload_offset, entry.length);
+            offset += entry.total;
+            remaining--;
+        }
+        if (++chunk_index < chunks_.size()) offset = chunks_[chunk_index].head;
+    }
+    return values;
+}
+
+size_t QuickList::memoryUsage() const {
+    return sizeof(QuickList) + chunk_bytes_;
+}
+
+std::vector<std::vector<uint8_t>> QuickList::packedChunks() const {
+    std::vector<std::vector<uint8_t>> packed;
+    packed.reserve(chunks_.size());
+
+    for (const auto& chunk : chunks_) {
+        std::vector<uint8_t> out;
+        out.reserve(chunk.liveBytes());
+        for (size_t offset = chunk.head; offset < chunk.bytes.size();) {
+            const DecodedEntry entry = decodeEntryAt(chunk.bytes, offset);
+            appendPackedValue(out, std::string_view(chunk.bytes).substr(entry.payload_offset, entry.length));
+            offset += entry.total;
+        }
+        packed.push_back(std::move(out));
+    }
+    return packed;
+}
+
+} // namespace titan
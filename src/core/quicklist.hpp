@@ -0,0 +1,69 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace titan {
+
+// Length-prefixed value sequence (varint length + bytes, repeated) used for
+// list payloads in WAL records.
+void appendPackedValue(std::vector<uint8_t>& out, std::string_view value);
+std::vector<std::string> unpackValues(std::span<const uint8_t> packed);
+
+// Doubly-ended list of packed chunks, after Redis' quicklist. Each chunk is a
+// byte buffer of entries encoded as varint(len) + bytes + reversed varint(len),
+// so both ends can be walked without per-entry allocations. Pushes and pops
+// touch a single chunk; index lookups walk chunk counts from the nearer end.
+class QuickList {
+public:
+    // Soft limit on a chunk's live bytes; a larger value gets its own chunk.
+    static constexpr size_t kChunkBytes = 8 * 1024;
+
+    void pushFront(std::string_view value);
+    void pushBack(std::string_view value);
+    std::optional<std::string> popFront();
+    std::optional<std::string> popBack();
+
+    std::optional<std::string> at(size_t index) const;
+    bool set(size_t index, std::string_view value);
+    // Inclusive bounds, already clamped by the caller.
+    std::vector<std::string> range(size_t start, size_t stop) const;
+
+    size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+    size_t memoryUsage() const;
+
+    // Each chunk's values in appendPackedValue() form, front to back.
+    std::vector<std::vector<uint8_t>> packedChunks() const;
+
+private:
+    struct Chunk {
+        std::string bytes;
+        // Entries live in bytes[head, bytes.size()); the gap in front is
+        // reused by pushFront.
+        size_t head = 0;
+        uint32_t count = 0;
+
+        size_t liveBytes() const { return bytes.size() - head; }
+    };
+
+    std::deque<Chunk> chunks_;
+    size_t size_ = 0;
+    // Sum of chunkBytes() over chunks_, kept so memoryUsage() stays O(1).
+    size_t chunk_bytes_ = 0;
+
+    static size_t chunkBytes(const Chunk& chunk) { return sizeof(Chunk) + chunk.bytes.capacity(); }
+    // Shrinks a chunk that only changes by pops from here on.
+    void seal(Chunk& chunk);
+
+    // Locates the chunk holding `index` and the entry's offset inside it.
+    std::pair<size_t, size_t> locate(size_t index) const;
+};
+
+} // namespace titan
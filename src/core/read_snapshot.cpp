@@ -0,0 +1,383 @@
+#include "read_snapshot.hpp"
+#include "compressor.hpp"
+#include "utils.hpp"
+#include <array>
+#include <charconv>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace titan {
+
+namespace {
+
+constexpr std::array<uint8_t, 8> kSnapshotMagic{{'T', 'K', 'V', 'S', 'N', 'P', '1', '\n'}};
+constexpr size_t kHeaderBytes = kSnapshotMagic.size() + 3 * sizeof(uint64_t);
+constexpr size_t kRecordHeaderBytes = 2 * sizeof(uint32_t) + sizeof(int64_t);
+constexpr const char* kSnapshotDirName = "snapshots";
+constexpr const char* kCurrentFileName = "CURRENT";
+
+std::filesystem::path snapshotDir(const std::filesystem::path& data_dir) {
+    return data_dir / kSnapshotDirName;
+}
+
+std::filesystem::path generationPath(const std::filesystem::path& data_dir, uint64_t generation) {
+    return snapshotDir(data_dir) / (std::to_string(generation) + ".tkvs");
+}
+
+std::optional<uint64_t> parseGeneration(std::string_view text) {
+    uint64_t value = 0;
+    const auto* end = text.data() + text.size();
+    const auto [ptr, ec] = std::from_chars(text.data(), end, value);
+    if (ec != std::errc() || ptr == text.data()) return std::nullopt;
+    return value;
+}
+
+template <typename T>
+T loadScalar(const uint8_t* src) {
+    T value;
+    std::memcpy(&value, src, sizeof(value));
+    return value;
+}
+
+template <typename T>
+void writeScalar(std::ofstream& out, T value) {
+    out.write(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+void corrupt(const std::string& detail) {
+    throw std::runtime_error("corrupt read snapshot: " + detail);
+}
+
+// Frames may reference dictionaries the writer registered after this
+// process started; they are persisted beside the data before use.
+void loadNewDictionaries(const std::filesystem::path& data_dir) {
+    const auto dict_dir = data_dir / "dictionaries";
+    std::error_code ec;
+    if (!std::filesystem::exists(dict_dir, ec)) return;
+
+    for (const auto& entry : std::filesystem::directory_iterator(dict_dir, ec)) {
+        if (!entry.is_regular_file() || entry.path().extension() != ".zdict") continue;
+        const auto dict_id = parseGeneration(entry.path().stem().string());
+        if (dict_id && Compressor::hasDictionary(static_cast<uint32_t>(*dict_id))) continue;
+
+        std::ifstream in(entry.path(), std::ios::binary);
+        std::string dictionary((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+        Compressor::registerDictionary(dictionary);
+    }
+}
+
+std::string decompressFrames(std::span<const uint8_t> frames) {
+    thread_local Compressor comp;
+    return comp.decompress(frames);
+}
+
+bool expired(const ReadSnapshot::Record& record, int64_t now_ms) {
+    return record.expires_at != 0 && now_ms >= record.expires_at;
+}
+
+} // namespace
+
+void ReadSnapshot::publish(const std::filesystem::path& data_dir, uint64_t generation,
+                           const std::vector<SnapshotEntry>& entries) {
+    const auto dir = snapshotDir(data_dir);
+    std::filesystem::create_directories(dir);
+
+    const auto path = generationPath(data_dir, generation);
+    const auto tmp_path = path.string() + ".tmp";
+    {
+        std::ofstream out(tmp_path, std::ios::binary | std::ios::trunc);
+        if (!out.is_open()) {
+            throw std::runtime_error("failed to open read snapshot for writing: " + tmp_path);
+        }
+
+        std::vector<uint64_t> offsets;
+        offsets.reserve(entries.size());
+        uint64_t offset = kHeaderBytes;
+        for (const auto& entry : entries) {
+            offsets.push_back(offset);
+            offset += kRecordHeaderBytes + entry.key.size() + entry.frames.size();
+        }
+
+        out.write(reinterpret_cast<const char*>(kSnapshotMagic.data()), kSnapshotMagic.size());
+        writeScalar<uint64_t>(out, generation);
+        writeScalar<uint64_t>(out, entries.size());
+        writeScalar<uint64_t>(out, offset);
+
+        for (const auto& entry : entries) {
+            writeScalar(out, static_cast<uint32_t>(entry.key.size()));
+            writeScalar(out, static_cast<uint32_t>(entry.frames.size()));
+            writeScalar(out, entry.expires_at);
+            out.write(entry.key.data(), static_cast<std::streamsize>(entry.key.size()));
+            out.write(reinterpret_cast<const char*>(entry.frames.data()),
+                      static_cast<std::streamsize>(entry.frames.size()));
+        }
+        out.write(reinterpret_cast<const char*>(offsets.data()),
+                  static_cast<std::streamsize>(offsets.size() * sizeof(uint64_t)));
+        out.write(reinterpret_cast<const char*>(kSnapshotMagic.data()), kSnapshotMagic.size());
+
+        out.flush();
+        if (!out) throw std::runtime_error("failed to write read snapshot: " + tmp_path);
+    }
+    std::filesystem::rename(tmp_path, path);
+
+    const auto current_path = dir / kCurrentFileName;
+    const auto current_tmp = current_path.string() + ".tmp";
+    {
+        std::ofstream out(current_tmp, std::ios::binary | std::ios::trunc);
+        out << generation << '\n';
+        out.flush();
+        if (!out) throw std::runtime_error("failed to write read snapshot pointer");
+    }
+    std::filesystem::rename(current_tmp, current_path);
+
+    // A reader may have just read the previous CURRENT, so that generation
+    // stays until the next publish.
+    std::error_code ec;
+    for (const auto& file : std::filesystem::directory_iterator(dir, ec)) {
+        if (file.path().extension() != ".tkvs") continue;
+        const auto older = parseGeneration(file.path().stem().string());
+        if (older && *older + 1 < generation) {
+            std::error_code remove_ec;
+            std::filesystem::remove(file.path(), remove_ec);
+        }
+    }
+}
+
+uint64_t ReadSnapshot::currentGeneration(const std::filesystem::path& data_dir) {
+    std::ifstream in(snapshotDir(data_dir) / kCurrentFileName, std::ios::binary);
+    if (!in.is_open()) return 0;
+
+    std::string text;
+    std::getline(in, text);
+    return parseGeneration(text).value_or(0);
+}
+
+ReadSnapshot::ReadSnapshot(const std::filesystem::path& data_dir, uint64_t generation)
+    : generation_(generation) {
+    const auto path = generationPath(data_dir, generation);
+
+#ifdef _WIN32
+    HANDLE file = CreateFileW(path.wstring().c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE,
+                              NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file == INVALID_HANDLE_VALUE) {
+        throw std::runtime_error("failed to open read snapshot: " + path.string());
+    }
+    LARGE_INTEGER size{};
+    GetFileSizeEx(file, &size);
+    bytes_ = static_cast<size_t>(size.QuadPart);
+    HANDLE mapping = bytes_ > 0 ? CreateFileMappingW(file, NULL, PAGE_READONLY, 0, 0, NULL) : NULL;
+    // The view keeps the mapping alive on its own.
+    if (mapping) {
+        data_ = static_cast<const uint8_t*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+        CloseHandle(mapping);
+    }
+    CloseHandle(file);
+#else
+    const int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw std::runtime_error("failed to open read snapshot: " + path.string());
+    }
+    struct stat st {};
+    if (::fstat(fd, &st) == 0) bytes_ = static_cast<size_t>(st.st_size);
+    if (bytes_ > 0) {
+        void* mapped = ::mmap(nullptr, bytes_, PROT_READ, MAP_SHARED, fd, 0);
+        if (mapped != MAP_FAILED) {
+            // Lookups jump around the file; readahead would mostly fetch
+            // pages nobody asked for.
+            ::madvise(mapped, bytes_, MADV_RANDOM);
+            data_ = static_cast<const uint8_t*>(mapped);
+        }
+    }
+    ::close(fd);
+#endif
+
+    if (!data_) throw std::runtime_error("failed to map read snapshot: " + path.string());
+    try {
+        validate();
+    } catch (...) {
+#ifdef _WIN32
+        UnmapViewOfFile(data_);
+#else
+        ::munmap(const_cast<uint8_t*>(data_), bytes_);
+#endif
+        throw;
+    }
+}
+
+ReadSnapshot::~ReadSnapshot() {
+    if (!data_) return;
+#ifdef _WIN32
+    UnmapViewOfFile(data_);
+#else
+    ::munmap(const_cast<uint8_t*>(data_), bytes_);
+#endif
+}
+
+void ReadSnapshot::validate() {
+    if (bytes_ < kHeaderBytes + kSnapshotMagic.size()
+        || std::memcmp(data_, kSnapshotMagic.data(), kSnapshotMagic.size()) != 0
+        || std::memcmp(data_ + bytes_ - kSnapshotMagic.size(), kSnapshotMagic.data(), kSnapshotMagic.size()) != 0) {
+        corrupt("bad magic");
+    }
+
+    const uint64_t generation = loadScalar<uint64_t>(data_ + kSnapshotMagic.size());
+    const uint64_t count = loadScalar<uint64_t>(data_ + kSnapshotMagic.size() + sizeof(uint64_t));
+    const uint64_t index_offset = loadScalar<uint64_t>(data_ + kSnapshotMagic.size() + 2 * sizeof(uint64_t));
+    if (generation != generation_) corrupt("generation mismatch");
+    if (index_offset < kHeaderBytes || index_offset > bytes_ - kSnapshotMagic.size()
+        || (bytes_ - index_offset - kSnapshotMagic.size()) / sizeof(uint64_t) != count
+        || (bytes_ - index_offset - kSnapshotMagic.size()) % sizeof(uint64_t) != 0) {
+        corrupt("bad index");
+    }
+
+    count_ = static_cast<size_t>(count);
+    index_offset_ = static_cast<size_t>(index_offset);
+}
+
+ReadSnapshot::Record ReadSnapshot::at(size_t position) const {
+    const uint64_t offset = loadScalar<uint64_t>(data_ + index_offset_ + position * sizeof(uint64_t));
+    if (offset < kHeaderBytes || offset > index_offset_ - kRecordHeaderBytes) corrupt("bad record offset");
+
+    const uint8_t* record = data_ + offset;
+    const uint32_t key_len = loadScalar<uint32_t>(record);
+    const uint32_t value_len = loadScalar<uint32_t>(record + sizeof(uint32_t));
+    if (static_cast<uint64_t>(key_len) + value_len > index_offset_ - offset - kRecordHeaderBytes) {
+        corrupt("record overruns data");
+    }
+
+    const uint8_t* key = record + kRecordHeaderBytes;
+    return {std::string_view(reinterpret_cast<const char*>(key), key_len),
+            std::span<const uint8_t>(key + key_len, value_len),
+            loadScalar<int64_t>(record + 2 * sizeof(uint32_t))};
+}
+
+std::string_view ReadSnapshot::keyAt(size_t position) const {
+    return at(position).key;
+}
+
+size_t ReadSnapshot::lowerBound(std::string_view key) const {
+    size_t low = 0;
+    size_t high = count_;
+    while (low < high) {
+        const size_t mid = low + (high - low) / 2;
+        if (keyAt(mid) < key) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+    return low;
+}
+
+std::optional<ReadSnapshot::Record> ReadSnapshot::find(std::string_view key) const {
+    const size_t position = lowerBound(key);
+    if (position == count_) return std::nullopt;
+    Record record = at(position);
+    if (record.key != key) return std::nullopt;
+    return record;
+}
+
+TitanReader::TitanReader(const std::string& data_dir) : dir_(data_dir) {
+    std::error_code ec;
+    if (!std::filesystem::is_directory(dir_, ec)) {
+        throw std::runtime_error("data directory does not exist: " + data_dir);
+    }
+    refresh();
+}
+
+TitanReader::~TitanReader() = default;
+
+std::shared_ptr<const ReadSnapshot> TitanReader::current() const {
+    std::lock_guard lock(mutex_);
+    return snapshot_;
+}
+
+bool TitanReader::refresh() {
+    // Two quick publishes can remove the generation CURRENT named when it
+    // was read; CURRENT has moved on by then, so read it again.
+    constexpr int kAttempts = 3;
+    for (int attempt = 1;; attempt++) {
+        const uint64_t generation = ReadSnapshot::currentGeneration(dir_);
+        if (generation == 0) return false;
+        {
+            std::lock_guard lock(mutex_);
+            if (snapshot_ && snapshot_->generation() == generation) return false;
+        }
+
+        try {
+            loadNewDictionaries(dir_);
+            auto next = std::make_shared<const ReadSnapshot>(dir_, generation);
+            std::lock_guard lock(mutex_);
+            snapshot_ = std::move(next);
+            return true;
+        } catch (const std::exception&) {
+            if (attempt == kAttempts || ReadSnapshot::currentGeneration(dir_) == generation) throw;
+        }
+    }
+}
+
+uint64_t TitanReader::generation() const {
+    auto snapshot = current();
+    return snapshot ? snapshot->generation() : 0;
+}
+
+size_t TitanReader::size() const {
+    auto snapshot = current();
+    return snapshot ? snapshot->size() : 0;
+}
+
+std::optional<std::string> TitanReader::get(const std::string& key) const {
+    auto snapshot = current();
+    if (!snapshot) return std::nullopt;
+
+    const auto record = snapshot->find(key);
+    if (!record || expired(*record, wallClockMs())) return std::nullopt;
+    return decompressFrames(record->frames);
+}
+
+bool TitanReader::has(const std::string& key) const {
+    auto snapshot = current();
+    if (!snapshot) return false;
+
+    const auto record = snapshot->find(key);
+    return record && !expired(*record, wallClockMs());
+}
+
+std::vector<std::string> TitanReader::keys(size_t limit) const {
+    std::vector<std::string> result;
+    auto snapshot = current();
+    if (!snapshot) return result;
+
+    const int64_t now_ms = wallClockMs();
+    for (size_t i = 0; i < snapshot->size() && result.size() < limit; i++) {
+        const auto record = snapshot->at(i);
+        if (!expired(record, now_ms)) result.emplace_back(record.key);
+    }
+    return result;
+}
+
+std::vector<std::pair<std::string, std::string>> TitanReader::scan(const std::string& prefix, size_t limit) const {
+    std::vector<std::pair<std::string, std::string>> result;
+    auto snapshot = current();
+    if (!snapshot) return result;
+
+    const int64_t now_ms = wallClockMs();
+    for (size_t i = snapshot->lowerBound(prefix); i < snapshot->size() && result.size() < limit; i++) {
+        const auto record = snapshot->at(i);
+        if (!record.key.starts_with(prefix)) break;
+        if (!expired(record, now_ms)) result.emplace_back(std::string(record.key), decompressFrames(record.frames));
+    }
+    return result;
+}
+
+} // namespace titan
@@ -0,0 +1,67 @@
+#pragma once
+
+#include "storage.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <span>
+#include <string_view>
+#include <vector>
+
+namespace titan {
+
+// Immutable, sorted copy of the live plain values that the writer process
+// publishes for readers in other processes. Readers map the file and
+// binary-search an offset index at its end, so a lookup touches a few pages
+// and takes no lock.
+//
+// Each generation is its own file under <data_dir>/snapshots; CURRENT names
+// the newest one and is replaced atomically, so a reader only ever maps a
+// complete file. Layout: magic, generation, entry count and index offset;
+// per entry klen u32, vlen u32, expires_at i64, key, compressed value; then
+// one u64 record offset per entry in key order and the magic again.
+class ReadSnapshot {
+public:
+    struct Record {
+        std::string_view key;
+        std::span<const uint8_t> frames;
+        // Unix ms, 0 without a TTL.
+        int64_t expires_at = 0;
+    };
+
+    // `entries` must be sorted by key, as Storage::snapshot() returns them.
+    // Generations older than the previous one are removed on a best-effort
+    // basis; readers that still map them keep a valid view on POSIX.
+    static void publish(const std::filesystem::path& data_dir, uint64_t generation,
+                        const std::vector<SnapshotEntry>& entries);
+    // The generation CURRENT points at, 0 when nothing was published.
+    static uint64_t currentGeneration(const std::filesystem::path& data_dir);
+
+    // Throws when the generation is missing or its file is malformed.
+    ReadSnapshot(const std::filesystem::path& data_dir, uint64_t generation);
+    ~ReadSnapshot();
+
+    ReadSnapshot(const ReadSnapshot&) = delete;
+    ReadSnapshot& operator=(const ReadSnapshot&) = delete;
+
+    uint64_t generation() const { return generation_; }
+    size_t size() const { return count_; }
+
+    std::optional<Record> find(std::string_view key) const;
+    // Position of the first record whose key is not below `key`.
+    size_t lowerBound(std::string_view key) const;
+    Record at(size_t position) const;
+
+private:
+    const uint8_t* data_ = nullptr;
+    size_t bytes_ = 0;
+    uint64_t generation_ = 0;
+    size_t count_ = 0;
+    size_t index_offset_ = 0;
+
+    void validate();
+    std::string_view keyAt(size_t position) const;
+};
+
+} // namespace titan
@@ -0,0 +1,344 @@
+#include "skiplist.hpp"
+#include "quicklist.hpp"
+#include "utils.hpp"
+#include <cmath>
+#include <cstring>
+#include <new>
+#include <random>
+#include <stdexcept>
+
+namespace titan {
+
+namespace {
+
+// Redis' branching factor: a node reaches level i + 1 with probability 1/4.
+constexpr uint32_t kLevelProbabilityMask = 0x3;
+
+// Per-member index cost: hash node (next link, cached hash) and its pair.
+constexpr size_t kIndexEntryBytes = 2 * sizeof(void*) + sizeof(std::pair<std::string_view, void*>);
+
+} // namespace
+
+void appendScoredMember(std::vector<uint8_t>& out, std::string_view member, double score) {
+    std::string value(sizeof(score) + member.size(), '\0');
+    std::memcpy(value.data(), &score, sizeof(score));
+    if (!member.empty()) std::memcpy(value.data() + sizeof(score), member.data(), member.size());
+    appendPackedValue(out, value);
+}
+
+std::vector<std::pair<std::string, double>> unpackScoredMembers(std::span<const uint8_t> packed) {
+    std::vector<std::pair<std::string, double>> members;
+    for (auto& value : unpackValues(packed)) {
+        if (value.size() < sizeof(double)) throw std::runtime_error("corrupt sorted set payload");
+        double score = 0;
+        std::memcpy(&score, value.data(), sizeof(score));
+        members.emplace_back(value.substr(sizeof(score)), score);
+    }
+    return members;
+}
+
+SortedSet::SortedSet() : header_(createNode(kMaxLevel, {}, 0)) {}
+
+SortedSet::~SortedSet() {
+    release();
+}
+
+SortedSet::SortedSet(SortedSet&& other) noexcept
+    : header_(other.header_), tail_(other.tail_), level_(other.level_), length_(other.length_),
+      node_bytes_(other.node_bytes_), index_(std::move(other.index_)) {
+    other.header_ = nullptr;
+    other.tail_ = nullptr;
+    other.level_ = 1;
+    other.length_ = 0;
+    other.node_bytes_ = 0;
+    other.index_.clear();
+}
+
+SortedSet& SortedSet::operator=(SortedSet&& other) noexcept {
+    if (this != &other) {
+        release();
+        header_ = other.header_;
+        tail_ = other.tail_;
+        level_ = other.level_;
+        length_ = other.length_;
+        node_bytes_ = other.node_bytes_;
+        index_ = std::move(other.index_);
+        other.header_ = nullptr;
+        other.tail_ = nullptr;
+        other.level_ = 1;
+        other.length_ = 0;
+        other.node_bytes_ = 0;
+        other.index_.clear();
+    }
+    return *this;
+}
+
+void SortedSet::release() {
+    if (!header_) return;
+    Node* node = header_->levels()[0].forward;
+    while (node) {
+        Node* next = node->levels()[0].forward;
+        destroyNode(node);
+        node = next;
+    }
+    destroyNode(header_);
+    header_ = nullptr;
+}
+
+SortedSet::Node* SortedSet::createNode(int height, std::string_view member, double score) {
+    void* memory = ::operator new(sizeof(Node) + static_cast<size_t>(height) * sizeof(Level));
+    Node* node = new (memory) Node{std::string(member), score, nullptr, height};
+    for (int i = 0; i < height; i++) new (&node->levels()[i]) Level{};
+    return node;
+}
+
+void SortedSet::destroyNode(Node* node) {
+    node->~Node();
+    ::operator delete(node);
+}
+
+size_t SortedSet::nodeBytes(const Node* node) {
+    return sizeof(Node) + static_cast<size_t>(node->height) * sizeof(Level) + stringHeapBytes(node->member);
+}
+
+int SortedSet::randomLevel() {
+    thread_local std::minstd_rand rng(std::random_device{}());
+    int height = 1;
+    while (height < kMaxLevel && (rng() & kLevelProbabilityMask) == 0) height++;
+    return height;
+}
+
+namespace {
+
+template <typename Node>
+bool orderedBefore(const Node* node, double score, std::string_view member) {
+    return node->score < score || (node->score == score && std::string_view(node->member) < member);
+}
+
+} // namespace
+
+void SortedSet::link(Node* node) {
+    Node* update[kMaxLevel];
+    size_t rank[kMaxLevel];
+
+    Node* x = header_;
+    for (int i = level_ - 1; i >= 0; i--) {
+        rank[i] = i == level_ - 1 ? 0 : rank[i + 1];
+        while (x->levels()[i].forward && orderedBefore(x->levels()[i].forward, node->score, node->member)) {
+            rank[i] += x->levels()[i].span;
+            x = x->levels()[i].forward;
+        }
+        update[i] = x;
+    }
+
+    if (node->height > level_) {
+        for (int i = level_; i < node->height; i++) {
+            rank[i] = 0;
+            update[i] = header_;
+            header_->levels()[i].span = length_;
+        }
+        level_ = node->height;
+    }
+
+    for (int i = 0; i < node->height; i++) {
+        Level& prev = update[i]->levels()[i];
+        node->levels()[i].forward = prev.forward;
+        prev.forward = node;
+        node->levels()[i].span = prev.span - (rank[0] - rank[i]);
+        prev.span = rank[0] - rank[i] + 1;
+    }
+    for (int i = node->height; i < level_; i++) {
+        update[i]->levels()[i].span++;
+    }
+
+    node->backward = update[0] == header_ ? nullptr : update[0];
+    if (node->levels()[0].forward) {
+        node->levels()[0].forward->backward = node;
+    } else {
+        tail_ = node;
+    }
+    length_++;
+}
+
+void SortedSet::unlink(Node* node) {
+    Node* update[kMaxLevel];
+    Node* x = header_;
+    for (int i = level_ - 1; i >= 0; i--) {
+        while (x->levels()[i].forward && x->levels()[i].forward != node
+               && orderedBefore(x->levels()[i].forward, node->score, node->member)) {
+            x = x->levels()[i].forward;
+        }
+        update[i] = x;
+    }
+
+    for (int i = 0; i < level_; i++) {
+        Level& prev = update[i]->levels()[i];
+        if (prev.forward == node) {
+            prev.span += node->levels()[i].span - 1;
+            prev.forward = node->levels()[i].forward;
+        } else {
+            prev.span--;
+        }
+    }
+
+    if (node->levels()[0].forward) {
+        node->levels()[0].forward->backward = node->backward;
+    } else {
+        tail_ = node->backward;
+    }
+    while (level_ > 1 && header_->levels()[level_ - 1].forward == nullptr) level_--;
+    length_--;
+}
+
+bool SortedSet::add(std::string_view member, double score) {
+    if (std::isnan(score)) throw std::runtime_error("score is not a number");
+
+    auto it = index_.find(member);
+    if (it != index_.end()) {
+        Node* node = it->second;
+        if (node->score == score) return false;
+
+        // Re-scoring in place keeps the node (and the index key viewing its
+        // member) when the order does not change.
+        const Node* prev = node->backward;
+        const Node* next = node->levels()[0].forward;
+        const bool stays = (!prev || orderedBefore(prev, score, node->member))
+            && (!next || !orderedBefore(next, score, node->member));
+        if (stays) {
+            node->score = score;
+        } else {
+            unlink(node);
+            node->score = score;
+            link(node);
+        }
+        return false;
+    }
+
+    Node* node = createNode(randomLevel(), member, score);
+    link(node);
+    index_.emplace(std::string_view(node->member), node);
+    node_bytes_ += nodeBytes(node);
+    return true;
+}
+
+bool SortedSet::remove(std::string_view member) {
+    auto it = index_.find(member);
+    if (it == index_.end()) return false;
+
+    Node* node = it->second;
+    index_.erase(it);
+    unlink(node);
+    node_bytes_ -= nodeBytes(node);
+    destroyNode(node);
+    return true;
+}
+
+std::optional<double> SortedSet::score(std::string_view member) const {
+    auto it = index_.find(member);
+    if (it == index_.end()) return std::nullopt;
+    return it->second->score;
+}
+
+std::optional<size_t> SortedSet::rank(std::string_view member, bool reverse) const {
+    auto it = index_.find(member);
+    if (it == index_.end()) return std::nullopt;
+
+    const Node* target = it->second;
+    size_t traversed = 0;
+    const Node* x = header_;
+    for (int i = level_ - 1; i >= 0; i--) {
+        while (x->levels()[i].forward && (x->levels()[i].forward == target
+               || orderedBefore(x->levels()[i].forward, target->score, target->member))) {
+            traversed += x->levels()[i].span;
+            x = x->levels()[i].forward;
+        }
+        if (x == target) break;
+    }
+
+    const size_t ascending = traversed - 1;
+    return reverse ? length_ - 1 - ascending : ascending;
+}
+
+SortedSet::Node* SortedSet::nodeAtRank(size_t rank) const {
+    size_t traversed = 0;
+    Node* x = header_;
+    for (int i = level_ - 1; i >= 0; i--) {
+        while (x->levels()[i].forward && traversed + x->levels()[i].span <= rank) {
+            traversed += x->levels()[i].span;
+            x = x->levels()[i].forward;
+        }
+        if (traversed == rank) return x;
+    }
+    return nullptr;
+}
+
+size_t SortedSet::countBefore(double score, bool inclusive) const {
+    size_t traversed = 0;
+    const Node* x = header_;
+    for (int i = level_ - 1; i >= 0; i--) {
+        while (x->levels()[i].forward) {
+            const double next = x->levels()[i].forward->score;
+            if (inclusive ? next > score : next >= score) break;
+            traversed += x->levels()[i].span;
+            x = x->levels()[i].forward;
+        }
+    }
+    return traversed;
+}
+
+std::vector<SortedSet::Member> SortedSet::range(size_t start, size_t stop, bool reverse) const {
+    std::vector<Member> members;
+    if (start > stop || start >= length_) return members;
+    if (stop >= length_) stop = length_ - 1;
+
+    size_t remaining = stop - start + 1;
+    members.reserve(remaining);
+
+    const Node* node = nodeAtRank(reverse ? length_ - start : start + 1);
+    while (node && remaining > 0) {
+        members.emplace_back(node->member, node->score);
+        node = reverse ? node->backward : node->levels()[0].forward;
+        remaining--;
+    }
+    return members;
+}
+
+std::vector<SortedSet::Member> SortedSet::rangeByScore(double min, double max, size_t offset, size_t count,
+                                                       bool reverse) const {
+    std::vector<Member> members;
+    if (std::isnan(min) || std::isnan(max)) return members;
+    if (reverse) {
+        // Ranks are 1-based, so `last` is the rank of the highest match.
+        const size_t last = countBefore(max, true);
+        if (count == 0 || min > max || offset >= last) return members;
+
+        const Node* node = nodeAtRank(last - offset);
+        while (node && node->score >= min && members.size() < count) {
+            members.emplace_back(node->member, node->score);
+            node = node->backward;
+        }
+        return members;
+    }
+
+    const size_t first = countBefore(min, false);
+    if (count == 0 || min > max || first >= length_ || offset >= length_ - first) return members;
+
+    const Node* node = nodeAtRank(first + offset + 1);
+    while (node && node->score <= max && members.size() < count) {
+        members.emplace_back(node->member, node->score);
+        node = node->levels()[0].forward;
+    }
+    return members;
+}
+
+size_t SortedSet::countByScore(double min, double max) const {
+    if (std::isnan(min) || std::isnan(max) || min > max) return 0;
+    return countBefore(max, true) - countBefore(min, false);
+}
+
+size_t SortedSet::memoryUsage() const {
+    return sizeof(SortedSet) + sizeof(Node) + kMaxLevel * sizeof(Level) + node_bytes_
+        + index_.size() * kIndexEntryBytes + index_.bucket_count() * sizeof(void*);
+}
+
+} // namespace titan
@@ -0,0 +1,99 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace titan {
+
+// (member, score) pairs in the appendPackedValue() form used by ZADD records:
+// each packed value is the 8-byte score followed by the member bytes.
+void appendScoredMember(std::vector<uint8_t>& out, std::string_view member, double score);
+std::vector<std::pair<std::string, double>> unpackScoredMembers(std::span<const uint8_t> packed);
+
+// Sorted set after Redis' zset: a skiplist ordered by (score, member) whose
+// links carry spans, so rank lookups and rank ranges cost O(log n), plus a
+// member -> node hash for O(1) score lookups. Ranks are 0-based.
+class SortedSet {
+public:
+    using Member = std::pair<std::string, double>;
+
+    SortedSet();
+    ~SortedSet();
+    SortedSet(SortedSet&& other) noexcept;
+    SortedSet& operator=(SortedSet&& other) noexcept;
+    SortedSet(const SortedSet&) = delete;
+    SortedSet& operator=(const SortedSet&) = delete;
+
+    // Inserts or re-scores a member; returns true when it was new.
+    bool add(std::string_view member, double score);
+    bool remove(std::string_view member);
+
+    std::optional<double> score(std::string_view member) const;
+    std::optional<size_t> rank(std::string_view member, bool reverse = false) const;
+    // Inclusive rank bounds, already clamped by the caller.
+    std::vector<Member> range(size_t start, size_t stop, bool reverse = false) const;
+    // Members with min <= score <= max, skipping the first `offset`; with
+    // `reverse` they are listed from the highest score down.
+    std::vector<Member> rangeByScore(double min, double max, size_t offset = 0,
+                                     size_t count = std::numeric_limits<size_t>::max(), bool reverse = false) const;
+    size_t countByScore(double min, double max) const;
+
+    size_t size() const { return length_; }
+    bool empty() const { return length_ == 0; }
+    size_t memoryUsage() const;
+
+private:
+    static constexpr int kMaxLevel = 32;
+
+    struct Node;
+
+    struct Level {
+        Node* forward = nullptr;
+        // Number of level-0 links this one skips over.
+        size_t span = 0;
+    };
+
+    struct Node {
+        std::string member;
+        double score = 0;
+        Node* backward = nullptr;
+        int height = 0;
+
+        // The levels are allocated directly after the node.
+        Level* levels() { return reinterpret_cast<Level*>(this + 1); }
+        const Level* levels() const { return reinterpret_cast<const Level*>(this + 1); }
+    };
+
+    Node* header_ = nullptr;
+    Node* tail_ = nullptr;
+    int level_ = 1;
+    size_t length_ = 0;
+    // Nodes, their levels and member strings; the index is added on top.
+    size_t node_bytes_ = 0;
+    // Keys view the member string of the node they map to.
+    std::unordered_map<std::string_view, Node*> index_;
+
+    static Node* createNode(int height, std::string_view member, double score);
+    static void destroyNode(Node* node);
+    static size_t nodeBytes(const Node* node);
+    static int randomLevel();
+
+    void link(Node* node);
+    void unlink(Node* node);
+    // Number of members scoring below `score`, or at most `score` when
+    // `inclusive` is set.
+    size_t countBefore(double score, bool inclusive) const;
+    // 1-based, as the span arithmetic counts the header as rank 0.
+    Node* nodeAtRank(size_t rank) const;
+    void release();
+};
+
+} // namespace titan
@@ -1,5 +1,8 @@
 #include "sstable.hpp"
 #include "checksum.hpp"
+#include "compressor.hpp"
+#include "key_prefix.hpp"
+#include "utils.hpp"
 #include <algorithm>
 #include <stdexcept>
 #include <array>
@@ -7,93 +10,125 @@
 namespace titan {
 
 namespace {
-constexpr std::array<uint8_t, 8> kSstMagic{{'T', 'K', 'V', 'S', 'S', 'T', '3', '\n'}};
+// v4 stores expirations as Unix milliseconds; v3 and headerless tables hold
+// steady-clock deadlines.
+constexpr std::array<uint8_t, 8> kSstMagic{{'T', 'K', 'V', 'S', 'S', 'T', '4', '\n'}};
+constexpr std::array<uint8_t, 8> kSstMagicV3{{'T', 'K', 'V', 'S', 'S', 'T', '3', '\n'}};
 }
 
-SSTable::SSTable(const std::string& filepath, bool bloom_enabled)
-    : filepath_(filepath), bloom_enabled_(bloom_enabled) {
-    loadIndex();
-}
-
-void SSTable::build(const std::string& filepath, const std::map<std::string, titan::ValueEntry>& memtable) {
-    std::ofstream out(filepath, std::ios::binary | std::ios::trunc);
-    if (!out.is_open()) {
+SSTableBuilder::SSTableBuilder(const std::string& filepath)
+    : filepath_(filepath), out_(filepath, std::ios::binary | std::ios::trunc) {
+    if (!out_.is_open()) {
         throw std::runtime_error("Failed to open SSTable for writing: " + filepath);
     }
+    out_.write(reinterpret_cast<const char*>(kSstMagic.data()), static_cast<std::streamsize>(kSstMagic.size()));
+}
 
-    out.write(reinterpret_cast<const char*>(kSstMagic.data()), static_cast<std::streamsize>(kSstMagic.size()));
-
-    std::vector<std::pair<std::string, uint64_t>> current_index;
-    current_index.reserve(memtable.size());
-
-    for (const auto& [key, entry] : memtable) {
-        uint64_t current_offset = out.tellp();
-        current_index.push_back({key, current_offset});
+void SSTableBuilder::add(std::string_view key, std::span<const uint8_t> compressed, uint64_t raw_size,
+                         int64_t expires_at) {
+    if (finished_) throw std::runtime_error("SSTable builder already finished");
+    // The index stores key lengths as u16.
+    if (key.empty() || key.size() > UINT16_MAX) {
+        throw std::runtime_error("SSTable keys must be 1 to 65535 bytes long");
+    }
+    if (!index_.empty() && key <= std::string_view(index_.back().first)) {
+        throw std::runtime_error("SSTable keys must be added in ascending order: " + std::string(key));
+    }
 
-        uint32_t key_len = static_cast<uint32_t>(key.size());
-        out.write(reinterpret_cast<const char*>(&key_len), sizeof(key_len));
-        out.write(key.data(), static_cast<std::streamsize>(key_len));
+    const uint64_t offset = out_.tellp();
+    index_.emplace_back(std::string(key), offset);
 
-        uint32_t val_len = static_cast<uint32_t>(entry.compressed_value.size());
-        out.write(reinterpret_cast<const char*>(&val_len), sizeof(val_len));
+    const uint32_t key_len = static_cast<uint32_t>(key.size());
+    out_.write(reinterpret_cast<const char*>(&key_len), sizeof(key_len));
+    out_.write(key.data(), static_cast<std::streamsize>(key_len));
 
-        if (val_len > 0) {
-            out.write(reinterpret_cast<const char*>(entry.compressed_value.data()), val_len);
-        }
+    const uint32_t val_len = static_cast<uint32_t>(compressed.size());
+    out_.write(reinterpret_cast<const char*>(&val_len), sizeof(val_len));
+    if (val_len > 0) {
+        out_.write(reinterpret_cast<const char*>(compressed.data()), val_len);
+    }
 
-        uint64_t raw_size = static_cast<uint64_t>(entry.raw_size);
-        out.write(reinterpret_cast<const char*>(&raw_size), sizeof(raw_size));
+    out_.write(reinterpret_cast<const char*>(&raw_size), sizeof(raw_size));
+    out_.write(reinterpret_cast<const char*>(&expires_at), sizeof(expires_at));
 
-        out.write(reinterpret_cast<const char*>(&entry.expires_at), sizeof(entry.expires_at));
+    uint32_t checksum = kFnv1a32Offset;
+    checksum = fnv1a32Update(checksum, &key_len, sizeof(key_len));
+    checksum = fnv1a32Update(checksum, key.data(), key.size());
+    checksum = fnv1a32Update(checksum, &val_len, sizeof(val_len));
+    if (val_len > 0) {
+        checksum = fnv1a32Update(checksum, compressed.data(), compressed.size());
+    }
+    checksum = fnv1a32Update(checksum, &raw_size, sizeof(raw_size));
+    checksum = fnv1a32Update(checksum, &expires_at, sizeof(expires_at));
 
-        uint32_t checksum = kFnv1a32Offset;
-        checksum = fnv1a32Update(checksum, &key_len, sizeof(key_len));
-        checksum = fnv1a32Update(checksum, key.data(), key.size());
-        checksum = fnv1a32Update(checksum, &val_len, sizeof(val_len));
-        if (val_len > 0) {
-            checksum = fnv1a32Update(checksum, entry.compressed_value.data(), entry.compressed_value.size());
-        }
-        checksum = fnv1a32Update(checksum, &raw_size, sizeof(raw_size));
-        checksum = fnv1a32Update(checksum, &entry.expires_at, sizeof(entry.expires_at));
+    out_.write(reinterpret_cast<const char*>(&checksum), sizeof(checksum));
+}
 
-        out.write(reinterpret_cast<const char*>(&checksum), sizeof(checksum));
-    }
+void SSTableBuilder::finish() {
+    TITAN_ASSERT(!finished_, "SSTable builder already finished");
+    finished_ = true;
 
-    uint64_t index_start_offset = out.tellp();
+    uint64_t index_start_offset = out_.tellp();
 
-    uint32_t total_keys = static_cast<uint32_t>(current_index.size());
-    out.write(reinterpret_cast<const char*>(&total_keys), sizeof(total_keys));
+    uint32_t total_keys = static_cast<uint32_t>(index_.size());
+    out_.write(reinterpret_cast<const char*>(&total_keys), sizeof(total_keys));
 
-    for (const auto& [key, offset] : current_index) {
+    for (const auto& [key, offset] : index_) {
         uint16_t key_len = static_cast<uint16_t>(key.length());
-        out.write(reinterpret_cast<const char*>(&key_len), sizeof(key_len));
-        out.write(key.data(), key_len);
-        out.write(reinterpret_cast<const char*>(&offset), sizeof(offset));
+        out_.write(reinterpret_cast<const char*>(&key_len), sizeof(key_len));
+        out_.write(key.data(), key_len);
+        out_.write(reinterpret_cast<const char*>(&offset), sizeof(offset));
     }
 
     uint32_t index_checksum = kFnv1a32Offset;
     index_checksum = fnv1a32Update(index_checksum, &total_keys, sizeof(total_keys));
-    for (const auto& [key, offset] : current_index) {
+    for (const auto& [key, offset] : index_) {
         const uint16_t key_len = static_cast<uint16_t>(key.size());
         index_checksum = fnv1a32Update(index_checksum, &key_len, sizeof(key_len));
         index_checksum = fnv1a32Update(index_checksum, key.data(), key.size());
         index_checksum = fnv1a32Update(index_checksum, &offset, sizeof(offset));
     }
-    out.write(reinterpret_cast<const char*>(&index_checksum), sizeof(index_checksum));
+    out_.write(reinterpret_cast<const char*>(&index_checksum), sizeof(index_checksum));
+
+    out_.write(reinterpret_cast<const char*>(&index_start_offset), sizeof(index_start_offset));
+
+    out_.close();
+    if (out_.fail()) {
+        throw std::runtime_error("Failed to write SSTable: " + filepath_);
+    }
+}
+
+SSTable::SSTable(const std::string& filepath, bool bloom_enabled)
+    : filepath_(filepath), bloom_enabled_(bloom_enabled) {
+    loadIndex();
+}
 
-    out.write(reinterpret_cast<const char*>(&index_start_offset), sizeof(index_start_offset));
+void SSTable::build(const std::string& filepath, const MemTable& memtable) {
+    SSTableBuilder builder(filepath);
+    for (const auto& [key, entry] : memtable) {
+        builder.add(key, entry.compressed_value, entry.raw_size, entry.expires_at);
+    }
+    builder.finish();
+}
 
-    out.close();
+void SSTable::verifyOrder() const {
+    for (size_t i = 1; i < index_.size(); ++i) {
+        if (!(index_[i - 1].key < index_[i].key)) {
+            throw std::runtime_error("SSTable keys are not in ascending order: " + filepath_);
+        }
+    }
 }
 
-bool SSTable::hasChecksummedHeader(std::ifstream& in) {
+int SSTable::readFormatVersion(std::ifstream& in) {
     in.seekg(0, std::ios::beg);
     std::array<uint8_t, kSstMagic.size()> header{};
     if (!in.read(reinterpret_cast<char*>(header.data()), static_cast<std::streamsize>(header.size()))) {
         in.clear();
-        return false;
+        return 0;
     }
-    return header == kSstMagic;
+    if (header == kSstMagic) return 4;
+    if (header == kSstMagicV3) return 3;
+    return 0;
 }
 
 uint32_t SSTable::hashKeyWithSeed(std::string_view key, uint32_t seed) {
@@ -105,6 +140,19 @@ uint32_t SSTable::hashKeyWithSeed(std::string_view key, uint32_t seed) {
     return hash;
 }
 
+// Every key in a sorted table shares the common prefix of its first and last
+// key, so packing the bytes after it keeps prefix-heavy key spaces (e.g.
+// "tenant:acme:session:...") from collapsing onto a single value.
+void SSTable::buildKeyPrefixes() {
+    shared_prefix_len_ = commonPrefixLength(min_key_, max_key_);
+
+    index_prefixes_.clear();
+    index_prefixes_.reserve(index_.size());
+    for (const auto& entry : index_) {
+        index_prefixes_.push_back(keyPrefix(std::string_view(entry.key).substr(shared_prefix_len_)));
+    }
+}
+
 void SSTable::buildFencePointers() {
     fence_pointers_.clear();
     if (index_.empty()) {
@@ -113,7 +161,7 @@ void SSTable::buildFencePointers() {
 
     fence_pointers_.reserve((index_.size() / kFenceStride) + 1);
     for (size_t pos = 0; pos < index_.size(); pos += kFenceStride) {
-        fence_pointers_.push_back({index_[pos].key, static_cast<uint32_t>(pos)});
+        fence_pointers_.push_back({index_[pos].key, index_prefixes_[pos], static_cast<uint32_t>(pos)});
     }
 }
 
@@ -172,18 +220,34 @@ void SSTable::rebuildReadPathStructures() {
     if (index_.empty()) {
         min_key_.clear();
         max_key_.clear();
+        index_prefixes_.clear();
+        shared_prefix_len_ = 0;
         fence_pointers_.clear();
         bloom_bits_.clear();
         bloom_bits_count_ = 0;
         bloom_hash_count_ = 0;
+        memory_bytes_ = 0;
         return;
     }
 
     min_key_ = index_.front().key;
     max_key_ = index_.back().key;
 
+    buildKeyPrefixes();
     buildFencePointers();
     buildBloomFilter();
+    computeMemoryUsage();
+}
+
+void SSTable::computeMemoryUsage() {
+    size_t bytes = index_.capacity() * sizeof(IndexEntry)
+        + index_prefixes_.capacity() * sizeof(uint64_t)
+        + fence_pointers_.capacity() * sizeof(FencePointer)
+        + bloom_bits_.capacity()
+        + stringHeapBytes(min_key_) + stringHeapBytes(max_key_);
+    for (const auto& entry : index_) bytes += stringHeapBytes(entry.key);
+    for (const auto& fence : fence_pointers_) bytes += stringHeapBytes(fence.key);
+    memory_bytes_ = bytes;
 }
 
 void SSTable::loadLegacyIndex(std::ifstream& in) {
@@ -253,7 +317,9 @@ void SSTable::loadIndex() {
         throw std::runtime_error("SSTable failed to open: " + filepath_);
     }
 
-    checksummed_format_ = hasChecksummedHeader(in);
+    const int version = readFormatVersion(in);
+    checksummed_format_ = version >= 3;
+    wall_clock_expiry_ = version >= 4;
     if (checksummed_format_) {
         loadChecksummedIndex(in);
     } else {
@@ -276,6 +342,8 @@ std::optional<uint64_t> SSTable::findRecordOffset(const std::string& key) const
         return std::nullopt;
     }
 
+    const uint64_t target = keyPrefix(std::string_view(key).substr(shared_prefix_len_));
+
     size_t lo = 0;
     size_t hi = index_.size();
     if (!fence_pointers_.empty()) {
@@ -283,8 +351,9 @@ std::optional<uint64_t> SSTable::findRecordOffset(const std::string& key) const
             fence_pointers_.begin(),
             fence_pointers_.end(),
             key,
-            [](const std::string& target, const FencePointer& fence) {
-                return target < fence.key;
+            [target](const std::string& probe, const FencePointer& fence) {
+                if (target != fence.prefix) return target < fence.prefix;
+                return probe < fence.key;
             });
 
         if (fence_it == fence_pointers_.begin()) {
@@ -304,21 +373,22 @@ std::optional<uint64_t> SSTable::findRecordOffset(const std::string& key) const
         }
     }
 
-    auto begin_it = index_.begin() + static_cast<std::ptrdiff_t>(lo);
-    auto end_it = index_.begin() + static_cast<std::ptrdiff_t>(hi);
-    auto it = std::lower_bound(
-        begin_it,
-        end_it,
-        key,
-        [](const IndexEntry& entry, const std::string& target) {
-            return entry.key < target;
-        });
-
-    if (it == end_it || it->key != key) {
-        return std::nullopt;
+    // Only entries whose packed prefix ties with the target need a full
+    // string comparison.
+    size_t pos = lo + countPrefixesBelow(index_prefixes_.data() + lo, hi - lo, target);
+    for (; pos < hi && index_prefixes_[pos] == target; ++pos) {
+        const int cmp = index_[pos].key.compare(key);
+        if (cmp == 0) return index_[pos].offset;
+        if (cmp > 0) break;
     }
 
-    return it->offset;
+    return std::nullopt;
+}
+
+size_t SSTable::lowerBound(std::string_view key) const {
+    auto it = std::lower_bound(index_.begin(), index_.end(), key,
+        [](const IndexEntry& entry, std::string_view probe) { return entry.key < probe; });
+    return static_cast<size_t>(it - index_.begin());
 }
 
 std::optional<titan::ValueEntry> SSTable::get(const std::string& key) const {
@@ -354,18 +424,19 @@ std::optional<titan::ValueEntry> SSTable::get(const std::string& key) const {
         return std::nullopt;
     }
 
-    entry.compressed_value.resize(val_len);
+    std::vector<uint8_t> value_bytes(val_len);
     if (val_len > 0) {
-        if (!in.read(reinterpret_cast<char*>(entry.compressed_value.data()), static_cast<std::streamsize>(val_len))) {
+        if (!in.read(reinterpret_cast<char*>(value_bytes.data()), static_cast<std::streamsize>(val_len))) {
             return std::nullopt;
         }
     }
+    entry.compressed_value.assign(value_bytes);
 
     uint64_t raw_size = 0;
     if (!in.read(reinterpret_cast<char*>(&raw_size), sizeof(raw_size))) {
         return std::nullopt;
     }
-    entry.raw_size = raw_size;
+    entry.raw_size = static_cast<uint32_t>(raw_size);
 
     if (!in.read(reinterpret_cast<char*>(&entry.expires_at), sizeof(entry.expires_at))) {
         return std::nullopt;
@@ -392,6 +463,10 @@ std::optional<titan::ValueEntry> SSTable::get(const std::string& key) const {
         }
     }
 
+    if (!wall_clock_expiry_ && entry.expires_at != 0) {
+        entry.expires_at = steadyToWallClockMs(entry.expires_at);
+    }
+
     return entry;
 }
 
@@ -404,4 +479,27 @@ std::vector<std::string> SSTable::keys() const {
     return out;
 }
 
+SSTableWriter::SSTableWriter(const std::string& path, int compression_level)
+    : builder_(std::make_unique<SSTableBuilder>(path)), compressor_(std::make_unique<Compressor>()),
+      compression_level_(compression_level) {}
+
+SSTableWriter::~SSTableWriter() = default;
+
+void SSTableWriter::add(const std::string& key, const std::string& value, int64_t ttl_ms) {
+    if (value.size() > Compressor::kMaxValueBytes) throw std::runtime_error("value too large: " + key);
+    CompressionSpec spec;
+    spec.level = compression_level_;
+    const auto frames = compressor_->compress(value, spec);
+    builder_->add(key, frames, value.size(), ttl_ms > 0 ? wallClockMs() + ttl_ms : 0);
+}
+
+size_t SSTableWriter::finish() {
+    builder_->finish();
+    return builder_->size();
+}
+
+size_t SSTableWriter::size() const {
+    return builder_->size();
+}
+
 } // namespace titan
@@ -7,15 +7,41 @@
 #include <fstream>
 #include <array>
 #include <string_view>
+#include <span>
 #include "storage.hpp"
 
 namespace titan {
 
+// Streams records into a new table in the current format. Keys must arrive
+// in strictly ascending byte order; only the key index is held in memory.
+class SSTableBuilder {
+public:
+    explicit SSTableBuilder(const std::string& filepath);
+
+    SSTableBuilder(const SSTableBuilder&) = delete;
+    SSTableBuilder& operator=(const SSTableBuilder&) = delete;
+
+    void add(std::string_view key, std::span<const uint8_t> compressed, uint64_t raw_size, int64_t expires_at);
+    // Writes the index and footer; the file is not a valid table before.
+    void finish();
+
+    size_t size() const { return index_.size(); }
+
+private:
+    std::string filepath_;
+    std::ofstream out_;
+    std::vector<std::pair<std::string, uint64_t>> index_;
+    bool finished_ = false;
+};
+
 class SSTable {
 public:
     explicit SSTable(const std::string& filepath, bool bloom_enabled = true);
 
-    static void build(const std::string& filepath, const std::map<std::string, titan::ValueEntry>& memtable);
+    static void build(const std::string& filepath, const MemTable& memtable);
+    // Throws unless the index is in strictly ascending key order, which
+    // tables written by anything but SSTableBuilder need not be.
+    void verifyOrder() const;
 
     std::optional<titan::ValueEntry> get(const std::string& key) const;
     std::vector<std::string> keys() const;
@@ -23,6 +49,11 @@ public:
     std::string getFilePath() const { return filepath_; }
 
     size_t size() const { return index_.size(); }
+    // Index positions in key order, for merge iteration.
+    size_t lowerBound(std::string_view key) const;
+    const std::string& keyAt(size_t position) const { return index_[position].key; }
+    // Resident bytes of the in-memory index, fences and Bloom filter.
+    size_t memoryUsage() const { return memory_bytes_; }
 
 private:
     struct IndexEntry {
@@ -32,14 +63,20 @@ private:
 
     struct FencePointer {
         std::string key;
+        uint64_t prefix = 0;
         uint32_t position = 0;
     };
 
     std::string filepath_;
     bool checksummed_format_ = false;
+    bool wall_clock_expiry_ = false;
     bool bloom_enabled_ = true;
 
     std::vector<IndexEntry> index_;
+    // Parallel to index_: 8 bytes past the table-wide shared prefix, packed by
+    // keyPrefix(). Most lookups resolve against this array alone.
+    std::vector<uint64_t> index_prefixes_;
+    size_t shared_prefix_len_ = 0;
     std::vector<FencePointer> fence_pointers_;
     std::string min_key_;
     std::string max_key_;
@@ -47,17 +84,20 @@ private:
     uint32_t bloom_bits_count_ = 0;
     uint32_t bloom_hash_count_ = 0;
     std::vector<uint8_t> bloom_bits_;
+    size_t memory_bytes_ = 0;
 
     static constexpr uint32_t kFenceStride = 64;
     static constexpr uint32_t kBloomBitsPerKey = 10;
     static constexpr uint32_t kBloomMinBits = 1024;
 
-    static bool hasChecksummedHeader(std::ifstream& in);
+    static int readFormatVersion(std::ifstream& in);
     static uint32_t hashKeyWithSeed(std::string_view key, uint32_t seed);
 
     void rebuildReadPathStructures();
+    void buildKeyPrefixes();
     void buildFencePointers();
     void buildBloomFilter();
+    void computeMemoryUsage();
     void bloomInsert(std::string_view key);
     bool bloomMayContain(std::string_view key) const;
 
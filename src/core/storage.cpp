@@ -1,31 +1,408 @@
 #include "storage.hpp"
 #include "sstable.hpp"
+#include "key_prefix.hpp"
 #include <chrono>
 #include <algorithm>
+#include <charconv>
+#include <cmath>
 #include <cstring>
 #include <filesystem>
 #include <limits>
+#include <tuple>
+#include <utility>
 
 namespace titan {
 
-Storage::Storage() {
+namespace {
+
+constexpr size_t kEvictionPoolSize = 16;
+constexpr size_t kEvictionRounds = 16;
+// New keys start above zero so they are not the first LFU victims.
+constexpr uint8_t kLfuInitialCounter = 5;
+
+// Approximate resident cost of one memtable entry: tree node, key and value
+// objects, out-of-line key/value bytes and its eviction slot. Pool rounding
+// is not modelled.
+size_t entryFootprint(const std::pmr::string& key, const ValueEntry& entry) {
+    size_t bytes = kTreeNodeOverhead + sizeof(std::pmr::string) + sizeof(ValueEntry)
+        + sizeof(MemTable::iterator) + stringHeapBytes(key);
+    if (entry.compressed_value.size() > CompactBytes::kInlineBytes) {
+        bytes += entry.compressed_value.size();
+    }
+    return bytes;
+}
+
+size_t tombstoneFootprint(const std::string& key) {
+    return kTreeNodeOverhead + sizeof(std::string) + sizeof(uint64_t) + stringHeapBytes(key);
+}
+
+size_t expiryRefFootprint(const std::string& key) {
+    return sizeof(std::pair<int64_t, std::string>) + stringHeapBytes(key);
+}
+
+// Hash node (next link, cached hash), key object and the list's own chunks.
+size_t listFootprint(const std::string& key, const QuickList& list) {
+    return 2 * sizeof(void*) + sizeof(std::string) + stringHeapBytes(key) + list.memoryUsage();
+}
+
+size_t zsetFootprint(const std::string& key, const SortedSet& zset) {
+    return 2 * sizeof(void*) + sizeof(std::string) + stringHeapBytes(key) + zset.memoryUsage();
+}
+
+template <bool kHasValues>
+size_t dictFootprint(const std::string& key, const Dict<kHasValues>& dict) {
+    return 2 * sizeof(void*) + sizeof(std::string) + stringHeapBytes(key) + dict.memoryUsage();
+}
+
+// Negative indexes count from the tail, as in Redis.
+std::optional<size_t> resolveListIndex(int64_t index, size_t length) {
+    if (index < 0) index += static_cast<int64_t>(length);
+    if (index < 0 || static_cast<size_t>(index) >= length) return std::nullopt;
+    return static_cast<size_t>(index);
+}
+
+int64_t addCounter(int64_t current, int64_t delta) {
+    constexpr int64_t kMax = std::numeric_limits<int64_t>::max();
+    constexpr int64_t kMin = std::numeric_limits<int64_t>::min();
+    if ((delta > 0 && current > kMax - delta) || (delta < 0 && current < kMin - delta)) {
+        throw std::runtime_error("increment would overflow");
+    }
+    return current + delta;
+}
+
+// Keeps the expiry heap ordered soonest-first.
+bool expiresLater(const std::pair<int64_t, std::string>& a, const std::pair<int64_t, std::string>& b) {
+    return a.first > b.first;
+}
+
+} // namespace
+
+Storage::Storage()
+    : arena_(std::make_unique<std::pmr::unsynchronized_pool_resource>()),
+      store_(arena_.get()),
+      pins_(std::make_shared<SnapshotPins>()) {
     compressor_ = std::make_unique<Compressor>();
 }
 
 int64_t Storage::now() const {
-    using namespace std::chrono;
-    return duration_cast<milliseconds>(steady_clock::now().time_since_epoch()).count();
+    return steadyClockMs();
 }
 
 bool Storage::isExpired(const ValueEntry& entry) const {
     if (entry.expires_at == 0) return false;
-    return now() >= entry.expires_at;
+    return wallClockMs() >= entry.expires_at;
+}
+
+uint8_t Storage::decayedLfuCounter(const ValueEntry& entry, int64_t ts) const {
+    if (eviction_.lfu_decay_minutes == 0) return entry.lfu_counter;
+
+    const int64_t idle_minutes = (ts - entry.last_access) / 60000;
+    const int64_t periods = idle_minutes / eviction_.lfu_decay_minutes;
+    return periods >= entry.lfu_counter ? 0 : static_cast<uint8_t>(entry.lfu_counter - periods);
+}
+
+// Morris-style logarithmic counter: the higher it is, the less likely a hit
+// increments it, so 8 bits cover millions of accesses.
+void Storage::touchUnlocked(ValueEntry& entry, int64_t ts) {
+    uint8_t counter = decayedLfuCounter(entry, ts);
+    if (counter < UINT8_MAX) {
+        const double base = counter > kLfuInitialCounter ? counter - kLfuInitialCounter : 0;
+        const double p = 1.0 / (base * eviction_.lfu_log_factor + 1.0);
+        if (std::uniform_real_distribution<double>(0.0, 1.0)(eviction_rng_) < p) counter++;
+    }
+    entry.lfu_counter = counter;
+    entry.last_access = ts;
+    entry.access_seq = ++access_clock_;
+}
+
+// Higher means a better victim.
+uint64_t Storage::evictionScore(const ValueEntry& entry, int64_t ts) const {
+    if (isExpired(entry)) return UINT64_MAX;
+
+    // Accesses since the entry was last touched; wraps after 2^32 accesses.
+    const uint64_t age = static_cast<uint32_t>(access_clock_ - entry.access_seq);
+
+    switch (eviction_.policy) {
+        case EvictionPolicy::AllKeysLfu:
+            // Counter first, recency as the tie-break within a counter value.
+            return (static_cast<uint64_t>(UINT8_MAX - decayedLfuCounter(entry, ts)) << 32) | age;
+        case EvictionPolicy::VolatileTtl:
+            return UINT64_MAX - 1 - static_cast<uint64_t>(entry.expires_at);
+        default:
+            return age;
+    }
+}
+
+void Storage::setCompressionPolicies(std::vector<std::pair<std::string, CompressionSpec>> policies) {
+    std::unique_lock lock(mutex_);
+    std::stable_sort(policies.begin(), policies.end(), [](const auto& a, const auto& b) {
+        return a.first.size() > b.first.size();
+    });
+    compression_policies_ = std::move(policies);
+}
+
+void Storage::upsertUnlocked(const std::string& key, std::span<const uint8_t> compressed, size_t raw_size,
+    int64_t expires_at, int64_t ts) {
+    preserveUnlocked(key);
+    auto it = store_.find(key);
+    if (it != store_.end()) {
+        raw_bytes_ -= it->second.raw_size;
+        compressed_bytes_ -= it->second.compressed_value.size();
+        memtable_bytes_ -= entryFootprint(it->first, it->second);
+        if (it->second.expires_at != 0) volatile_count_--;
+    } else {
+        it = store_.emplace_hint(it, std::piecewise_construct, std::forward_as_tuple(key), std::forward_as_tuple());
+        it->second.slot = static_cast<uint32_t>(slots_.size());
+        slots_.push_back(it);
+    }
+
+    ValueEntry& entry = it->second;
+    if (entry.last_access == 0) {
+        entry.lfu_counter = kLfuInitialCounter;
+        entry.last_access = ts;
+    }
+    touchUnlocked(entry, ts);
+    entry.compressed_value.assign(compressed);
+    entry.raw_size = static_cast<uint32_t>(raw_size);
+    entry.expires_at = expires_at;
+    entry.cold = false;
+    entry.version = ++write_seq_;
+
+    raw_bytes_ += raw_size;
+    compressed_bytes_ += compressed.size();
+    memtable_bytes_ += entryFootprint(it->first, entry);
+    if (expires_at != 0) {
+        volatile_count_++;
+        scheduleExpiryUnlocked(it->first, expires_at);
+    }
+}
+
+void Storage::scheduleExpiryUnlocked(const std::pmr::string& key, int64_t expires_at) {
+    expiry_heap_.emplace_back(expires_at, std::string(key));
+    expiry_heap_bytes_ += expiryRefFootprint(expiry_heap_.back().second);
+    std::push_heap(expiry_heap_.begin(), expiry_heap_.end(), expiresLater);
+
+    if (expiry_heap_.size() > 1024 && expiry_heap_.size() > 2 * volatile_count_) {
+        rebuildExpiryHeapUnlocked();
+    }
+}
+
+void Storage::rebuildExpiryHeapUnlocked() {
+    expiry_heap_.clear();
+    expiry_heap_.shrink_to_fit();
+    expiry_heap_bytes_ = 0;
+    expiry_heap_.reserve(volatile_count_);
+
+    for (const auto& [key, entry] : store_) {
+        if (entry.expires_at == 0) continue;
+        expiry_heap_.emplace_back(entry.expires_at, std::string(key));
+        expiry_heap_bytes_ += expiryRefFootprint(expiry_heap_.back().second);
+    }
+    std::make_heap(expiry_heap_.begin(), expiry_heap_.end(), expiresLater);
+}
+
+// Removes an entry whose TTL has passed. An older, unexpired version may
+// still sit in an SSTable, so it is masked like a delete.
+void Storage::dropExpiredEntryUnlocked(MemTable::iterator it) {
+    markDeletedUnlocked(std::string(it->first));
+    eraseEntryUnlocked(it);
+}
+
+size_t Storage::purgeExpiredUnlocked(size_t max_keys, bool record) {
+    const int64_t ts = wallClockMs();
+    size_t removed = 0;
+    // Stale heap entries cost a pop each; cap them so a slice stays bounded.
+    size_t budget = max_keys > SIZE_MAX / 4 ? SIZE_MAX : max_keys * 4;
+
+    while (!expiry_heap_.empty() && removed < max_keys && budget-- > 0) {
+        if (expiry_heap_.front().first > ts) break;
+
+        std::pop_heap(expiry_heap_.begin(), expiry_heap_.end(), expiresLater);
+        ExpiryRef ref = std::move(expiry_heap_.back());
+        expiry_heap_.pop_back();
+        expiry_heap_bytes_ -= expiryRefFootprint(ref.second);
+
+        auto it = store_.find(ref.second);
+        if (it == store_.end() || it->second.expires_at != ref.first) continue;
+
+        dropExpiredEntryUnlocked(it);
+        removed++;
+        if (record) reclaimed_keys_.push_back({std::move(ref.second), false});
+    }
+
+    return removed;
+}
+
+size_t Storage::purgeExpired(size_t max_keys) {
+    std::unique_lock lock(mutex_);
+    return purgeExpiredUnlocked(max_keys, record_reclaimed_keys_);
+}
+
+// Returns the entry's frames so the caller can log the new expiry, or
+// nullopt when the key does not exist. expires_at == 0 removes the expiry
+// and, like Redis PERSIST, is a no-op returning nullopt on a key without one.
+std::optional<std::vector<uint8_t>> Storage::setExpiry(const std::string& key, int64_t expires_at) {
+    std::unique_lock lock(mutex_);
+    if (deleted_keys_.find(key) != deleted_keys_.end()) return std::nullopt;
+
+    auto it = store_.find(key);
+    if (it != store_.end()) {
+        if (isExpired(it->second)) {
+            dropExpiredEntryUnlocked(it);
+            return std::nullopt;
+        }
+
+        if (expires_at == 0 && it->second.expires_at == 0) return std::nullopt;
+
+        preserveUnlocked(key);
+        ValueEntry& entry = it->second;
+        if (entry.expires_at != 0) volatile_count_--;
+        entry.expires_at = expires_at;
+        entry.version = ++write_seq_;
+        if (expires_at != 0) {
+            volatile_count_++;
+            scheduleExpiryUnlocked(it->first, expires_at);
+        }
+        return std::vector<uint8_t>(entry.compressed_value.begin(), entry.compressed_value.end());
+    }
+
+    auto sst_entry = findInSSTablesUnlocked(key);
+    if (!sst_entry.has_value() || isExpired(*sst_entry)) return std::nullopt;
+    if (expires_at == 0 && sst_entry->expires_at == 0) return std::nullopt;
+
+    // Pull the value into the memtable so the new expiry shadows the SSTable.
+    std::vector<uint8_t> frames(sst_entry->compressed_value.begin(), sst_entry->compressed_value.end());
+    upsertUnlocked(key, frames, sst_entry->raw_size, expires_at, now());
+    enforceMemoryLimitUnlocked();
+    return frames;
+}
+
+std::optional<int64_t> Storage::ttl(const std::string& key) {
+    std::shared_lock lock(mutex_);
+    if (deleted_keys_.find(key) != deleted_keys_.end()) return std::nullopt;
+
+    auto it = store_.find(key);
+    std::optional<ValueEntry> sst_entry;
+    const ValueEntry* entry = nullptr;
+    if (it != store_.end()) {
+        entry = &it->second;
+    } else {
+        sst_entry = findInSSTablesUnlocked(key);
+        if (sst_entry.has_value()) entry = &*sst_entry;
+    }
+
+    if (!entry || isExpired(*entry)) return std::nullopt;
+    if (entry->expires_at == 0) return -1;
+    return entry->expires_at - wallClockMs();
+}
+
+void Storage::eraseEntryUnlocked(MemTable::iterator it) {
+    preserveUnlocked(it->first);
+    ValueEntry& entry = it->second;
+    raw_bytes_ -= entry.raw_size;
+    compressed_bytes_ -= entry.compressed_value.size();
+    memtable_bytes_ -= entryFootprint(it->first, entry);
+    if (entry.expires_at != 0) volatile_count_--;
+
+    // Swap-remove keeps slots_ dense so sampling stays O(1).
+    MemTable::iterator last = slots_.back();
+    slots_[entry.slot] = last;
+    last->second.slot = entry.slot;
+    slots_.pop_back();
+
+    store_.erase(it);
+}
+
+void Storage::addTombstoneUnlocked(const std::string& key) {
+    preserveUnlocked(key);
+    if (deleted_keys_.insert_or_assign(key, ++write_seq_).second) {
+        tombstone_bytes_ += tombstoneFootprint(key);
+    }
+}
+
+// Without SSTables nothing older can resurface, so a tombstone would only
+// cost memory that eviction can never reclaim. It would also have carried
+// the key's next version; renewing base_version_ instead keeps a version
+// read before the removal from matching again.
+void Storage::markDeletedUnlocked(const std::string& key) {
+    if (!sstables_.empty()) {
+        addTombstoneUnlocked(key);
+        return;
+    }
+    base_version_ = ++write_seq_;
+}
+
+void Storage::dropTombstoneUnlocked(const std::string& key) {
+    auto it = deleted_keys_.find(key);
+    if (it == deleted_keys_.end()) return;
+
+    preserveUnlocked(key);
+    tombstone_bytes_ -= tombstoneFootprint(key);
+    deleted_keys_.erase(it);
+}
+
+// Drops every memtable node and hands the arena's blocks back upstream in one
+// go instead of freeing entries one by one.
+void Storage::resetMemTableUnlocked() {
+    store_.clear();
+    slots_.clear();
+    eviction_pool_.clear();
+    expiry_heap_.clear();
+    expiry_heap_bytes_ = 0;
+    arena_->release();
+    raw_bytes_ = 0;
+    compressed_bytes_ = 0;
+    memtable_bytes_ = 0;
+    volatile_count_ = 0;
+    // Dropped entries take their versions with them.
+    base_version_ = ++write_seq_;
+}
+
+void Storage::refreshSSTableIndexBytesUnlocked() {
+    sstable_index_bytes_ = 0;
+    for (const auto& table : sstables_) {
+        sstable_index_bytes_ += table->memoryUsage();
+    }
+}
+
+size_t Storage::memoryUsageUnlocked() const {
+    return memtable_bytes_ + slots_.capacity() * sizeof(MemTable::iterator) + expiry_heap_bytes_
+        + tombstone_bytes_ + sstable_index_bytes_ + collection_bytes_;
+}
+
+CompressionSpec Storage::compressionSpecFor(std::string_view key) const {
+    for (const auto& [prefix, spec] : compression_policies_) {
+        if (hasPrefix(key, prefix)) return spec;
+    }
+
+    CompressionSpec spec;
+    spec.level = compression_level_;
+    return spec;
 }
 
 void Storage::setMaxMemoryBytes(size_t limit_bytes) {
     std::unique_lock lock(mutex_);
     max_memory_bytes_ = limit_bytes;
-    maybeSpillToDiskUnlocked();
+    enforceMemoryLimitUnlocked();
+}
+
+void Storage::setEvictionConfig(const EvictionConfig& config) {
+    std::unique_lock lock(mutex_);
+    eviction_ = config;
+    if (eviction_.samples == 0) eviction_.samples = 1;
+    eviction_pool_.clear();
+    enforceMemoryLimitUnlocked();
+}
+
+void Storage::setRecordReclaimedKeys(bool enabled) {
+    std::unique_lock lock(mutex_);
+    record_reclaimed_keys_ = enabled;
+    if (!enabled) reclaimed_keys_.clear();
+}
+
+std::vector<Storage::ReclaimedKey> Storage::takeReclaimedKeys() {
+    std::unique_lock lock(mutex_);
+    return std::exchange(reclaimed_keys_, {});
 }
 
 void Storage::setSSTableBloomFilterEnabled(bool enabled) {
@@ -60,6 +437,7 @@ void Storage::loadSSTablesFromDirectory(const std::string& spill_dir, RecoveryMo
     });
 
     sstables_.clear();
+    ingested_.clear();
     spill_seq_ = 0;
 
     for (const auto& filepath : files) {
@@ -73,12 +451,14 @@ void Storage::loadSSTablesFromDirectory(const std::string& spill_dir, RecoveryMo
     }
 
     spill_seq_ = sstables_.size();
+    refreshSSTableIndexBytesUnlocked();
 }
 
 void Storage::loadSSTablesFromFiles(const std::vector<std::string>& sst_files, RecoveryMode mode) {
     std::unique_lock lock(mutex_);
 
     sstables_.clear();
+    ingested_.clear();
     spill_seq_ = 0;
 
     for (const auto& file : sst_files) {
@@ -100,6 +480,35 @@ void Storage::loadSSTablesFromFiles(const std::vector<std::string>& sst_files, R
     }
 
     spill_seq_ = sstables_.size();
+    refreshSSTableIndexBytesUnlocked();
+}
+
+std::shared_ptr<SSTable> Storage::openSSTable(const std::string& filepath) const {
+    bool bloom_enabled = true;
+    {
+        std::shared_lock lock(mutex_);
+        bloom_enabled = sstable_bloom_enabled_;
+    }
+    return std::make_shared<SSTable>(filepath, bloom_enabled);
+}
+
+void Storage::ingest(const std::vector<std::shared_ptr<SSTable>>& tables) {
+    std::unique_lock lock(mutex_);
+    for (const auto& table : tables) {
+        if (!store_.empty() || !deleted_keys_.empty()) {
+            for (size_t i = 0; i < table->size(); ++i) {
+                const std::string& key = table->keyAt(i);
+                if (auto it = store_.find(key); it != store_.end()) eraseEntryUnlocked(it);
+                dropTombstoneUnlocked(key);
+            }
+        }
+        sstables_.push_back(table);
+        ingested_.insert(table.get());
+        sstable_index_bytes_ += table->memoryUsage();
+    }
+    // Keys held only in SSTables report base_version_, and some of them
+    // just changed.
+    base_version_ = ++write_seq_;
 }
 
 void Storage::flushSpillState() {
@@ -115,69 +524,121 @@ void Storage::put(const std::string& key, const std::string& value, int64_t ttl_
     std::unique_lock lock(mutex_);
     TITAN_ASSERT(!key.empty(), "key cannot be empty");
 
-    auto compressed = compressor_->compress(value, compression_level_);
-    size_t new_raw_size = value.size();
-    size_t new_compressed_size = compressed.size();
-
-    auto it = store_.find(key);
-    if (it != store_.end()) {
-        raw_bytes_ -= it->second.raw_size;
-        compressed_bytes_ -= it->second.compressed_value.size();
-    }
-
-    raw_bytes_ += new_raw_size;
-    compressed_bytes_ += new_compressed_size;
+    auto compressed = compressor_->compress(value, compressionSpecFor(key));
 
-    int64_t expires = ttl_ms > 0 ? now() + ttl_ms : 0;
-    store_[key] = {std::move(compressed), new_raw_size, expires};
-    deleted_keys_.erase(key);
-    maybeSpillToDiskUnlocked();
+    const int64_t ts = now();
+    upsertUnlocked(key, compressed, value.size(), ttl_ms > 0 ? wallClockMs() + ttl_ms : 0, ts);
+    dropTombstoneUnlocked(key);
+    enforceMemoryLimitUnlocked();
 }
 
-void Storage::putPrecompressed(const std::string& key, std::vector<uint8_t>&& compressed_value, int64_t ttl_ms) {
+void Storage::putPrecompressed(const std::string& key, std::vector<uint8_t>&& compressed_value, int64_t expires_at) {
     std::unique_lock lock(mutex_);
 
     size_t new_raw_size = Compressor::getDecompressedSize(compressed_value);
-    size_t new_compressed_size = compressed_value.size();
-
-    auto it = store_.find(key);
-    if (it != store_.end()) {
-        raw_bytes_ -= it->second.raw_size;
-        compressed_bytes_ -= it->second.compressed_value.size();
-    }
 
-    raw_bytes_ += new_raw_size;
-    compressed_bytes_ += new_compressed_size;
-
-    int64_t expires = ttl_ms > 0 ? now() + ttl_ms : 0;
-    store_[key] = {std::move(compressed_value), new_raw_size, expires};
-    deleted_keys_.erase(key);
-    maybeSpillToDiskUnlocked();
+    const int64_t ts = now();
+    upsertUnlocked(key, compressed_value, new_raw_size, expires_at, ts);
+    dropTombstoneUnlocked(key);
+    enforceMemoryLimitUnlocked();
 }
 
 void Storage::putPrecompressedBatch(std::vector<std::pair<std::string, std::vector<uint8_t>>>&& batch, size_t total_raw_size) {
     std::unique_lock lock(mutex_);
     (void)total_raw_size;
 
+    const int64_t ts = now();
     for (auto& [key, compressed] : batch) {
         TITAN_ASSERT(!key.empty(), "key cannot be empty");
 
         size_t entry_raw = Compressor::getDecompressedSize(compressed);
-        size_t entry_comp = compressed.size();
+        upsertUnlocked(key, compressed, entry_raw, 0, ts);
+        dropTombstoneUnlocked(key);
+    }
 
-        auto it = store_.find(key);
-        if (it != store_.end()) {
-            raw_bytes_ -= it->second.raw_size;
-            compressed_bytes_ -= it->second.compressed_value.size();
+    enforceMemoryLimitUnlocked();
+}
+
+bool Storage::applyBatch(std::vector<BatchWrite>& writes,
+    const std::vector<std::pair<std::string, uint64_t>>& watches,
+    const std::function<void(const std::vector<BatchWrite>&)>& log) {
+    std::unique_lock lock(mutex_);
+
+    for (const auto& [key, version] : watches) {
+        if (versionUnlocked(key) != version) return false;
+    }
+
+    // The value each key will hold after the writes resolved so far.
+    struct Staged {
+        bool live = false;
+        std::span<const uint8_t> frames;
+        int64_t expires_at = 0;
+    };
+    std::unordered_map<std::string_view, Staged> staged;
+
+    for (auto& write : writes) {
+        TITAN_ASSERT(!write.key.empty(), "key cannot be empty");
+        if (write.kind == BatchWrite::Kind::Put) {
+            staged[write.key] = Staged{true, write.frames, write.expires_at};
+            continue;
+        }
+        if (write.kind == BatchWrite::Kind::Del) {
+            staged[write.key] = Staged{};
+            continue;
+        }
+
+        std::optional<int64_t> current = 0;
+        int64_t expires_at = 0;
+        if (auto it = staged.find(write.key); it != staged.end()) {
+            if (it->second.live) {
+                current = parseIntegerUnlocked(it->second.frames);
+                expires_at = it->second.expires_at;
+            }
+        } else if (deleted_keys_.find(write.key) == deleted_keys_.end()) {
+            if (auto entry = store_.find(write.key); entry != store_.end()) {
+                if (!isExpired(entry->second)) {
+                    current = parseIntegerUnlocked(entry->second.compressed_value);
+                    expires_at = entry->second.expires_at;
+                }
+            } else if (auto sst_entry = findInSSTablesUnlocked(write.key); sst_entry && !isExpired(*sst_entry)) {
+                current = parseIntegerUnlocked(sst_entry->compressed_value);
+                expires_at = sst_entry->expires_at;
+            }
+        }
+
+        // A failing counter is reported in its slot, as for a failing
+        // command in Redis EXEC; the rest of the batch still applies.
+        if (!current.has_value()) {
+            write.error = "value is not an integer or out of range";
+            continue;
         }
+        try {
+            write.result = addCounter(*current, write.delta);
+        } catch (const std::runtime_error& e) {
+            write.error = e.what();
+            continue;
+        }
+        write.expires_at = expires_at;
+        const auto frame = Compressor::encodeInteger(write.result);
+        write.frames.assign(frame.begin(), frame.end());
+        staged[write.key] = Staged{true, write.frames, write.expires_at};
+    }
 
-        raw_bytes_ += entry_raw;
-        compressed_bytes_ += entry_comp;
-        store_[key] = {std::move(compressed), entry_raw};
-        deleted_keys_.erase(key);
+    const int64_t ts = now();
+    for (auto& write : writes) {
+        if (!write.error.empty()) continue;
+        if (write.kind == BatchWrite::Kind::Del) {
+            write.result = delUnlocked(write.key) ? 1 : 0;
+            write.dropped_collections = dropCollectionsUnlocked(write.key);
+            continue;
+        }
+        upsertUnlocked(write.key, write.frames, Compressor::getDecompressedSize(write.frames), write.expires_at, ts);
+        dropTombstoneUnlocked(write.key);
     }
 
-    maybeSpillToDiskUnlocked();
+    if (log) log(writes);
+    enforceMemoryLimitUnlocked();
+    return true;
 }
 
 void Storage::spillToDisk(const std::string& filepath) {
@@ -195,22 +656,114 @@ void Storage::spillToDiskUnlocked(const std::string& filepath) {
         std::filesystem::create_directories(parent);
     }
 
+    // Expired entries would otherwise be carried into the table.
+    purgeExpiredUnlocked(SIZE_MAX, record_reclaimed_keys_);
+    if (store_.empty()) return;
+
     SSTable::build(filepath, store_);
     sstables_.push_back(std::make_shared<SSTable>(filepath, sstable_bloom_enabled_));
+    sstable_index_bytes_ += sstables_.back()->memoryUsage();
 
-    store_.clear();
-    raw_bytes_ = 0;
-    compressed_bytes_ = 0;
+    // Pinned snapshots do not see the new table.
+    preserveMemTableUnlocked();
+    resetMemTableUnlocked();
 }
 
-void Storage::maybeSpillToDiskUnlocked() {
+void Storage::enforceMemoryLimitUnlocked() {
     if (max_memory_bytes_ == 0) return;
-    if (raw_bytes_ <= max_memory_bytes_) return;
+
+    if (eviction_.policy == EvictionPolicy::Spill) {
+        maybeSpillToDiskUnlocked();
+    } else {
+        evictUntilWithinLimitUnlocked();
+    }
+}
+
+// Spilling only relieves the memtable, so only the memtable is held to the
+// budget; tombstones and SSTable indexes are reported but not enforced here.
+void Storage::maybeSpillToDiskUnlocked() {
+    if (memtable_bytes_ <= max_memory_bytes_) return;
     if (spill_dir_.empty()) return;
 
     spillToDiskUnlocked(nextSpillFilePathUnlocked());
 }
 
+// Eviction only samples plain values, so native collections are reported
+// but not held to the budget: one large list would otherwise evict every
+// other key and still leave the budget exceeded.
+void Storage::evictUntilWithinLimitUnlocked() {
+    while (!slots_.empty() && memoryUsageUnlocked() - collection_bytes_ > max_memory_bytes_) {
+        if (!evictOneUnlocked()) break;
+    }
+}
+
+// Samples a few entries and merges them into the candidate pool, keeping
+// the kEvictionPoolSize highest scores (Redis evictionPoolPopulate).
+void Storage::populateEvictionPoolUnlocked(int64_t ts) {
+    std::uniform_int_distribution<size_t> pick(0, slots_.size() - 1);
+
+    for (size_t i = 0; i < eviction_.samples; ++i) {
+        auto it = slots_[pick(eviction_rng_)];
+        const ValueEntry& entry = it->second;
+        if (eviction_.policy == EvictionPolicy::VolatileTtl && entry.expires_at == 0) continue;
+
+        const uint64_t score = evictionScore(entry, ts);
+        if (eviction_pool_.size() >= kEvictionPoolSize && score <= eviction_pool_.front().score) continue;
+
+        const std::string_view key(it->first);
+        const bool pooled = std::any_of(eviction_pool_.begin(), eviction_pool_.end(),
+            [&](const EvictionCandidate& c) { return c.key == key; });
+        if (pooled) continue;
+
+        auto pos = std::upper_bound(eviction_pool_.begin(), eviction_pool_.end(), score,
+            [](uint64_t value, const EvictionCandidate& c) { return value < c.score; });
+        eviction_pool_.insert(pos, EvictionCandidate{score, std::string(key)});
+        if (eviction_pool_.size() > kEvictionPoolSize) eviction_pool_.erase(eviction_pool_.begin());
+    }
+}
+
+// Evicts the best pooled candidate that still exists. Returns false when no
+// candidate turns up, e.g. VolatileTtl with no TTL keys left.
+bool Storage::evictOneUnlocked() {
+    if (eviction_.policy == EvictionPolicy::VolatileTtl && volatile_count_ == 0) return false;
+
+    const int64_t ts = now();
+    for (size_t round = 0; round < kEvictionRounds; ++round) {
+        populateEvictionPoolUnlocked(ts);
+
+        while (!eviction_pool_.empty()) {
+            std::string key = std::move(eviction_pool_.back().key);
+            eviction_pool_.pop_back();
+
+            auto it = store_.find(key);
+            if (it == store_.end()) continue;
+            if (eviction_.policy == EvictionPolicy::VolatileTtl && it->second.expires_at == 0) continue;
+
+            // Pooled scores go stale when a key is touched again; requeue it
+            // if it is no longer the best candidate.
+            const uint64_t score = evictionScore(it->second, ts);
+            if (!eviction_pool_.empty() && score < eviction_pool_.back().score) {
+                auto pos = std::upper_bound(eviction_pool_.begin(), eviction_pool_.end(), score,
+                    [](uint64_t value, const EvictionCandidate& c) { return value < c.score; });
+                eviction_pool_.insert(pos, EvictionCandidate{score, std::move(key)});
+                continue;
+            }
+
+            const size_t freed = entryFootprint(it->first, it->second);
+            // An older version may still sit in an SSTable; mask it like a delete.
+            markDeletedUnlocked(key);
+            eraseEntryUnlocked(it);
+
+            evicted_total_++;
+            evicted_bytes_total_ += freed;
+            if (record_reclaimed_keys_) reclaimed_keys_.push_back({std::move(key), true});
+            return true;
+        }
+    }
+
+    return false;
+}
+
 std::string Storage::nextSpillFilePathUnlocked() {
     if (spill_dir_.empty()) return "";
 
@@ -264,7 +817,8 @@ std::map<std::string, std::string> Storage::materializeVisibleUnlocked() const {
         }
     }
 
-    for (const auto& [key, entry] : store_) {
+    for (const auto& [pooled_key, entry] : store_) {
+        const std::string key(pooled_key);
         if (deleted_keys_.find(key) != deleted_keys_.end()) continue;
         if (isExpired(entry)) {
             merged.erase(key);
@@ -273,67 +827,241 @@ std::map<std::string, std::string> Storage::materializeVisibleUnlocked() const {
         merged[key] = compressor_->decompress(entry.compressed_value);
     }
 
-    for (const auto& key : deleted_keys_) {
-        merged.erase(key);
+    for (const auto& tombstone : deleted_keys_) {
+        merged.erase(tombstone.first);
     }
 
     return merged;
 }
 
-std::optional<std::string> Storage::get(const std::string& key) {
-    std::unique_lock lock(mutex_);
+std::optional<int64_t> Storage::parseIntegerUnlocked(std::span<const uint8_t> frames) const {
+    if (auto value = Compressor::decodeInteger(frames)) return value;
+    return Compressor::parseCanonicalInteger(compressor_->decompress(frames));
+}
 
-    if (deleted_keys_.find(key) != deleted_keys_.end()) return std::nullopt;
+std::optional<Storage::IncrResult> Storage::incrBy(const std::string& key, int64_t delta,
+                                                   const std::function<void(const IncrResult&)>& log) {
+    std::unique_lock lock(mutex_);
+    TITAN_ASSERT(!key.empty(), "key cannot be empty");
 
     auto it = store_.find(key);
+    if (it != store_.end() && isExpired(it->second)) {
+        dropExpiredEntryUnlocked(it);
+        it = store_.end();
+    }
+
+    IncrResult result;
+    int64_t current = 0;
     if (it != store_.end()) {
-        if (isExpired(it->second)) {
-            raw_bytes_ -= it->second.raw_size;
-            compressed_bytes_ -= it->second.compressed_value.size();
-            store_.erase(it);
-            return std::nullopt;
+        const auto value = parseIntegerUnlocked(it->second.compressed_value);
+        if (!value.has_value()) return std::nullopt;
+        current = *value;
+        result.expires_at = it->second.expires_at;
+    } else if (deleted_keys_.find(key) == deleted_keys_.end()) {
+        auto sst_entry = findInSSTablesUnlocked(key);
+        if (sst_entry.has_value() && !isExpired(*sst_entry)) {
+            const auto value = parseIntegerUnlocked(sst_entry->compressed_value);
+            if (!value.has_value()) return std::nullopt;
+            current = *value;
+            result.expires_at = sst_entry->expires_at;
         }
+    }
 
-        return compressor_->decompress(it->second.compressed_value);
+    result.value = addCounter(current, delta);
+
+    const auto frame = Compressor::encodeInteger(result.value);
+    const size_t raw_size = Compressor::getDecompressedSize(frame);
+    result.raw_size = raw_size;
+    const int64_t ts = now();
+
+    if (it != store_.end()) {
+        // Rewrite the entry in place; its expiry is already scheduled.
+        preserveUnlocked(key);
+        ValueEntry& entry = it->second;
+        raw_bytes_ -= entry.raw_size;
+        compressed_bytes_ -= entry.compressed_value.size();
+        memtable_bytes_ -= entryFootprint(it->first, entry);
+        touchUnlocked(entry, ts);
+        entry.compressed_value.assign(frame);
+        entry.raw_size = static_cast<uint32_t>(raw_size);
+        entry.cold = false;
+        entry.version = ++write_seq_;
+        raw_bytes_ += raw_size;
+        compressed_bytes_ += frame.size();
+        memtable_bytes_ += entryFootprint(it->first, entry);
+        if (log) log(result);
+        return result;
     }
 
-    auto sst_entry = findInSSTablesUnlocked(key);
-    if (!sst_entry.has_value()) return std::nullopt;
-    if (isExpired(*sst_entry)) return std::nullopt;
+    upsertUnlocked(key, frame, raw_size, result.expires_at, ts);
+    dropTombstoneUnlocked(key);
+    if (log) log(result);
+    enforceMemoryLimitUnlocked();
+    return result;
+}
 
-    return compressor_->decompress(sst_entry->compressed_value);
+uint64_t Storage::versionUnlocked(const std::string& key) const {
+    if (auto tombstone = deleted_keys_.find(key); tombstone != deleted_keys_.end()) return tombstone->second;
+    auto it = store_.find(key);
+    if (it != store_.end() && !isExpired(it->second)) return it->second.version;
+    return base_version_;
 }
 
-std::vector<std::optional<std::string>> Storage::getBatch(const std::vector<std::string>& keys) {
-    std::unique_lock lock(mutex_);
-    std::vector<std::optional<std::string>> results;
-    results.reserve(keys.size());
+bool Storage::liveUnlocked(const std::string& key) const {
+    if (deleted_keys_.find(key) != deleted_keys_.end()) return false;
+    auto it = store_.find(key);
+    if (it != store_.end()) return !isExpired(it->second);
+    auto sst_entry = findInSSTablesUnlocked(key);
+    return sst_entry.has_value() && !isExpired(*sst_entry);
+}
 
-    for (const auto& k : keys) {
-        if (deleted_keys_.find(k) != deleted_keys_.end()) {
-            results.push_back(std::nullopt);
-            continue;
-        }
+VersionedValue Storage::getWithVersion(const std::string& key) {
+    std::unique_lock lock(mutex_);
+    VersionedValue result;
 
-        auto it = store_.find(k);
+    if (deleted_keys_.find(key) == deleted_keys_.end()) {
+        auto it = store_.find(key);
         if (it != store_.end()) {
             if (isExpired(it->second)) {
-                raw_bytes_ -= it->second.raw_size;
-                compressed_bytes_ -= it->second.compressed_value.size();
-                store_.erase(it);
-                results.push_back(std::nullopt);
-                continue;
+                dropExpiredEntryUnlocked(it);
+            } else {
+                touchUnlocked(it->second, now());
+                result.value = compressor_->decompress(it->second.compressed_value);
+                result.version = it->second.version;
+                return result;
             }
-
-            results.push_back(compressor_->decompress(it->second.compressed_value));
-            continue;
+        } else if (auto sst_entry = findInSSTablesUnlocked(key); sst_entry.has_value() && !isExpired(*sst_entry)) {
+            result.value = compressor_->decompress(sst_entry->compressed_value);
         }
+    }
 
-        auto sst_entry = findInSSTablesUnlocked(k);
-        if (!sst_entry.has_value() || isExpired(*sst_entry)) {
-            results.push_back(std::nullopt);
-            continue;
-        }
+    result.version = versionUnlocked(key);
+    return result;
+}
+
+uint64_t Storage::version(const std::string& key) const {
+    std::shared_lock lock(mutex_);
+    return versionUnlocked(key);
+}
+
+std::optional<uint64_t> Storage::putIfVersion(const std::string& key, std::span<const uint8_t> compressed_value,
+    uint64_t expected_version, int64_t expires_at) {
+    std::unique_lock lock(mutex_);
+    TITAN_ASSERT(!key.empty(), "key cannot be empty");
+    if (versionUnlocked(key) != expected_version) return std::nullopt;
+
+    upsertUnlocked(key, compressed_value, Compressor::getDecompressedSize(compressed_value), expires_at, now());
+    dropTombstoneUnlocked(key);
+    enforceMemoryLimitUnlocked();
+    // A spill triggered by this write already moved the version on.
+    return versionUnlocked(key);
+}
+
+std::optional<uint64_t> Storage::putIfAbsent(const std::string& key, std::span<const uint8_t> compressed_value,
+    int64_t expires_at) {
+    std::unique_lock lock(mutex_);
+    TITAN_ASSERT(!key.empty(), "key cannot be empty");
+    if (liveUnlocked(key)) return std::nullopt;
+
+    upsertUnlocked(key, compressed_value, Compressor::getDecompressedSize(compressed_value), expires_at, now());
+    dropTombstoneUnlocked(key);
+    enforceMemoryLimitUnlocked();
+    return versionUnlocked(key);
+}
+
+std::optional<std::string> Storage::get(const std::string& key) {
+    std::unique_lock lock(mutex_);
+
+    if (deleted_keys_.find(key) != deleted_keys_.end()) return std::nullopt;
+
+    auto it = store_.find(key);
+    if (it != store_.end()) {
+        if (isExpired(it->second)) {
+            dropExpiredEntryUnlocked(it);
+            return std::nullopt;
+        }
+
+        touchUnlocked(it->second, now());
+        return compressor_->decompress(it->second.compressed_value);
+    }
+
+    auto sst_entry = findInSSTablesUnlocked(key);
+    if (!sst_entry.has_value()) return std::nullopt;
+    if (isExpired(*sst_entry)) return std::nullopt;
+
+    return compressor_->decompress(sst_entry->compressed_value);
+}
+
+std::optional<std::string> Storage::getRange(const std::string& key, size_t offset, size_t length) {
+    std::unique_lock lock(mutex_);
+
+    if (deleted_keys_.find(key) != deleted_keys_.end()) return std::nullopt;
+
+    auto it = store_.find(key);
+    if (it != store_.end()) {
+        if (isExpired(it->second)) {
+            dropExpiredEntryUnlocked(it);
+            return std::nullopt;
+        }
+
+        touchUnlocked(it->second, now());
+        return compressor_->decompressRange(it->second.compressed_value, offset, length);
+    }
+
+    auto sst_entry = findInSSTablesUnlocked(key);
+    if (!sst_entry.has_value()) return std::nullopt;
+    if (isExpired(*sst_entry)) return std::nullopt;
+
+    return compressor_->decompressRange(sst_entry->compressed_value, offset, length);
+}
+
+std::optional<size_t> Storage::valueLength(const std::string& key) {
+    std::shared_lock lock(mutex_);
+
+    if (deleted_keys_.find(key) != deleted_keys_.end()) return std::nullopt;
+
+    auto it = store_.find(key);
+    if (it != store_.end()) {
+        if (isExpired(it->second)) return std::nullopt;
+        return it->second.raw_size;
+    }
+
+    auto sst_entry = findInSSTablesUnlocked(key);
+    if (!sst_entry.has_value() || isExpired(*sst_entry)) return std::nullopt;
+
+    return sst_entry->raw_size;
+}
+
+std::vector<std::optional<std::string>> Storage::getBatch(const std::vector<std::string>& keys) {
+    std::unique_lock lock(mutex_);
+    std::vector<std::optional<std::string>> results;
+    results.reserve(keys.size());
+    const int64_t ts = now();
+
+    for (const auto& k : keys) {
+        if (deleted_keys_.find(k) != deleted_keys_.end()) {
+            results.push_back(std::nullopt);
+            continue;
+        }
+
+        auto it = store_.find(k);
+        if (it != store_.end()) {
+            if (isExpired(it->second)) {
+                dropExpiredEntryUnlocked(it);
+                results.push_back(std::nullopt);
+                continue;
+            }
+
+            touchUnlocked(it->second, ts);
+            results.push_back(compressor_->decompress(it->second.compressed_value));
+            continue;
+        }
+
+        auto sst_entry = findInSSTablesUnlocked(k);
+        if (!sst_entry.has_value() || isExpired(*sst_entry)) {
+            results.push_back(std::nullopt);
+            continue;
+        }
 
         results.push_back(compressor_->decompress(sst_entry->compressed_value));
     }
@@ -343,13 +1071,15 @@ std::vector<std::optional<std::string>> Storage::getBatch(const std::vector<std:
 
 bool Storage::del(const std::string& key) {
     std::unique_lock lock(mutex_);
+    return delUnlocked(key);
+}
+
+bool Storage::delUnlocked(const std::string& key) {
     bool deleted = false;
 
     auto it = store_.find(key);
     if (it != store_.end()) {
-        raw_bytes_ -= it->second.raw_size;
-        compressed_bytes_ -= it->second.compressed_value.size();
-        store_.erase(it);
+        eraseEntryUnlocked(it);
         deleted = true;
     }
 
@@ -358,12 +1088,45 @@ bool Storage::del(const std::string& key) {
     }
 
     if (deleted) {
-        deleted_keys_.insert(key);
+        markDeletedUnlocked(key);
     }
 
     return deleted;
 }
 
+bool Storage::dropCollections(const std::string& key, const std::function<void()>& log) {
+    std::unique_lock lock(mutex_);
+    const bool dropped = dropCollectionsUnlocked(key);
+    if (dropped && log) log();
+    return dropped;
+}
+
+bool Storage::dropCollectionsUnlocked(const std::string& key) {
+    bool dropped = false;
+
+    if (auto it = lists_.find(key); it != lists_.end()) {
+        collection_bytes_ -= listFootprint(it->first, it->second);
+        lists_.erase(it);
+        dropped = true;
+    }
+    if (auto it = zsets_.find(key); it != zsets_.end()) {
+        collection_bytes_ -= zsetFootprint(it->first, it->second);
+        zsets_.erase(it);
+        dropped = true;
+    }
+    if (auto it = hashes_.find(key); it != hashes_.end()) {
+        collection_bytes_ -= dictFootprint(it->first, it->second);
+        hashes_.erase(it);
+        dropped = true;
+    }
+    if (auto it = sets_.find(key); it != sets_.end()) {
+        collection_bytes_ -= dictFootprint(it->first, it->second);
+        sets_.erase(it);
+        dropped = true;
+    }
+    return dropped;
+}
+
 bool Storage::has(const std::string& key) {
     std::unique_lock lock(mutex_);
 
@@ -372,9 +1135,7 @@ bool Storage::has(const std::string& key) {
     auto it = store_.find(key);
     if (it != store_.end()) {
         if (isExpired(it->second)) {
-            raw_bytes_ -= it->second.raw_size;
-            compressed_bytes_ -= it->second.compressed_value.size();
-            store_.erase(it);
+            dropExpiredEntryUnlocked(it);
             return false;
         }
 
@@ -391,33 +1152,454 @@ bool Storage::has(const std::string& key) {
 void Storage::clear() {
     std::unique_lock lock(mutex_);
     clearSpillFilesUnlocked();
-    store_.clear();
+    resetMemTableUnlocked();
     sstables_.clear();
+    ingested_.clear();
     deleted_keys_.clear();
-    raw_bytes_ = 0;
-    compressed_bytes_ = 0;
+    // The spill files are gone, so pinned snapshots cannot be served.
+    clear_epoch_++;
+    history_.clear();
+    history_bytes_ = 0;
+    lists_.clear();
+    zsets_.clear();
+    hashes_.clear();
+    sets_.clear();
+    tombstone_bytes_ = 0;
+    sstable_index_bytes_ = 0;
+    collection_bytes_ = 0;
     spill_seq_ = 0;
 }
 
+size_t Storage::listPush(const std::string& key, const std::vector<std::string>& values, bool front,
+    const std::function<void()>& log) {
+    std::unique_lock lock(mutex_);
+    TITAN_ASSERT(!key.empty(), "key cannot be empty");
+
+    auto [it, inserted] = lists_.try_emplace(key);
+    QuickList& list = it->second;
+    if (!inserted) collection_bytes_ -= listFootprint(it->first, list);
+
+    // A batch pushed to the head keeps its argument order.
+    if (front) {
+        for (auto value = values.rbegin(); value != values.rend(); ++value) list.pushFront(*value);
+    } else {
+        for (const auto& value : values) list.pushBack(value);
+    }
+
+    const size_t length = list.size();
+    if (list.empty()) {
+        lists_.erase(it);
+    } else {
+        collection_bytes_ += listFootprint(it->first, list);
+    }
+    if (log) log();
+    enforceMemoryLimitUnlocked();
+    return length;
+}
+
+std::optional<std::string> Storage::listPop(const std::string& key, bool front, const std::function<void()>& log) {
+    std::unique_lock lock(mutex_);
+    auto it = lists_.find(key);
+    if (it == lists_.end()) return std::nullopt;
+
+    QuickList& list = it->second;
+    collection_bytes_ -= listFootprint(it->first, list);
+    auto value = front ? list.popFront() : list.popBack();
+
+    if (list.empty()) {
+        lists_.erase(it);
+    } else {
+        collection_bytes_ += listFootprint(it->first, list);
+    }
+    if (value.has_value() && log) log();
+    return value;
+}
+
+size_t Storage::listLength(const std::string& key) const {
+    std::shared_lock lock(mutex_);
+    auto it = lists_.find(key);
+    return it == lists_.end() ? 0 : it->second.size();
+}
+
+std::optional<std::string> Storage::listIndex(const std::string& key, int64_t index) const {
+    std::shared_lock lock(mutex_);
+    auto it = lists_.find(key);
+    if (it == lists_.end()) return std::nullopt;
+
+    const auto position = resolveListIndex(index, it->second.size());
+    if (!position.has_value()) return std::nullopt;
+    return it->second.at(*position);
+}
+
+std::optional<size_t> Storage::listSet(const std::string& key, int64_t index, const std::string& value,
+    const std::function<void(size_t)>& log) {
+    std::unique_lock lock(mutex_);
+    auto it = lists_.find(key);
+    if (it == lists_.end()) return std::nullopt;
+
+    const auto position = resolveListIndex(index, it->second.size());
+    if (!position.has_value()) return std::nullopt;
+
+    collection_bytes_ -= listFootprint(it->first, it->second);
+    it->second.set(*position, value);
+    collection_bytes_ += listFootprint(it->first, it->second);
+    if (log) log(*position);
+    enforceMemoryLimitUnlocked();
+    return position;
+}
+
+std::vector<std::string> Storage::listRange(const std::string& key, int64_t start, int64_t stop) const {
+    std::shared_lock lock(mutex_);
+    auto it = lists_.find(key);
+    if (it == lists_.end()) return {};
+
+    const auto length = static_cast<int64_t>(it->second.size());
+    if (start < 0) start = std::max<int64_t>(0, start + length);
+    if (stop < 0) stop += length;
+    if (stop < 0 || start > stop || start >= length) return {};
+    return it->second.range(static_cast<size_t>(start), static_cast<size_t>(stop));
+}
+
+std::vector<std::pair<std::string, std::vector<std::vector<uint8_t>>>> Storage::listSnapshot() const {
+    std::shared_lock lock(mutex_);
+    std::vector<std::pair<std::string, std::vector<std::vector<uint8_t>>>> result;
+    result.reserve(lists_.size());
+    for (const auto& [key, list] : lists_) {
+        result.emplace_back(key, list.packedChunks());
+    }
+    return result;
+}
+
+size_t Storage::zsetAdd(const std::string& key, const std::vector<SortedSet::Member>& members,
+    const std::function<void()>& log) {
+    std::unique_lock lock(mutex_);
+    TITAN_ASSERT(!key.empty(), "key cannot be empty");
+    for (const auto& [member, score] : members) {
+        if (std::isnan(score)) throw std::runtime_error("score is not a number");
+    }
+
+    auto [it, inserted] = zsets_.try_emplace(key);
+    SortedSet& zset = it->second;
+    if (!inserted) collection_bytes_ -= zsetFootprint(it->first, zset);
+
+    size_t added = 0;
+    for (const auto& [member, score] : members) {
+        if (zset.add(member, score)) added++;
+    }
+
+    if (zset.empty()) {
+        zsets_.erase(it);
+    } else {
+        collection_bytes_ += zsetFootprint(it->first, zset);
+    }
+    if (log) log();
+    enforceMemoryLimitUnlocked();
+    return added;
+}
+
+double Storage::zsetIncrBy(const std::string& key, const std::string& member, double delta,
+                           const std::function<void(double)>& log) {
+    std::unique_lock lock(mutex_);
+    TITAN_ASSERT(!key.empty(), "key cannot be empty");
+
+    auto [it, inserted] = zsets_.try_emplace(key);
+    SortedSet& zset = it->second;
+    const double score = zset.score(member).value_or(0) + delta;
+    if (std::isnan(score)) {
+        if (inserted) zsets_.erase(it);
+        throw std::runtime_error("resulting score is not a number");
+    }
+
+    if (!inserted) collection_bytes_ -= zsetFootprint(it->first, zset);
+    zset.add(member, score);
+    collection_bytes_ += zsetFootprint(it->first, zset);
+    if (log) log(score);
+    enforceMemoryLimitUnlocked();
+    return score;
+}
+
+size_t Storage::zsetRemove(const std::string& key, const std::vector<std::string>& members,
+    const std::function<void()>& log) {
+    std::unique_lock lock(mutex_);
+    auto it = zsets_.find(key);
+    if (it == zsets_.end()) return 0;
+
+    SortedSet& zset = it->second;
+    collection_bytes_ -= zsetFootprint(it->first, zset);
+    size_t removed = 0;
+    for (const auto& member : members) {
+        if (zset.remove(member)) removed++;
+    }
+
+    if (zset.empty()) {
+        zsets_.erase(it);
+    } else {
+        collection_bytes_ += zsetFootprint(it->first, zset);
+    }
+    if (removed > 0 && log) log();
+    return removed;
+}
+
+std::optional<double> Storage::zsetScore(const std::string& key, const std::string& member) const {
+    std::shared_lock lock(mutex_);
+    auto it = zsets_.find(key);
+    if (it == zsets_.end()) return std::nullopt;
+    return it->second.score(member);
+}
+
+std::optional<size_t> Storage::zsetRank(const std::string& key, const std::string& member, bool reverse) const {
+    std::shared_lock lock(mutex_);
+    auto it = zsets_.find(key);
+    if (it == zsets_.end()) return std::nullopt;
+    return it->second.rank(member, reverse);
+}
+
+size_t Storage::zsetCard(const std::string& key) const {
+    std::shared_lock lock(mutex_);
+    auto it = zsets_.find(key);
+    return it == zsets_.end() ? 0 : it->second.size();
+}
+
+std::vector<SortedSet::Member> Storage::zsetRange(const std::string& key, int64_t start, int64_t stop, bool reverse) const {
+    std::shared_lock lock(mutex_);
+    auto it = zsets_.find(key);
+    if (it == zsets_.end()) return {};
+
+    const auto length = static_cast<int64_t>(it->second.size());
+    if (start < 0) start = std::max<int64_t>(0, start + length);
+    if (stop < 0) stop += length;
+    if (stop < 0 || start > stop || start >= length) return {};
+    return it->second.range(static_cast<size_t>(start), static_cast<size_t>(stop), reverse);
+}
+
+std::vector<SortedSet::Member> Storage::zsetRangeByScore(const std::string& key, double min, double max,
+                                                         size_t offset, size_t count, bool reverse) const {
+    std::shared_lock lock(mutex_);
+    auto it = zsets_.find(key);
+    if (it == zsets_.end()) return {};
+    return it->second.rangeByScore(min, max, offset, count, reverse);
+}
+
+size_t Storage::zsetCount(const std::string& key, double min, double max) const {
+    std::shared_lock lock(mutex_);
+    auto it = zsets_.find(key);
+    return it == zsets_.end() ? 0 : it->second.countByScore(min, max);
+}
+
+std::vector<std::pair<std::string, std::vector<SortedSet::Member>>> Storage::zsetSnapshot() const {
+    std::shared_lock lock(mutex_);
+    std::vector<std::pair<std::string, std::vector<SortedSet::Member>>> result;
+    result.reserve(zsets_.size());
+    for (const auto& [key, zset] : zsets_) {
+        result.emplace_back(key, zset.range(0, zset.size() - 1));
+    }
+    return result;
+}
+
+size_t Storage::hashSet(const std::string& key, const std::vector<FieldValue>& fields,
+    const std::function<void()>& log) {
+    std::unique_lock lock(mutex_);
+    TITAN_ASSERT(!key.empty(), "key cannot be empty");
+    if (fields.empty()) return 0;
+
+    auto [it, inserted] = hashes_.try_emplace(key);
+    if (!inserted) collection_bytes_ -= dictFootprint(it->first, it->second);
+    size_t added = 0;
+    for (const auto& [field, value] : fields) {
+        if (it->second.set(field, value)) added++;
+    }
+    collection_bytes_ += dictFootprint(it->first, it->second);
+    if (log) log();
+    enforceMemoryLimitUnlocked();
+    return added;
+}
+
+std::optional<std::string> Storage::hashGet(const std::string& key, const std::string& field) const {
+    std::shared_lock lock(mutex_);
+    auto it = hashes_.find(key);
+    if (it == hashes_.end()) return std::nullopt;
+    return it->second.get(field);
+}
+
+size_t Storage::hashDel(const std::string& key, const std::vector<std::string>& fields,
+    const std::function<void()>& log) {
+    std::unique_lock lock(mutex_);
+    auto it = hashes_.find(key);
+    if (it == hashes_.end()) return 0;
+
+    collection_bytes_ -= dictFootprint(it->first, it->second);
+    size_t removed = 0;
+    for (const auto& field : fields) {
+        if (it->second.erase(field)) removed++;
+    }
+
+    if (it->second.empty()) {
+        hashes_.erase(it);
+    } else {
+        collection_bytes_ += dictFootprint(it->first, it->second);
+    }
+    if (removed > 0 && log) log();
+    return removed;
+}
+
+size_t Storage::hashLength(const std::string& key) const {
+    std::shared_lock lock(mutex_);
+    auto it = hashes_.find(key);
+    return it == hashes_.end() ? 0 : it->second.size();
+}
+
+std::vector<Storage::FieldValue> Storage::hashGetAll(const std::string& key) const {
+    std::shared_lock lock(mutex_);
+    auto it = hashes_.find(key);
+    if (it == hashes_.end()) return {};
+    return it->second.entries();
+}
+
+std::optional<int64_t> Storage::hashIncrBy(const std::string& key, const std::string& field, int64_t delta,
+                                           const std::function<void(int64_t)>& log) {
+    std::unique_lock lock(mutex_);
+    TITAN_ASSERT(!key.empty(), "key cannot be empty");
+
+    auto [it, inserted] = hashes_.try_emplace(key);
+    int64_t current = 0;
+    if (auto existing = it->second.get(field); existing.has_value()) {
+        const char* end = existing->data() + existing->size();
+        auto [ptr, ec] = std::from_chars(existing->data(), end, current);
+        if (ec != std::errc() || ptr != end) return std::nullopt;
+    }
+
+    constexpr int64_t kMax = std::numeric_limits<int64_t>::max();
+    constexpr int64_t kMin = std::numeric_limits<int64_t>::min();
+    if ((delta > 0 && current > kMax - delta) || (delta < 0 && current < kMin - delta)) {
+        if (inserted) hashes_.erase(it);
+        throw std::runtime_error("increment would overflow");
+    }
+    const int64_t next = current + delta;
+
+    if (!inserted) collection_bytes_ -= dictFootprint(it->first, it->second);
+    it->second.set(field, std::to_string(next));
+    collection_bytes_ += dictFootprint(it->first, it->second);
+    if (log) log(next);
+    enforceMemoryLimitUnlocked();
+    return next;
+}
+
+size_t Storage::setAdd(const std::string& key, const std::vector<std::string>& members,
+    const std::function<void()>& log) {
+    std::unique_lock lock(mutex_);
+    TITAN_ASSERT(!key.empty(), "key cannot be empty");
+    if (members.empty()) return 0;
+
+    auto [it, inserted] = sets_.try_emplace(key);
+    if (!inserted) collection_bytes_ -= dictFootprint(it->first, it->second);
+    size_t added = 0;
+    for (const auto& member : members) {
+        if (it->second.set(member)) added++;
+    }
+    collection_bytes_ += dictFootprint(it->first, it->second);
+    if (added > 0 && log) log();
+    enforceMemoryLimitUnlocked();
+    return added;
+}
+
+size_t Storage::setRemove(const std::string& key, const std::vector<std::string>& members,
+    const std::function<void()>& log) {
+    std::unique_lock lock(mutex_);
+    auto it = sets_.find(key);
+    if (it == sets_.end()) return 0;
+
+    collection_bytes_ -= dictFootprint(it->first, it->second);
+    size_t removed = 0;
+    for (const auto& member : members) {
+        if (it->second.erase(member)) removed++;
+    }
+
+    if (it->second.empty()) {
+        sets_.erase(it);
+    } else {
+        collection_bytes_ += dictFootprint(it->first, it->second);
+    }
+    if (removed > 0 && log) log();
+    return removed;
+}
+
+bool Storage::setIsMember(const std::string& key, const std::string& member) const {
+    std::shared_lock lock(mutex_);
+    auto it = sets_.find(key);
+    return it != sets_.end() && it->second.contains(member);
+}
+
+size_t Storage::setCard(const std::string& key) const {
+    std::shared_lock lock(mutex_);
+    auto it = sets_.find(key);
+    return it == sets_.end() ? 0 : it->second.size();
+}
+
+std::vector<std::string> Storage::setMembers(const std::string& key) const {
+    std::shared_lock lock(mutex_);
+    auto it = sets_.find(key);
+    if (it == sets_.end()) return {};
+
+    std::vector<std::string> members;
+    members.reserve(it->second.size());
+    for (auto& [member, unused] : it->second.entries()) members.push_back(std::move(member));
+    return members;
+}
+
+std::vector<std::pair<std::string, std::vector<Storage::FieldValue>>> Storage::hashSnapshot() const {
+    std::shared_lock lock(mutex_);
+    std::vector<std::pair<std::string, std::vector<FieldValue>>> result;
+    result.reserve(hashes_.size());
+    for (const auto& [key, hash] : hashes_) {
+        result.emplace_back(key, hash.entries());
+    }
+    return result;
+}
+
+std::vector<std::pair<std::string, std::vector<std::string>>> Storage::setSnapshot() const {
+    std::shared_lock lock(mutex_);
+    std::vector<std::pair<std::string, std::vector<std::string>>> result;
+    result.reserve(sets_.size());
+    for (const auto& [key, set] : sets_) {
+        std::vector<std::string> members;
+        members.reserve(set.size());
+        for (auto& [member, unused] : set.entries()) members.push_back(std::move(member));
+        result.emplace_back(key, std::move(members));
+    }
+    return result;
+}
+
+size_t Storage::collectionCountUnlocked() const {
+    return lists_.size() + zsets_.size() + hashes_.size() + sets_.size();
+}
+
 StorageStats Storage::getStats() const {
     std::shared_lock lock(mutex_);
     StorageStats s;
 
+    s.memtable_bytes = memtable_bytes_ + slots_.capacity() * sizeof(MemTable::iterator) + expiry_heap_bytes_;
+    s.tombstone_bytes = tombstone_bytes_;
+    s.sstable_index_bytes = sstable_index_bytes_;
+    s.collection_bytes = collection_bytes_;
+    s.memory_bytes = memoryUsageUnlocked();
+    s.evicted_keys = evicted_total_;
+    s.evicted_bytes = evicted_bytes_total_;
+
     if (sstables_.empty() && deleted_keys_.empty()) {
-        s.key_count = store_.size();
+        s.key_count = store_.size() + collectionCountUnlocked();
         s.raw_bytes = raw_bytes_;
         s.compressed_bytes = compressed_bytes_;
         return s;
     }
 
     const auto merged = materializeVisibleUnlocked();
-    s.key_count = merged.size();
+    s.key_count = merged.size() + collectionCountUnlocked();
 
     size_t total_raw = 0;
     size_t total_compressed = 0;
-    for (const auto& [_, value] : merged) {
+    for (const auto& [k, value] : merged) {
         total_raw += value.size();
-        total_compressed += compressor_->compress(value, compression_level_).size();
+        total_compressed += compressor_->compress(value, compressionSpecFor(k)).size();
     }
 
     s.raw_bytes = total_raw;
@@ -425,34 +1607,20 @@ StorageStats Storage::getStats() const {
     return s;
 }
 
-std::vector<std::string> Storage::keys(size_t limit) const {
+std::vector<std::string> Storage::keys(const IterateOptions& options, const std::optional<std::string>& after,
+                                       size_t limit) const {
     std::shared_lock lock(mutex_);
-    const auto merged = materializeVisibleUnlocked();
-
     std::vector<std::string> result;
-    result.reserve(std::min(limit, merged.size()));
-
-    for (const auto& [k, _] : merged) {
-        result.push_back(k);
-        if (result.size() >= limit) break;
+    for (auto& [key, _] : collectUnlocked(currentViewUnlocked(), options, after, limit, false)) {
+        result.push_back(std::move(key));
     }
-
     return result;
 }
 
-std::vector<std::pair<std::string, std::string>> Storage::scan(const std::string& prefix, size_t limit) const {
+std::vector<std::pair<std::string, std::string>> Storage::scan(const IterateOptions& options,
+    const std::optional<std::string>& after, size_t limit) const {
     std::shared_lock lock(mutex_);
-    const auto merged = materializeVisibleUnlocked();
-
-    std::vector<std::pair<std::string, std::string>> result;
-
-    auto it = prefix.empty() ? merged.begin() : merged.lower_bound(prefix);
-    for (; it != merged.end() && result.size() < limit; ++it) {
-        if (!prefix.empty() && it->first.compare(0, prefix.size(), prefix) != 0) break;
-        result.emplace_back(it->first, it->second);
-    }
-
-    return result;
+    return collectUnlocked(currentViewUnlocked(), options, after, limit, true);
 }
 
 size_t Storage::countPrefix(const std::string& prefix) const {
@@ -463,50 +1631,521 @@ size_t Storage::countPrefix(const std::string& prefix) const {
 
     auto it = prefix.empty() ? merged.begin() : merged.lower_bound(prefix);
     for (; it != merged.end(); ++it) {
-        if (!prefix.empty() && it->first.compare(0, prefix.size(), prefix) != 0) break;
+        if (!hasPrefix(it->first, prefix)) break;
         count++;
     }
 
     return count;
 }
 
-std::vector<std::pair<std::string, std::string>> Storage::range(
-    const std::string& start, const std::string& end, size_t limit) const {
+std::vector<std::pair<std::string, std::vector<uint8_t>>> Storage::collectColdEntries(
+    int64_t idle_ms, const std::string& after_key, size_t limit) const {
     std::shared_lock lock(mutex_);
-    const auto merged = materializeVisibleUnlocked();
-
-    std::vector<std::pair<std::string, std::string>> result;
+    const int64_t cutoff = now() - idle_ms;
 
-    for (auto it = merged.lower_bound(start); it != merged.end() && it->first <= end && result.size() < limit; ++it) {
-        result.emplace_back(it->first, it->second);
+    std::vector<std::pair<std::string, std::vector<uint8_t>>> result;
+    auto it = after_key.empty() ? store_.begin() : store_.upper_bound(after_key);
+    for (; it != store_.end() && result.size() < limit; ++it) {
+        const auto& entry = it->second;
+        if (entry.cold || entry.last_access > cutoff || entry.compressed_value.empty()) continue;
+        if (isExpired(entry)) continue;
+        if (compressionSpecFor(it->first).codec == CompressionCodec::None) continue;
+        result.emplace_back(std::string(it->first), std::vector<uint8_t>(entry.compressed_value.begin(), entry.compressed_value.end()));
     }
 
     return result;
 }
 
-std::vector<std::pair<std::string, std::vector<uint8_t>>> Storage::snapshot() const {
+size_t Storage::replaceColdEntries(std::vector<ColdReplacement>&& replacements) {
+    std::unique_lock lock(mutex_);
+    size_t saved = 0;
+
+    for (auto& r : replacements) {
+        auto it = store_.find(r.key);
+        if (it == store_.end() || !std::ranges::equal(it->second.compressed_value.view(), r.original)) continue;
+
+        it->second.cold = true;
+        if (r.recompressed.empty() || r.recompressed.size() >= r.original.size()) continue;
+
+        saved += r.original.size() - r.recompressed.size();
+        compressed_bytes_ -= r.original.size() - r.recompressed.size();
+        memtable_bytes_ -= entryFootprint(it->first, it->second);
+        it->second.compressed_value.assign(r.recompressed);
+        memtable_bytes_ += entryFootprint(it->first, it->second);
+    }
+
+    return saved;
+}
+
+// Frames are copied as stored, so compaction never recompresses and keeps
+// each key's expiry.
+std::vector<SnapshotEntry> Storage::snapshot() const {
     std::shared_lock lock(mutex_);
+    return snapshotUnlocked();
+}
+
+std::vector<SnapshotEntry> Storage::snapshotUnlocked() const {
+    const auto frameBytes = [](const CompactBytes& bytes) {
+        return std::vector<uint8_t>(bytes.begin(), bytes.end());
+    };
 
     if (sstables_.empty() && deleted_keys_.empty()) {
-        std::vector<std::pair<std::string, std::vector<uint8_t>>> result;
+        std::vector<SnapshotEntry> result;
         result.reserve(store_.size());
 
         for (const auto& [k, v] : store_) {
             if (!isExpired(v)) {
-                result.emplace_back(k, v.compressed_value);
+                result.push_back({std::string(k), frameBytes(v.compressed_value), v.expires_at});
             }
         }
         return result;
     }
 
-    const auto merged = materializeVisibleUnlocked();
-    std::vector<std::pair<std::string, std::vector<uint8_t>>> result;
+    std::map<std::string, SnapshotEntry> merged;
+    const auto overlay = [&](std::string key, const ValueEntry& entry) {
+        if (isExpired(entry)) {
+            merged.erase(key);
+            return;
+        }
+        auto& slot = merged[key];
+        slot.frames = frameBytes(entry.compressed_value);
+        slot.expires_at = entry.expires_at;
+        slot.key = std::move(key);
+    };
+
+    for (const auto& table : sstables_) {
+        for (auto& key : table->keys()) {
+            if (deleted_keys_.find(key) != deleted_keys_.end()) continue;
+            auto entry = table->get(key);
+            if (entry.has_value()) overlay(std::move(key), *entry);
+        }
+    }
+
+    for (const auto& [pooled_key, entry] : store_) {
+        std::string key(pooled_key);
+        if (deleted_keys_.find(key) != deleted_keys_.end()) continue;
+        overlay(std::move(key), entry);
+    }
+
+    std::vector<SnapshotEntry> result;
     result.reserve(merged.size());
+    for (auto& [_, entry] : merged) {
+        result.push_back(std::move(entry));
+    }
+    return result;
+}
 
-    for (const auto& [k, value] : merged) {
-        result.emplace_back(k, compressor_->compress(value, compression_level_));
+// Keys are resolved one at a time against the newest table that holds them,
+// so the ingested tables' contents are never gathered in memory.
+CompactionSnapshot Storage::compactionSnapshot() const {
+    std::shared_lock lock(mutex_);
+
+    CompactionSnapshot result;
+    if (ingested_.empty()) {
+        result.entries = snapshotUnlocked();
+        return result;
+    }
+
+    // Position of the newest table holding `key`, with its entry.
+    const auto newestTable = [&](const std::string& key) -> std::pair<size_t, std::optional<ValueEntry>> {
+        for (size_t i = sstables_.size(); i-- > 0;) {
+            auto entry = sstables_[i]->get(key);
+            if (entry.has_value()) return {i, std::move(entry)};
+        }
+        return {sstables_.size(), std::nullopt};
+    };
+    const auto shadowed = [&](const std::string& key) {
+        return deleted_keys_.find(key) != deleted_keys_.end() || store_.find(key) != store_.end();
+    };
+
+    // An ingested table is kept while some key is served from it.
+    std::vector<bool> kept(sstables_.size(), false);
+    for (size_t i = 0; i < sstables_.size(); ++i) {
+        const auto& table = sstables_[i];
+        if (ingested_.count(table.get()) == 0) continue;
+        for (size_t k = 0; k < table->size() && !kept[i]; ++k) {
+            const std::string& key = table->keyAt(k);
+            if (shadowed(key)) continue;
+            const auto [at, entry] = newestTable(key);
+            kept[i] = at == i && !isExpired(*entry);
+        }
+        if (kept[i]) result.ingested.push_back(table->getFilePath());
+    }
+
+    // Keys of kept tables that are gone for good.
+    std::set<std::string> deleted;
+    for (size_t i = 0; i < sstables_.size(); ++i) {
+        if (!kept[i]) continue;
+        const auto& table = sstables_[i];
+        for (size_t k = 0; k < table->size(); ++k) {
+            const std::string& key = table->keyAt(k);
+            bool gone = deleted_keys_.find(key) != deleted_keys_.end();
+            if (!gone) {
+                if (auto it = store_.find(key); it != store_.end()) {
+                    gone = isExpired(it->second);
+                } else {
+                    gone = isExpired(*newestTable(key).second);
+                }
+            }
+            if (gone) deleted.insert(key);
+        }
+    }
+    result.deleted.assign(deleted.begin(), deleted.end());
+
+    // Everything else live, from the memtable and from spilled tables.
+    for (const auto& [pooled_key, entry] : store_) {
+        std::string key(pooled_key);
+        if (deleted_keys_.find(key) != deleted_keys_.end() || isExpired(entry)) continue;
+        result.entries.push_back({std::move(key),
+            std::vector<uint8_t>(entry.compressed_value.begin(), entry.compressed_value.end()), entry.expires_at});
+    }
+    for (size_t i = 0; i < sstables_.size(); ++i) {
+        const auto& table = sstables_[i];
+        if (ingested_.count(table.get()) != 0) continue;
+        for (size_t k = 0; k < table->size(); ++k) {
+            const std::string& key = table->keyAt(k);
+            if (shadowed(key)) continue;
+            auto [at, entry] = newestTable(key);
+            if (at != i || isExpired(*entry)) continue;
+            result.entries.push_back({key,
+                std::vector<uint8_t>(entry->compressed_value.begin(), entry->compressed_value.end()), entry->expires_at});
+        }
+    }
+    return result;
+}
+
+
+// Records the state of `key` as it stands before a write while some snapshot
+// is pinned. The record takes a sequence of its own, below the version the
+// write is about to assign, so even removals that take no version (eviction,
+// expiry) leave a boundary.
+void Storage::preserveUnlocked(std::string_view key) {
+    if (pins_->count.load() == 0) {
+        if (!history_.empty()) {
+            history_.clear();
+            history_bytes_ = 0;
+        }
+        return;
+    }
+
+    HistoryRecord record;
+    record.until = ++write_seq_;
+    if (deleted_keys_.find(key) != deleted_keys_.end()) {
+        record.state = HistoryRecord::State::Deleted;
+    } else if (auto it = store_.find(key); it != store_.end()) {
+        record.state = HistoryRecord::State::Value;
+        record.frames.assign(it->second.compressed_value.begin(), it->second.compressed_value.end());
+        record.expires_at = it->second.expires_at;
+    }
+
+    history_bytes_ += key.size() + sizeof(HistoryRecord) + record.frames.size();
+    auto slot = history_.find(key);
+    if (slot == history_.end()) slot = history_.emplace(std::string(key), std::vector<HistoryRecord>()).first;
+    slot->second.push_back(std::move(record));
+
+    if (history_bytes_ > history_prune_at_) pruneHistoryUnlocked();
+}
+
+// A spill moves every entry into a table that existing snapshots do not
+// know about, so all of them are kept under one boundary.
+void Storage::preserveMemTableUnlocked() {
+    if (pins_->count.load() == 0 || store_.empty()) return;
+
+    const uint64_t until = ++write_seq_;
+    for (const auto& [pooled_key, entry] : store_) {
+        HistoryRecord record;
+        record.until = until;
+        record.state = HistoryRecord::State::Value;
+        record.frames.assign(entry.compressed_value.begin(), entry.compressed_value.end());
+        record.expires_at = entry.expires_at;
+
+        history_bytes_ += pooled_key.size() + sizeof(HistoryRecord) + record.frames.size();
+        auto slot = history_.find(std::string_view(pooled_key));
+        if (slot == history_.end()) slot = history_.emplace(std::string(pooled_key), std::vector<HistoryRecord>()).first;
+        slot->second.push_back(std::move(record));
+    }
+}
+
+// Drops records no pinned snapshot can reach: those replaced at or before
+// the oldest pin.
+void Storage::pruneHistoryUnlocked() {
+    uint64_t oldest = 0;
+    {
+        std::lock_guard lock(pins_->mutex);
+        if (!pins_->sequences.empty()) oldest = *pins_->sequences.begin();
+    }
+
+    history_bytes_ = 0;
+    for (auto it = history_.begin(); it != history_.end();) {
+        auto& records = it->second;
+        records.erase(records.begin(), std::find_if(records.begin(), records.end(),
+            [oldest](const HistoryRecord& record) { return record.until > oldest; }));
+        if (records.empty()) {
+            it = history_.erase(it);
+            continue;
+        }
+        for (const auto& record : records) {
+            history_bytes_ += it->first.size() + sizeof(HistoryRecord) + record.frames.size();
+        }
+        ++it;
+    }
+    history_prune_at_ = std::max<size_t>(2 * history_bytes_, 1024 * 1024);
+}
+
+std::shared_ptr<const StorageSnapshot> Storage::pinSnapshot() {
+    std::shared_lock lock(mutex_);
+    auto* snapshot = new StorageSnapshot();
+    snapshot->sequence = write_seq_;
+    snapshot->wall_ms = wallClockMs();
+    snapshot->clear_epoch = clear_epoch_;
+    snapshot->sstables = sstables_;
+
+    {
+        std::lock_guard pins_lock(pins_->mutex);
+        pins_->sequences.insert(snapshot->sequence);
+        pins_->count.fetch_add(1);
+    }
+    return std::shared_ptr<const StorageSnapshot>(snapshot, [pins = pins_](const StorageSnapshot* pinned) {
+        {
+            std::lock_guard pins_lock(pins->mutex);
+            pins->sequences.erase(pins->sequences.find(pinned->sequence));
+            pins->count.fetch_sub(1);
+        }
+        delete pinned;
+    });
+}
+
+StorageSnapshot Storage::currentViewUnlocked() const {
+    StorageSnapshot view;
+    view.sequence = write_seq_;
+    view.wall_ms = wallClockMs();
+    view.clear_epoch = clear_epoch_;
+    view.sstables = sstables_;
+    return view;
+}
+
+// With `with_value` unset a live key resolves to an empty string, sparing
+// the decompression.
+std::optional<std::string> Storage::resolveAtUnlocked(std::string_view key, const StorageSnapshot& snapshot,
+                                                      bool with_value) const {
+    const auto live = [&](int64_t expires_at) { return expires_at == 0 || snapshot.wall_ms < expires_at; };
+    const auto decode = [&](const auto& frames) {
+        return with_value ? compressor_->decompress(frames) : std::string();
+    };
+    const auto underlying = [&]() -> std::optional<std::string> {
+        const std::string owned(key);
+        for (auto it = snapshot.sstables.rbegin(); it != snapshot.sstables.rend(); ++it) {
+            auto entry = (*it)->get(owned);
+            if (!entry.has_value()) continue;
+            if (!live(entry->expires_at)) return std::nullopt;
+            return decode(entry->compressed_value);
+        }
+        return std::nullopt;
+    };
+
+    auto history = snapshot.sequence < write_seq_ ? history_.find(key) : history_.end();
+    if (history != history_.end()) {
+        const auto& records = history->second;
+        auto record = std::find_if(records.begin(), records.end(),
+            [&](const HistoryRecord& r) { return r.until > snapshot.sequence; });
+        if (record != records.end()) {
+            switch (record->state) {
+                case HistoryRecord::State::Value:
+                    if (!live(record->expires_at)) return std::nullopt;
+                    return decode(record->frames);
+                case HistoryRecord::State::Deleted:
+                    return std::nullopt;
+                case HistoryRecord::State::Underlying:
+                    return underlying();
+            }
+        }
+    }
+
+    if (deleted_keys_.find(key) != deleted_keys_.end()) return std::nullopt;
+    if (auto it = store_.find(key); it != store_.end()) {
+        if (!live(it->second.expires_at)) return std::nullopt;
+        return decode(it->second.compressed_value);
+    }
+    return underlying();
+}
+
+namespace {
+
+// Where a scan source starts: the tightest of the scan bound and the resume
+// key, which is exclusive.
+struct SeekPoint {
+    std::string_view key;
+    bool inclusive = true;
+    bool bounded = false;
+};
+
+void tighten(SeekPoint& point, std::string_view key, bool inclusive, bool reverse) {
+    if (!point.bounded || (reverse ? key < point.key : key > point.key) || (key == point.key && !inclusive)) {
+        point = {key, inclusive, true};
+    }
+}
+
+// The smallest string above every key that starts with `prefix`, if any.
+std::optional<std::string> prefixSuccessor(std::string prefix) {
+    while (!prefix.empty() && static_cast<uint8_t>(prefix.back()) == 0xff) prefix.pop_back();
+    if (prefix.empty()) return std::nullopt;
+    prefix.back() = static_cast<char>(static_cast<uint8_t>(prefix.back()) + 1);
+    return prefix;
+}
+
+// True once `key` lies past the far end of the scan, so its source is done.
+bool pastScanEnd(std::string_view key, const IterateOptions& options) {
+    if (options.reverse) {
+        if (!options.start.empty() && key < options.start) return true;
+        return !options.prefix.empty() && key < options.prefix;
+    }
+    if (!options.end.empty() && key > options.end) return true;
+    return !options.prefix.empty() && key > options.prefix && !hasPrefix(key, options.prefix);
+}
+
+// Walks one sorted source from `from` in scan order, appending up to `want`
+// keys. Returns true when the source has no keys left within the scan.
+template <typename Position, typename KeyOf>
+bool collectKeys(Position first, Position last, Position from, const IterateOptions& options, size_t want,
+                 KeyOf key_of, std::vector<std::string_view>& out) {
+    size_t taken = 0;
+    Position position = from;
+    while (taken < want) {
+        if (options.reverse) {
+            if (position == first) return true;
+            --position;
+        } else if (position == last) {
+            return true;
+        }
+
+        const std::string_view key = key_of(position);
+        if (pastScanEnd(key, options)) return true;
+        if (options.prefix.empty() || hasPrefix(key, options.prefix)) {
+            out.push_back(key);
+            taken++;
+        }
+        if (!options.reverse) ++position;
+    }
+    // Exhausted if the last key taken was also the last one there is.
+    if (options.reverse) return position == first;
+    return position == last;
+}
+
+} // namespace
+
+void Storage::checkSnapshotUnlocked(const StorageSnapshot& snapshot) const {
+    if (snapshot.clear_epoch != clear_epoch_) throw std::runtime_error("snapshot invalidated by clear()");
+}
+
+std::optional<std::string> Storage::getAt(const StorageSnapshot& snapshot, const std::string& key) const {
+    std::shared_lock lock(mutex_);
+    checkSnapshotUnlocked(snapshot);
+    return resolveAtUnlocked(key, snapshot, true);
+}
+
+bool Storage::hasAt(const StorageSnapshot& snapshot, const std::string& key) const {
+    std::shared_lock lock(mutex_);
+    checkSnapshotUnlocked(snapshot);
+    return resolveAtUnlocked(key, snapshot, false).has_value();
+}
+
+std::vector<std::string> Storage::keysAt(const StorageSnapshot& snapshot, const IterateOptions& options,
+                                         const std::optional<std::string>& after, size_t limit) const {
+    std::shared_lock lock(mutex_);
+    checkSnapshotUnlocked(snapshot);
+    std::vector<std::string> result;
+    for (auto& [key, _] : collectUnlocked(snapshot, options, after, limit, false)) {
+        result.push_back(std::move(key));
     }
+    return result;
+}
 
+std::vector<std::pair<std::string, std::string>> Storage::scanAt(const StorageSnapshot& snapshot,
+    const IterateOptions& options, const std::optional<std::string>& after, size_t limit) const {
+    std::shared_lock lock(mutex_);
+    checkSnapshotUnlocked(snapshot);
+    return collectUnlocked(snapshot, options, after, limit, true);
+}
+
+std::vector<std::pair<std::string, std::string>> Storage::collectUnlocked(const StorageSnapshot& snapshot,
+    const IterateOptions& options, const std::optional<std::string>& after, size_t limit, bool with_values) const {
+    const bool reverse = options.reverse;
+    std::optional<std::string> prefix_end;
+    if (reverse && !options.prefix.empty()) prefix_end = prefixSuccessor(options.prefix);
+
+    std::vector<std::pair<std::string, std::string>> result;
+    std::string resume;
+    bool resuming = after.has_value();
+    if (resuming) resume = *after;
+
+    std::vector<std::string_view> candidates;
+    while (result.size() < limit) {
+        SeekPoint seek;
+        if (reverse) {
+            if (!options.end.empty()) tighten(seek, options.end, true, true);
+            if (prefix_end.has_value()) tighten(seek, *prefix_end, false, true);
+        } else {
+            if (!options.start.empty()) tighten(seek, options.start, true, false);
+            if (!options.prefix.empty()) tighten(seek, options.prefix, true, false);
+        }
+        if (resuming) tighten(seek, resume, false, reverse);
+
+        // Forward scans start at the first key past the seek point, reverse
+        // ones step back from the first key beyond it.
+        const bool from_lower = reverse != seek.inclusive;
+        const size_t want = std::max<size_t>(limit - result.size(), 32);
+        candidates.clear();
+        // The nearest key at which some source stopped short; keys beyond it
+        // may still be missing from the candidates.
+        std::optional<std::string_view> horizon;
+        const auto note = [&](bool exhausted) {
+            if (exhausted || candidates.empty()) return;
+            const std::string_view last = candidates.back();
+            if (!horizon || (reverse ? last > *horizon : last < *horizon)) horizon = last;
+        };
+
+        const auto map_source = [&](const auto& map) {
+            auto from = !seek.bounded ? (reverse ? map.end() : map.begin())
+                : from_lower ? map.lower_bound(seek.key) : map.upper_bound(seek.key);
+            const size_t before = candidates.size();
+            const bool exhausted = collectKeys(map.begin(), map.end(), from, options, want,
+                [](auto it) { return std::string_view(it->first); }, candidates);
+            if (candidates.size() > before) note(exhausted);
+        };
+        map_source(store_);
+        // Only states replaced after the snapshot can differ from the layers.
+        if (snapshot.sequence < write_seq_) map_source(history_);
+        for (const auto& table : snapshot.sstables) {
+            size_t from = reverse ? table->size() : 0;
+            if (seek.bounded) {
+                from = table->lowerBound(seek.key);
+                if (!from_lower && from < table->size() && table->keyAt(from) == seek.key) from++;
+            }
+            const size_t before = candidates.size();
+            const bool exhausted = collectKeys(size_t{0}, table->size(), from, options, want,
+                [&](size_t position) { return std::string_view(table->keyAt(position)); }, candidates);
+            if (candidates.size() > before) note(exhausted);
+        }
+
+        if (reverse) {
+            std::sort(candidates.begin(), candidates.end(), std::greater<>());
+        } else {
+            std::sort(candidates.begin(), candidates.end());
+        }
+        candidates.erase(std::unique(candidates.begin(), candidates.end()), candidates.end());
+
+        for (const auto key : candidates) {
+            if (horizon && (reverse ? key < *horizon : key > *horizon)) break;
+            auto value = resolveAtUnlocked(key, snapshot, with_values);
+            if (value.has_value()) {
+                result.emplace_back(std::string(key), std::move(*value));
+                if (result.size() == limit) return result;
+            }
+        }
+        if (!horizon) break;
+        resume = std::string(*horizon);
+        resuming = true;
+    }
     return result;
 }
 
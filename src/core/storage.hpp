@@ -2,8 +2,15 @@
 
 #include "titankv.hpp"
 #include "compressor.hpp"
+#include "compact_bytes.hpp"
+#include "dict.hpp"
+#include "quicklist.hpp"
+#include "skiplist.hpp"
 #include "utils.hpp"
+#include <functional>
 #include <map>
+#include <memory_resource>
+#include <string_view>
 #include <string>
 #include <vector>
 #include <mutex>
@@ -11,73 +18,427 @@
 #include <optional>
 #include <memory>
 #include <set>
+#include <random>
+#include <unordered_map>
+#include <unordered_set>
 
 namespace titan {
 
+// Allocator-aware so that entries created inside the memtable take their
+// value bytes from the memtable arena (uses-allocator construction).
 struct ValueEntry {
-    std::vector<uint8_t> compressed_value;
-    size_t raw_size = 0;
+    using allocator_type = CompactBytes::allocator_type;
+
+    CompactBytes compressed_value;
     int64_t expires_at = 0;
+    int64_t last_access = 0;
+    uint32_t raw_size = 0;
+    // Position in Storage::slots_, used to sample eviction candidates.
+    uint32_t slot = 0;
+    // Storage::access_clock_ at the last touch; finer-grained than
+    // last_access for LRU ordering.
+    uint32_t access_seq = 0;
+    uint8_t lfu_counter = 0;
+    bool cold = false;
+    // Storage::write_seq_ at the last write; see VersionedValue.
+    uint64_t version = 0;
+
+    ValueEntry() = default;
+    explicit ValueEntry(const allocator_type& alloc) : compressed_value(alloc) {}
+    ValueEntry(const ValueEntry& other) = default;
+    ValueEntry(ValueEntry&& other) = default;
+    ValueEntry(const ValueEntry& other, const allocator_type& alloc)
+        : compressed_value(other.compressed_value, alloc), expires_at(other.expires_at),
+          last_access(other.last_access), raw_size(other.raw_size), slot(other.slot),
+          access_seq(other.access_seq), lfu_counter(other.lfu_counter), cold(other.cold),
+          version(other.version) {}
+    ValueEntry(ValueEntry&& other, const allocator_type& alloc)
+        : compressed_value(std::move(other.compressed_value), alloc), expires_at(other.expires_at),
+          last_access(other.last_access), raw_size(other.raw_size), slot(other.slot),
+          access_seq(other.access_seq), lfu_counter(other.lfu_counter), cold(other.cold),
+          version(other.version) {}
+    ValueEntry& operator=(const ValueEntry& other) = default;
+    ValueEntry& operator=(ValueEntry&& other) = default;
+};
+
+// Keys, map nodes and value bytes all come from one pool arena that is
+// released wholesale when the memtable is flushed or cleared.
+struct MemTableKeyLess {
+    using is_transparent = void;
+    bool operator()(std::string_view a, std::string_view b) const noexcept { return a < b; }
+};
+
+using MemTable = std::pmr::map<std::pmr::string, ValueEntry, MemTableKeyLess>;
+
+// A cold value re-encoded off-lock; it is only swapped in if the entry still
+// holds `original`, so concurrent writes always win.
+struct ColdReplacement {
+    std::string key;
+    std::vector<uint8_t> original;
+    std::vector<uint8_t> recompressed;
+};
+
+// One write of an atomic batch (see Storage::applyBatch).
+struct BatchWrite {
+    enum class Kind : uint8_t { Put, Del, Incr };
+
+    Kind kind = Kind::Put;
+    std::string key;
+    // Put: the compressed value and its deadline. Incr: filled in with the
+    // resulting integer frame and the expiry it kept.
+    std::vector<uint8_t> frames;
+    int64_t expires_at = 0;
+    int64_t delta = 0;
+    // Incr: the new value. Del: whether a plain value was removed.
+    int64_t result = 0;
+    bool dropped_collections = false;
+    // Incr: set when the counter could not be applied; the write is skipped.
+    std::string error;
+};
+
+// A live key as carried into a compacted WAL. expires_at is Unix ms, 0 for
+// keys without a TTL.
+struct SnapshotEntry {
+    std::string key;
+    std::vector<uint8_t> frames;
+    int64_t expires_at = 0;
+};
+
+// What compaction rewrites the WAL from. Ingested tables that still serve
+// a key stay as they are: `ingested` holds their paths oldest first,
+// `entries` leaves out the keys they serve, and `deleted` names their keys
+// that are gone and must be removed again once the tables are re-ingested.
+struct CompactionSnapshot {
+    std::vector<std::string> ingested;
+    std::vector<std::string> deleted;
+    std::vector<SnapshotEntry> entries;
 };
 
 class SSTable;
 
+// A pinned point in the write sequence; see Storage::pinSnapshot().
+struct StorageSnapshot {
+    uint64_t sequence = 0;
+    // Expiry is judged as of the pin.
+    int64_t wall_ms = 0;
+    uint64_t clear_epoch = 0;
+    std::vector<std::shared_ptr<SSTable>> sstables;
+};
+
 class Storage {
 public:
     Storage();
 
     void put(const std::string& key, const std::string& value, int64_t ttl_ms = 0);
-    void putPrecompressed(const std::string& key, std::vector<uint8_t>&& compressed_value, int64_t ttl_ms = 0);
+    // expires_at is an absolute Unix-ms deadline (0 = none), as logged to the WAL.
+    void putPrecompressed(const std::string& key, std::vector<uint8_t>&& compressed_value, int64_t expires_at = 0);
     void putPrecompressedBatch(std::vector<std::pair<std::string, std::vector<uint8_t>>>&& batch, size_t total_raw_size);
 
+    // Adds delta to the integer under key in one step, keeping its expiry; a
+    // missing key counts as 0. Returns the new value and its expiry, or
+    // nullopt when the current value is not a canonical int64.
+    //
+    // The counter updates log their result rather than the delta, so `log`
+    // runs once the result is applied and before the lock is released:
+    // concurrent updates then reach the WAL in the order they were applied
+    // and replay ends on the same value.
+    struct IncrResult {
+        int64_t value = 0;
+        int64_t expires_at = 0;
+        // Length of the value as decimal text.
+        size_t raw_size = 0;
+    };
+    std::optional<IncrResult> incrBy(const std::string& key, int64_t delta,
+                                     const std::function<void(const IncrResult&)>& log = {});
+
+    // Applies the writes in order under one lock acquisition. Counters are
+    // resolved against the batch's own earlier writes; an incr that hits a
+    // non-integer value or would overflow gets its `error` set and is
+    // skipped, and the other writes still apply. Dels also drop native
+    // collections, like TitanEngine::del.
+    //
+    // Returns false without applying anything when a key in `watches` is no
+    // longer at its version. `log` runs once the batch is applied and before
+    // the lock is released, as for incrBy.
+    bool applyBatch(std::vector<BatchWrite>& writes,
+                    const std::vector<std::pair<std::string, uint64_t>>& watches = {},
+                    const std::function<void(const std::vector<BatchWrite>&)>& log = {});
+
+    // Versioned reads and conditional writes for compare-and-set. The puts
+    // take precompressed frames and return the key's new version, or nullopt
+    // when the condition failed and nothing was written.
+    VersionedValue getWithVersion(const std::string& key);
+    uint64_t version(const std::string& key) const;
+    std::optional<uint64_t> putIfVersion(const std::string& key, std::span<const uint8_t> compressed_value,
+                                         uint64_t expected_version, int64_t expires_at = 0);
+    std::optional<uint64_t> putIfAbsent(const std::string& key, std::span<const uint8_t> compressed_value,
+                                        int64_t expires_at = 0);
+
     std::optional<std::string> get(const std::string& key);
+    std::optional<std::string> getRange(const std::string& key, size_t offset, size_t length);
+    std::optional<size_t> valueLength(const std::string& key);
     std::vector<std::optional<std::string>> getBatch(const std::vector<std::string>& keys);
     bool del(const std::string& key);
+    // Removes native collections under the key; plain values are untouched.
+    // `log` runs under the lock when something was dropped.
+    bool dropCollections(const std::string& key, const std::function<void()>& log = {});
     bool has(const std::string& key);
     void clear();
 
-    std::vector<std::string> keys(size_t limit) const;
-    std::vector<std::pair<std::string, std::string>> scan(const std::string& prefix, size_t limit) const;
+    // Up to `limit` live keys or pairs within `options`, in key order
+    // (descending when reversed) and starting past `after` when set. Each
+    // source is entered with a binary search, so a page costs the same
+    // however deep into the keyspace it starts.
+    std::vector<std::string> keys(const IterateOptions& options, const std::optional<std::string>& after,
+                                  size_t limit) const;
+    std::vector<std::pair<std::string, std::string>> scan(const IterateOptions& options,
+        const std::optional<std::string>& after, size_t limit) const;
     size_t countPrefix(const std::string& prefix) const;
-    std::vector<std::pair<std::string, std::string>> range(const std::string& start, const std::string& end, size_t limit) const;
 
-    std::vector<std::pair<std::string, std::vector<uint8_t>>> snapshot() const;
+    std::vector<SnapshotEntry> snapshot() const;
+    CompactionSnapshot compactionSnapshot() const;
+
+    // Pins the current write sequence. While any pin is held, writes keep
+    // the state they replace, so reads at the pin see the data as it was
+    // without copying it up front; the kept states are dropped once the
+    // pins that could see them are released. clear() invalidates pins.
+    std::shared_ptr<const StorageSnapshot> pinSnapshot();
+    // Reads as of `snapshot`; they throw once clear() has invalidated it.
+    std::optional<std::string> getAt(const StorageSnapshot& snapshot, const std::string& key) const;
+    bool hasAt(const StorageSnapshot& snapshot, const std::string& key) const;
+    std::vector<std::string> keysAt(const StorageSnapshot& snapshot, const IterateOptions& options,
+                                    const std::optional<std::string>& after, size_t limit) const;
+    std::vector<std::pair<std::string, std::string>> scanAt(const StorageSnapshot& snapshot,
+        const IterateOptions& options, const std::optional<std::string>& after, size_t limit) const;
+
+    std::vector<std::pair<std::string, std::vector<uint8_t>>> collectColdEntries(
+        int64_t idle_ms, const std::string& after_key, size_t limit) const;
+    size_t replaceColdEntries(std::vector<ColdReplacement>&& replacements);
+
+    // Native lists sit beside the memtable under their own key space. They
+    // are neither spilled nor evicted but count toward memory_bytes; an
+    // emptied list is removed. Indexes may be negative (from the tail).
+    //
+    // Collection writes are logged as deltas, so replay only rebuilds the
+    // same collection if the records follow apply order. Each write takes a
+    // `log` that runs under the lock once it has changed something, as for
+    // incrBy; writes that change nothing do not call it.
+    size_t listPush(const std::string& key, const std::vector<std::string>& values, bool front,
+                    const std::function<void()>& log = {});
+    std::optional<std::string> listPop(const std::string& key, bool front, const std::function<void()>& log = {});
+    size_t listLength(const std::string& key) const;
+    std::optional<std::string> listIndex(const std::string& key, int64_t index) const;
+    // Returns the resolved index, or nullopt when it is out of range; `log`
+    // gets the resolved index.
+    std::optional<size_t> listSet(const std::string& key, int64_t index, const std::string& value,
+                                  const std::function<void(size_t)>& log = {});
+    std::vector<std::string> listRange(const std::string& key, int64_t start, int64_t stop) const;
+    // Each list as packed chunks, front to back.
+    std::vector<std::pair<std::string, std::vector<std::vector<uint8_t>>>> listSnapshot() const;
+
+    // Native sorted sets, kept like lists. Scores must not be NaN; rank
+    // indexes may be negative and count from the highest score when
+    // `reverse` is set.
+    size_t zsetAdd(const std::string& key, const std::vector<SortedSet::Member>& members,
+                   const std::function<void()>& log = {});
+    double zsetIncrBy(const std::string& key, const std::string& member, double delta,
+                      const std::function<void(double)>& log = {});
+    size_t zsetRemove(const std::string& key, const std::vector<std::string>& members,
+                      const std::function<void()>& log = {});
+    std::optional<double> zsetScore(const std::string& key, const std::string& member) const;
+    std::optional<size_t> zsetRank(const std::string& key, const std::string& member, bool reverse) const;
+    size_t zsetCard(const std::string& key) const;
+    std::vector<SortedSet::Member> zsetRange(const std::string& key, int64_t start, int64_t stop, bool reverse) const;
+    std::vector<SortedSet::Member> zsetRangeByScore(const std::string& key, double min, double max,
+                                                    size_t offset, size_t count, bool reverse) const;
+    size_t zsetCount(const std::string& key, double min, double max) const;
+    // Each sorted set's members in ascending order.
+    std::vector<std::pair<std::string, std::vector<SortedSet::Member>>> zsetSnapshot() const;
+
+    // Native hashes and sets, kept like lists.
+    using FieldValue = std::pair<std::string, std::string>;
+    size_t hashSet(const std::string& key, const std::vector<FieldValue>& fields,
+                   const std::function<void()>& log = {});
+    std::optional<std::string> hashGet(const std::string& key, const std::string& field) const;
+    size_t hashDel(const std::string& key, const std::vector<std::string>& fields,
+                   const std::function<void()>& log = {});
+    size_t hashLength(const std::string& key) const;
+    std::vector<FieldValue> hashGetAll(const std::string& key) const;
+    // Returns the new value, or nullopt when the field does not hold an integer.
+    std::optional<int64_t> hashIncrBy(const std::string& key, const std::string& field, int64_t delta,
+                                      const std::function<void(int64_t)>& log = {});
+    size_t setAdd(const std::string& key, const std::vector<std::string>& members,
+                  const std::function<void()>& log = {});
+    size_t setRemove(const std::string& key, const std::vector<std::string>& members,
+                     const std::function<void()>& log = {});
+    bool setIsMember(const std::string& key, const std::string& member) const;
+    size_t setCard(const std::string& key) const;
+    std::vector<std::string> setMembers(const std::string& key) const;
+    std::vector<std::pair<std::string, std::vector<FieldValue>>> hashSnapshot() const;
+    std::vector<std::pair<std::string, std::vector<std::string>>> setSnapshot() const;
 
     StorageStats getStats() const;
     void setCompressionLevel(int level) { compression_level_ = level; }
     int getCompressionLevel() const { return compression_level_; }
+    void setCompressionPolicies(std::vector<std::pair<std::string, CompressionSpec>> policies);
+    CompressionSpec compressionSpecFor(std::string_view key) const;
 
     void setMaxMemoryBytes(size_t limit_bytes);
+    void setEvictionConfig(const EvictionConfig& config);
+    // When set, keys removed by eviction or active expiry are queued for the
+    // caller to log as deletes and report to keyspace subscribers.
+    struct ReclaimedKey {
+        std::string key;
+        bool evicted = false;
+    };
+    void setRecordReclaimedKeys(bool enabled);
+    std::vector<ReclaimedKey> takeReclaimedKeys();
+
+    size_t purgeExpired(size_t max_keys);
+    std::optional<std::vector<uint8_t>> setExpiry(const std::string& key, int64_t expires_at);
+    std::optional<int64_t> ttl(const std::string& key);
     void setSSTableBloomFilterEnabled(bool enabled);
     void setSpillDirectory(const std::string& spill_dir);
     void spillToDisk(const std::string& filepath);
     void loadSSTablesFromDirectory(const std::string& spill_dir, RecoveryMode mode = RecoveryMode::Permissive);
     void loadSSTablesFromFiles(const std::vector<std::string>& sst_files, RecoveryMode mode);
     void flushSpillState();
+    // Opens a table with the storage's Bloom filter setting; the index is
+    // read with no lock held.
+    std::shared_ptr<SSTable> openSSTable(const std::string& filepath) const;
+    // Layers the tables over everything stored so far, later ones on top:
+    // memtable entries and tombstones for their keys are dropped so the
+    // tables' values win. Collections are not touched.
+    void ingest(const std::vector<std::shared_ptr<SSTable>>& tables);
 
 private:
     mutable std::shared_mutex mutex_;
-    std::map<std::string, ValueEntry> store_;
+    // Declared before store_ so the arena outlives every node that uses it.
+    std::unique_ptr<std::pmr::unsynchronized_pool_resource> arena_;
+    MemTable store_;
+    std::vector<MemTable::iterator> slots_;
     std::unique_ptr<Compressor> compressor_;
     std::vector<std::shared_ptr<SSTable>> sstables_;
-    std::set<std::string> deleted_keys_;
+    // The tables in sstables_ that came from ingest().
+    std::unordered_set<const SSTable*> ingested_;
+    // Tombstones with the version of the delete that wrote them.
+    std::map<std::string, uint64_t, std::less<>> deleted_keys_;
+    std::unordered_map<std::string, QuickList> lists_;
+    std::unordered_map<std::string, SortedSet> zsets_;
+    std::unordered_map<std::string, HashDict> hashes_;
+    std::unordered_map<std::string, SetDict> sets_;
     int compression_level_ = 3;
+    std::vector<std::pair<std::string, CompressionSpec>> compression_policies_;
 
     size_t raw_bytes_ = 0;
     size_t compressed_bytes_ = 0;
     size_t max_memory_bytes_ = 0;
+    size_t memtable_bytes_ = 0;
+    size_t tombstone_bytes_ = 0;
+    size_t sstable_index_bytes_ = 0;
+    size_t collection_bytes_ = 0;
+    size_t volatile_count_ = 0;
+    EvictionConfig eviction_{};
+    bool record_reclaimed_keys_ = false;
+    std::vector<ReclaimedKey> reclaimed_keys_;
+    size_t evicted_total_ = 0;
+    size_t evicted_bytes_total_ = 0;
+    std::minstd_rand eviction_rng_;
+    uint32_t access_clock_ = 0;
+    // Source of entry and tombstone versions. base_version_ is reported for
+    // keys with neither and is renewed whenever memtable entries leave
+    // without a trace (spill, clear, removals with no SSTables to mask).
+    uint64_t write_seq_ = 0;
+    uint64_t base_version_ = 0;
+
+    // Best eviction candidates seen across steps, ascending by score. Keys
+    // are re-resolved on use since entries may be gone by then.
+    struct EvictionCandidate {
+        uint64_t score = 0;
+        std::string key;
+    };
+    std::vector<EvictionCandidate> eviction_pool_;
+
+    // Min-heap of (expires_at, key). Entries go stale when a key is
+    // overwritten or deleted and are skipped when popped; the heap is rebuilt
+    // once stale entries dominate.
+    using ExpiryRef = std::pair<int64_t, std::string>;
+    std::vector<ExpiryRef> expiry_heap_;
+    size_t expiry_heap_bytes_ = 0;
+
+    // Sequences pinned by outstanding StorageSnapshots. Shared with their
+    // deleters, which may run after the storage is gone.
+    struct SnapshotPins {
+        std::mutex mutex;
+        std::multiset<uint64_t> sequences;
+        std::atomic<size_t> count{0};
+    };
+    std::shared_ptr<SnapshotPins> pins_;
+    // States replaced while a snapshot was pinned, per key in the order they
+    // were replaced. `until` is the sequence of the replacing write, so a
+    // snapshot at S reads the first record with until > S, or the current
+    // state when there is none. Underlying defers to the snapshot's SSTables.
+    struct HistoryRecord {
+        enum class State : uint8_t { Value, Deleted, Underlying };
+        uint64_t until = 0;
+        State state = State::Underlying;
+        std::vector<uint8_t> frames;
+        int64_t expires_at = 0;
+    };
+    std::map<std::string, std::vector<HistoryRecord>, std::less<>> history_;
+    size_t history_bytes_ = 0;
+    size_t history_prune_at_ = 0;
+    uint64_t clear_epoch_ = 0;
     bool sstable_bloom_enabled_ = true;
     std::string spill_dir_;
     uint64_t spill_seq_ = 0;
 
     int64_t now() const;
     bool isExpired(const ValueEntry& entry) const;
+    void touchUnlocked(ValueEntry& entry, int64_t ts);
+    uint8_t decayedLfuCounter(const ValueEntry& entry, int64_t ts) const;
+    uint64_t evictionScore(const ValueEntry& entry, int64_t ts) const;
+    void upsertUnlocked(const std::string& key, std::span<const uint8_t> compressed, size_t raw_size,
+        int64_t expires_at, int64_t ts);
+    void eraseEntryUnlocked(MemTable::iterator it);
+    void dropExpiredEntryUnlocked(MemTable::iterator it);
+    void scheduleExpiryUnlocked(const std::pmr::string& key, int64_t expires_at);
+    void rebuildExpiryHeapUnlocked();
+    size_t purgeExpiredUnlocked(size_t max_keys, bool record);
+    uint64_t versionUnlocked(const std::string& key) const;
+    std::optional<int64_t> parseIntegerUnlocked(std::span<const uint8_t> frames) const;
+    bool delUnlocked(const std::string& key);
+    bool dropCollectionsUnlocked(const std::string& key);
+    bool liveUnlocked(const std::string& key) const;
+    void addTombstoneUnlocked(const std::string& key);
+    void markDeletedUnlocked(const std::string& key);
+    void dropTombstoneUnlocked(const std::string& key);
+    void resetMemTableUnlocked();
+    void refreshSSTableIndexBytesUnlocked();
+    size_t memoryUsageUnlocked() const;
+    size_t collectionCountUnlocked() const;
+    void enforceMemoryLimitUnlocked();
     void maybeSpillToDiskUnlocked();
+    void evictUntilWithinLimitUnlocked();
+    void populateEvictionPoolUnlocked(int64_t ts);
+    bool evictOneUnlocked();
     void spillToDiskUnlocked(const std::string& filepath);
     std::string nextSpillFilePathUnlocked();
     void clearSpillFilesUnlocked();
     std::optional<ValueEntry> findInSSTablesUnlocked(const std::string& key) const;
+    void preserveUnlocked(std::string_view key);
+    void preserveMemTableUnlocked();
+    void pruneHistoryUnlocked();
+    // The current state, in the shape of a snapshot that needs no history.
+    StorageSnapshot currentViewUnlocked() const;
+    void checkSnapshotUnlocked(const StorageSnapshot& snapshot) const;
+    std::optional<std::string> resolveAtUnlocked(std::string_view key, const StorageSnapshot& snapshot,
+                                                 bool with_value) const;
+    std::vector<std::pair<std::string, std::string>> collectUnlocked(const StorageSnapshot& snapshot,
+        const IterateOptions& options, const std::optional<std::string>& after, size_t limit,
+        bool with_values) const;
     std::map<std::string, std::string> materializeVisibleUnlocked() const;
+    std::vector<SnapshotEntry> snapshotUnlocked() const;
 };
 
 } // namespace titan
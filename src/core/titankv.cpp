@@ -2,16 +2,166 @@
 #include "storage.hpp"
 #include "wal.hpp"
 #include "manifest.hpp"
+#include "read_snapshot.hpp"
+#include "pubsub.hpp"
 #include "compressor.hpp"
+#include "quicklist.hpp"
+#include "skiplist.hpp"
+#include "sstable.hpp"
 #include "utils.hpp"
 #include <algorithm>
 #include <chrono>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iterator>
+#include <unordered_set>
 
 namespace {
 
-int64_t unixNowMs() {
-    using namespace std::chrono;
-    return duration_cast<milliseconds>(system_clock::now().time_since_epoch()).count();
+// Keys reclaimed per storage lock acquisition during an expiry cycle.
+constexpr size_t kExpirySliceKeys = 256;
+
+// TTLs are turned into absolute deadlines once, so the WAL and the memtable
+// agree on the same instant.
+int64_t expiryFromTtl(int64_t ttl_ms) {
+    return ttl_ms > 0 ? titan::wallClockMs() + ttl_ms : 0;
+}
+
+// Records that shrink the dataset; they drive the tombstone ratio that
+// triggers auto-compaction.
+bool isRemovalOp(titan::WalOp op) {
+    return op == titan::WalOp::DEL || op == titan::WalOp::DROP
+        || op == titan::WalOp::LPOP || op == titan::WalOp::RPOP
+        || op == titan::WalOp::ZREM || op == titan::WalOp::HDEL
+        || op == titan::WalOp::SREM;
+}
+
+// Pairs read from the iterator per step of an export.
+constexpr size_t kExportBatch = 256;
+
+bool isValidUtf8(std::string_view text) {
+    size_t i = 0;
+    while (i < text.size()) {
+        const auto lead = static_cast<uint8_t>(text[i]);
+        size_t extra = 0;
+        uint32_t code = 0;
+        if (lead < 0x80) {
+            i++;
+            continue;
+        } else if ((lead & 0xE0) == 0xC0) {
+            extra = 1;
+            code = lead & 0x1F;
+        } else if ((lead & 0xF0) == 0xE0) {
+            extra = 2;
+            code = lead & 0x0F;
+        } else if ((lead & 0xF8) == 0xF0) {
+            extra = 3;
+            code = lead & 0x07;
+        } else {
+            return false;
+        }
+        if (text.size() - i <= extra) return false;
+        for (size_t k = 1; k <= extra; k++) {
+            const auto next = static_cast<uint8_t>(text[i + k]);
+            if ((next & 0xC0) != 0x80) return false;
+            code = (code << 6) | (next & 0x3F);
+        }
+        // Overlong forms, surrogates and code points past U+10FFFF.
+        static constexpr uint32_t kMinCode[] = {0, 0x80, 0x800, 0x10000};
+        if (code < kMinCode[extra] || (code >= 0xD800 && code <= 0xDFFF) || code > 0x10FFFF) return false;
+        i += extra + 1;
+    }
+    return true;
+}
+
+void appendJsonString(std::string& out, std::string_view text) {
+    static constexpr char kHex[] = "0123456789abcdef";
+    out.push_back('"');
+    for (const char ch : text) {
+        const auto c = static_cast<uint8_t>(ch);
+        switch (c) {
+            case '"': out += "\\\""; break;
+            case '\\': out += "\\\\"; break;
+            case '\n': out += "\\n"; break;
+            case '\r': out += "\\r"; break;
+            case '\t': out += "\\t"; break;
+            default:
+                if (c < 0x20) {
+                    out += "\\u00";
+                    out.push_back(kHex[c >> 4]);
+                    out.push_back(kHex[c & 0xF]);
+                } else {
+                    out.push_back(ch);
+                }
+        }
+    }
+    out.push_back('"');
+}
+
+void appendBase64(std::string& out, std::string_view bytes) {
+    static constexpr char kAlphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    size_t i = 0;
+    for (; i + 3 <= bytes.size(); i += 3) {
+        const uint32_t n = (static_cast<uint8_t>(bytes[i]) << 16) | (static_cast<uint8_t>(bytes[i + 1]) << 8)
+            | static_cast<uint8_t>(bytes[i + 2]);
+        out.push_back(kAlphabet[(n >> 18) & 63]);
+        out.push_back(kAlphabet[(n >> 12) & 63]);
+        out.push_back(kAlphabet[(n >> 6) & 63]);
+        out.push_back(kAlphabet[n & 63]);
+    }
+    if (i < bytes.size()) {
+        uint32_t n = static_cast<uint8_t>(bytes[i]) << 16;
+        if (i + 1 < bytes.size()) n |= static_cast<uint8_t>(bytes[i + 1]) << 8;
+        out.push_back(kAlphabet[(n >> 18) & 63]);
+        out.push_back(kAlphabet[(n >> 12) & 63]);
+        out.push_back(i + 1 < bytes.size() ? kAlphabet[(n >> 6) & 63] : '=');
+        out.push_back('=');
+    }
+}
+
+// Ingested SSTables, under the data directory. INGEST records name them
+// relative to the data directory.
+constexpr char kIngestDirectory[] = "ingest";
+
+// Files a failed ingest left behind, and those only compacted-away records
+// referred to, are dropped once recovery knows which ones the WAL names.
+void removeUnreferencedIngestFiles(const std::filesystem::path& db_path,
+                                   const std::unordered_set<std::string>& referenced) {
+    std::error_code ec;
+    const auto dir = db_path / kIngestDirectory;
+    if (!std::filesystem::exists(dir, ec)) return;
+
+    for (const auto& entry : std::filesystem::directory_iterator(dir, ec)) {
+        if (ec) break;
+        const auto name = (std::filesystem::path(kIngestDirectory) / entry.path().filename()).generic_string();
+        if (referenced.count(name) == 0) std::filesystem::remove(entry.path(), ec);
+        ec.clear();
+    }
+}
+
+// Hard-links the immutable files directly under `from` into `to`, copying
+// where a link is not possible. Files a reused checkpoint already holds in
+// full are kept. `keep` filters by file name.
+void linkImmutableFiles(const std::filesystem::path& from, const std::filesystem::path& to,
+                        const std::function<bool(const std::filesystem::path&)>& keep = {}) {
+    std::error_code ec;
+    if (!std::filesystem::exists(from, ec)) return;
+
+    std::filesystem::create_directories(to);
+    for (const auto& entry : std::filesystem::directory_iterator(from)) {
+        if (keep && !keep(entry.path())) continue;
+        const auto linked = to / entry.path().filename();
+        if (std::filesystem::exists(linked, ec) && std::filesystem::file_size(linked, ec) == entry.file_size(ec)) {
+            continue;
+        }
+        std::filesystem::remove(linked, ec);
+        std::filesystem::create_hard_link(entry.path(), linked, ec);
+        if (ec) {
+            ec.clear();
+            std::filesystem::copy_file(entry.path(), linked);
+        }
+    }
 }
 
 }
@@ -23,13 +173,18 @@ TitanEngine::TitanEngine() : TitanEngine("", RecoveryMode::Permissive, true) {}
 TitanEngine::TitanEngine(const std::string& data_dir, RecoveryMode recovery_mode, bool sstable_bloom_enabled)
     : recovery_mode_(recovery_mode) {
     storage_ = std::make_unique<Storage>();
+    pubsub_ = std::make_unique<PubSub>();
     storage_->setSSTableBloomFilterEnabled(sstable_bloom_enabled);
     if (!data_dir.empty()) {
         db_path_ = std::filesystem::path(data_dir);
         storage_->setSpillDirectory((db_path_ / "sstables").string());
         wal_ = std::make_unique<WAL>(db_path_);
+        loadDictionaries();
         recover();
+        storage_->setRecordReclaimedKeys(true);
     }
+
+    expiry_thread_ = std::thread(&TitanEngine::expiryLoop, this);
 }
 
 TitanEngine::~TitanEngine() {
@@ -46,6 +201,162 @@ void TitanEngine::trackWalActivity(size_t put_ops, size_t del_ops, size_t estima
     physical_write_bytes_total_.fetch_add(estimated_bytes);
 }
 
+// Evicted and actively expired keys are logged as deletes so they stay gone
+// after a restart, and reported to keyspace subscribers.
+void TitanEngine::logReclaimedKeys() {
+    if (!wal_ && !pubsub_->keyspaceActive()) return;
+
+    auto reclaimed = storage_->takeReclaimedKeys();
+    if (reclaimed.empty()) return;
+
+    if (wal_) {
+        size_t estimated_bytes = 0;
+        for (const auto& entry : reclaimed) {
+            wal_->logDel(entry.key);
+            estimated_bytes += 1 + 4 + entry.key.size() + 4;
+        }
+        trackWalActivity(0, reclaimed.size(), estimated_bytes);
+    }
+    for (const auto& entry : reclaimed) {
+        pubsub_->publishKeyEvent(entry.evicted ? "evicted" : "expired", entry.key);
+    }
+}
+
+// In-memory engines only collect reclaimed keys while someone listens to
+// keyspace events, and the write paths above do not drain them, so that
+// happens here after the write's own event.
+void TitanEngine::notifyKeyspace(const char* event, const std::string& key) {
+    if (!pubsub_->keyspaceActive()) return;
+
+    pubsub_->publishKeyEvent(event, key);
+    if (!wal_) logReclaimedKeys();
+}
+
+void TitanEngine::updateReclaimedKeyRecording() {
+    if (storage_) storage_->setRecordReclaimedKeys(wal_ != nullptr || pubsub_->keyspaceActive());
+}
+
+uint64_t TitanEngine::addSubscriber(std::function<void()> wake) {
+    return pubsub_->addSubscriber(std::move(wake));
+}
+
+void TitanEngine::removeSubscriber(uint64_t subscriber) {
+    pubsub_->removeSubscriber(subscriber);
+    updateReclaimedKeyRecording();
+}
+
+bool TitanEngine::subscribe(uint64_t subscriber, const std::string& channel) {
+    const bool added = pubsub_->subscribe(subscriber, channel);
+    updateReclaimedKeyRecording();
+    return added;
+}
+
+bool TitanEngine::unsubscribe(uint64_t subscriber, const std::string& channel) {
+    const bool removed = pubsub_->unsubscribe(subscriber, channel);
+    updateReclaimedKeyRecording();
+    return removed;
+}
+
+size_t TitanEngine::publish(const std::string& channel, const std::string& message, uint64_t origin,
+    std::vector<std::string>* origin_matches) {
+    return pubsub_->publish(channel, message, origin, origin_matches);
+}
+
+std::vector<PubSubMessage> TitanEngine::drainMessages(uint64_t subscriber) {
+    return pubsub_->drain(subscriber);
+}
+
+// Reclaims expired keys in slices until a slice comes back short or the
+// time budget is spent, similar to Redis's active expire cycle.
+void TitanEngine::runExpiryCycle(std::chrono::milliseconds budget) {
+    const auto deadline = std::chrono::steady_clock::now() + budget;
+    size_t removed = 0;
+    do {
+        removed = storage_->purgeExpired(kExpirySliceKeys);
+    } while (removed == kExpirySliceKeys && std::chrono::steady_clock::now() < deadline);
+
+    logReclaimedKeys();
+}
+
+void TitanEngine::expiryLoop() {
+    std::unique_lock lock(expiry_mutex_);
+    while (!expiry_stop_) {
+        if (expiry_interval_ms_ <= 0) {
+            expiry_cv_.wait(lock);
+            continue;
+        }
+
+        const auto interval = std::chrono::milliseconds(expiry_interval_ms_);
+        if (expiry_cv_.wait_for(lock, interval, [this] { return expiry_stop_; })) break;
+
+        lock.unlock();
+        try {
+            runExpiryCycle(std::max(interval / 4, std::chrono::milliseconds(1)));
+        } catch (...) {
+            // A failed cycle is retried on the next tick; reads still expire lazily.
+        }
+        lock.lock();
+    }
+}
+
+void TitanEngine::stopExpiryThread() {
+    {
+        std::lock_guard lock(expiry_mutex_);
+        expiry_stop_ = true;
+    }
+    expiry_cv_.notify_all();
+    if (expiry_thread_.joinable()) {
+        expiry_thread_.join();
+    }
+}
+
+void TitanEngine::setActiveExpiryInterval(int64_t interval_ms) {
+    {
+        std::lock_guard lock(expiry_mutex_);
+        expiry_interval_ms_ = interval_ms;
+    }
+    expiry_cv_.notify_all();
+}
+
+size_t TitanEngine::purgeExpired(size_t max_keys) {
+    const size_t removed = storage_->purgeExpired(max_keys);
+    logReclaimedKeys();
+    return removed;
+}
+
+// The WAL has no expiry-only record, so a changed expiry is logged by
+// re-writing the current frames with the new TTL.
+bool TitanEngine::logExpiryChange(const std::string& key, int64_t ttl_ms) {
+    const int64_t expires_at = expiryFromTtl(ttl_ms);
+    auto frames = storage_->setExpiry(key, expires_at);
+    if (!frames.has_value()) return false;
+
+    if (wal_) {
+        wal_->logPrecompressed(key, *frames, expires_at);
+        trackWalActivity(1, 0, 1 + 4 + 4 + key.size() + frames->size() + 8 + 4);
+        logReclaimedKeys();
+        maybeAutoCompact();
+    }
+    notifyKeyspace(expires_at != 0 ? "expire" : "persist", key);
+    return true;
+}
+
+bool TitanEngine::expire(const std::string& key, int64_t ttl_ms) {
+    if (ttl_ms <= 0) {
+        return del(key);
+    }
+    return logExpiryChange(key, ttl_ms);
+}
+
+bool TitanEngine::persist(const std::string& key) {
+    return logExpiryChange(key, 0);
+}
+
+int64_t TitanEngine::ttl(const std::string& key) {
+    auto remaining = storage_->ttl(key);
+    return remaining.has_value() ? *remaining : -2;
+}
+
 void TitanEngine::resetCompactionCountersFromWal() {
     wal_put_ops_.store(0);
     wal_del_ops_.store(0);
@@ -64,12 +375,16 @@ void TitanEngine::resetCompactionCountersFromWal() {
         }
     }
 
+    // Removals right after an INGEST record shadow its tables, which
+    // compaction keeps, so they cannot be reclaimed and count as live.
     auto entries = wal_->recover(RecoveryMode::Permissive);
+    bool after_ingest = false;
     for (const auto& entry : entries) {
-        if (entry.op == WalOp::PUT) {
-            wal_put_ops_.fetch_add(1);
-        } else if (entry.op == WalOp::DEL) {
+        after_ingest = entry.op == WalOp::INGEST || (after_ingest && entry.op == WalOp::DEL);
+        if (isRemovalOp(entry.op) && !after_ingest) {
             wal_del_ops_.fetch_add(1);
+        } else {
+            wal_put_ops_.fetch_add(1);
         }
     }
 }
@@ -147,46 +462,311 @@ void TitanEngine::recover() {
 
         resetCompactionCountersFromWal();
         writeRecoveryManifestSnapshot();
+        removeUnreferencedIngestFiles(db_path_, {});
         return;
     }
 
+    // A record whose deadline passed while the database was closed is replayed
+    // as a delete: it still has to shadow older versions of the key.
+    const int64_t replay_now = wallClockMs();
+    std::unordered_set<std::string> ingested;
     for (auto& entry : entries) {
-        if (entry.op == WalOp::PUT) {
-            storage_->putPrecompressed(entry.key, std::move(entry.value), entry.ttl_ms);
+        const bool carries_value = entry.op == WalOp::PUT || entry.op == WalOp::INCR;
+        if (carries_value && entry.expires_at != 0 && entry.expires_at <= replay_now) {
+            storage_->del(entry.key);
+        } else if (entry.op == WalOp::PUT) {
+            storage_->putPrecompressed(entry.key, std::move(entry.value), entry.expires_at);
+        } else if (entry.op == WalOp::INCR) {
+            if (entry.value.size() != sizeof(int64_t)) {
+                if (recovery_mode_ == RecoveryMode::Strict) throw std::runtime_error("corrupt WAL: truncated INCR record");
+                continue;
+            }
+            int64_t value = 0;
+            std::memcpy(&value, entry.value.data(), sizeof(value));
+            const auto frame = Compressor::encodeInteger(value);
+            storage_->putPrecompressed(entry.key, std::vector<uint8_t>(frame.begin(), frame.end()), entry.expires_at);
         } else if (entry.op == WalOp::DEL) {
             storage_->del(entry.key);
+        } else if (entry.op == WalOp::INGEST) {
+            std::vector<std::shared_ptr<SSTable>> tables;
+            for (auto& name : unpackValues(entry.value)) {
+                try {
+                    tables.push_back(storage_->openSSTable((db_path_ / name).string()));
+                } catch (...) {
+                    if (recovery_mode_ == RecoveryMode::Strict) throw;
+                }
+                ingested.insert(std::move(name));
+            }
+            storage_->ingest(tables);
+        } else {
+            replayCollectionOp(entry);
         }
     }
 
     resetCompactionCountersFromWal();
 
     writeRecoveryManifestSnapshot();
+    if (!db_path_.empty()) removeUnreferencedIngestFiles(db_path_, ingested);
+}
+
+void TitanEngine::replayCollectionOp(const LogEntry& entry) {
+    switch (entry.op) {
+        case WalOp::LPUSH:
+        case WalOp::RPUSH:
+            storage_->listPush(entry.key, unpackValues(entry.value), entry.op == WalOp::LPUSH);
+            break;
+        case WalOp::LPOP:
+        case WalOp::RPOP:
+            storage_->listPop(entry.key, entry.op == WalOp::LPOP);
+            break;
+        case WalOp::LSET: {
+            uint64_t index = 0;
+            if (entry.value.size() < sizeof(index)) {
+                if (recovery_mode_ == RecoveryMode::Strict) throw std::runtime_error("corrupt WAL: truncated LSET record");
+                break;
+            }
+            std::memcpy(&index, entry.value.data(), sizeof(index));
+            storage_->listSet(entry.key, static_cast<int64_t>(index),
+                std::string(entry.value.begin() + sizeof(index), entry.value.end()));
+            break;
+        }
+        case WalOp::ZADD:
+            storage_->zsetAdd(entry.key, unpackScoredMembers(entry.value));
+            break;
+        case WalOp::ZREM:
+            storage_->zsetRemove(entry.key, unpackValues(entry.value));
+            break;
+        case WalOp::HSET: {
+            auto items = unpackValues(entry.value);
+            if (items.size() % 2 != 0) {
+                if (recovery_mode_ == RecoveryMode::Strict) throw std::runtime_error("corrupt WAL: odd HSET record");
+                break;
+            }
+            std::vector<Storage::FieldValue> fields;
+            fields.reserve(items.size() / 2);
+            for (size_t i = 0; i < items.size(); i += 2) {
+                fields.emplace_back(std::move(items[i]), std::move(items[i + 1]));
+            }
+            storage_->hashSet(entry.key, fields);
+            break;
+        }
+        case WalOp::HDEL:
+            storage_->hashDel(entry.key, unpackValues(entry.value));
+            break;
+        case WalOp::SADD:
+            storage_->setAdd(entry.key, unpackValues(entry.value));
+            break;
+        case WalOp::SREM:
+            storage_->setRemove(entry.key, unpackValues(entry.value));
+            break;
+        case WalOp::DROP:
+            storage_->dropCollections(entry.key);
+            break;
+        default:
+            break;
+    }
+}
+
+// Dictionaries referenced by on-disk frames live next to the WAL so that data
+// stays readable even if a later open drops the policy that introduced them.
+void TitanEngine::loadDictionaries() {
+    const auto dict_dir = db_path_ / "dictionaries";
+    std::error_code ec;
+    if (!std::filesystem::exists(dict_dir, ec)) return;
+
+    for (const auto& entry : std::filesystem::directory_iterator(dict_dir, ec)) {
+        if (!entry.is_regular_file() || entry.path().extension() != ".zdict") continue;
+
+        std::ifstream in(entry.path(), std::ios::binary);
+        std::string dictionary((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+        try {
+            Compressor::registerDictionary(dictionary);
+        } catch (...) {
+            if (recovery_mode_ == RecoveryMode::Strict) throw;
+        }
+    }
+}
+
+void TitanEngine::persistDictionary(uint32_t dict_id, const std::string& dictionary) {
+    if (db_path_.empty()) return;
+
+    const auto dict_dir = db_path_ / "dictionaries";
+    const auto dict_path = dict_dir / (std::to_string(dict_id) + ".zdict");
+    if (std::filesystem::exists(dict_path)) return;
+
+    std::filesystem::create_directories(dict_dir);
+    const auto tmp_path = dict_path.string() + ".tmp";
+    {
+        std::ofstream out(tmp_path, std::ios::binary | std::ios::trunc);
+        out.write(dictionary.data(), static_cast<std::streamsize>(dictionary.size()));
+        if (!out) throw std::runtime_error("failed to persist compression dictionary");
+    }
+    std::filesystem::rename(tmp_path, dict_path);
+}
+
+void TitanEngine::setCompressionPolicies(const std::vector<CompressionPolicy>& policies) {
+    std::vector<std::pair<std::string, CompressionSpec>> specs;
+    specs.reserve(policies.size());
+
+    for (const auto& policy : policies) {
+        CompressionSpec spec;
+        spec.codec = policy.codec;
+        spec.level = policy.level;
+
+        if (!policy.dictionary.empty()) {
+            spec.dict_id = Compressor::registerDictionary(policy.dictionary);
+            persistDictionary(spec.dict_id, policy.dictionary);
+        }
+
+        specs.emplace_back(policy.prefix, spec);
+    }
+
+    storage_->setCompressionPolicies(std::move(specs));
+}
+
+std::vector<uint8_t> TitanEngine::compressValue(const std::string& key, const char* data, size_t size) const {
+    thread_local Compressor comp;
+    std::vector<uint8_t> frames;
+    if (size > 0) {
+        comp.compressAppend(data, size, storage_->compressionSpecFor(key), frames);
+    }
+    return frames;
+}
+
+void TitanEngine::setColdRecompressionPolicy(const ColdRecompressionPolicy& policy) {
+    std::lock_guard<std::mutex> lock(cold_mutex_);
+    cold_policy_ = policy;
+    if (cold_policy_.batch_size == 0) cold_policy_.batch_size = 1;
+}
+
+// Walks the memtable in key order, one slice at a time. Each slice is copied
+// under a shared lock, re-encoded with no lock held and swapped back in only
+// where the entry was not overwritten meanwhile.
+size_t TitanEngine::recompressCold() {
+    std::lock_guard<std::mutex> lock(cold_mutex_);
+    if (!cold_policy_.enabled) return 0;
+
+    constexpr size_t kDictionaryCapacity = 64 * 1024;
+    constexpr size_t kMaxSampleBytes = 128 * 1024;
+
+    thread_local Compressor comp;
+    size_t saved = 0;
+    std::string cursor;
+
+    while (true) {
+        auto slice = storage_->collectColdEntries(cold_policy_.idle_ms, cursor, cold_policy_.batch_size);
+        if (slice.empty()) break;
+        cursor = slice.back().first;
+
+        std::vector<std::string> raw_values;
+        raw_values.reserve(slice.size());
+        for (const auto& [_, compressed] : slice) {
+            raw_values.push_back(comp.decompress(compressed));
+        }
+
+        if (cold_policy_.train_dictionary && cold_dict_id_ == 0) {
+            std::vector<std::string> samples;
+            for (const auto& value : raw_values) {
+                if (value.size() <= kMaxSampleBytes) samples.push_back(value);
+            }
+            std::string dictionary = Compressor::trainDictionary(samples, kDictionaryCapacity);
+            if (!dictionary.empty()) {
+                cold_dict_id_ = Compressor::registerDictionary(dictionary);
+                persistDictionary(cold_dict_id_, dictionary);
+            }
+        }
+
+        CompressionSpec spec;
+        spec.level = cold_policy_.level;
+        spec.dict_id = cold_dict_id_;
+
+        std::vector<ColdReplacement> replacements;
+        replacements.reserve(slice.size());
+        size_t shrunk = 0;
+        for (size_t i = 0; i < slice.size(); i++) {
+            ColdReplacement r;
+            r.key = std::move(slice[i].first);
+            r.original = std::move(slice[i].second);
+            r.recompressed = comp.compress(raw_values[i], spec);
+            if (r.recompressed.size() < r.original.size()) shrunk++;
+            replacements.push_back(std::move(r));
+        }
+
+        saved += storage_->replaceColdEntries(std::move(replacements));
+        cold_recompressed_total_.fetch_add(shrunk);
+    }
+
+    cold_bytes_saved_total_.fetch_add(saved);
+    return saved;
 }
 
 void TitanEngine::put(const std::string& key, const std::string& value, int64_t ttl_ms) {
-    storage_->put(key, value, ttl_ms);
+    TITAN_ASSERT(!key.empty(), "key cannot be empty");
+
+    // Compress once and share the frames between the WAL and the memtable.
+    auto compressed = compressValue(key, value.data(), value.size());
+    const size_t estimated_bytes = 1 + 4 + 4 + key.size() + compressed.size() + 8 + 4;
+
+    const int64_t expires_at = expiryFromTtl(ttl_ms);
+    if (wal_) wal_->logPrecompressed(key, compressed, expires_at);
+    storage_->putPrecompressed(key, std::move(compressed), expires_at);
     logical_write_bytes_total_.fetch_add(value.size());
+
     if (wal_) {
-        wal_->logPut(key, value, ttl_ms, storage_->getCompressionLevel());
-        const size_t estimated_bytes = 1 + 4 + 4 + key.size() + value.size() + 8 + 4;
         trackWalActivity(1, 0, estimated_bytes);
+        logReclaimedKeys();
         maybeAutoCompact();
     }
+    notifyKeyspace("set", key);
 }
 
 std::optional<std::string> TitanEngine::get(const std::string& key) {
     return storage_->get(key);
 }
 
+std::optional<std::string> TitanEngine::getRange(const std::string& key, size_t offset, size_t length) {
+    return storage_->getRange(key, offset, length);
+}
+
+std::optional<size_t> TitanEngine::valueLength(const std::string& key) {
+    return storage_->valueLength(key);
+}
+
+std::vector<uint8_t> TitanEngine::compressChunk(const std::string& key, const std::string& chunk) const {
+    return compressValue(key, chunk.data(), chunk.size());
+}
+
+void TitanEngine::putCompressed(const std::string& key, std::vector<uint8_t>&& frames, int64_t ttl_ms) {
+    TITAN_ASSERT(!key.empty(), "key cannot be empty");
+    const size_t raw_size = Compressor::getDecompressedSize(frames);
+    const size_t estimated_bytes = 1 + 4 + 4 + key.size() + frames.size() + 8 + 4;
+
+    const int64_t expires_at = expiryFromTtl(ttl_ms);
+    if (wal_) wal_->logPrecompressed(key, frames, expires_at);
+    storage_->putPrecompressed(key, std::move(frames), expires_at);
+    logical_write_bytes_total_.fetch_add(raw_size);
+
+    if (wal_) {
+        trackWalActivity(1, 0, estimated_bytes);
+        logReclaimedKeys();
+        maybeAutoCompact();
+    }
+    notifyKeyspace("set", key);
+}
+
 bool TitanEngine::del(const std::string& key) {
-    bool deleted = storage_->del(key);
-    if (deleted && wal_) {
-        wal_->logDel(key);
-        const size_t estimated_bytes = 1 + 4 + key.size() + 4;
-        trackWalActivity(0, 1, estimated_bytes);
+    const bool deleted = storage_->del(key);
+    if (deleted && wal_) wal_->logDel(key);
+    std::function<void()> log;
+    if (wal_) log = [&] { wal_->logOp(WalOp::DROP, key, {}); };
+    const bool dropped = storage_->dropCollections(key, log);
+    if (wal_ && (deleted || dropped)) {
+        const size_t records = static_cast<size_t>(deleted) + static_cast<size_t>(dropped);
+        trackWalActivity(0, records, records * (1 + 4 + key.size() + 4));
         maybeAutoCompact();
     }
-    return deleted;
+    if (deleted) notifyKeyspace("del", key);
+    return deleted || dropped;
 }
 
 bool TitanEngine::has(const std::string& key) {
@@ -206,36 +786,196 @@ void TitanEngine::clear() {
     writeRecoveryManifestSnapshot();
 }
 
+// The counter is read, updated and re-encoded under the storage lock, and
+// logged as an INCR of the resulting value so replay is idempotent.
+// The result is logged from inside the storage update (see Storage::incrBy).
 int64_t TitanEngine::incr(const std::string& key, int64_t delta) {
-    auto val_opt = storage_->get(key);
-    int64_t val = 0;
-    if (val_opt) {
-        try {
-            val = std::stoll(*val_opt);
-        } catch (...) {
-            val = 0;
-        }
+    std::function<void(const Storage::IncrResult&)> log;
+    if (wal_) {
+        log = [&](const Storage::IncrResult& applied) {
+            std::vector<uint8_t> payload(sizeof(int64_t));
+            std::memcpy(payload.data(), &applied.value, sizeof(int64_t));
+            wal_->logOp(WalOp::INCR, key, payload, applied.expires_at);
+        };
     }
-    val += delta;
-    put(key, std::to_string(val));
-    return val;
+    const auto result = storage_->incrBy(key, delta, log);
+    if (!result.has_value()) throw std::runtime_error("value is not an integer or out of range");
+
+    logical_write_bytes_total_.fetch_add(result->raw_size);
+    if (wal_) {
+        trackWalActivity(1, 0, 1 + 4 + 4 + key.size() + sizeof(int64_t) + 8 + 4);
+        logReclaimedKeys();
+        maybeAutoCompact();
+    }
+    notifyKeyspace("incrby", key);
+    return result->value;
 }
 
 int64_t TitanEngine::decr(const std::string& key, int64_t delta) {
+    if (delta == std::numeric_limits<int64_t>::min()) throw std::runtime_error("increment would overflow");
     return incr(key, -delta);
 }
 
+VersionedValue TitanEngine::getWithVersion(const std::string& key) {
+    return storage_->getWithVersion(key);
+}
+
+uint64_t TitanEngine::version(const std::string& key) const {
+    return storage_->version(key);
+}
+
+// The frames are compressed before the storage lock is taken and only logged
+// once the condition held, so a failed attempt costs no WAL write.
+std::optional<uint64_t> TitanEngine::putIfVersion(const std::string& key, const std::string& value,
+    uint64_t expected_version, int64_t ttl_ms) {
+    TITAN_ASSERT(!key.empty(), "key cannot be empty");
+    auto compressed = compressValue(key, value.data(), value.size());
+    const int64_t expires_at = expiryFromTtl(ttl_ms);
+
+    const auto version = storage_->putIfVersion(key, compressed, expected_version, expires_at);
+    if (version.has_value()) logConditionalPut(key, compressed, value.size(), expires_at);
+    return version;
+}
+
+std::optional<uint64_t> TitanEngine::putIfAbsent(const std::string& key, const std::string& value, int64_t ttl_ms) {
+    TITAN_ASSERT(!key.empty(), "key cannot be empty");
+    auto compressed = compressValue(key, value.data(), value.size());
+    const int64_t expires_at = expiryFromTtl(ttl_ms);
+
+    const auto version = storage_->putIfAbsent(key, compressed, expires_at);
+    if (version.has_value()) logConditionalPut(key, compressed, value.size(), expires_at);
+    return version;
+}
+
+void TitanEngine::logConditionalPut(const std::string& key, const std::vector<uint8_t>& compressed, size_t raw_size,
+    int64_t expires_at) {
+    logical_write_bytes_total_.fetch_add(raw_size);
+    if (wal_) {
+        wal_->logPrecompressed(key, compressed, expires_at);
+        trackWalActivity(1, 0, 1 + 4 + 4 + key.size() + compressed.size() + 8 + 4);
+        logReclaimedKeys();
+        maybeAutoCompact();
+    }
+    notifyKeyspace("set", key);
+}
+
+size_t TitanEngine::lpush(const std::string& key, const std::vector<std::string>& values) {
+    return pushList(key, values, true);
+}
+
+size_t TitanEngine::rpush(const std::string& key, const std::vector<std::string>& values) {
+    return pushList(key, values, false);
+}
+
+// Only the pushed values are logged, never the list itself.
+size_t TitanEngine::pushList(const std::string& key, const std::vector<std::string>& values, bool front) {
+    TITAN_ASSERT(!key.empty(), "key cannot be empty");
+    if (values.empty()) return storage_->listLength(key);
+
+    std::vector<uint8_t> payload;
+    size_t logical_bytes = 0;
+    for (const auto& value : values) {
+        appendPackedValue(payload, value);
+        logical_bytes += value.size();
+    }
+
+    // Logged from inside the push (see Storage::listPush), so a push that
+    // throws is never logged and concurrent list writes reach the WAL in the
+    // order they were applied.
+    std::function<void()> log;
+    if (wal_) log = [&] { wal_->logOp(front ? WalOp::LPUSH : WalOp::RPUSH, key, payload); };
+    const size_t length = storage_->listPush(key, values, front, log);
+    logical_write_bytes_total_.fetch_add(logical_bytes);
+
+    if (wal_) {
+        trackWalActivity(1, 0, 1 + 4 + 4 + key.size() + payload.size() + 4);
+        logReclaimedKeys();
+        maybeAutoCompact();
+    }
+    return length;
+}
+
+std::optional<std::string> TitanEngine::lpop(const std::string& key) {
+    return popList(key, true);
+}
+
+std::optional<std::string> TitanEngine::rpop(const std::string& key) {
+    return popList(key, false);
+}
+
+std::optional<std::string> TitanEngine::popList(const std::string& key, bool front) {
+    std::function<void()> log;
+    if (wal_) log = [&] { wal_->logOp(front ? WalOp::LPOP : WalOp::RPOP, key, {}); };
+    auto value = storage_->listPop(key, front, log);
+    if (value.has_value() && wal_) {
+        trackWalActivity(0, 1, 1 + 4 + 4 + key.size() + 4);
+        maybeAutoCompact();
+    }
+    return value;
+}
+
+size_t TitanEngine::llen(const std::string& key) const {
+    return storage_->listLength(key);
+}
+
+std::vector<std::string> TitanEngine::lrange(const std::string& key, int64_t start, int64_t stop) const {
+    return storage_->listRange(key, start, stop);
+}
+
+std::optional<std::string> TitanEngine::lindex(const std::string& key, int64_t index) const {
+    return storage_->listIndex(key, index);
+}
+
+// Logged with the resolved index so replay does not depend on the sign.
+bool TitanEngine::lset(const std::string& key, int64_t index, const std::string& value) {
+    std::function<void(size_t)> log;
+    if (wal_) {
+        log = [&](size_t position) {
+            const uint64_t resolved = position;
+            std::vector<uint8_t> payload(sizeof(resolved));
+            std::memcpy(payload.data(), &resolved, sizeof(resolved));
+            payload.insert(payload.end(), value.begin(), value.end());
+            wal_->logOp(WalOp::LSET, key, payload);
+        };
+    }
+    const auto position = storage_->listSet(key, index, value, log);
+    if (!position.has_value()) return false;
+
+    if (wal_) {
+        trackWalActivity(1, 0, 1 + 4 + 4 + key.size() + sizeof(uint64_t) + value.size() + 4);
+        logReclaimedKeys();
+        maybeAutoCompact();
+    }
+    logical_write_bytes_total_.fetch_add(value.size());
+    return true;
+}
+
 std::vector<std::string> TitanEngine::keys(size_t limit) const {
-    return storage_->keys(limit);
+    return keys(IterateOptions{}, limit);
 }
 
 std::vector<TitanEngine::KVPair> TitanEngine::scan(const std::string& prefix, size_t limit) const {
-    return storage_->scan(prefix, limit);
+    IterateOptions options;
+    options.prefix = prefix;
+    return scan(options, limit);
 }
 
 std::vector<TitanEngine::KVPair> TitanEngine::range(
     const std::string& start, const std::string& end, size_t limit) const {
-    return storage_->range(start, end, limit);
+    IterateOptions options;
+    options.start = start;
+    options.end = end;
+    return scan(options, limit);
+}
+
+std::vector<std::string> TitanEngine::keys(const IterateOptions& options, size_t limit,
+                                           const std::optional<std::string>& after) const {
+    return storage_->keys(options, after, limit);
+}
+
+std::vector<TitanEngine::KVPair> TitanEngine::scan(const IterateOptions& options, size_t limit,
+                                                   const std::optional<std::string>& after) const {
+    return storage_->scan(options, after, limit);
 }
 
 size_t TitanEngine::countPrefix(const std::string& prefix) const {
@@ -249,10 +989,8 @@ void TitanEngine::putBatch(const std::vector<KVPair>& pairs) {
     compressed_batch.reserve(pairs.size());
     size_t total_raw_size = 0;
 
-    Compressor comp;
-    int level = storage_->getCompressionLevel();
     for (const auto& [k, v] : pairs) {
-        compressed_batch.push_back({k, comp.compress(v, level)});
+        compressed_batch.push_back({k, compressValue(k, v.data(), v.size())});
         total_raw_size += v.size();
         logical_write_bytes_total_.fetch_add(v.size());
     }
@@ -267,14 +1005,402 @@ void TitanEngine::putBatch(const std::vector<KVPair>& pairs) {
 
     if (wal_) {
         trackWalActivity(pairs.size(), 0, estimated_bytes);
+        logReclaimedKeys();
         maybeAutoCompact();
     }
+    for (const auto& pair : pairs) notifyKeyspace("set", pair.first);
+}
+
+std::optional<std::vector<WriteResult>> TitanEngine::write(const WriteBatch& batch) {
+    if (batch.empty() && batch.watches().empty()) return std::vector<WriteResult>{};
+
+    // Per wrapped WAL record: op, key and value lengths, expiry.
+    constexpr size_t kBatchEntryOverhead = 1 + 4 + 4 + 8;
+
+    std::vector<BatchWrite> writes;
+    writes.reserve(batch.size());
+    size_t logical_bytes = 0;
+    size_t packed_bytes = 0;
+    for (const auto& op : batch.ops()) {
+        TITAN_ASSERT(!op.key.empty(), "key cannot be empty");
+        BatchWrite write;
+        write.key = op.key;
+        switch (op.kind) {
+            case WriteBatch::OpKind::Put:
+                write.kind = BatchWrite::Kind::Put;
+                write.frames = compressValue(op.key, op.value.data(), op.value.size());
+                write.expires_at = expiryFromTtl(op.ttl_ms);
+                logical_bytes += op.value.size();
+                packed_bytes += kBatchEntryOverhead + op.key.size() + write.frames.size();
+                break;
+            case WriteBatch::OpKind::Del:
+                write.kind = BatchWrite::Kind::Del;
+                // A DEL and a DROP at most.
+                packed_bytes += 2 * (kBatchEntryOverhead + op.key.size());
+                break;
+            case WriteBatch::OpKind::Incr:
+                write.kind = BatchWrite::Kind::Incr;
+                write.delta = op.delta;
+                packed_bytes += kBatchEntryOverhead + op.key.size() + Compressor::kIntegerFrameBytes;
+                break;
+        }
+        writes.push_back(std::move(write));
+    }
+    // Checked up front so an oversized batch is rejected before it is applied.
+    if (wal_ && packed_bytes > Compressor::kMaxValueBytes) throw std::runtime_error("write batch too large");
+
+    // Logged under the storage lock so that concurrent batches and counter
+    // updates reach the WAL in the order they were applied.
+    size_t put_ops = 0;
+    size_t del_ops = 0;
+    size_t estimated_bytes = 0;
+    std::function<void(const std::vector<BatchWrite>&)> log;
+    if (wal_) {
+        log = [&](const std::vector<BatchWrite>& applied) {
+            std::vector<LogEntry> entries;
+            for (const auto& write : applied) {
+                if (!write.error.empty()) continue;
+                if (write.kind == BatchWrite::Kind::Del) {
+                    if (write.result != 0) entries.push_back({WalOp::DEL, write.key, {}, 0});
+                    if (write.dropped_collections) entries.push_back({WalOp::DROP, write.key, {}, 0});
+                    continue;
+                }
+                entries.push_back({WalOp::PUT, write.key, write.frames, write.expires_at});
+            }
+            if (entries.empty()) return;
+            estimated_bytes = 1 + 4 + 4 + entries.front().key.size() + 4;
+            for (const auto& entry : entries) {
+                estimated_bytes += kBatchEntryOverhead + entry.key.size() + entry.value.size();
+                if (entry.op == WalOp::PUT) {
+                    put_ops++;
+                } else {
+                    del_ops++;
+                }
+            }
+            wal_->logBatch(entries);
+        };
+    }
+    if (!storage_->applyBatch(writes, batch.watches(), log)) return std::nullopt;
+
+    std::vector<WriteResult> results;
+    results.reserve(writes.size());
+    for (auto& write : writes) {
+        if (!write.error.empty()) {
+            results.push_back({0, std::move(write.error)});
+            continue;
+        }
+        if (write.kind == BatchWrite::Kind::Del) {
+            results.push_back({write.result != 0 || write.dropped_collections ? 1 : 0, {}});
+            continue;
+        }
+        results.push_back({write.kind == BatchWrite::Kind::Incr ? write.result : 0, {}});
+        if (write.kind == BatchWrite::Kind::Incr) logical_bytes += Compressor::getDecompressedSize(write.frames);
+    }
+    logical_write_bytes_total_.fetch_add(logical_bytes);
+
+    if (wal_ && put_ops + del_ops > 0) {
+        trackWalActivity(put_ops, del_ops, estimated_bytes);
+        logReclaimedKeys();
+        maybeAutoCompact();
+    }
+    for (size_t i = 0; i < writes.size(); i++) {
+        if (!results[i].error.empty()) continue;
+        const auto& key = writes[i].key;
+        switch (writes[i].kind) {
+            case BatchWrite::Kind::Put: notifyKeyspace("set", key); break;
+            case BatchWrite::Kind::Incr: notifyKeyspace("incrby", key); break;
+            case BatchWrite::Kind::Del:
+                if (writes[i].result != 0) notifyKeyspace("del", key);
+                break;
+        }
+    }
+    return results;
 }
 
 std::vector<std::optional<std::string>> TitanEngine::getBatch(const std::vector<std::string>& keys) {
     return storage_->getBatch(keys);
 }
 
+std::unique_ptr<TitanIterator> TitanEngine::iterate(const IterateOptions& options) {
+    if (!storage_) throw std::runtime_error("database is closed");
+    return std::unique_ptr<TitanIterator>(new TitanIterator(*this, options, storage_->pinSnapshot()));
+}
+
+std::unique_ptr<TitanSnapshot> TitanEngine::snapshot() {
+    if (!storage_) throw std::runtime_error("database is closed");
+    return std::unique_ptr<TitanSnapshot>(new TitanSnapshot(*this, storage_->pinSnapshot()));
+}
+
+std::unique_ptr<TitanExporter> TitanEngine::exportNdjson(const IterateOptions& options, int compression_level) {
+    return std::unique_ptr<TitanExporter>(new TitanExporter(iterate(options), compression_level));
+}
+
+Storage& TitanEngine::openStorage() const {
+    if (!storage_) throw std::runtime_error("database is closed");
+    return *storage_;
+}
+
+TitanIterator::TitanIterator(TitanEngine& engine, IterateOptions options,
+    std::shared_ptr<const StorageSnapshot> snapshot)
+    : engine_(engine), options_(std::move(options)), snapshot_(std::move(snapshot)) {}
+
+TitanIterator::~TitanIterator() = default;
+
+std::vector<TitanIterator::KVPair> TitanIterator::next(size_t max_entries) {
+    TITAN_ASSERT(max_entries > 0, "chunk size must be positive");
+    if (done_) return {};
+
+    auto chunk = engine_.openStorage().scanAt(*snapshot_, options_, last_key_, max_entries);
+    if (!chunk.empty()) last_key_ = chunk.back().first;
+    if (chunk.size() < max_entries) {
+        // Release the pin as soon as nothing more will be read.
+        done_ = true;
+        snapshot_.reset();
+    }
+    return chunk;
+}
+
+TitanSnapshot::TitanSnapshot(TitanEngine& engine, std::shared_ptr<const StorageSnapshot> snapshot)
+    : engine_(engine), snapshot_(std::move(snapshot)) {}
+
+TitanSnapshot::~TitanSnapshot() = default;
+
+std::optional<std::string> TitanSnapshot::get(const std::string& key) const {
+    return engine_.openStorage().getAt(*snapshot_, key);
+}
+
+bool TitanSnapshot::has(const std::string& key) const {
+    return engine_.openStorage().hasAt(*snapshot_, key);
+}
+
+std::vector<std::string> TitanSnapshot::keys(const IterateOptions& options, size_t limit,
+                                             const std::optional<std::string>& after) const {
+    return engine_.openStorage().keysAt(*snapshot_, options, after, limit);
+}
+
+std::vector<TitanSnapshot::KVPair> TitanSnapshot::scan(const IterateOptions& options, size_t limit,
+                                                       const std::optional<std::string>& after) const {
+    return engine_.openStorage().scanAt(*snapshot_, options, after, limit);
+}
+
+std::unique_ptr<TitanIterator> TitanSnapshot::iterate(const IterateOptions& options) const {
+    return std::unique_ptr<TitanIterator>(new TitanIterator(engine_, options, snapshot_));
+}
+
+std::unique_ptr<TitanExporter> TitanSnapshot::exportNdjson(const IterateOptions& options,
+                                                          int compression_level) const {
+    return std::unique_ptr<TitanExporter>(new TitanExporter(iterate(options), compression_level));
+}
+
+uint64_t TitanSnapshot::sequence() const {
+    return snapshot_->sequence;
+}
+
+TitanExporter::TitanExporter(std::unique_ptr<TitanIterator> iterator, int compression_level)
+    : iterator_(std::move(iterator)) {
+    if (compression_level > 0) {
+        compressor_ = std::make_unique<Compressor>();
+        compressor_->beginStream(compression_level);
+    }
+}
+
+TitanExporter::~TitanExporter() = default;
+
+std::string TitanExporter::next(size_t chunk_bytes) {
+    TITAN_ASSERT(chunk_bytes > 0, "chunk size must be positive");
+    std::string out;
+    if (done_) return out;
+
+    std::string lines;
+    while (out.size() < chunk_bytes && !iterator_->done()) {
+        lines.clear();
+        for (const auto& [key, value] : iterator_->next(kExportBatch)) {
+            lines += "{\"key\":";
+            appendJsonString(lines, key);
+            lines += ",\"value\":";
+            if (isValidUtf8(value)) {
+                appendJsonString(lines, value);
+                lines += "}\n";
+            } else {
+                lines.push_back('"');
+                appendBase64(lines, value);
+                lines += "\",\"encoding\":\"base64\"}\n";
+            }
+            records_++;
+        }
+        if (compressor_) {
+            compressor_->compressStream(lines, iterator_->done(), out);
+        } else {
+            out += lines;
+        }
+    }
+    done_ = iterator_->done();
+    return out;
+}
+
+size_t TitanEngine::zadd(const std::string& key, const std::vector<ScoredMember>& members) {
+    TITAN_ASSERT(!key.empty(), "key cannot be empty");
+    if (members.empty()) return 0;
+
+    std::vector<uint8_t> payload;
+    for (const auto& [member, score] : members) appendScoredMember(payload, member, score);
+    const size_t added = storage_->zsetAdd(key, members, collectionLog(WalOp::ZADD, key, payload));
+    trackCollectionWrite(key, payload);
+    return added;
+}
+
+// Logged as a ZADD of the resulting score, so replay is idempotent. The
+// record is written from inside the storage update (see Storage::incrBy).
+double TitanEngine::zincrby(const std::string& key, const std::string& member, double delta) {
+    std::vector<uint8_t> payload;
+    const double score = storage_->zsetIncrBy(key, member, delta, [&](double applied) {
+        appendScoredMember(payload, member, applied);
+        if (wal_) wal_->logOp(WalOp::ZADD, key, payload);
+    });
+    trackCollectionWrite(key, payload);
+    return score;
+}
+
+size_t TitanEngine::zrem(const std::string& key, const std::vector<std::string>& members) {
+    std::vector<uint8_t> payload;
+    for (const auto& member : members) appendPackedValue(payload, member);
+    const size_t removed = storage_->zsetRemove(key, members, collectionLog(WalOp::ZREM, key, payload));
+    if (removed > 0) trackCollectionRemoval(key, payload);
+    return removed;
+}
+
+std::optional<double> TitanEngine::zscore(const std::string& key, const std::string& member) const {
+    return storage_->zsetScore(key, member);
+}
+
+std::optional<size_t> TitanEngine::zrank(const std::string& key, const std::string& member, bool reverse) const {
+    return storage_->zsetRank(key, member, reverse);
+}
+
+size_t TitanEngine::zcard(const std::string& key) const {
+    return storage_->zsetCard(key);
+}
+
+std::vector<TitanEngine::ScoredMember> TitanEngine::zrange(const std::string& key, int64_t start, int64_t stop, bool reverse) const {
+    return storage_->zsetRange(key, start, stop, reverse);
+}
+
+std::vector<TitanEngine::ScoredMember> TitanEngine::zrangeByScore(const std::string& key, double min, double max,
+                                                                  size_t offset, size_t count, bool reverse) const {
+    return storage_->zsetRangeByScore(key, min, max, offset, count, reverse);
+}
+
+size_t TitanEngine::zcount(const std::string& key, double min, double max) const {
+    return storage_->zsetCount(key, min, max);
+}
+
+size_t TitanEngine::hset(const std::string& key, const std::vector<FieldValue>& fields) {
+    TITAN_ASSERT(!key.empty(), "key cannot be empty");
+    if (fields.empty()) return 0;
+
+    std::vector<uint8_t> payload;
+    for (const auto& [field, value] : fields) {
+        appendPackedValue(payload, field);
+        appendPackedValue(payload, value);
+    }
+    const size_t added = storage_->hashSet(key, fields, collectionLog(WalOp::HSET, key, payload));
+    trackCollectionWrite(key, payload);
+    return added;
+}
+
+std::optional<std::string> TitanEngine::hget(const std::string& key, const std::string& field) const {
+    return storage_->hashGet(key, field);
+}
+
+size_t TitanEngine::hdel(const std::string& key, const std::vector<std::string>& fields) {
+    std::vector<uint8_t> payload;
+    for (const auto& field : fields) appendPackedValue(payload, field);
+    const size_t removed = storage_->hashDel(key, fields, collectionLog(WalOp::HDEL, key, payload));
+    if (removed > 0) trackCollectionRemoval(key, payload);
+    return removed;
+}
+
+size_t TitanEngine::hlen(const std::string& key) const {
+    return storage_->hashLength(key);
+}
+
+std::vector<TitanEngine::FieldValue> TitanEngine::hgetall(const std::string& key) const {
+    return storage_->hashGetAll(key);
+}
+
+// Logged as an HSET of the resulting value, like zincrby.
+int64_t TitanEngine::hincrby(const std::string& key, const std::string& field, int64_t delta) {
+    std::vector<uint8_t> payload;
+    const auto value = storage_->hashIncrBy(key, field, delta, [&](int64_t applied) {
+        appendPackedValue(payload, field);
+        appendPackedValue(payload, std::to_string(applied));
+        if (wal_) wal_->logOp(WalOp::HSET, key, payload);
+    });
+    if (!value.has_value()) throw std::runtime_error("hash value is not an integer");
+
+    trackCollectionWrite(key, payload);
+    return *value;
+}
+
+size_t TitanEngine::sadd(const std::string& key, const std::vector<std::string>& members) {
+    TITAN_ASSERT(!key.empty(), "key cannot be empty");
+    if (members.empty()) return 0;
+
+    std::vector<uint8_t> payload;
+    for (const auto& member : members) appendPackedValue(payload, member);
+    // Members already present are not logged.
+    const size_t added = storage_->setAdd(key, members, collectionLog(WalOp::SADD, key, payload));
+    if (added > 0) trackCollectionWrite(key, payload);
+    return added;
+}
+
+size_t TitanEngine::srem(const std::string& key, const std::vector<std::string>& members) {
+    std::vector<uint8_t> payload;
+    for (const auto& member : members) appendPackedValue(payload, member);
+    const size_t removed = storage_->setRemove(key, members, collectionLog(WalOp::SREM, key, payload));
+    if (removed > 0) trackCollectionRemoval(key, payload);
+    return removed;
+}
+
+bool TitanEngine::sismember(const std::string& key, const std::string& member) const {
+    return storage_->setIsMember(key, member);
+}
+
+size_t TitanEngine::scard(const std::string& key) const {
+    return storage_->setCard(key);
+}
+
+std::vector<std::string> TitanEngine::smembers(const std::string& key) const {
+    return storage_->setMembers(key);
+}
+
+// Collection records are logged as deltas, so they must reach the WAL in
+// the order the writes were applied: the storage write runs this under its
+// lock. Empty without a WAL.
+std::function<void()> TitanEngine::collectionLog(WalOp op, const std::string& key,
+                                                 const std::vector<uint8_t>& payload) {
+    if (!wal_) return {};
+    return [this, op, &key, &payload] { wal_->logOp(op, key, payload); };
+}
+
+// Accounting for a collection removal whose record is already in the WAL.
+void TitanEngine::trackCollectionRemoval(const std::string& key, const std::vector<uint8_t>& payload) {
+    if (!wal_) return;
+
+    trackWalActivity(0, 1, 1 + 4 + 4 + key.size() + payload.size() + 4);
+    maybeAutoCompact();
+}
+
+// Accounting for a collection write whose record is already in the WAL.
+void TitanEngine::trackCollectionWrite(const std::string& key, const std::vector<uint8_t>& payload) {
+    logical_write_bytes_total_.fetch_add(payload.size());
+    if (!wal_) return;
+
+    trackWalActivity(1, 0, 1 + 4 + 4 + key.size() + payload.size() + 4);
+    logReclaimedKeys();
+    maybeAutoCompact();
+}
+
 void TitanEngine::flush() {
     if (wal_) wal_->flush();
 }
@@ -282,15 +1408,81 @@ void TitanEngine::flush() {
 void TitanEngine::compactInternal(bool auto_triggered) {
     if (!wal_) return;
 
-    auto snapshot = storage_->snapshot();
+    // Cold values are re-encoded first so the rewritten WAL carries the
+    // smaller frames.
+    recompressCold();
+
+    // Ingested tables that still serve keys are not folded in: the INGEST
+    // record naming them comes first, then the removals of their keys, and
+    // everything else is logged on top. The lock keeps an ingest from
+    // landing between the snapshot and the rewrite.
+    std::unique_lock<std::mutex> ingest_lock(ingest_mutex_);
+    auto snapshot = storage_->compactionSnapshot();
     std::vector<LogEntry> entries;
-    entries.reserve(snapshot.size());
+    entries.reserve(1 + snapshot.deleted.size() + snapshot.entries.size());
 
-    for (auto& [k, v] : snapshot) {
-        entries.push_back({WalOp::PUT, std::move(k), std::move(v)});
+    if (!snapshot.ingested.empty()) {
+        std::vector<uint8_t> payload;
+        for (const auto& file : snapshot.ingested) {
+            const auto name = std::filesystem::path(kIngestDirectory) / std::filesystem::path(file).filename();
+            appendPackedValue(payload, name.generic_string());
+        }
+        entries.push_back({WalOp::INGEST, kIngestDirectory, std::move(payload)});
+    }
+    for (auto& key : snapshot.deleted) {
+        entries.push_back({WalOp::DEL, std::move(key), {}});
+    }
+    for (auto& entry : snapshot.entries) {
+        entries.push_back({WalOp::PUT, std::move(entry.key), std::move(entry.frames), entry.expires_at});
+    }
+
+    // Lists are rewritten as one RPUSH per chunk.
+    for (auto& [key, chunks] : storage_->listSnapshot()) {
+        for (auto& chunk : chunks) {
+            entries.push_back({WalOp::RPUSH, key, std::move(chunk)});
+        }
+    }
+
+    // Sorted sets are rewritten as ZADD records of about one list chunk each.
+    for (auto& [key, members] : storage_->zsetSnapshot()) {
+        std::vector<uint8_t> payload;
+        for (const auto& [member, score] : members) {
+            appendScoredMember(payload, member, score);
+            if (payload.size() >= QuickList::kChunkBytes) {
+                entries.push_back({WalOp::ZADD, key, std::move(payload)});
+                payload.clear();
+            }
+        }
+        if (!payload.empty()) entries.push_back({WalOp::ZADD, key, std::move(payload)});
+    }
+
+    // Hashes and sets are rewritten in batches the same way.
+    for (auto& [key, fields] : storage_->hashSnapshot()) {
+        std::vector<uint8_t> payload;
+        for (const auto& [field, value] : fields) {
+            appendPackedValue(payload, field);
+            appendPackedValue(payload, value);
+            if (payload.size() >= QuickList::kChunkBytes) {
+                entries.push_back({WalOp::HSET, key, std::move(payload)});
+                payload.clear();
+            }
+        }
+        if (!payload.empty()) entries.push_back({WalOp::HSET, key, std::move(payload)});
+    }
+    for (auto& [key, members] : storage_->setSnapshot()) {
+        std::vector<uint8_t> payload;
+        for (const auto& member : members) {
+            appendPackedValue(payload, member);
+            if (payload.size() >= QuickList::kChunkBytes) {
+                entries.push_back({WalOp::SADD, key, std::move(payload)});
+                payload.clear();
+            }
+        }
+        if (!payload.empty()) entries.push_back({WalOp::SADD, key, std::move(payload)});
     }
 
     wal_->compact(entries);
+    ingest_lock.unlock();
     std::error_code ec;
     if (std::filesystem::exists(wal_->path(), ec)) {
         const size_t compacted_wal_size = std::filesystem::file_size(wal_->path(), ec);
@@ -337,6 +1529,12 @@ void TitanEngine::setCompressionLevel(int level) {
 
 void TitanEngine::setMaxMemoryBytes(size_t limit_bytes) {
     storage_->setMaxMemoryBytes(limit_bytes);
+    logReclaimedKeys();
+}
+
+void TitanEngine::setEvictionConfig(const EvictionConfig& config) {
+    storage_->setEvictionConfig(config);
+    logReclaimedKeys();
 }
 
 void TitanEngine::setSSTableBloomFilterEnabled(bool enabled) {
@@ -377,6 +1575,8 @@ StorageStats TitanEngine::getStats() const {
     stats.physical_write_bytes = physical_write_bytes_total_.load();
     stats.compaction_count = compaction_count_total_.load();
     stats.auto_compaction_count = auto_compaction_count_total_.load();
+    stats.cold_recompressed_count = cold_recompressed_total_.load();
+    stats.cold_bytes_saved = cold_bytes_saved_total_.load();
 
     if (stats.logical_write_bytes > 0) {
         stats.write_amplification = static_cast<double>(stats.physical_write_bytes)
@@ -395,13 +1595,145 @@ StorageStats TitanEngine::getStats() const {
     return stats;
 }
 
+uint64_t TitanEngine::publishSnapshot() {
+    if (db_path_.empty() || !storage_) {
+        throw std::runtime_error("read snapshots require an open persistent database");
+    }
+
+    // Only the process holding the WAL lock publishes, so the next
+    // generation can be taken from CURRENT.
+    std::lock_guard lock(publish_mutex_);
+    const uint64_t generation = ReadSnapshot::currentGeneration(db_path_) + 1;
+    ReadSnapshot::publish(db_path_, generation, storage_->snapshot());
+    return generation;
+}
+
+CheckpointResult TitanEngine::checkpoint(const std::string& dir) {
+    if (!wal_ || !storage_) {
+        throw std::runtime_error("checkpoints require an open persistent database");
+    }
+
+    const std::filesystem::path target(dir);
+    std::error_code ec;
+    if (std::filesystem::exists(target, ec) && std::filesystem::equivalent(target, db_path_, ec)) {
+        throw std::runtime_error("checkpoint directory must differ from the database directory");
+    }
+    std::filesystem::create_directories(target);
+
+    // Keys reclaimed since the last write are logged first, so the copy
+    // does not bring them back.
+    logReclaimedKeys();
+
+    ManifestStore manifest_store(target);
+    RecoveryManifest previous;
+    const bool has_previous = manifest_store.load(previous);
+    const auto wal_name = wal_->path().filename();
+    const WalCopy copy = wal_->copyTo(target / wal_name, has_previous ? previous.wal_lineage : 0,
+                                      has_previous ? previous.wal_size_bytes : 0);
+
+    // The WAL holds the whole state, and recovery only falls back to
+    // SSTables when it is empty, so stale ones from a reused directory go.
+    std::filesystem::remove_all(target / "sstables", ec);
+
+    // Ingested tables are immutable and only removed when the database is
+    // opened, so every one the copied log names is complete by now and a
+    // link is as good as a copy.
+    {
+        std::lock_guard<std::mutex> lock(ingest_mutex_);
+        linkImmutableFiles(db_path_ / kIngestDirectory, target / kIngestDirectory);
+    }
+
+    // Frames compressed with a trained dictionary cannot be read without it.
+    // A dictionary is persisted before any frame uses it, so those the copied
+    // log needs are all in place; half-written .tmp files are skipped.
+    linkImmutableFiles(db_path_ / "dictionaries", target / "dictionaries",
+                       [](const std::filesystem::path& file) { return file.extension() == ".zdict"; });
+
+    RecoveryManifest manifest;
+    manifest.updated_at_ms = wallClockMs();
+    manifest.wal_file = wal_name.string();
+    manifest.wal_format = wal_->usesChecksummedFormat() ? "checksummed" : "legacy";
+    manifest.wal_size_bytes = copy.size;
+    manifest.wal_lineage = copy.lineage;
+    manifest_store.save(manifest);
+
+    return {copy.size, copy.copied};
+}
+
+size_t TitanEngine::ingest(const std::vector<std::string>& files, bool move) {
+    Storage& storage = openStorage();
+    if (!wal_) throw std::runtime_error("ingest requires a persistent database");
+    if (files.empty()) return 0;
+
+    std::lock_guard<std::mutex> lock(ingest_mutex_);
+    const auto ingest_dir = db_path_ / kIngestDirectory;
+    std::filesystem::create_directories(ingest_dir);
+
+    // Every file is staged under a fresh name and checked before anything
+    // refers to it; until the WAL record is written a failure puts moved
+    // files back and drops the copies.
+    struct StagedFile {
+        std::filesystem::path source;
+        std::filesystem::path target;
+        bool renamed = false;
+    };
+    std::vector<StagedFile> staged;
+    std::vector<std::shared_ptr<SSTable>> tables;
+    std::vector<uint8_t> payload;
+    size_t records = 0;
+    try {
+        for (const auto& file : files) {
+            const std::string name = "ingest-" + std::to_string(wallClockMs()) + "-"
+                + std::to_string(ingest_seq_++) + ".sst";
+            StagedFile item{file, ingest_dir / name};
+            if (move) {
+                std::error_code ec;
+                std::filesystem::rename(item.source, item.target, ec);
+                item.renamed = !ec;
+            }
+            if (!item.renamed) std::filesystem::copy_file(item.source, item.target);
+            staged.push_back(item);
+
+            auto table = storage.openSSTable(item.target.string());
+            table->verifyOrder();
+            records += table->size();
+            tables.push_back(std::move(table));
+            appendPackedValue(payload, (std::filesystem::path(kIngestDirectory) / name).generic_string());
+        }
+        wal_->logOp(WalOp::INGEST, kIngestDirectory, payload);
+    } catch (...) {
+        std::error_code ec;
+        for (const auto& item : staged) {
+            if (item.renamed) {
+                std::filesystem::rename(item.target, item.source, ec);
+            } else {
+                std::filesystem::remove(item.target, ec);
+            }
+        }
+        throw;
+    }
+
+    storage.ingest(tables);
+    if (move) {
+        // Files that had to be copied across file systems.
+        std::error_code ec;
+        for (const auto& item : staged) {
+            if (!item.renamed) std::filesystem::remove(item.source, ec);
+        }
+    }
+    return records;
+}
+
 void TitanEngine::close() {
+    stopExpiryThread();
+
     if (compaction_thread_.joinable()) {
         compaction_thread_.join();
     }
 
     if (storage_) {
         storage_->flushSpillState();
+        logReclaimedKeys();
     }
 
     if (wal_) {
@@ -419,7 +1751,7 @@ void TitanEngine::writeRecoveryManifestSnapshot() {
 
     ManifestStore manifest_store(db_path_);
     RecoveryManifest manifest;
-    manifest.updated_at_ms = unixNowMs();
+    manifest.updated_at_ms = wallClockMs();
 
     if (wal_) {
         manifest.wal_file = wal_->path().filename().string();
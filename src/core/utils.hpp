@@ -1,9 +1,12 @@
 #pragma once
 
+#include <chrono>
+#include <cstdint>
 #include <stdexcept>
 #include <string>
 #include <format>
 #include <source_location>
+#include <cstddef>
 
 namespace titan {
 
@@ -17,4 +20,34 @@ inline void TITAN_ASSERT(bool condition, const std::string& message,
     }
 }
 
+// Rough per-node cost of a node-based tree container: parent/left/right links
+// and colour, before the stored value itself.
+inline constexpr size_t kTreeNodeOverhead = 4 * sizeof(void*);
+
+// Heap bytes a string owns beyond its own object; zero while the contents
+// still fit the small-string buffer.
+template <typename String>
+inline size_t stringHeapBytes(const String& s) {
+    static const size_t inline_capacity = String().capacity();
+    return s.capacity() > inline_capacity ? s.capacity() + 1 : 0;
+}
+
+// Expirations are absolute Unix milliseconds so they stay meaningful across
+// restarts; access times use the monotonic clock.
+inline int64_t wallClockMs() {
+    using namespace std::chrono;
+    return duration_cast<milliseconds>(system_clock::now().time_since_epoch()).count();
+}
+
+inline int64_t steadyClockMs() {
+    using namespace std::chrono;
+    return duration_cast<milliseconds>(steady_clock::now().time_since_epoch()).count();
+}
+
+// Maps a steady-clock deadline written by an older format onto wall-clock
+// time. Exact while the host has not rebooted since it was written.
+inline int64_t steadyToWallClockMs(int64_t steady_ms) {
+    return steady_ms - steadyClockMs() + wallClockMs();
+}
+
 } // namespace titan
@@ -1,7 +1,11 @@
 #include "wal.hpp"
 #include "checksum.hpp"
+#include <algorithm>
 #include <cstring>
 #include <array>
+#include <optional>
+#include <random>
+#include <span>
 
 #ifndef _WIN32
 #include <fcntl.h>
@@ -14,21 +18,105 @@ namespace titan {
 namespace {
 constexpr const char* kWalFileName = "titan.tkv";
 constexpr const char* kLegacyWalFileName = "titan.t";
-constexpr std::array<uint8_t, 8> kWalMagic{{'T', 'K', 'V', 'W', 'A', 'L', '3', '\n'}};
+constexpr std::array<uint8_t, 8> kWalMagic{{'T', 'K', 'V', 'W', 'A', 'L', '4', '\n'}};
+constexpr std::array<uint8_t, 8> kWalMagicV3{{'T', 'K', 'V', 'W', 'A', 'L', '3', '\n'}};
+
+uint64_t newLineage() {
+    std::random_device device;
+    return (static_cast<uint64_t>(device()) << 32) | device();
+}
+
+bool isRecordOp(WalOp op) {
+    switch (op) {
+        case WalOp::PUT:
+        case WalOp::DEL:
+        case WalOp::LPUSH:
+        case WalOp::RPUSH:
+        case WalOp::LPOP:
+        case WalOp::RPOP:
+        case WalOp::LSET:
+        case WalOp::DROP:
+        case WalOp::ZADD:
+        case WalOp::ZREM:
+        case WalOp::HSET:
+        case WalOp::HDEL:
+        case WalOp::SADD:
+        case WalOp::SREM:
+        case WalOp::INCR:
+        case WalOp::BATCH:
+        case WalOp::INGEST:
+            return true;
+        default:
+            return false;
+    }
+}
+
+// Every record but the deletes has a value section; only PUT and INCR have
+// an expiry.
+bool carriesValue(WalOp op) { return op != WalOp::DEL && op != WalOp::DROP; }
+bool carriesExpiry(WalOp op) { return op == WalOp::PUT || op == WalOp::INCR; }
+
+template <typename T>
+void appendScalar(std::vector<uint8_t>& out, T value) {
+    const auto* bytes = reinterpret_cast<const uint8_t*>(&value);
+    out.insert(out.end(), bytes, bytes + sizeof(value));
+}
+
+template <typename T>
+bool readScalar(std::span<const uint8_t> in, size_t& pos, T& value) {
+    if (in.size() - pos < sizeof(value)) return false;
+    std::memcpy(&value, in.data() + pos, sizeof(value));
+    pos += sizeof(value);
+    return true;
 }
 
-bool WAL::isChecksummedWalFile(const std::filesystem::path& path) {
+// Unwraps a BATCH value; expiries are left in their stored form. Returns
+// nullopt when the payload is malformed.
+std::optional<std::vector<LogEntry>> unpackBatch(std::span<const uint8_t> in) {
+    std::vector<LogEntry> entries;
+    size_t pos = 0;
+    while (pos < in.size()) {
+        uint8_t op_byte = 0;
+        uint32_t klen = 0;
+        uint32_t vlen = 0;
+        if (!readScalar(in, pos, op_byte) || !readScalar(in, pos, klen) || !readScalar(in, pos, vlen)) {
+            return std::nullopt;
+        }
+        const auto op = static_cast<WalOp>(op_byte);
+        if (!isRecordOp(op) || op == WalOp::BATCH || klen == 0) return std::nullopt;
+        if (in.size() - pos < static_cast<size_t>(klen) + vlen) return std::nullopt;
+
+        LogEntry entry{op, std::string(reinterpret_cast<const char*>(in.data() + pos), klen), {}, 0};
+        pos += klen;
+        entry.value.assign(in.begin() + static_cast<std::ptrdiff_t>(pos), in.begin() + static_cast<std::ptrdiff_t>(pos + vlen));
+        pos += vlen;
+        if (!readScalar(in, pos, entry.expires_at)) return std::nullopt;
+        entries.push_back(std::move(entry));
+    }
+    return entries;
+}
+}
+
+// 4 and 3 are checksummed formats; 0 is the headerless legacy layout.
+int WAL::readFormatVersion(const std::filesystem::path& path) {
     std::ifstream in(path, std::ios::binary);
     if (!in.is_open()) {
-        return false;
+        return 0;
     }
 
     std::array<uint8_t, kWalMagic.size()> header{};
     if (!in.read(reinterpret_cast<char*>(header.data()), static_cast<std::streamsize>(header.size()))) {
-        return false;
+        return 0;
     }
 
-    return header == kWalMagic;
+    if (header == kWalMagic) return 4;
+    if (header == kWalMagicV3) return 3;
+    return 0;
+}
+
+int64_t WAL::encodeExpiry(int64_t expires_at, bool wall_clock) {
+    if (expires_at == 0 || wall_clock) return expires_at;
+    return std::max<int64_t>(1, expires_at - wallClockMs());
 }
 
 void WAL::writeWalMagicHeader(std::ofstream& out) {
@@ -122,9 +210,12 @@ WAL::WAL(const std::filesystem::path& dir) {
     const auto wal_size = wal_exists ? std::filesystem::file_size(path_, size_ec) : 0;
 
     if (wal_exists && wal_size > 0) {
-        checksummed_format_ = isChecksummedWalFile(path_);
+        const int version = readFormatVersion(path_);
+        checksummed_format_ = version >= 3;
+        wall_clock_expiry_ = version >= 4;
     } else {
         checksummed_format_ = true;
+        wall_clock_expiry_ = true;
         std::ofstream init(path_, std::ios::binary | std::ios::trunc);
         if (!init.is_open()) {
             throw std::runtime_error("failed to initialize WAL file: " + path_.string());
@@ -138,7 +229,7 @@ WAL::WAL(const std::filesystem::path& dir) {
     if (!file_.is_open()) {
         throw std::runtime_error("failed to open WAL file: " + path_.string());
     }
-    compressor_ = std::make_unique<Compressor>();
+    lineage_ = newLineage();
 }
 
 WAL::~WAL() {
@@ -163,50 +254,58 @@ WAL::~WAL() {
 #endif
 }
 
-void WAL::writeEntry(WalOp op, const std::string& key, const std::vector<uint8_t>& value, int64_t ttl_ms) {
+void WAL::appendRecord(std::ostream& out, bool checksummed, WalOp op, const std::string& key,
+    const std::vector<uint8_t>& value, int64_t expiry_field) {
     uint32_t klen = static_cast<uint32_t>(key.size());
     uint32_t vlen = static_cast<uint32_t>(value.size());
     uint8_t op_byte = static_cast<uint8_t>(op);
 
     TITAN_ASSERT(klen > 0, "empty key in WAL write");
 
-    if (!checksummed_format_) {
-        file_.write(reinterpret_cast<const char*>(&op_byte), 1);
-        file_.write(reinterpret_cast<const char*>(&klen), 4);
-        if (op == WalOp::PUT) {
-            file_.write(reinterpret_cast<const char*>(&vlen), 4);
+    if (!checksummed) {
+        out.write(reinterpret_cast<const char*>(&op_byte), 1);
+        out.write(reinterpret_cast<const char*>(&klen), 4);
+        if (carriesValue(op)) {
+            out.write(reinterpret_cast<const char*>(&vlen), 4);
+        }
+        out.write(key.data(), klen);
+        if (carriesValue(op)) {
+            out.write(reinterpret_cast<const char*>(value.data()), vlen);
         }
-        file_.write(key.data(), klen);
-        if (op == WalOp::PUT) {
-            file_.write(reinterpret_cast<const char*>(value.data()), vlen);
-            file_.write(reinterpret_cast<const char*>(&ttl_ms), 8);
+        if (carriesExpiry(op)) {
+            out.write(reinterpret_cast<const char*>(&expiry_field), 8);
         }
         return;
     }
 
     std::vector<uint8_t> payload;
-    payload.reserve(1 + 4 + (op == WalOp::PUT ? 4 : 0) + key.size() + value.size() + (op == WalOp::PUT ? 8 : 0));
+    payload.reserve(1 + 4 + (carriesValue(op) ? 4 : 0) + key.size() + value.size() + (carriesExpiry(op) ? 8 : 0));
 
     payload.push_back(op_byte);
     payload.insert(payload.end(), reinterpret_cast<const uint8_t*>(&klen), reinterpret_cast<const uint8_t*>(&klen) + sizeof(klen));
-    if (op == WalOp::PUT) {
+    if (carriesValue(op)) {
         payload.insert(payload.end(), reinterpret_cast<const uint8_t*>(&vlen), reinterpret_cast<const uint8_t*>(&vlen) + sizeof(vlen));
     }
     payload.insert(payload.end(), key.begin(), key.end());
-    if (op == WalOp::PUT) {
+    if (carriesValue(op)) {
         payload.insert(payload.end(), value.begin(), value.end());
-        payload.insert(payload.end(), reinterpret_cast<const uint8_t*>(&ttl_ms), reinterpret_cast<const uint8_t*>(&ttl_ms) + sizeof(ttl_ms));
+    }
+    if (carriesExpiry(op)) {
+        payload.insert(payload.end(), reinterpret_cast<const uint8_t*>(&expiry_field), reinterpret_cast<const uint8_t*>(&expiry_field) + sizeof(expiry_field));
     }
 
     const uint32_t checksum = fnv1a32(payload.data(), payload.size());
-    file_.write(reinterpret_cast<const char*>(payload.data()), static_cast<std::streamsize>(payload.size()));
-    file_.write(reinterpret_cast<const char*>(&checksum), static_cast<std::streamsize>(sizeof(checksum)));
+    out.write(reinterpret_cast<const char*>(payload.data()), static_cast<std::streamsize>(payload.size()));
+    out.write(reinterpret_cast<const char*>(&checksum), static_cast<std::streamsize>(sizeof(checksum)));
 }
 
-void WAL::logPut(const std::string& key, const std::string& value, int64_t ttl_ms, int compression_level) {
+void WAL::writeEntry(WalOp op, const std::string& key, const std::vector<uint8_t>& value, int64_t expires_at) {
+    appendRecord(file_, checksummed_format_, op, key, value, encodeExpiry(expires_at, wall_clock_expiry_));
+}
+
+void WAL::logPrecompressed(const std::string& key, const std::vector<uint8_t>& compressed, int64_t expires_at) {
     std::lock_guard<std::mutex> lock(mutex_);
-    auto compressed = compressor_->compress(value, compression_level);
-    writeEntry(WalOp::PUT, key, compressed, ttl_ms);
+    writeEntry(WalOp::PUT, key, compressed, expires_at);
     file_.flush();
 }
 
@@ -224,6 +323,33 @@ void WAL::logDel(const std::string& key) {
     file_.flush();
 }
 
+void WAL::logOp(WalOp op, const std::string& key, const std::vector<uint8_t>& payload, int64_t expires_at) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    writeEntry(op, key, payload, expires_at);
+    file_.flush();
+}
+
+void WAL::logBatch(const std::vector<LogEntry>& entries) {
+    if (entries.empty()) return;
+
+    std::vector<uint8_t> packed;
+    for (const auto& entry : entries) {
+        TITAN_ASSERT(entry.op != WalOp::BATCH && !entry.key.empty(), "invalid WAL batch entry");
+        appendScalar(packed, static_cast<uint8_t>(entry.op));
+        appendScalar(packed, static_cast<uint32_t>(entry.key.size()));
+        appendScalar(packed, static_cast<uint32_t>(entry.value.size()));
+        packed.insert(packed.end(), entry.key.begin(), entry.key.end());
+        packed.insert(packed.end(), entry.value.begin(), entry.value.end());
+        appendScalar(packed, encodeExpiry(entry.expires_at, wall_clock_expiry_));
+    }
+    if (packed.size() > Compressor::kMaxValueBytes) throw std::runtime_error("write batch too large");
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    // The record key is informational; recovery only reads the wrapped ones.
+    appendRecord(file_, checksummed_format_, WalOp::BATCH, entries.front().key, packed, 0);
+    file_.flush();
+}
+
 void WAL::flush() {
     std::lock_guard<std::mutex> lock(mutex_);
     file_.flush();
@@ -240,13 +366,31 @@ std::vector<LogEntry> WAL::recover(RecoveryMode mode) {
         }
     };
 
+    const int64_t replay_now = wallClockMs();
+    auto decodeExpiry = [&](int64_t stored) -> int64_t {
+        if (stored <= 0) return 0;
+        return wall_clock_expiry_ ? stored : replay_now + stored;
+    };
+    auto appendBatch = [&](const std::vector<uint8_t>& value) {
+        auto batch = unpackBatch(value);
+        if (!batch.has_value()) {
+            handleCorruption("corrupt WAL: malformed batch record");
+            return false;
+        }
+        for (auto& entry : *batch) {
+            entry.expires_at = decodeExpiry(entry.expires_at);
+            entries.push_back(std::move(entry));
+        }
+        return true;
+    };
+
     if (checksummed_format_) {
         std::array<uint8_t, kWalMagic.size()> header{};
         if (!in.read(reinterpret_cast<char*>(header.data()), static_cast<std::streamsize>(header.size()))) {
             handleCorruption("corrupt WAL: missing magic header");
             return entries;
         }
-        if (header != kWalMagic) {
+        if (header != (wall_clock_expiry_ ? kWalMagic : kWalMagicV3)) {
             handleCorruption("corrupt WAL: invalid magic header");
             return entries;
         }
@@ -261,7 +405,7 @@ std::vector<LogEntry> WAL::recover(RecoveryMode mode) {
             payload.push_back(op_byte);
 
             WalOp op = static_cast<WalOp>(op_byte);
-            if (op != WalOp::PUT && op != WalOp::DEL) {
+            if (!isRecordOp(op)) {
                 handleCorruption("corrupt WAL: invalid operation code");
                 break;
             }
@@ -280,14 +424,14 @@ std::vector<LogEntry> WAL::recover(RecoveryMode mode) {
             }
 
             uint32_t vlen = 0;
-            if (op == WalOp::PUT) {
+            if (carriesValue(op)) {
                 if (!in.read(reinterpret_cast<char*>(&vlen), 4)) {
                     handleCorruption("corrupt WAL: truncated value length");
                     break;
                 }
                 payload.insert(payload.end(), reinterpret_cast<const uint8_t*>(&vlen), reinterpret_cast<const uint8_t*>(&vlen) + sizeof(vlen));
 
-                constexpr uint32_t MAX_VALUE_SIZE = 100 * 1024 * 1024;
+                constexpr uint32_t MAX_VALUE_SIZE = static_cast<uint32_t>(Compressor::kMaxValueBytes);
                 if (vlen > MAX_VALUE_SIZE) {
                     handleCorruption("corrupt WAL: invalid value length");
                     break;
@@ -302,20 +446,21 @@ std::vector<LogEntry> WAL::recover(RecoveryMode mode) {
             payload.insert(payload.end(), key.begin(), key.end());
 
             std::vector<uint8_t> value;
-            int64_t ttl_ms = 0;
-            if (op == WalOp::PUT) {
+            int64_t expiry_field = 0;
+            if (carriesValue(op)) {
                 value.resize(vlen);
                 if (!in.read(reinterpret_cast<char*>(value.data()), static_cast<std::streamsize>(vlen))) {
                     handleCorruption("corrupt WAL: truncated value payload");
                     break;
                 }
                 payload.insert(payload.end(), value.begin(), value.end());
-
-                if (!in.read(reinterpret_cast<char*>(&ttl_ms), 8)) {
+            }
+            if (carriesExpiry(op)) {
+                if (!in.read(reinterpret_cast<char*>(&expiry_field), 8)) {
                     handleCorruption("corrupt WAL: truncated ttl payload");
                     break;
                 }
-                payload.insert(payload.end(), reinterpret_cast<const uint8_t*>(&ttl_ms), reinterpret_cast<const uint8_t*>(&ttl_ms) + sizeof(ttl_ms));
+                payload.insert(payload.end(), reinterpret_cast<const uint8_t*>(&expiry_field), reinterpret_cast<const uint8_t*>(&expiry_field) + sizeof(expiry_field));
             }
 
             uint32_t stored_checksum = 0;
@@ -330,7 +475,11 @@ std::vector<LogEntry> WAL::recover(RecoveryMode mode) {
                 break;
             }
 
-            entries.push_back({op, std::move(key), std::move(value), ttl_ms});
+            if (op == WalOp::BATCH) {
+                if (!appendBatch(value)) break;
+                continue;
+            }
+            entries.push_back({op, std::move(key), std::move(value), decodeExpiry(expiry_field)});
         }
 
         return entries;
@@ -340,7 +489,7 @@ std::vector<LogEntry> WAL::recover(RecoveryMode mode) {
         uint8_t op_byte;
         if (!in.read(reinterpret_cast<char*>(&op_byte), 1)) break;
         WalOp op = static_cast<WalOp>(op_byte);
-        if (op != WalOp::PUT && op != WalOp::DEL) {
+        if (!isRecordOp(op)) {
             handleCorruption("corrupt WAL: invalid operation code");
             break;
         }
@@ -358,12 +507,12 @@ std::vector<LogEntry> WAL::recover(RecoveryMode mode) {
         }
 
         uint32_t vlen = 0;
-        if (op == WalOp::PUT) {
+        if (carriesValue(op)) {
             if (!in.read(reinterpret_cast<char*>(&vlen), 4)) {
                 handleCorruption("corrupt WAL: truncated value length");
                 break;
             }
-            constexpr uint32_t MAX_VALUE_SIZE = 100 * 1024 * 1024; // 100MB
+            constexpr uint32_t MAX_VALUE_SIZE = static_cast<uint32_t>(Compressor::kMaxValueBytes);
             if (vlen > MAX_VALUE_SIZE) {
                 handleCorruption("corrupt WAL: value length too large");
                 break;
@@ -377,20 +526,26 @@ std::vector<LogEntry> WAL::recover(RecoveryMode mode) {
         }
 
         std::vector<uint8_t> value;
-        int64_t ttl_ms = 0;
-        if (op == WalOp::PUT) {
+        int64_t expiry_field = 0;
+        if (carriesValue(op)) {
             value.resize(vlen);
             if (!in.read(reinterpret_cast<char*>(value.data()), vlen)) {
                 handleCorruption("corrupt WAL: truncated value payload");
                 break;
             }
-            if (!in.read(reinterpret_cast<char*>(&ttl_ms), 8)) {
+        }
+        if (carriesExpiry(op)) {
+            if (!in.read(reinterpret_cast<char*>(&expiry_field), 8)) {
                 handleCorruption("corrupt WAL: truncated ttl payload");
                 break;
             }
         }
 
-        entries.push_back({op, std::move(key), std::move(value), ttl_ms});
+        if (op == WalOp::BATCH) {
+            if (!appendBatch(value)) break;
+            continue;
+        }
+        entries.push_back({op, std::move(key), std::move(value), decodeExpiry(expiry_field)});
     }
     return entries;
 }
@@ -421,33 +576,8 @@ void WAL::compact(const std::vector<LogEntry>& active_entries) {
     }
 
     for (const auto& entry : active_entries) {
-        uint32_t klen = static_cast<uint32_t>(entry.key.size());
-        uint32_t vlen = static_cast<uint32_t>(entry.value.size());
-        uint8_t op_byte = static_cast<uint8_t>(WalOp::PUT);
-        int64_t ttl_ms = entry.ttl_ms;
-
-        if (!checksummed_format_) {
-            out.write(reinterpret_cast<const char*>(&op_byte), 1);
-            out.write(reinterpret_cast<const char*>(&klen), 4);
-            out.write(reinterpret_cast<const char*>(&vlen), 4);
-            out.write(entry.key.data(), klen);
-            out.write(reinterpret_cast<const char*>(entry.value.data()), vlen);
-            out.write(reinterpret_cast<const char*>(&ttl_ms), 8);
-            continue;
-        }
-
-        std::vector<uint8_t> payload;
-        payload.reserve(1 + 4 + 4 + entry.key.size() + entry.value.size() + 8);
-        payload.push_back(op_byte);
-        payload.insert(payload.end(), reinterpret_cast<const uint8_t*>(&klen), reinterpret_cast<const uint8_t*>(&klen) + sizeof(klen));
-        payload.insert(payload.end(), reinterpret_cast<const uint8_t*>(&vlen), reinterpret_cast<const uint8_t*>(&vlen) + sizeof(vlen));
-        payload.insert(payload.end(), entry.key.begin(), entry.key.end());
-        payload.insert(payload.end(), entry.value.begin(), entry.value.end());
-        payload.insert(payload.end(), reinterpret_cast<const uint8_t*>(&ttl_ms), reinterpret_cast<const uint8_t*>(&ttl_ms) + sizeof(ttl_ms));
-
-        const uint32_t checksum = fnv1a32(payload.data(), payload.size());
-        out.write(reinterpret_cast<const char*>(payload.data()), static_cast<std::streamsize>(payload.size()));
-        out.write(reinterpret_cast<const char*>(&checksum), sizeof(checksum));
+        appendRecord(out, checksummed_format_, entry.op, entry.key, entry.value,
+            encodeExpiry(entry.expires_at, checksummed_format_));
     }
     out.flush();
     out.close();
@@ -478,10 +608,70 @@ void WAL::compact(const std::vector<LogEntry>& active_entries) {
         ec.clear();
     }
 
+    // A checksummed WAL is rewritten in the current format.
+    wall_clock_expiry_ = checksummed_format_;
+    lineage_ = newLineage();
+
     file_.open(path_, std::ios::binary | std::ios::app);
     if (!file_.is_open()) {
         throw std::runtime_error("failed to reopen WAL after compact: " + path_.string());
     }
 }
 
+WalCopy WAL::copyTo(const std::filesystem::path& target, uint64_t lineage, uint64_t reuse_bytes) {
+    std::ifstream in;
+    WalCopy copy;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        file_.flush();
+        in.open(path_, std::ios::binary | std::ios::ate);
+        if (!in.is_open()) {
+            throw std::runtime_error("failed to open WAL for checkpoint: " + path_.string());
+        }
+        copy.size = static_cast<uint64_t>(in.tellg());
+        copy.lineage = lineage_;
+    }
+
+    std::error_code ec;
+    const bool append = lineage == copy.lineage && reuse_bytes <= copy.size
+        && std::filesystem::exists(target, ec) && std::filesystem::file_size(target, ec) == reuse_bytes && !ec;
+    const uint64_t offset = append ? reuse_bytes : 0;
+
+    // A full copy goes through a temp file so an interrupted one never
+    // leaves a truncated log under the final name.
+    auto write_path = target;
+    if (!append) write_path += ".tmp";
+    std::ofstream out(write_path, std::ios::binary | (append ? std::ios::app : std::ios::trunc));
+    if (!out.is_open()) {
+        throw std::runtime_error("failed to write checkpoint WAL: " + write_path.string());
+    }
+
+    in.seekg(static_cast<std::streamoff>(offset));
+    std::vector<char> buffer(1024 * 1024);
+    uint64_t remaining = copy.size - offset;
+    while (remaining > 0) {
+        const auto chunk = static_cast<std::streamsize>(std::min<uint64_t>(remaining, buffer.size()));
+        in.read(buffer.data(), chunk);
+        if (in.gcount() != chunk) {
+            throw std::runtime_error("failed to read WAL for checkpoint: " + path_.string());
+        }
+        out.write(buffer.data(), chunk);
+        remaining -= static_cast<uint64_t>(chunk);
+    }
+    out.flush();
+    if (!out) {
+        throw std::runtime_error("failed to write checkpoint WAL: " + write_path.string());
+    }
+    out.close();
+
+    if (!append) {
+        std::filesystem::rename(write_path, target, ec);
+        if (ec) {
+            throw std::runtime_error("failed to finalize checkpoint WAL: " + target.string());
+        }
+    }
+    copy.copied = copy.size - offset;
+    return copy;
+}
+
 } // namespace titan
@@ -19,14 +19,55 @@ namespace titan {
 enum class WalOp : uint8_t {
     PUT = 1,
     DEL = 2,
-    CHECKPOINT = 3
+    CHECKPOINT = 3,
+    // List deltas. Pushes carry appendPackedValue() items, LSET an 8-byte
+    // index followed by the new value, pops nothing.
+    LPUSH = 4,
+    RPUSH = 5,
+    LPOP = 6,
+    RPOP = 7,
+    LSET = 8,
+    // Removes every native collection under the key; DEL only touches the
+    // plain value.
+    DROP = 9,
+    // Sorted set deltas: ZADD carries appendScoredMember() pairs with their
+    // final scores, ZREM appendPackedValue() members.
+    ZADD = 10,
+    ZREM = 11,
+    // Field-level hash and set deltas: HSET carries alternating field and
+    // value items, the others the fields or members they touch, all in
+    // appendPackedValue() form.
+    HSET = 12,
+    HDEL = 13,
+    SADD = 14,
+    SREM = 15,
+    // Counter update: the resulting value as 8 bytes plus the
+    // key's expiry, so replay overwrites instead of re-adding.
+    INCR = 16,
+    // Several PUT/DEL/DROP records wrapped in one: the value holds each as
+    // op, key length, value length, key, value and expiry, and the whole
+    // batch shares one checksum so recovery replays all of it or none.
+    BATCH = 17,
+    // SSTables added by TitanEngine::ingest(): the value lists their paths
+    // relative to the data directory as appendPackedValue() items. The key
+    // only satisfies the record format.
+    INGEST = 18
+};
+
+struct WalCopy {
+    // Bytes of log the copy holds.
+    uint64_t size = 0;
+    // Bytes written by this copy; less than `size` when it only appended.
+    uint64_t copied = 0;
+    uint64_t lineage = 0;
 };
 
 struct LogEntry {
     WalOp op;
     std::string key;
     std::vector<uint8_t> value;
-    int64_t ttl_ms = 0;
+    // Unix ms; 0 when the key has no TTL.
+    int64_t expires_at = 0;
 };
 
 class WAL {
@@ -37,14 +78,26 @@ public:
     WAL(const WAL&) = delete;
     WAL& operator=(const WAL&) = delete;
 
-    void logPut(const std::string& key, const std::string& value, int64_t ttl_ms = 0, int compression_level = 3);
+    void logPrecompressed(const std::string& key, const std::vector<uint8_t>& compressed, int64_t expires_at = 0);
     void logPrecompressedBatch(const std::vector<std::pair<std::string, std::vector<uint8_t>>>& batch);
     void logDel(const std::string& key);
+    void logOp(WalOp op, const std::string& key, const std::vector<uint8_t>& payload, int64_t expires_at = 0);
+    // Writes the entries as one BATCH record and flushes once. Recovery
+    // returns them unwrapped.
+    void logBatch(const std::vector<LogEntry>& entries);
 
     std::vector<LogEntry> recover(RecoveryMode mode);
     void compact(const std::vector<LogEntry>& active_entries);
     void flush();
 
+    // Copies the log as it stands into `target`. Only the end offset is
+    // fixed under the log lock: the bytes are read afterwards through a
+    // handle opened at the same time, which stays valid because records are
+    // only appended and compaction swaps the file by rename. When `lineage`
+    // is the current one and `target` holds exactly `reuse_bytes`, only the
+    // bytes past them are appended.
+    WalCopy copyTo(const std::filesystem::path& target, uint64_t lineage, uint64_t reuse_bytes);
+
     const std::filesystem::path& path() const { return path_; }
     bool usesChecksummedFormat() const { return checksummed_format_; }
 
@@ -53,8 +106,14 @@ private:
     std::filesystem::path lock_path_;
     std::ofstream file_;
     std::mutex mutex_;
-    std::unique_ptr<Compressor> compressor_;
     bool checksummed_format_ = false;
+    // Random tag of the current file contents. It changes whenever the log
+    // stops being an extension of what an earlier copy saw: on open, since
+    // another process may have rewritten it, and on every compaction.
+    uint64_t lineage_ = 0;
+    // v4 files store absolute expirations; v3 and legacy files store a TTL
+    // relative to the moment the record was replayed.
+    bool wall_clock_expiry_ = false;
 
 #ifdef _WIN32
     HANDLE lock_handle_ = INVALID_HANDLE_VALUE;
@@ -62,9 +121,12 @@ private:
     int lock_fd_ = -1;
 #endif
 
-    void writeEntry(WalOp op, const std::string& key, const std::vector<uint8_t>& value, int64_t ttl_ms = 0);
-    static bool isChecksummedWalFile(const std::filesystem::path& path);
+    void writeEntry(WalOp op, const std::string& key, const std::vector<uint8_t>& value, int64_t expires_at = 0);
+    static void appendRecord(std::ostream& out, bool checksummed, WalOp op, const std::string& key,
+        const std::vector<uint8_t>& value, int64_t expiry_field);
+    static int readFormatVersion(const std::filesystem::path& path);
     static void writeWalMagicHeader(std::ofstream& out);
+    static int64_t encodeExpiry(int64_t expires_at, bool wall_clock);
     void recoverCompactionArtifacts();
 };
 
@@ -1,4 +1,4 @@
-const { TitanKV } = require('../lib');
+const { TitanKV, TitanReader } = require('../lib');
 const { spawn } = require('child_process');
 const path = require('path');
 const fs = require('fs');
@@ -15,6 +15,11 @@ if (process.argv[2] === 'worker') {
     } catch (e) {
         console.log('WORKER_ERROR: ' + e.message);
     }
+
+    // Read snapshots need no lock
+    const reader = new TitanReader(testDir, { refreshIntervalMs: 0 })
+    console.log('WORKER_READ: ' + reader.get('shared'))
+    reader.close()
     return;
 }
 
@@ -25,6 +30,8 @@ console.log('╚═════════════════════
 // Master opens the DB first
 const db = new TitanKV(testDir);
 console.log('  \u2192 Master Process Opened DB natively');
+db.put('shared', 'from-master')
+db.publishSnapshot()
 
 const worker = spawn(process.execPath, [__filename, 'worker']);
 let out = '';
@@ -39,4 +46,11 @@ worker.on('close', () => {
         console.error('  \u2717 IPC File Locking FAILED! Output:', out);
         process.exit(1);
     }
+
+    if (out.includes('WORKER_READ: from-master')) {
+        console.log('  \u2713 Read snapshot served to secondary process without the lock');
+    } else {
+        console.error('  \u2717 Read snapshot FAILED! Output:', out);
+        process.exit(1);
+    }
 });
@@ -1,4 +1,4 @@
-const { TitanKV } = require('../lib');
+const { TitanKV, TitanReader, SSTableWriter } = require('../lib');
 const fs = require('fs');
 const path = require('path');
 
@@ -24,6 +24,54 @@ async function runTests() {
         console.log(`\u2514${'─'.repeat(57)}\u2518`);
     }
 
+    // Writes through a fresh database in test/<name>, then hands it to check
+    // after a restart and again after a compaction; pauseMs passes while it
+    // is closed.
+    async function roundTrip(name, write, check, pauseMs = 0) {
+        const dir = path.join(__dirname, name);
+        try { fs.rmSync(dir, { recursive: true, force: true }); } catch {}
+        const first = new TitanKV(dir);
+        write(first);
+        first.close();
+        for (const stage of ['restart', 'compaction']) {
+            if (pauseMs > 0) await new Promise(r => setTimeout(r, pauseMs));
+            const reopened = new TitanKV(dir);
+            check(reopened, stage);
+            if (stage === 'restart') reopened.compact();
+            reopened.close();
+        }
+        try { fs.rmSync(dir, { recursive: true, force: true }); } catch {}
+    }
+
+    // Runs script in four workers sharing the database in test/<name> (each
+    // sees db and t), then returns what read gives live and after a restart,
+    // which has to match whatever order the writes were applied in.
+    async function raceReplay(name, seed, script, read) {
+        const { Worker } = require('worker_threads');
+        const dir = path.join(__dirname, name);
+        try { fs.rmSync(dir, { recursive: true, force: true }); } catch {}
+        const first = new TitanKV(dir);
+        seed(first);
+        await Promise.all([0, 1, 2, 3].map(t => new Promise((resolve, reject) => {
+            const worker = new Worker(`
+                const { workerData: { dir, t } } = require('worker_threads');
+                const { TitanKV } = require(${JSON.stringify(path.join(__dirname, '..', 'lib'))});
+                const db = new TitanKV(dir);
+                ${script}
+                db.close();
+            `, { eval: true, workerData: { dir, t } });
+            worker.once('exit', resolve);
+            worker.once('error', reject);
+        })));
+        const live = read(first);
+        first.close();
+        const reopened = new TitanKV(dir);
+        const replayed = read(reopened);
+        reopened.close();
+        try { fs.rmSync(dir, { recursive: true, force: true }); } catch {}
+        return [live, replayed];
+    }
+
     // === Core ===
     section('Core Operations');
 
@@ -60,6 +108,13 @@ async function runTests() {
     test('incr delta', db.incr('counter', 10) === 12);
     test('decr', db.decr('counter') === 11);
     test('decr delta', db.decr('counter', 5) === 6);
+    test('counter reads as text', db.get('counter') === '6');
+    db.put('counter:text', 'abc');
+    let incrNaN = false;
+    try { db.incr('counter:text'); } catch { incrNaN = true; }
+    test('incr non-integer throws', incrNaN && db.get('counter:text') === 'abc');
+    db.put('counter:ttl', '41', 60000);
+    test('incr keeps ttl', db.incr('counter:ttl') === 42 && db.ttl('counter:ttl') > 0);
 
     // === Batch ===
     section('Batch Operations');
@@ -84,6 +139,205 @@ async function runTests() {
     test('putBatchAsync does not throw', asyncBatchErr === null);
     test('getBatchAsync returns expected values', asyncBatch[0] === '10' && asyncBatch[1] === '20' && asyncBatch[2] === null && asyncBatch[3] === '30');
 
+    // === Binary values ===
+    section('Binary Values (Buffer / Uint8Array)');
+
+    db.clear();
+    const binPayload = Buffer.from([0x00, 0xff, 0x10, 0x80, 0x00, 0x7f]);
+    db.put('bin:1', binPayload);
+    const binOut = db.getBuffer('bin:1');
+    test('getBuffer returns Buffer', Buffer.isBuffer(binOut));
+    test('binary roundtrip is byte-exact', binOut !== null && binOut.equals(binPayload));
+    test('getBuffer missing is null', db.getBuffer('bin:missing') === null);
+
+    db.put('bin:u8', new Uint8Array([1, 2, 3, 250]));
+    test('Uint8Array value stored', db.getBuffer('bin:u8').equals(Buffer.from([1, 2, 3, 250])));
+
+    const view = Buffer.from([9, 9, 1, 2, 9]).subarray(2, 4);
+    db.put('bin:view', view);
+    test('Buffer view respects byteOffset', db.getBuffer('bin:view').equals(Buffer.from([1, 2])));
+
+    db.putBatch([['bin:b1', Buffer.from([0xde, 0xad])], ['bin:b2', 'text']]);
+    const binBatch = db.getBatchBuffer(['bin:b1', 'bin:missing', 'bin:b2']);
+    test('getBatchBuffer mixed values', binBatch[0].equals(Buffer.from([0xde, 0xad])) && binBatch[1] === null && binBatch[2].toString() === 'text');
+
+    await db.putAsync('bin:async', Buffer.from([0, 1, 0]));
+    const binAsync = await db.getBufferAsync('bin:async');
+    test('getBufferAsync roundtrip', binAsync !== null && binAsync.equals(Buffer.from([0, 1, 0])));
+    const binBatchAsync = await db.getBatchBufferAsync(['bin:async', 'bin:b1']);
+    test('getBatchBufferAsync roundtrip', binBatchAsync[0].equals(Buffer.from([0, 1, 0])) && binBatchAsync[1].length === 2);
+
+    const extDb = new TitanKV(null, { externalBuffers: true });
+    const extPayload = Buffer.alloc(64 * 1024, 0xab);
+    extDb.put('ext:1', extPayload);
+    test('externalBuffers roundtrip', extDb.getBuffer('ext:1').equals(extPayload));
+    extDb.put('ext:empty', Buffer.alloc(0));
+    test('externalBuffers empty value', extDb.getBuffer('ext:empty').length === 0);
+    extDb.close();
+
+    // === Large values ===
+    section('Large Values (Range / Streaming)');
+
+    const largePayload = Buffer.alloc(3 * 1024 * 1024 + 17);
+    for (let i = 0; i < largePayload.length; i++) largePayload[i] = (i * 31 + (i >> 12)) & 0xff;
+    db.put('large:1', largePayload);
+    test('strlen reports raw length', db.strlen('large:1') === largePayload.length);
+    test('strlen missing is 0', db.strlen('large:missing') === 0);
+    const crossFrame = db.getRangeBuffer('large:1', 1024 * 1024 - 8, 16);
+    test('getRangeBuffer spans frame boundary', crossFrame.equals(largePayload.subarray(1024 * 1024 - 8, 1024 * 1024 + 8)));
+    test('getRangeBuffer clamps at end', db.getRangeBuffer('large:1', largePayload.length - 4, 100).length === 4);
+    db.put('large:str', 'hello world');
+    test('getRange string slice', db.getRange('large:str', 6, 5) === 'world');
+    test('getRangeAsync string slice', (await db.getRangeAsync('large:str', 0, 5)) === 'hello');
+    test('getRange missing is null', db.getRange('large:missing', 0, 1) === null);
+
+    const streamed = [];
+    for await (const chunk of db.createReadStream('large:1', { chunkSize: 1024 * 1024 })) streamed.push(chunk);
+    test('createReadStream yields whole value', Buffer.concat(streamed).equals(largePayload));
+    const partial = [];
+    for await (const chunk of db.createReadStream('large:1', { start: 10, end: 20 })) partial.push(chunk);
+    test('createReadStream honours start/end', Buffer.concat(partial).equals(largePayload.subarray(10, 20)));
+
+    db.put('large:2', 'previous');
+    const ws = db.createWriteStream('large:2');
+    for (let off = 0; off < largePayload.length; off += 300 * 1024) {
+        ws.write(largePayload.subarray(off, off + 300 * 1024));
+    }
+    test('createWriteStream keeps old value until finish', db.get('large:2') === 'previous');
+    await new Promise((resolve, reject) => ws.end(resolve).on('error', reject));
+    test('createWriteStream stores streamed value', db.getBuffer('large:2').equals(largePayload));
+    test('streamed value supports range reads', db.getRangeBuffer('large:2', 2 * 1024 * 1024, 4).equals(largePayload.subarray(2 * 1024 * 1024, 2 * 1024 * 1024 + 4)));
+
+    // === Compression policies ===
+    section('Compression Policies');
+
+    const policyDir = path.join(__dirname, 'test-data-policies');
+    try { fs.rmSync(policyDir, { recursive: true, force: true }); } catch {}
+    const policyDb = new TitanKV(policyDir, {
+        compressionPolicies: [
+            { prefix: 'sess:', codec: 'none' },
+            { prefix: 'rep:', level: 19 },
+        ],
+    });
+    const repetitive = 'abc'.repeat(10000);
+    policyDb.put('sess:1', repetitive);
+    policyDb.put('rep:1', repetitive);
+    policyDb.putBatch([['sess:2', 'batched'], ['rep:2', repetitive]]);
+    const policyStats = policyDb.stats();
+    test('codec none stores raw bytes', policyStats.compressedBytes > repetitive.length);
+    test('policy values roundtrip', policyDb.get('sess:1') === repetitive && policyDb.get('rep:2') === repetitive);
+    test('codec none range read', policyDb.getRange('sess:1', 3, 3) === 'abc');
+    policyDb.close();
+
+    const policyReopen = new TitanKV(policyDir);
+    test('policy values survive reopen without policies', policyReopen.get('sess:2') === 'batched' && policyReopen.get('rep:1') === repetitive);
+    policyReopen.close();
+
+    let badCodec = false;
+    try { new TitanKV(null, { compressionPolicies: [{ prefix: 'x:', codec: 'lz4' }] }); } catch { badCodec = true; }
+    test('unknown codec rejected', badCodec);
+    let badDict = false;
+    try { new TitanKV(null, { compressionPolicies: [{ prefix: 'x:', dictionary: Buffer.from('not a dictionary') }] }); } catch { badDict = true; }
+    test('untrained dictionary rejected', badDict);
+    try { fs.rmSync(policyDir, { recursive: true, force: true }); } catch {}
+
+    section('Cold Recompression');
+
+    const coldDb = new TitanKV(null, { compressionLevel: 1, coldRecompress: { afterMs: 0, level: 19, trainDictionary: true } });
+    const coldValues = [];
+    for (let i = 0; i < 500; i++) {
+        const v = JSON.stringify({ id: i, name: `customer-${(i * 7919) % 1000}`, tier: 'gold', region: 'eu-west-1', tags: ['a', 'b', 'c'] });
+        coldValues.push(v);
+        coldDb.put(`cold:${i}`, v);
+    }
+    const coldBefore = coldDb.stats().compressedBytes;
+    const coldSaved = await coldDb.recompressColdAsync();
+    const coldStats = coldDb.stats();
+    test('recompressCold saves bytes', coldSaved > 0 && coldStats.compressedBytes === coldBefore - coldSaved);
+    test('coldBytesSaved reported', coldStats.coldBytesSaved === coldSaved && coldStats.coldRecompressedCount > 0);
+    test('cold values roundtrip', coldValues.every((v, i) => coldDb.get(`cold:${i}`) === v));
+    test('second pass is a no-op', coldDb.recompressCold() === 0);
+    coldDb.close();
+
+    const noColdDb = new TitanKV();
+    noColdDb.put('k', 'v'.repeat(1000));
+    test('recompressCold disabled by default', noColdDb.recompressCold() === 0);
+    noColdDb.close();
+
+    section('Memory Accounting & Eviction');
+
+    const memDb = new TitanKV();
+    memDb.put('mem:a', 'x'.repeat(100));
+    const memStats = memDb.stats();
+    test('memoryBytes covers memtable', memStats.memoryBytes >= memStats.memtableBytes && memStats.memtableBytes > 100);
+    for (let i = 0; i < 1000; i++) {
+        memDb.put(`churn:${i}`, 'v');
+        memDb.del(`churn:${i}`);
+    }
+    test('in-memory deletes keep no tombstones', memDb.stats().tombstoneBytes === 0 && memDb.get('churn:1') === null);
+    memDb.close();
+
+    const lfuDb = new TitanKV(null, { maxMemoryBytes: 32 * 1024, evictionPolicy: 'allkeys-lfu' });
+    for (let i = 0; i < 2000; i++) {
+        lfuDb.put(`lfu:${i}`, `value-${i}-${'y'.repeat(40)}`);
+        if (i >= 10) for (let r = 0; r < 5; r++) lfuDb.get('lfu:0');
+    }
+    const lfuStats = lfuDb.stats();
+    test('eviction holds the budget', lfuStats.memoryBytes <= 32 * 1024);
+    test('eviction dropped keys', lfuStats.keyCount < 2000 && lfuStats.keyCount > 0);
+    test('lfu keeps the hot key', lfuDb.get('lfu:0') !== null);
+    test('evictions counted', lfuStats.evictedKeys > 0 && lfuStats.evictedBytes > 0);
+    lfuDb.close();
+
+    const listEvictDb = new TitanKV(null, { maxMemoryBytes: 32 * 1024, evictionPolicy: 'allkeys-lru' });
+    for (let i = 0; i < 50; i++) listEvictDb.put(`str:${i}`, 's'.repeat(40));
+    for (let i = 0; i < 2000; i++) listEvictDb.rpush('big:list', `item-${i}-${'z'.repeat(40)}`);
+    listEvictDb.put('str:last', 's'.repeat(40));
+    const listEvictStats = listEvictDb.stats();
+    test('large list does not evict plain keys', listEvictStats.collectionBytes > 32 * 1024 && listEvictDb.get('str:0') !== null && listEvictDb.get('str:last') !== null);
+    test('large list is kept', listEvictDb.llen('big:list') === 2000);
+    listEvictDb.close();
+
+    const ttlEvictDb = new TitanKV(null, { maxMemoryBytes: 16 * 1024, evictionPolicy: 'volatile-ttl' });
+    for (let i = 0; i < 20; i++) ttlEvictDb.put(`keep:${i}`, 'k'.repeat(40));
+    for (let i = 0; i < 500; i++) ttlEvictDb.put(`tmp:${i}`, 't'.repeat(40), 60_000);
+    let keptAll = true;
+    for (let i = 0; i < 20; i++) keptAll = keptAll && ttlEvictDb.get(`keep:${i}`) !== null;
+    test('volatile-ttl never evicts persistent keys', keptAll);
+    ttlEvictDb.close();
+
+    section('Native TTL Index');
+
+    const ttlIdxDb = new TitanKV(null, { cleanupIntervalMs: 20 });
+    for (let i = 0; i < 1000; i++) ttlIdxDb.put(`short:${i}`, 'v', 30);
+    ttlIdxDb.put('long', 'v', 60_000);
+    test('ttl reported for put ttl', ttlIdxDb.ttl('long') > 59_000);
+    await new Promise(r => setTimeout(r, 150));
+    test('unread expired keys reclaimed', ttlIdxDb.size() === 1);
+    test('expire on missing key', ttlIdxDb.expire('short:1', 1000) === false);
+    ttlIdxDb.close();
+
+    // Deadlines are wall-clock instants, so time spent closed counts
+    // against them and keys that expired meanwhile are not loaded
+    await roundTrip('ttl-restart-data', ttlDb => {
+        ttlDb.put('ttl:long', 'v', 60_000)
+        ttlDb.put('ttl:short', 'v', 100)
+        ttlDb.put('ttl:later', 'v')
+        ttlDb.expire('ttl:later', 60_000)
+        ttlDb.put('ttl:kept', 'v', 100)
+        ttlDb.persist('ttl:kept')
+    }, (ttlDb, stage) => {
+        const left = ttlDb.ttl('ttl:long')
+        test(`deadline runs on while closed (${stage})`, left > 50_000 && left <= 60_000 - 150)
+        test(`key expired while closed is not loaded (${stage})`, ttlDb.size() === 3 && ttlDb.get('ttl:short') === null)
+        test(`expire and persist replayed (${stage})`,
+            ttlDb.ttl('ttl:later') > 50_000 && ttlDb.ttl('ttl:kept') === -1 && ttlDb.get('ttl:kept') === 'v')
+    }, 150)
+
+    let badPolicy = false;
+    try { new TitanKV(null, { evictionPolicy: 'random' }); } catch { badPolicy = true; }
+    test('unknown eviction policy rejected', badPolicy);
+
     // === Query ===
     section('Query Operations');
 
@@ -104,6 +358,13 @@ async function runTests() {
     test('range query', ranged.length === 2);
     test('keys', db.keys().length === 5);
 
+    const newest = db.scan('user:', { limit: 2, reverse: true })
+    test('scan reverse', newest.map(([k]) => k).join() === 'user:3,user:2')
+    const nextPage = db.scan('user:', { limit: 2, reverse: true, after: newest[1][0] })
+    test('scan resumes after key', nextPage.length === 1 && nextPage[0][0] === 'user:1')
+    test('range reverse', db.range('post:1', 'user:1', { reverse: true }).map(([k]) => k).join() === 'user:1,post:2,post:1')
+    test('keys after', db.keys({ after: 'post:2', limit: 2 }).join() === 'user:1,user:2')
+
     section('Async Query Operations');
 
     let asyncQueryErr = null;
@@ -152,6 +413,7 @@ async function runTests() {
 
     test('persist', db.persist('sess:1') === true);
     test('ttl after persist = -1', db.ttl('sess:1') === -1);
+    test('persist without ttl = false', db.persist('sess:1') === false);
 
     test('expire missing', db.expire('sess:nope', 1000) === false);
 
@@ -171,6 +433,58 @@ async function runTests() {
     for (const [k, v] of db.iterate('user:', 2)) { iterCount++; }
     test('iterate generator', iterCount === 3);
 
+    // === Snapshot cursors ===
+    section('Snapshot Cursors');
+
+    const cursorDb = new TitanKV()
+    for (let i = 0; i < 50; i++) cursorDb.put('cur:' + String(i).padStart(2, '0'), 'v' + i)
+    cursorDb.put('other', 'x')
+
+    const seen = []
+    const cursor = cursorDb.iterate({ prefix: 'cur:', batchSize: 8 })
+    for await (const [k, v] of cursor) {
+        if (seen.length === 0) {
+            cursorDb.put('cur:00', 'changed')
+            cursorDb.put('cur:99', 'added')
+            cursorDb.del('cur:49')
+        }
+        seen.push([k, v])
+    }
+    test('cursor visits every prefixed key', seen.length === 50 && seen.every(([k]) => k.startsWith('cur:')))
+    test('cursor keys are ordered', seen.every(([k], i) => i === 0 || seen[i - 1][0] < k))
+    test('cursor ignores later writes', seen[0][1] === 'v0' && seen[49][0] === 'cur:49' && !seen.some(([k]) => k === 'cur:99'))
+
+    const reversed = []
+    for await (const [k] of cursorDb.iterate({ start: 'cur:10', end: 'cur:14', reverse: true, batchSize: 2 })) reversed.push(k)
+    test('cursor reverse range', reversed.join() === 'cur:14,cur:13,cur:12,cur:11,cur:10')
+
+    const early = cursorDb.iterate({ prefix: 'cur:' })
+    for await (const entry of early) break
+    test('cursor released on break', (await early.next()).done === true)
+
+    const [first] = cursorDb.iterate({ prefix: 'cur:0', asBuffer: true })
+    test('cursor asBuffer', Buffer.isBuffer(first[1]) && first[1].toString() === 'changed')
+
+    section('Point-in-Time Snapshots')
+
+    const snap = cursorDb.snapshot()
+    cursorDb.put('cur:01', 'after')
+    cursorDb.del('cur:02')
+    cursorDb.put('cur:new', 'after')
+    test('snapshot get sees pinned value', snap.get('cur:01') === 'v1' && cursorDb.get('cur:01') === 'after')
+    test('snapshot has deleted key', snap.has('cur:02') && !cursorDb.has('cur:02'))
+    test('snapshot hides later keys', snap.get('cur:new') === null)
+    test('snapshot scan', snap.scan('cur:0', { limit: 3 }).map(([k, v]) => k + '=' + v).join() === 'cur:00=changed,cur:01=v1,cur:02=v2')
+    let snapCount = 0
+    for await (const [k] of snap.iterate({ prefix: 'cur:' })) snapCount++
+    test('snapshot iterate', snapCount === 50)
+    test('snapshot sequence', typeof snap.sequence === 'number' && snap.sequence > 0)
+    snap.release()
+    let releasedErr = null
+    try { snap.get('cur:01') } catch (e) { releasedErr = e }
+    test('released snapshot throws', releasedErr !== null)
+    cursorDb.close()
+
     // === MULTI/EXEC ===
     section('MULTI/EXEC Transactions');
 
@@ -208,6 +522,281 @@ async function runTests() {
         res3[3] === true
     );
 
+    const tx6 = db.multi()
+    tx6.put('tx:b', '10')
+    tx6.incr('tx:b', 5)
+    tx6.decr('tx:b')
+    tx6.del('tx:1')
+    const res6 = tx6.exec()
+    test('batched tx results',
+        res6.length === 4 && res6[0] === undefined && res6[1] === 15 && res6[2] === 14 && res6[3] === true)
+
+    // A failing command is reported in its slot on both paths
+    const tx7 = db.multi()
+    tx7.put('tx:partial', 'x')
+    tx7.incr('tx:2')
+    tx7.put('tx:2', 'text')
+    tx7.incr('tx:2')
+    const res7 = tx7.exec()
+    test('batched tx reports failing command in its slot',
+        res7.length === 4 && res7[0] === undefined && res7[1] instanceof Error && res7[3] instanceof Error &&
+        db.get('tx:partial') === 'x' && db.get('tx:2') === 'text' && tx7.length === 0)
+    const tx10 = db.multi()
+    tx10.put('tx:mixed', 'x')
+    tx10.incr('tx:2')
+    tx10.sadd('tx:mixedSet', 'm')
+    const res10 = tx10.exec()
+    test('mixed tx reports failing command in its slot',
+        res10.length === 3 && res10[0] === undefined && res10[1] instanceof Error && res10[2] === 1 &&
+        db.get('tx:mixed') === 'x' && db.scard('tx:mixedSet') === 1 && tx10.length === 0)
+
+    db.put('tx:watched', 'a');
+    db.watch('tx:watched');
+    const tx4 = db.multi();
+    tx4.put('tx:watched', 'c');
+    db.put('tx:watched', 'b');
+    test('exec aborts after watched write', tx4.exec() === null && db.get('tx:watched') === 'b');
+    db.watch('tx:watched');
+    const tx5 = db.multi();
+    tx5.put('tx:watched', 'c');
+    test('exec runs when watched key unchanged', Array.isArray(tx5.exec()) && db.get('tx:watched') === 'c');
+    db.watch('tx:watched')
+    const tx8 = db.multi()
+    tx8.put('tx:watched', 'd')
+    tx8.incr('tx:watchedCount')
+    await db.putAsync('tx:watched', 'async')
+    test('batched exec aborts after async write',
+        tx8.exec() === null && db.get('tx:watched') === 'async' && db.get('tx:watchedCount') === null)
+    db.watch('tx:watched')
+    const tx9 = db.multi()
+    tx9.put('tx:watched', 'e')
+    tx9.sadd('tx:watchedSet', 'm')
+    await db.putAsync('tx:watched', 'async2')
+    test('mixed exec aborts after async write',
+        tx9.exec() === null && db.get('tx:watched') === 'async2' && db.scard('tx:watchedSet') === 0)
+
+    // === Versions ===
+    section('Versions (compare-and-set)');
+
+    db.clear();
+    const absent = db.getWithVersion('cas');
+    test('getWithVersion missing key', absent.value === null && typeof absent.version === 'number');
+    const v1 = db.putIfAbsent('cas', 'one');
+    test('putIfAbsent writes new key', typeof v1 === 'number' && db.get('cas') === 'one');
+    test('putIfAbsent keeps existing key', db.putIfAbsent('cas', 'other') === null && db.get('cas') === 'one');
+    const read = db.getWithVersion('cas');
+    test('getWithVersion returns value and version', read.value === 'one' && read.version === v1);
+    const v2 = db.putIfVersion('cas', 'two', read.version);
+    test('putIfVersion with current version', typeof v2 === 'number' && v2 !== v1 && db.get('cas') === 'two');
+    test('putIfVersion with stale version', db.putIfVersion('cas', 'three', v1) === null && db.get('cas') === 'two');
+    db.del('cas');
+    test('delete changes the version', db.getWithVersion('cas').version !== v2);
+    const beforeExpiry = db.getWithVersion('cas:ttl').version;
+    db.put('cas:ttl', 'short', 20);
+    await new Promise(r => setTimeout(r, 40));
+    test('expiry changes the version', db.get('cas:ttl') === null && db.putIfVersion('cas:ttl', 'stale', beforeExpiry) === null);
+
+    // === Read snapshots ===
+    section('Read Snapshots (multi-process reads)');
+
+    const snapDir = path.join(__dirname, 'snapshot-data')
+    try { fs.rmSync(snapDir, { recursive: true, force: true }); } catch {}
+    const writer = new TitanKV(snapDir)
+    const reader = new TitanReader(snapDir, { refreshIntervalMs: 0 })
+    test('reader before first publish', reader.generation() === 0 && reader.get('a') === null)
+    writer.put('a', '1')
+    writer.put('user:1', 'alice')
+    writer.put('user:2', 'bob')
+    writer.incr('hits', 3)
+    test('publishSnapshot returns generation', writer.publishSnapshot() === 1)
+    test('reader refresh maps new generation', reader.refresh() === true && reader.generation() === 1)
+    test('reader get', reader.get('a') === '1' && reader.get('hits') === '3' && reader.get('nope') === null)
+    test('reader getBuffer', reader.getBuffer('a').equals(Buffer.from('1')))
+    test('reader scan', reader.scan('user:').map(p => p[1]).join() === 'alice,bob')
+    writer.put('a', '2')
+    test('reader sees published state', reader.get('a') === '1')
+    test('publishSnapshotAsync', await writer.publishSnapshotAsync() === 2 && reader.refresh() && reader.get('a') === '2')
+    reader.close()
+    writer.close()
+    try { fs.rmSync(snapDir, { recursive: true, force: true }); } catch {}
+
+    // === Checkpoints ===
+    section('Online Checkpoints');
+
+    const cpSource = path.join(__dirname, 'checkpoint-source')
+    const cpTarget = path.join(__dirname, 'checkpoint-target')
+    for (const dir of [cpSource, cpTarget]) {
+        try { fs.rmSync(dir, { recursive: true, force: true }); } catch {}
+    }
+    const cpDb = new TitanKV(cpSource)
+    for (let i = 0; i < 100; i++) cpDb.put(`cp:${i}`, `value-${i}`)
+    const firstCheckpoint = cpDb.checkpoint(cpTarget)
+    test('checkpoint copies the whole WAL', firstCheckpoint.walBytes > 0 && firstCheckpoint.copiedBytes === firstCheckpoint.walBytes)
+    cpDb.put('cp:0', 'changed')
+    cpDb.del('cp:1')
+    const secondCheckpoint = await cpDb.checkpointAsync(cpTarget)
+    test('repeated checkpoint is incremental', secondCheckpoint.copiedBytes > 0 && secondCheckpoint.copiedBytes < secondCheckpoint.walBytes)
+    let threw = false
+    try { cpDb.checkpoint(cpSource) } catch { threw = true }
+    test('checkpoint rejects the source directory', threw)
+    cpDb.close()
+    const restored = new TitanKV(cpTarget)
+    test('checkpoint opens as a database', restored.get('cp:0') === 'changed' && restored.get('cp:1') === null && restored.get('cp:99') === 'value-99')
+    restored.close()
+
+    // Dictionaries are registered process-wide, so the copy is opened from a
+    // fresh process that has only what the checkpoint holds
+    const cpDictSource = path.join(__dirname, 'checkpoint-dict-source')
+    const cpDictTarget = path.join(__dirname, 'checkpoint-dict-target')
+    for (const dir of [cpDictSource, cpDictTarget]) {
+        try { fs.rmSync(dir, { recursive: true, force: true }); } catch {}
+    }
+    const cpDictDb = new TitanKV(cpDictSource, { coldRecompress: { afterMs: 0, level: 19, trainDictionary: true } })
+    const cpDictValue = i => JSON.stringify({ id: i, name: `customer-${(i * 7919) % 1000}`, tier: 'gold', region: 'eu-west-1' })
+    for (let i = 0; i < 500; i++) cpDictDb.put(`cpd:${i}`, cpDictValue(i))
+    cpDictDb.recompressCold()
+    cpDictDb.compact()
+    cpDictDb.checkpoint(cpDictTarget)
+    cpDictDb.close()
+    const cpDictFiles = fs.readdirSync(path.join(cpDictTarget, 'dictionaries')).filter(f => f.endsWith('.zdict'))
+    const cpDictRead = require('child_process').spawnSync(process.execPath, ['-e', `
+        const { TitanKV } = require(${JSON.stringify(path.join(__dirname, '..', 'lib'))})
+        const db = new TitanKV(${JSON.stringify(cpDictTarget)}, { recoverMode: 'strict' })
+        process.stdout.write(db.get('cpd:7'))
+        db.close()
+    `], { encoding: 'utf8' })
+    test('checkpoint carries compression dictionaries', cpDictFiles.length > 0 && cpDictRead.stdout === cpDictValue(7))
+    for (const dir of [cpSource, cpTarget, cpDictSource, cpDictTarget]) {
+        try { fs.rmSync(dir, { recursive: true, force: true }); } catch {}
+    }
+
+    // === SSTable ingest ===
+    section('SSTable Bulk Ingest');
+
+    const ingestDir = path.join(__dirname, 'ingest-data')
+    try { fs.rmSync(ingestDir, { recursive: true, force: true }); } catch {}
+    fs.mkdirSync(ingestDir, { recursive: true })
+    const sstPath = path.join(ingestDir, 'bulk.sst')
+    const sstWriter = new SSTableWriter(sstPath)
+    for (let i = 0; i < 1000; i++) sstWriter.add(`bulk:${String(i).padStart(4, '0')}`, `value-${i}`)
+    threw = false
+    try { sstWriter.add('bulk:0000', 'again') } catch { threw = true }
+    test('SSTableWriter rejects unsorted keys', threw)
+    test('SSTableWriter.finish returns record count', sstWriter.finish() === 1000)
+    const ingestDb = new TitanKV(path.join(ingestDir, 'db'))
+    ingestDb.put('bulk:0001', 'old')
+    ingestDb.put('other', 'kept')
+    test('ingest returns record count', ingestDb.ingest([sstPath]) === 1000 && fs.existsSync(sstPath))
+    test('ingested values replace existing ones', ingestDb.get('bulk:0001') === 'value-1' && ingestDb.get('other') === 'kept')
+    test('ingested keys are scannable', ingestDb.keys({ limit: 5000 }).filter(k => k.startsWith('bulk:')).length === 1000)
+    const sstMoved = path.join(ingestDir, 'moved.sst')
+    const movedWriter = new SSTableWriter(sstMoved)
+    movedWriter.add('bulk:0002', 'moved')
+    movedWriter.finish()
+    test('ingestAsync with move', await ingestDb.ingestAsync([sstMoved], { move: true }) === 1 && !fs.existsSync(sstMoved))
+    ingestDb.close()
+    const reopenedIngest = new TitanKV(path.join(ingestDir, 'db'))
+    test('ingested data survives restart', reopenedIngest.get('bulk:0002') === 'moved' && reopenedIngest.get('bulk:0999') === 'value-999')
+    // Compaction keeps the tables and logs only what was written over them
+    reopenedIngest.del('bulk:0003')
+    reopenedIngest.compact()
+    reopenedIngest.close()
+    const compactedIngest = new TitanKV(path.join(ingestDir, 'db'))
+    const ingestStats = compactedIngest.stats()
+    test('compaction keeps ingested tables', fs.readdirSync(path.join(ingestDir, 'db', 'ingest')).length === 2 &&
+        compactedIngest.get('bulk:0999') === 'value-999' && compactedIngest.get('bulk:0002') === 'moved' &&
+        compactedIngest.get('bulk:0003') === null && compactedIngest.get('other') === 'kept')
+    test('compacted WAL leaves ingested values out', ingestStats.walBytes < 1024 && ingestStats.sstableIndexBytes > 0)
+    compactedIngest.close()
+
+    // Lookups compare the 8 bytes past the keys' shared prefix ("k:") packed
+    // into an integer, inside windows of 64 entries; with the Bloom filter
+    // off every miss reaches that search. The "same-8b!" block ties on the
+    // packed bytes across several windows.
+    const lookupKeys = ['k:0', 'k:a', 'k:a\0', 'k:~']
+    for (let i = 0; i < 200; i++) lookupKeys.push(`k:same-8b!${String(i).padStart(4, '0')}`)
+    lookupKeys.sort()
+    const lookupPath = path.join(ingestDir, 'lookup.sst')
+    const lookupWriter = new SSTableWriter(lookupPath)
+    lookupKeys.forEach((key, i) => lookupWriter.add(key, `v${i}`))
+    lookupWriter.finish()
+    const lookupDb = new TitanKV(path.join(ingestDir, 'lookup'), { bloomFilter: false })
+    lookupDb.ingest([lookupPath])
+    test('packed-prefix ties resolve to the exact key', lookupKeys.every((key, i) => lookupDb.get(key) === `v${i}`))
+    test('zero-padded keys do not tie', lookupDb.get('k:a') === 'v1' && lookupDb.get('k:a\0') === 'v2' &&
+        lookupDb.get('k:a\0\0') === null && lookupDb.get('k:a\x01') === null)
+    test('keys tying on the packed prefix miss', ['k:same-8b!', 'k:same-8b!0100x', 'k:same-8b!0200', 'k:same-8b"']
+        .every(key => lookupDb.get(key) === null))
+    // Just below each fence key, and just past it inside the next window
+    const fenceProbes = [64, 128, 192].flatMap(at => [`${lookupKeys[at - 1]}~`, `${lookupKeys[at]}\0`])
+    test('probes beside a fence window miss', fenceProbes.every(key => lookupDb.get(key) === null))
+    test('keys beside a fence window hit', [63, 64, 65, 127, 128, 191, 192].every(at => lookupDb.get(lookupKeys[at]) === `v${at}`))
+    lookupDb.close()
+    try { fs.rmSync(ingestDir, { recursive: true, force: true }); } catch {}
+
+    // === NDJSON export ===
+    section('Streaming NDJSON Export');
+
+    const exportDir = path.join(__dirname, 'export-data')
+    try { fs.rmSync(exportDir, { recursive: true, force: true }); } catch {}
+    fs.mkdirSync(exportDir, { recursive: true })
+    const exportDb = new TitanKV()
+    for (let i = 0; i < 2000; i++) exportDb.put(`exp:${String(i).padStart(4, '0')}`, `payload "${i}"\n`)
+    exportDb.put('other', 'skipped')
+    const ndjsonPath = path.join(exportDir, 'dump.ndjson')
+    const exportResult = await exportDb.exportNDJSON(ndjsonPath, { prefix: 'exp:', chunkBytes: 4096 })
+    const exportLines = fs.readFileSync(ndjsonPath, 'utf8').split('\n').filter(Boolean)
+    test('exportNDJSON reports records and bytes', exportResult.records === 2000 && exportResult.bytes === fs.statSync(ndjsonPath).size)
+    test('exportNDJSON writes one JSON line per value', exportLines.length === 2000)
+    const firstLine = JSON.parse(exportLines[0])
+    test('exported lines carry key and value', firstLine.key === 'exp:0000' && firstLine.value === 'payload "0"\n')
+    const exportSnap = exportDb.snapshot()
+    exportDb.put('exp:0000', 'changed')
+    const snapPath = path.join(exportDir, 'snap.ndjson')
+    await exportSnap.exportNDJSON(snapPath, { prefix: 'exp:', end: 'exp:0009' })
+    const snapLines = fs.readFileSync(snapPath, 'utf8').split('\n').filter(Boolean).map(l => JSON.parse(l))
+    test('snapshot export ignores later writes', snapLines.length === 10 && snapLines[0].value === 'payload "0"\n')
+    exportSnap.release()
+    const zstPath = path.join(exportDir, 'dump.ndjson.zst')
+    await exportDb.exportNDJSON(fs.createWriteStream(zstPath), { prefix: 'exp:', compress: true })
+    const zst = fs.readFileSync(zstPath)
+    test('compressed export is a zstd frame', zst.length > 0 && zst.readUInt32LE(0) === 0xfd2fb528 && zst.length < fs.statSync(ndjsonPath).size)
+    let exportedLines = 0
+    for await (const chunk of exportDb.exportStream({ prefix: 'exp:', reverse: true })) exportedLines += chunk.toString().split('\n').length - 1
+    test('exportStream is async iterable', exportedLines === 2000)
+    exportDb.close()
+    try { fs.rmSync(exportDir, { recursive: true, force: true }); } catch {}
+
+    // === Worker threads ===
+    section('Shared Engines (worker_threads)');
+
+    const { Worker } = require('worker_threads')
+    const sharedA = new TitanKV(null, { shared: 'test-shared' })
+    const sharedB = new TitanKV(null, { shared: 'test-shared' })
+    sharedA.put('shared:key', 'from-main')
+    test('handles share one engine', sharedB.get('shared:key') === 'from-main')
+    const workerResult = await new Promise((resolve, reject) => {
+        const worker = new Worker(`
+            const { parentPort } = require('worker_threads')
+            const { TitanKV } = require(${JSON.stringify(path.join(__dirname, '..', 'lib'))})
+            const db = new TitanKV(null, { shared: 'test-shared' })
+            const seen = db.get('shared:key')
+            db.put('shared:worker', 'from-worker')
+            db.close()
+            parentPort.postMessage(seen)
+        `, { eval: true })
+        worker.once('message', resolve)
+        worker.once('error', reject)
+    })
+    test('worker thread reads shared engine', workerResult === 'from-main')
+    test('main thread sees worker write', sharedA.get('shared:worker') === 'from-worker')
+    sharedA.close()
+    test('engine stays open for remaining handle', sharedB.get('shared:key') === 'from-main')
+    sharedB.close()
+    const sharedC = new TitanKV(null, { shared: 'test-shared' })
+    test('last close releases engine', sharedC.get('shared:key') === null)
+    sharedC.close()
+
     // === Pub/Sub ===
     section('Pub/Sub');
 
@@ -230,6 +819,41 @@ async function runTests() {
     db.publish('chat:general', 'after unsub');
     test('unsubscribe works', received === null);
 
+    const nextMessage = (handle, channel) => new Promise(resolve => {
+        const timer = setTimeout(() => resolve(null), 2000)
+        const fn = (msg, ch) => {
+            clearTimeout(timer)
+            handle.unsubscribe(channel, fn)
+            resolve({ msg, ch })
+        }
+        handle.subscribe(channel, fn)
+    })
+    const pubA = new TitanKV(null, { shared: 'test-pubsub' })
+    const pubB = new TitanKV(null, { shared: 'test-pubsub' })
+    const crossHandle = nextMessage(pubB, 'news:*')
+    test('publish counts other handles', pubA.publish('news:1', 'hi') === 1)
+    const crossMsg = await crossHandle
+    test('other handle receives batched message', crossMsg !== null && crossMsg.msg === 'hi' && crossMsg.ch === 'news:1')
+    test('unsubscribe reaches the engine', pubA.publish('news:1', 'gone') === 0)
+
+    const setEvent = nextMessage(pubB, '__keyevent@0__:set')
+    await pubA.putAsync('ks:1', 'v')
+    const setMsg = await setEvent
+    test('keyspace event for async write', setMsg !== null && setMsg.msg === 'ks:1')
+    const ttlEvents = []
+    const expired = new Promise(resolve => {
+        const timer = setTimeout(resolve, 2000)
+        pubB.subscribe('__keyspace@0__:ks:ttl', msg => {
+            ttlEvents.push(msg)
+            if (msg === 'expired') { clearTimeout(timer); resolve() }
+        })
+    })
+    pubA.put('ks:ttl', 'v', 20)
+    await expired
+    test('keyspace events for TTL expiry', ttlEvents.join() === 'set,expired')
+    pubA.close()
+    pubB.close()
+
     // === Lists ===
     section('List Operations (Redis-like)');
 
@@ -250,6 +874,62 @@ async function runTests() {
     test('rpop', db.rpop('mylist') === 'last');
     test('llen after pop', db.llen('mylist') === 1);
 
+    section('Native Lists');
+
+    // 500-byte items fill an 8 KiB chunk at about 16, so the edits below
+    // straddle chunk boundaries; listModel holds the expected contents
+    const listModel = []
+    await roundTrip('list-restart-data', listDb => {
+        for (let i = 0; i < 64; i++) {
+            listModel.push(`item:${i}`.padEnd(500, '.'))
+            listDb.rpush('jobs', listModel[i])
+        }
+        for (const i of [0, 15, 16, 17, 31, 32, 63]) {
+            listModel[i] = `set:${i}`.padEnd(i % 2 ? 10 : 9000, '.')
+            listDb.lset('jobs', i, listModel[i])
+        }
+        const popped = []
+        for (let i = 0; i < 17; i++) popped.push(listDb.lpop('jobs'))
+        test('lpop across a chunk boundary', popped.join() === listModel.splice(0, 17).join())
+        for (let i = 0; i < 3; i++) {
+            listModel.unshift(`front:${i}`)
+            listDb.lpush('jobs', `front:${i}`)
+        }
+        test('rpop across a chunk boundary', listDb.rpop('jobs') === listModel.pop())
+        listModel[listModel.length - 1] = 'tail'
+        listDb.lset('jobs', -1, 'tail')
+        test('list edits match', listDb.llen('jobs') === listModel.length && listDb.lrange('jobs', 0, -1).join() === listModel.join())
+        test('lindex at every position', listModel.every((v, i) =>
+            listDb.lindex('jobs', i) === v && listDb.lindex('jobs', i - listModel.length) === v))
+        test('lrange clamps out-of-range stop', listDb.lrange('jobs', -2, 1000000).join() === listModel.slice(-2).join())
+        test('list counted in collectionBytes', listDb.stats().collectionBytes > 0 && listDb.type('jobs') === 'list')
+    }, (listDb, stage) => {
+        test(`list chunks replayed (${stage})`, listDb.lrange('jobs', 0, -1).join() === listModel.join())
+        // Edits made after reopening are logged against the replayed chunks
+        listModel[1] = `reopened:${stage}`
+        listDb.lset('jobs', 1, listModel[1])
+        test(`lpop after ${stage}`, listDb.lpop('jobs') === listModel.shift() && listDb.lindex('jobs', 0) === listModel[0])
+        if (stage === 'compaction') test('del drops native list', listDb.del('jobs') === true && listDb.llen('jobs') === 0)
+    })
+
+    const [listRaceLive, listRaceReplayed] = await raceReplay('list-race-data', raceDb => raceDb.rpush('race', 'seed'), `
+        for (let i = 0; i < 2000; i++) {
+            const v = t + ':' + i
+            switch ((i + t) % 5) {
+                case 0: db.lpush('race', v); break
+                case 1: db.rpush('race', v, v + 'b'); break
+                case 2: db.lpop('race'); break
+                case 3: db.rpop('race'); break
+                default: db.lset('race', 0, v); db.lset('race', -1, v)
+            }
+        }
+    `, raceDb => raceDb.lrange('race', 0, -1).join())
+    test('concurrent list writes replay to the live list', listRaceLive.length > 0 && listRaceReplayed === listRaceLive)
+
+    db._db.put('\x00L:legacy', JSON.stringify(['a', 'b']));
+    test('legacy JSON list migrated', db.rpush('legacy', 'c') === 3 && db.lrange('legacy', 0, -1).join() === 'a,b,c');
+    test('legacy JSON key removed', db._db.has('\x00L:legacy') === false);
+
     // === Sets ===
     section('Set Operations (Redis-like)');
 
@@ -297,6 +977,71 @@ async function runTests() {
     test('hgetall handles corrupt data', corruptRes !== null && Object.keys(corruptRes).length === 0);
     test('hget handles corrupt data', db.hget('corrupt', 'field') === null);
 
+    let hincrNaN = false;
+    try { db.hincrby('profile', 'name', 1); } catch { hincrNaN = true; }
+    db.hset('profile', 'name', 'joji');
+    try { db.hincrby('profile', 'name', 1); } catch { hincrNaN = true; }
+    test('hincrby rejects non-integer field', hincrNaN && db.hget('profile', 'name') === 'joji');
+
+    section('Native Hashes & Sets');
+
+    // Hashes and sets start packed, keeping insertion order, and convert
+    // once to a hash table past 128 entries or on an item over 64 bytes.
+    // Fields are added in descending order so insertion order is visible.
+    const fieldNames = n => Array.from({ length: n }, (_, i) => `f${n - i}`)
+    const sameItems = (a, b) => [...a].sort().join() === [...b].sort().join()
+    const fieldValuesMatch = hash => Object.entries(hash).every(([field, value]) => value === `v:${field}`)
+    await roundTrip('field-restart-data', fieldDb => {
+        for (const key of ['packed', 'grown', 'edge']) {
+            for (const field of fieldNames(128)) fieldDb.hset(key, field, `v:${field}`)
+        }
+        test('packed hash keeps insertion order', Object.keys(fieldDb.hgetall('packed')).join() === fieldNames(128).join())
+        fieldDb.hset('grown', 'f0', 'v:f0')
+        const grown = fieldDb.hgetall('grown')
+        test('hash converts past 128 fields',
+            fieldDb.hlen('grown') === 129 && sameItems(Object.keys(grown), [...fieldNames(128), 'f0']) && fieldValuesMatch(grown))
+        fieldDb.hset('long', 'a', '1')
+        fieldDb.hset('long', 'b', 'x'.repeat(65))
+        fieldDb.hincrby('long', 'a', 41)
+        test('hash converts on a long value', fieldDb.hget('long', 'b') === 'x'.repeat(65) && fieldDb.hget('long', 'a') === '42')
+
+        for (let i = 0; i < 200; i++) fieldDb.sadd('members', `m${i}`)
+        fieldDb.srem('members', 'm1')
+        test('set converts past 128 members', fieldDb.scard('members') === 199 &&
+            !fieldDb.sismember('members', 'm1') && fieldDb.sismember('members', 'm0') && fieldDb.sismember('members', 'm199'))
+        fieldDb.sadd('tags', 'a', 'k'.repeat(65))
+        test('set converts on a long member', sameItems(fieldDb.smembers('tags'), ['a', 'k'.repeat(65)]))
+        test('native hash and set types', fieldDb.type('grown') === 'hash' && fieldDb.type('members') === 'set')
+
+        const fieldWalBefore = fieldDb.stats().physicalWriteBytes
+        fieldDb.hset('grown', 'f1', 'v:f1')
+        test('hset logs only the field', fieldDb.stats().physicalWriteBytes - fieldWalBefore < 100)
+    }, (fieldDb, stage) => {
+        test(`packed hash replayed in order (${stage})`, Object.keys(fieldDb.hgetall('packed')).join() === fieldNames(128).join())
+        test(`converted hash and set replayed (${stage})`,
+            fieldDb.hlen('grown') === 129 && fieldValuesMatch(fieldDb.hgetall('grown')) && fieldDb.hget('long', 'a') === '42' &&
+            fieldDb.scard('members') === 199 && !fieldDb.sismember('members', 'm1') && fieldDb.scard('tags') === 2)
+        // A hash replayed packed still converts when it grows
+        if (stage === 'restart') fieldDb.hset('edge', 'f0', 'v:f0')
+        const edge = fieldDb.hgetall('edge')
+        test(`replayed packed hash converts (${stage})`, Object.keys(edge).length === 129 && fieldValuesMatch(edge))
+        if (stage === 'compaction') test('del drops native hash', fieldDb.del('grown') === true && fieldDb.hlen('grown') === 0)
+    })
+
+    // SADD is only logged when it adds, so a SADD/SREM pair logged out of
+    // order would leave a stale member behind after a restart
+    const [fieldRaceLive, fieldRaceReplayed] = await raceReplay('field-race-data', () => {}, `
+        for (let i = 0; i < 2000; i++) {
+            const item = 'm' + (i % 4)
+            if ((i + t) % 2) { db.sadd('race', item); db.hset('race:h', item, t + ':' + i) }
+            else { db.srem('race', item); db.hdel('race:h', item) }
+        }
+    `, raceDb => JSON.stringify([raceDb.smembers('race').sort(), Object.entries(raceDb.hgetall('race:h')).sort()]))
+    test('concurrent set and hash writes replay to the live state', fieldRaceReplayed === fieldRaceLive)
+
+    db._db.put('\x00S:legacy', JSON.stringify(['a', 'b']));
+    test('legacy JSON set migrated', db.sadd('legacy', 'c') === 1 && db.scard('legacy') === 3);
+
     // === Sorted Sets ===
     section('Sorted Set Operations (Redis-like)');
 
@@ -322,6 +1067,9 @@ async function runTests() {
     const byScore = db.zrangebyscore('leaderboard', 100, 250);
     test('zrangebyscore', byScore.length === 2);
 
+    const revByScore = db.zrevrangebyscore('leaderboard', '+inf', 100, { limit: { offset: 0, count: 2 } })
+    test('zrevrangebyscore', revByScore.length === 2 && revByScore[0] === rev[0] && revByScore[1] === rev[1])
+
     const byScoreInf = db.zrangebyscore('leaderboard', '-inf', '+inf');
     test('zrangebyscore -inf/+inf', byScoreInf.length === 4);
 
@@ -334,6 +1082,64 @@ async function runTests() {
     test('zrem', db.zrem('leaderboard', 'newbie') === 1);
     test('zrem missing', db.zrem('leaderboard', 'nobody') === 0);
     test('zcard after zrem', db.zcard('leaderboard') === 4);
+    test('zrevrank', db.zrevrank('leaderboard', 'charlie') === 0 && db.zrevrank('leaderboard', 'nobody') === null);
+    test('zrangebyscore limit', db.zrangebyscore('leaderboard', '-inf', '+inf', { limit: { offset: 1, count: 2 } }).join() === 'bob,dave');
+
+    let nanScore = false;
+    try { db.zadd('leaderboard', 'abc', 'bad'); } catch { nanScore = true; }
+    test('zadd rejects NaN score', nanScore && db.zscore('leaderboard', 'bad') === null);
+
+    section('Native Sorted Sets');
+
+    // Ranks come from skiplist spans, which every ZREM has to splice;
+    // zsetModel holds the expected [score, member] order
+    let zsetModel = []
+    const zsetMembers = entries => entries.map(([, member]) => member).join()
+    const zsetRanksMatch = zsetDb => zsetModel.every(([, member], rank) => zsetDb.zrank('board', member) === rank)
+    await roundTrip('zset-restart-data', zsetDb => {
+        for (let i = 0; i < 2000; i++) {
+            zsetModel.push([(i * 7919) % 2000, `p:${i}`])
+            zsetDb.zadd('board', zsetModel[i][0], zsetModel[i][1])
+        }
+        for (let i = 0; i < 2000; i += 3) zsetDb.zrem('board', `p:${i}`)
+        zsetDb.zincrby('board', 100000, 'p:1')
+        zsetDb.zadd('board', 500, 'tie:b', 500, 'tie:a')
+        zsetModel = zsetModel.filter((_, i) => i % 3 !== 0)
+        zsetModel.find(([, member]) => member === 'p:1')[0] += 100000
+        zsetModel.push([500, 'tie:b'], [500, 'tie:a'])
+        zsetModel.sort((a, b) => a[0] - b[0] || (a[1] < b[1] ? -1 : a[1] > b[1] ? 1 : 0))
+
+        test('zrank exact after zrem', zsetDb.zcard('board') === zsetModel.length && zsetRanksMatch(zsetDb))
+        test('zrevrank after zrem', zsetDb.zrevrank('board', 'p:1') === 0 &&
+            zsetDb.zrevrank('board', zsetModel[0][1]) === zsetModel.length - 1)
+        test('zrange by rank after zrem', zsetDb.zrange('board', 500, 509).join() === zsetMembers(zsetModel.slice(500, 510)))
+        test('equal scores ordered by member', zsetDb.zrank('board', 'tie:a') + 1 === zsetDb.zrank('board', 'tie:b'))
+        const window = zsetModel.filter(([score]) => score >= 100 && score <= 199)
+        test('zcount after zrem', zsetDb.zcount('board', 100, 199) === window.length)
+        test('zrangebyscore offset after zrem',
+            zsetDb.zrangebyscore('board', 100, 199, { limit: { offset: 10, count: 5 } }).join() === zsetMembers(window.slice(10, 15)))
+        test('type of native zset', zsetDb.type('board') === 'zset')
+    }, (zsetDb, stage) => {
+        test(`ranks replayed (${stage})`, zsetDb.zcard('board') === zsetModel.length && zsetRanksMatch(zsetDb))
+        // Dropping the head moves every other rank down by one
+        const [, head] = zsetModel.shift()
+        test(`zrem head after ${stage}`, zsetDb.zrem('board', head) === 1 && zsetRanksMatch(zsetDb))
+        if (stage === 'compaction') test('del drops native zset', zsetDb.del('board') === true && zsetDb.zcard('board') === 0)
+    })
+
+    // A ZADD and ZREM of one member must replay in the order they applied,
+    // or the member comes back (or goes missing) after a restart
+    const [zsetRaceLive, zsetRaceReplayed] = await raceReplay('zset-race-data', () => {}, `
+        for (let i = 0; i < 2000; i++) {
+            const member = 'm' + (i % 4)
+            if ((i + t) % 2) db.zadd('race', t * 10000 + i, member)
+            else db.zrem('race', member)
+        }
+    `, raceDb => JSON.stringify(raceDb.zrange('race', 0, -1, { withScores: true })))
+    test('concurrent zadd/zrem replay to the live sorted set', zsetRaceReplayed === zsetRaceLive)
+
+    db._db.put('\x00Z:legacy', JSON.stringify([[1, 'a'], [2, 'b']]));
+    test('legacy JSON zset migrated', db.zadd('legacy', 3, 'c') === 1 && db.zrange('legacy', 0, -1).join() === 'a,b,c');
 
     // === JSON Import ===
     section('JSON Import/Export');
@@ -447,7 +1253,7 @@ async function runTests() {
     // Manually inject invalid JSON with list prefix '\x00L:'
     db._db.put('\x00L:' + corruptKey, '{invalid_json');
 
-    // _getList should catch the JSON.parse error and return []
+    // Migration should drop the unparseable legacy list
     test('llen handles corrupt data', db.llen(corruptKey) === 0);
     const corruptList = db.lrange(corruptKey, 0, -1);
     test('lrange handles corrupt data', Array.isArray(corruptList) && corruptList.length === 0);
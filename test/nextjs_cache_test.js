@@ -51,6 +51,17 @@ function test(name, condition) {
     test('Revalidate tag purges cached item', dataAfterReval === null)
     test('Revalidate tag purges tag set', db.scard('extest:tags:products') === 0)
 
+    // 4. Handler constructed by Next.js without a client owns a bounded instance
+    const owned = new NextJSTitanKVCache({ maxMemoryBytes: 64 * 1024 })
+    for (let i = 0; i < 2000; i++) {
+      await owned.set('page_' + i, { html: 'x'.repeat(64) + i }, {})
+    }
+    const ownedStats = owned.client.stats()
+    test('Owned cache stays within its budget', ownedStats.memoryBytes <= 64 * 1024 && ownedStats.evictedKeys > 0)
+    const recent = await owned.get('page_1999')
+    test('Owned cache keeps recent entries', recent !== null)
+    owned.client.close()
+
   } catch (err) {
     console.error('\nTest crashed:', err)
     failed++